@@ -3,6 +3,7 @@
 #include "delegation_sketch/DelegationBuildConfig.hpp"
 #include "delegation_sketch/DelegationConfig.hpp"
 #include "delegation_sketch/DelegationHeavyHitter.hpp"
+#include "delegation_sketch/DelegationKey.hpp"
 #include "delegation_sketch/DelegationSketch.hpp"
 #include "delegation_sketch/delegation_sketch_utils.hpp"
 #include "frequency_estimator/AugmentedSketch.hpp"
@@ -12,10 +13,18 @@
 #include "frequency_estimator/HeapHashMapSpaceSaving.hpp"
 #include "frequency_estimator/HeavyKeeper.hpp"
 #include "frequency_estimator/MacroPreprocessor.hpp"
+#include "frequency_estimator/SharedCuckooHeavyKeeper.hpp"
+#include "frequency_estimator/elastic_sketch/ElasticSketch.hpp"
 #include "heavy_hitter_app/AppConfig.hpp"
 
 using namespace std;
 
+#if EQUAL(KEY_TYPE, five_tuple)
+using KeyType = FiveTuple;
+#else
+using KeyType = int;
+#endif
+
 #if EQUAL(ALGORITHM, count_min)
 using FrequencyEstimatorConfig = CountMinConfig;
 using FrequencyEstimator = CountMinSketch;
@@ -25,16 +34,22 @@ using FrequencyEstimator = AugmentedSketch;
 #elif EQUAL(ALGORITHM, cuckoo_heavy_keeper)
 using FrequencyEstimatorConfig = CuckooHeavyKeeperConfig;
 using FrequencyEstimator = CuckooHeavyKeeper;
+#elif EQUAL(ALGORITHM, shared_cuckoo_heavy_keeper)
+using FrequencyEstimatorConfig = SharedCuckooHeavyKeeperConfig;
+using FrequencyEstimator = SharedCuckooHeavyKeeper;
 #elif EQUAL(ALGORITHM, heavy_keeper)
 using FrequencyEstimatorConfig = HeavyKeeperConfig;
 using FrequencyEstimator = HeavyKeeper;
+#elif EQUAL(ALGORITHM, elastic_sketch)
+using FrequencyEstimatorConfig = ElasticSketchConfig;
+using FrequencyEstimator = ElasticSketch;
 #elif EQUAL(ALGORITHM, heap_hashmap_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
 using FrequencyEstimator = HeapHashMapSpaceSavingV2;
 #endif
 
 using DelegationConfigBasedOnMode = DelegationHeavyHitterConfig;
-using MultithreadedApp = DelegationHeavyHitter<FrequencyEstimator>;
+using MultithreadedApp = DelegationHeavyHitter<FrequencyEstimator, KeyType>;
 
 // assert that parser information is consistent
 void assert_consistency(AppConfig &app_configs, DelegationConfigBasedOnMode &delegation_configs, FrequencyEstimatorConfig &frequency_estimator_configs);
@@ -84,15 +99,21 @@ int main(int argc, char **argv) {
     Relation *r1 = generate_relation(app_configs);
 
     for (int i = 0; i < app_configs.NUM_RUNS; i++) {
-        // init vector of frequency_estimator objects
-        vector<FrequencyEstimator> frequency_estimators;
-        for (int i = 0; i < app_configs.NUM_THREADS; i++) { frequency_estimators.push_back(FrequencyEstimator(frequency_estimator_configs)); }
-
         // init delegation sketch context
         atomic<bool> START_BENCHMARK = false;
         atomic<bool> START_ACCURACY_EVALUATION = false;
         DelegationSketchContext delegation_sketch_context(app_configs, delegation_configs, r1, START_BENCHMARK, START_ACCURACY_EVALUATION);
 
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+        // a single frequency_estimator updated by all threads
+        vector<FrequencyEstimator> frequency_estimators;
+        frequency_estimators.push_back(FrequencyEstimator(frequency_estimator_configs));
+#else
+        // init vector of frequency_estimator objects, each one on the NUMA node of its thread
+        vector<FrequencyEstimator> frequency_estimators =
+            construct_on_thread_cpus<FrequencyEstimator>(delegation_sketch_context, [&](int) { return FrequencyEstimator(frequency_estimator_configs); });
+#endif
+
         // print important configs
         string log_output_path = create_file_path_from_context(delegation_sketch_context, "_log");
 
@@ -118,7 +139,7 @@ int main(int argc, char **argv) {
         print(frequency_estimator_configs);
 
         // start threads
-        MultithreadedApp *delegation_sketch = start_threads<FrequencyEstimator>(delegation_sketch_context, frequency_estimators);
+        MultithreadedApp *delegation_sketch = start_threads<FrequencyEstimator, KeyType>(delegation_sketch_context, frequency_estimators);
 
         // replace _log with _delegation
         size_t pos = log_output_path.find("_log");
@@ -130,7 +151,7 @@ int main(int argc, char **argv) {
 
         // print stats
         print_stats_for_delegation_sketch(delegation_sketch_context, delegation_sketch, delegation_output_file_path);
-        print_stats_for_heavy_hitters<FrequencyEstimator, int>(delegation_sketch_context, delegation_sketch, heavyhitter_output_file_path);
+        print_stats_for_heavy_hitters<FrequencyEstimator, KeyType>(delegation_sketch_context, delegation_sketch, heavyhitter_output_file_path);
     }
 
     return 0;
@@ -3,6 +3,7 @@
 #include "delegation_sketch/DelegationBuildConfig.hpp"
 #include "delegation_sketch/DelegationConfig.hpp"
 #include "delegation_sketch/DelegationHeavyHitter.hpp"
+#include "delegation_sketch/DelegationKey.hpp"
 #include "delegation_sketch/DelegationSketch.hpp"
 #include "delegation_sketch/delegation_sketch_utils.hpp"
 #include "frequency_estimator/AugmentedSketch.hpp"
@@ -13,34 +14,50 @@
 #include "frequency_estimator/HeavyKeeper.hpp"
 #include "frequency_estimator/MacroPreprocessor.hpp"
 #include "frequency_estimator/SequentialHeavyHitterWrapperForParallel.hpp"
+#include "frequency_estimator/StreamSummarySpaceSaving.hpp"
+#include "frequency_estimator/elastic_sketch/ElasticSketch.hpp"
 #include "heavy_hitter_app/AppConfig.hpp"
 
 using namespace std;
 
+#if EQUAL(KEY_TYPE, five_tuple)
+using KeyType = FiveTuple;
+#else
+using KeyType = int;
+#endif
+
 #if EQUAL(ALGORITHM, count_min)
 using FrequencyEstimatorConfig = CountMinConfig;
 using FrequencyEstimator = CountMinSketch;
-using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<CountMinSketch, int>;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<CountMinSketch, estimator_key_t<KeyType>>;
 #elif EQUAL(ALGORITHM, augmented_sketch)
 using FrequencyEstimatorConfig = AugmentedSketchConfig;
 using FrequencyEstimator = AugmentedSketch;
-using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<AugmentedSketch, int>;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<AugmentedSketch, estimator_key_t<KeyType>>;
 #elif EQUAL(ALGORITHM, cuckoo_heavy_keeper)
 using FrequencyEstimatorConfig = CuckooHeavyKeeperConfig;
 using FrequencyEstimator = CuckooHeavyKeeper;
-using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<CuckooHeavyKeeper, int>;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<CuckooHeavyKeeper, estimator_key_t<KeyType>>;
 #elif EQUAL(ALGORITHM, heavy_keeper)
 using FrequencyEstimatorConfig = HeavyKeeperConfig;
 using FrequencyEstimator = HeavyKeeper;
-using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<HeavyKeeper, int>;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<HeavyKeeper, estimator_key_t<KeyType>>;
+#elif EQUAL(ALGORITHM, elastic_sketch)
+using FrequencyEstimatorConfig = ElasticSketchConfig;
+using FrequencyEstimator = ElasticSketch;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<ElasticSketch, estimator_key_t<KeyType>>;
 #elif EQUAL(ALGORITHM, heap_hashmap_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
 using FrequencyEstimator = HeapHashMapSpaceSavingV2;
-using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<HeapHashMapSpaceSavingV2, int>;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<HeapHashMapSpaceSavingV2, estimator_key_t<KeyType>>;
+#elif EQUAL(ALGORITHM, stream_summary_space_saving)
+using FrequencyEstimatorConfig = StreamSummarySpaceSavingConfig;
+using FrequencyEstimator = StreamSummarySpaceSaving;
+using HeavyHitterTracker = SequentialHeavyHitterWrapperForParallel<StreamSummarySpaceSaving, estimator_key_t<KeyType>>;
 #endif
 
 using DelegationConfigBasedOnMode = DelegationHeavyHitterConfig;
-using MultithreadedApp = DelegationHeavyHitter<HeavyHitterTracker>;
+using MultithreadedApp = DelegationHeavyHitter<HeavyHitterTracker, KeyType>;
 
 // assert that parser information is consistent
 void assert_consistency(AppConfig &app_configs, DelegationConfigBasedOnMode &delegation_configs, FrequencyEstimatorConfig &frequency_estimator_configs);
@@ -90,17 +107,17 @@ int main(int argc, char **argv) {
     Relation *r1 = generate_relation(app_configs);
 
     for (int i = 0; i < app_configs.NUM_RUNS; i++) {
-        // init vector of frequency_estimator objects
-        vector<HeavyHitterTracker> frequency_estimators;
-        vector<FrequencyEstimator> tmp_frequency_estimators;
-        for (int i = 0; i < app_configs.NUM_THREADS; i++) { tmp_frequency_estimators.push_back(FrequencyEstimator(frequency_estimator_configs)); }
-        for (int i = 0; i < app_configs.NUM_THREADS; i++) { frequency_estimators.push_back(HeavyHitterTracker(tmp_frequency_estimators[i], app_configs.THETA)); }
-
         // init delegation sketch context
         atomic<bool> START_BENCHMARK = false;
         atomic<bool> START_ACCURACY_EVALUATION = false;
         DelegationSketchContext delegation_sketch_context(app_configs, delegation_configs, r1, START_BENCHMARK, START_ACCURACY_EVALUATION);
 
+        // init vector of frequency_estimator objects, each one on the NUMA node of its thread
+        vector<FrequencyEstimator> tmp_frequency_estimators =
+            construct_on_thread_cpus<FrequencyEstimator>(delegation_sketch_context, [&](int) { return FrequencyEstimator(frequency_estimator_configs); });
+        vector<HeavyHitterTracker> frequency_estimators = construct_on_thread_cpus<HeavyHitterTracker>(
+            delegation_sketch_context, [&](int i) { return HeavyHitterTracker(tmp_frequency_estimators[i], app_configs.THETA); });
+
         // print important configs
         string log_output_path = create_file_path_from_context(delegation_sketch_context, "_log");
 
@@ -126,7 +143,7 @@ int main(int argc, char **argv) {
         print(frequency_estimator_configs);
 
         // start threads
-        MultithreadedApp *delegation_sketch = start_threads<HeavyHitterTracker>(delegation_sketch_context, frequency_estimators);
+        MultithreadedApp *delegation_sketch = start_threads<HeavyHitterTracker, KeyType>(delegation_sketch_context, frequency_estimators);
 
         // replace _log with _delegation
         size_t pos = log_output_path.find("_log");
@@ -138,7 +155,7 @@ int main(int argc, char **argv) {
 
         // print stats
         print_stats_for_delegation_sketch(delegation_sketch_context, delegation_sketch, delegation_output_file_path);
-        print_stats_for_heavy_hitters<HeavyHitterTracker, int>(delegation_sketch_context, delegation_sketch, heavyhitter_output_file_path);
+        print_stats_for_heavy_hitters<HeavyHitterTracker, KeyType>(delegation_sketch_context, delegation_sketch, heavyhitter_output_file_path);
     }
 
     return 0;
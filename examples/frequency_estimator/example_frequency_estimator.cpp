@@ -26,11 +26,14 @@ using FrequencyEstimator = CuckooHeavyKeeper;
 #elif EQUAL(ALGORITHM, heavy_keeper)
 using FrequencyEstimatorConfig = HeavyKeeperConfig;
 using FrequencyEstimator = HeavyKeeper;
+#elif EQUAL(ALGORITHM, elastic_sketch)
+using FrequencyEstimatorConfig = ElasticSketchConfig;
+using FrequencyEstimator = ElasticSketch;
 #elif EQUAL(ALGORITHM, simple_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
 using FrequencyEstimator = SpaceSaving;
 #elif EQUAL(ALGORITHM, stream_summary_space_saving)
-using FrequencyEstimatorConfig = SpaceSavingConfig;
+using FrequencyEstimatorConfig = StreamSummarySpaceSavingConfig;
 using FrequencyEstimator = StreamSummarySpaceSaving;
 #elif EQUAL(ALGORITHM, heap_hashmap_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
@@ -41,6 +44,9 @@ using FrequencyEstimator = WeightedFrequent;
 #elif EQUAL(ALGORITHM, optimized_weighted_frequent)
 using FrequencyEstimatorConfig = OptimizedWeightedFrequentConfig;
 using FrequencyEstimator = OptimizedWeightedFrequent;
+#elif EQUAL(ALGORITHM, misra_gries)
+using FrequencyEstimatorConfig = MisraGriesConfig;
+using FrequencyEstimator = MisraGries;
 #else
 #endif
 
@@ -25,14 +25,20 @@ using FrequencyEstimator = AugmentedSketch;
 #elif EQUAL(ALGORITHM, cuckoo_heavy_keeper)
 using FrequencyEstimatorConfig = CuckooHeavyKeeperConfig;
 using FrequencyEstimator = CuckooHeavyKeeper;
+#elif EQUAL(ALGORITHM, windowed_cuckoo_heavy_keeper)
+using FrequencyEstimatorConfig = WindowedCuckooHeavyKeeperConfig;
+using FrequencyEstimator = WindowedCuckooHeavyKeeper;
 #elif EQUAL(ALGORITHM, heavy_keeper)
 using FrequencyEstimatorConfig = HeavyKeeperConfig;
 using FrequencyEstimator = HeavyKeeper;
+#elif EQUAL(ALGORITHM, elastic_sketch)
+using FrequencyEstimatorConfig = ElasticSketchConfig;
+using FrequencyEstimator = ElasticSketch;
 #elif EQUAL(ALGORITHM, simple_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
 using FrequencyEstimator = SpaceSaving;
 #elif EQUAL(ALGORITHM, stream_summary_space_saving)
-using FrequencyEstimatorConfig = SpaceSavingConfig;
+using FrequencyEstimatorConfig = StreamSummarySpaceSavingConfig;
 using FrequencyEstimator = StreamSummarySpaceSaving;
 #elif EQUAL(ALGORITHM, heap_hashmap_space_saving)
 using FrequencyEstimatorConfig = SpaceSavingConfig;
@@ -43,6 +49,9 @@ using FrequencyEstimator = WeightedFrequent;
 #elif EQUAL(ALGORITHM, optimized_weighted_frequent)
 using FrequencyEstimatorConfig = OptimizedWeightedFrequentConfig;
 using FrequencyEstimator = OptimizedWeightedFrequent;
+#elif EQUAL(ALGORITHM, misra_gries)
+using FrequencyEstimatorConfig = MisraGriesConfig;
+using FrequencyEstimator = MisraGries;
 #else
 #endif
 
@@ -7,12 +7,21 @@
 #include <iostream>
 using namespace std;
 
+#if EQUAL(KEY_TYPE, five_tuple)
+using KeyType = FiveTuple;
+#else
+using KeyType = int;
+#endif
+
 #if EQUAL(ALGORITHM, weighted_frequent)
 using FrequencyEstimatorConfig = WeightedFrequentConfig;
 using FrequencyEstimator = WeightedFrequent;
 #elif EQUAL(ALGORITHM, optimized_weighted_frequent)
 using FrequencyEstimatorConfig = OptimizedWeightedFrequentConfig;
 using FrequencyEstimator = OptimizedWeightedFrequent;
+#elif EQUAL(ALGORITHM, misra_gries)
+using FrequencyEstimatorConfig = MisraGriesConfig;
+using FrequencyEstimator = MisraGries;
 #else
 #endif
 
@@ -50,9 +59,10 @@ int main(int argc, char **argv) {
     // print the configs
     cout << frequency_estimator_configs;
     cout << app_configs;
+    cout << prif_configs;
 
     // run the test
-    test<FrequencyEstimatorConfig>(app_configs, prif_configs, frequency_estimator_configs);
+    test<FrequencyEstimatorConfig, KeyType>(app_configs, prif_configs, frequency_estimator_configs);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "frequency_estimator/CountMinSketch.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Constants
+const int NUM_KEYS = 1 << 20;         // key universe
+const int NUM_UPDATES = 4'000'000;    // updates per run
+const int NUM_RUNS = 5;               // best of
+const double ZIPF = 1.2;              // skew of the key stream
+// (width, depth): the default of countmin.width/depth (4 KiB, in L1), the sketch of the runs below (16 KiB) and one past the last
+// level cache (64 MiB)
+const std::vector<std::pair<unsigned int, unsigned int>> SHAPES = {{128, 8}, {1024, 4}, {1 << 22, 4}};
+const double THETA = 0.0005;          // heavy hitters the ARE is taken over
+
+// the CountMinSketch before the flat layout: one array per row and one pairwise hash (mod a prime, mod the width) per row
+class RowArrayCountMinSketch {
+  public:
+    static constexpr long LONG_PRIME = 2147483647;
+
+    RowArrayCountMinSketch(unsigned int width, unsigned int depth) : width(width), depth(depth), C(depth, std::vector<int>(width)), hashes(depth) {
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<long> dis(1, LONG_PRIME);
+        for (auto &hash : hashes) { hash = {dis(gen), dis(gen)}; }
+    }
+
+    unsigned int update_and_estimate(const int &item, int c = 1) {
+        int minval = std::numeric_limits<int>::max();
+        for (unsigned int i = 0; i < depth; i++) {
+            unsigned int hashval = (hashes[i].first * item + hashes[i].second) % LONG_PRIME % width;
+            C[i][hashval] += c;
+            minval = std::min(minval, C[i][hashval]);
+        }
+        return minval;
+    }
+
+    unsigned int estimate(const int &item) {
+        int minval = std::numeric_limits<int>::max();
+        for (unsigned int i = 0; i < depth; i++) { minval = std::min(minval, C[i][(hashes[i].first * item + hashes[i].second) % LONG_PRIME % width]); }
+        return minval;
+    }
+
+  private:
+    unsigned int width, depth;
+    std::vector<std::vector<int>> C;
+    std::vector<std::pair<long, long>> hashes;
+};
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// The layout of CountMinSketch and a blocked one, written the same way (inline, scalar) so that only the layout differs.
+// Row-major: the column of row i is (h1 + i * h2) & (width - 1), the counters of a key are width apart.
+// Blocked: the counters of a key share one 64-byte block of 16, row i takes one of the 16 / depth counters of its part of the block.
+// A row has width counters either way, but two keys in the same block collide in all rows far more often than in independent rows.
+template <bool BLOCKED> class LayoutCountMinSketch {
+  public:
+    LayoutCountMinSketch(unsigned int width, unsigned int depth, bool conservative_update)
+        : width(width), depth(depth), column_bits(std::countr_zero(16 / depth)), conservative_update(conservative_update), C(size_t(width) * depth) {}
+
+    unsigned int update_and_estimate(const int &item, int c = 1) {
+        uint32_t offsets[32];
+        this->offsets(item, offsets);
+        int minval = std::numeric_limits<int>::max();
+        if (conservative_update) {
+            for (unsigned int i = 0; i < depth; i++) { minval = std::min(minval, C[offsets[i]]); }
+            minval += c;
+            for (unsigned int i = 0; i < depth; i++) { C[offsets[i]] = std::max(C[offsets[i]], minval); }
+            return minval;
+        }
+        for (unsigned int i = 0; i < depth; i++) {
+            C[offsets[i]] += c;
+            minval = std::min(minval, C[offsets[i]]);
+        }
+        return minval;
+    }
+
+    unsigned int estimate(const int &item) {
+        uint32_t offsets[32];
+        this->offsets(item, offsets);
+        int minval = std::numeric_limits<int>::max();
+        for (unsigned int i = 0; i < depth; i++) { minval = std::min(minval, C[offsets[i]]); }
+        return minval;
+    }
+
+  private:
+    unsigned int width, depth, column_bits;
+    bool conservative_update;
+    std::vector<int> C;
+
+    void offsets(int item, uint32_t *offsets) const {
+        uint64_t hash = mix64(uint32_t(item));
+        uint32_t h1 = uint32_t(hash), h2 = uint32_t(hash >> 32);
+        if constexpr (BLOCKED) {
+            uint32_t block_start = (h1 & (uint32_t(C.size() / 16) - 1)) * 16;
+            for (unsigned int i = 0; i < depth; i++) { offsets[i] = block_start + (i << column_bits) + ((h2 >> (i * column_bits)) & ((1u << column_bits) - 1)); }
+        } else {
+            for (unsigned int i = 0; i < depth; i++) { offsets[i] = i * width + ((h1 + i * (h2 | 1)) & (width - 1)); }
+        }
+    }
+};
+
+// Zipf keys drawn up front, so the runs time the sketch calls only
+std::vector<int> generate_keys() {
+    std::vector<double> cdf(NUM_KEYS);
+    double sum = 0;
+    for (int i = 0; i < NUM_KEYS; ++i) { cdf[i] = sum += 1.0 / std::pow(i + 1, ZIPF); }
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dis(0.0, sum);
+    std::vector<int> keys(NUM_UPDATES);
+    for (auto &key : keys) { key = std::lower_bound(cdf.begin(), cdf.end(), dis(gen)) - cdf.begin(); }
+    return keys;
+}
+
+// best time of NUM_RUNS runs in ns per update_and_estimate, and the ARE over the heavy hitters of the last run
+template <typename Sketch, typename Make> void measure(const std::string &name, const std::vector<int> &keys, const std::map<int, int> &heavy_hitters, Make make) {
+    double best = 1e30;
+    unsigned long checksum = 0;
+    double are = 0;
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        Sketch sketch = make();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int key : keys) { checksum += sketch.update_and_estimate(key, 1); }
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / keys.size());
+
+        are = 0;
+        for (auto &[key, count] : heavy_hitters) { are += std::abs(double(sketch.estimate(key)) - count) / count; }
+        are /= heavy_hitters.size();
+    }
+    if (checksum == 0) { std::cout << "(empty sketch)\n"; }
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2) << std::setw(10) << best << " ns" << std::setw(12)
+              << std::setprecision(4) << are << "\n";
+}
+
+int main() {
+    std::vector<int> keys = generate_keys();
+    std::map<int, int> exact_counter;
+    for (int key : keys) { exact_counter[key]++; }
+    std::map<int, int> heavy_hitters;
+    for (auto &[key, count] : exact_counter) {
+        if (count >= THETA * NUM_UPDATES) { heavy_hitters[key] = count; }
+    }
+
+    std::cout << "Updates: " << NUM_UPDATES << ", keys: " << NUM_KEYS << ", Zipf " << ZIPF << ", best of " << NUM_RUNS << " runs, ARE over "
+              << heavy_hitters.size() << " keys >= " << THETA << " N\n";
+    for (auto [width, depth] : SHAPES) {
+        std::cout << "\n" << width << "x" << depth << "\n";
+        std::cout << std::left << std::setw(28) << "Sketch" << std::right << std::setw(13) << "update" << std::setw(12) << "ARE" << "\n";
+        measure<RowArrayCountMinSketch>("row arrays, hash per row", keys, heavy_hitters, [=] { return RowArrayCountMinSketch(width, depth); });
+        measure<CountMinSketch>("flat, hashed once", keys, heavy_hitters, [=] { return CountMinSketch(width, depth); });
+        measure<CountMinSketch>("flat, conservative update", keys, heavy_hitters, [=] { return CountMinSketch(width, depth, true); });
+        measure<LayoutCountMinSketch<false>>("inline row-major", keys, heavy_hitters, [=] { return LayoutCountMinSketch<false>(width, depth, false); });
+        measure<LayoutCountMinSketch<true>>("inline blocked", keys, heavy_hitters, [=] { return LayoutCountMinSketch<true>(width, depth, false); });
+        measure<LayoutCountMinSketch<false>>("inline row-major, cons.", keys, heavy_hitters, [=] { return LayoutCountMinSketch<false>(width, depth, true); });
+        measure<LayoutCountMinSketch<true>>("inline blocked, cons.", keys, heavy_hitters, [=] { return LayoutCountMinSketch<true>(width, depth, true); });
+    }
+    return 0;
+}
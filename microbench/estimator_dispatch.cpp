@@ -0,0 +1,93 @@
+#include "frequency_estimator/AnyFrequencyEstimator.hpp"
+#include "frequency_estimator/CountMinSketch.hpp"
+#include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include "frequency_estimator/HeavyKeeper.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Constants
+const int NUM_KEYS = 1 << 20;          // key universe
+const int NUM_UPDATES = 20'000'000;    // updates per run
+const int NUM_RUNS = 5;                // best of
+const double ZIPF = 1.1;               // skew of the key stream
+
+// Zipf keys drawn up front, so the runs time the estimator calls only
+std::vector<int> generate_keys() {
+    std::vector<double> cdf(NUM_KEYS);
+    double sum = 0;
+    for (int i = 0; i < NUM_KEYS; ++i) { cdf[i] = sum += 1.0 / std::pow(i + 1, ZIPF); }
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> dis(0.0, sum);
+    std::vector<int> keys(NUM_UPDATES);
+    for (auto &key : keys) { key = std::lower_bound(cdf.begin(), cdf.end(), dis(gen)) - cdf.begin(); }
+    return keys;
+}
+
+// exact counts of the key universe, inline and next to free, so its row isolates the cost of the call itself
+class ArrayCounter : public FrequencyEstimatorBase<ArrayCounter> {
+  public:
+    ArrayCounter() : counts(NUM_KEYS) {}
+
+    void print_status() {}
+    void update(const int &item, int c = 1) { counts[item] += c; }
+    void update(const std::string &item, int c = 1) { update(std::stoi(item), c); }
+    unsigned int estimate(const int &item) { return counts[item]; }
+    unsigned int estimate(const std::string &item) { return estimate(std::stoi(item)); }
+    unsigned int update_and_estimate(const int &item, int c = 1) { return counts[item] += c; }
+    unsigned int update_and_estimate(const std::string &item, int c = 1) { return update_and_estimate(std::stoi(item), c); }
+
+  private:
+    std::vector<unsigned int> counts;
+};
+
+// the call pattern of the heavy-hitter wrappers: the estimator is a template parameter held by reference
+template <typename Estimator> struct Wrapper {
+    Estimator &estimator;
+    unsigned long heavy = 0;
+
+    void update(int key) {
+        if (estimator.update_and_estimate(key, 1) > 1000) { ++heavy; }
+    }
+};
+
+// best time of NUM_RUNS runs in ns per update, a fresh estimator per run
+template <typename Estimator, typename Make> double time_updates(const std::vector<int> &keys, Make &&make) {
+    double best = 1e30;
+    unsigned long checksum = 0;
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        Estimator estimator = make();
+        Wrapper<Estimator> wrapper{estimator};
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int key : keys) { wrapper.update(key); }
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / keys.size());
+        checksum += wrapper.heavy;
+    }
+    if (checksum == 0) { std::cout << "(no heavy updates)\n"; }
+    return best;
+}
+
+template <typename Estimator, typename Make> void compare(const std::string &name, const std::vector<int> &keys, Make make) {
+    double direct = time_updates<Estimator>(keys, make);
+    double erased = time_updates<AnyFrequencyEstimator>(keys, [&] { return AnyFrequencyEstimator(make()); });
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2) << std::setw(10) << direct << " ns"
+              << std::setw(10) << erased << " ns" << std::setw(10) << erased / direct << "x\n";
+}
+
+int main() {
+    std::vector<int> keys = generate_keys();
+    std::cout << "Updates: " << NUM_UPDATES << ", keys: " << NUM_KEYS << ", Zipf " << ZIPF << ", best of " << NUM_RUNS << " runs\n\n";
+    std::cout << std::left << std::setw(20) << "Estimator" << std::right << std::setw(13) << "direct" << std::setw(13) << "type-erased"
+              << std::setw(11) << "ratio" << "\n";
+    compare<ArrayCounter>("ArrayCounter", keys, [] { return ArrayCounter(); });
+    compare<CountMinSketch>("CountMinSketch", keys, [] { return CountMinSketch(1024u, 4u); });
+    compare<HeavyKeeper>("HeavyKeeper", keys, [] { return HeavyKeeper(1024); });
+    compare<CuckooHeavyKeeper>("CuckooHeavyKeeper", keys, [] { return CuckooHeavyKeeper(256); });
+    return 0;
+}
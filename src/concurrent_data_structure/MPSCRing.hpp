@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <semaphore>
+#include <thread>
+
+// Bounded lock-free multi-producer single-consumer ring.
+// Producers reserve k consecutive slots with a single fetch_add on the tail and publish each slot through its sequence
+// number; the consumer drains ready slots in batches. The semaphore is only touched when the consumer parks on an empty ring.
+template <typename T> class MPSCRing {
+  private:
+    struct alignas(64) Slot {
+        std::atomic<unsigned long> sequence;
+        T data;
+    };
+
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    alignas(64) std::atomic<unsigned long> tail;
+    alignas(64) std::atomic<unsigned long> head;   // only written by the consumer
+    alignas(64) std::atomic<bool> consumer_parked;
+    std::binary_semaphore wakeup;
+
+    static size_t round_up_to_power_of_two(size_t n) {
+        size_t power = 1;
+        while (power < n) { power <<= 1; }
+        return power;
+    }
+
+    void wake_consumer() {
+        // orders the preceding publication before reading the flag, pairs with the fence in wait_until_not_empty
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_parked.load(std::memory_order_relaxed) && consumer_parked.exchange(false, std::memory_order_seq_cst)) { wakeup.release(); }
+    }
+
+  public:
+    MPSCRing(size_t min_capacity)
+        : capacity(round_up_to_power_of_two(min_capacity)), mask(capacity - 1), slots(new Slot[capacity]), tail(0), head(0), consumer_parked(false), wakeup(0) {
+        for (size_t i = 0; i < capacity; i++) { slots[i].sequence.store(i, std::memory_order_relaxed); }
+    }
+
+    size_t get_capacity() const { return capacity; }
+
+    // number of published or reserved slots not yet consumed, approximate while producers run
+    size_t size_approx() const { return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed); }
+
+    // running totals of reserved and consumed slots, their deltas give arrival and drain rates
+    unsigned long produced() const { return tail.load(std::memory_order_relaxed); }
+    unsigned long consumed() const { return head.load(std::memory_order_relaxed); }
+
+    // reserve count slots at once, blocks (spinning) while the consumer has not freed them yet
+    template <typename Iterator> void enqueue_batch(Iterator first, size_t count) {
+        unsigned long position = tail.fetch_add(count, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++, ++first) {
+            Slot &slot = slots[(position + i) & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != position + i) {
+                // the ring is full, the consumer must not stay parked on what this batch has published so far
+                wake_consumer();
+                while (slot.sequence.load(std::memory_order_acquire) != position + i) { std::this_thread::yield(); }
+            }
+            slot.data = std::move(*first);
+            slot.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        wake_consumer();
+    }
+
+    void enqueue(T item) { enqueue_batch(&item, 1); }
+
+    // move up to max_count ready items into out, returns how many were taken
+    template <typename OutputIterator> size_t dequeue_batch(OutputIterator out, size_t max_count) {
+        unsigned long position = head.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (count < max_count) {
+            Slot &slot = slots[position & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) { break; }
+            *out++ = std::move(slot.data);
+            slot.sequence.store(position + capacity, std::memory_order_release);
+            position++;
+            count++;
+        }
+        head.store(position, std::memory_order_relaxed);
+        return count;
+    }
+
+    bool is_empty() const {
+        unsigned long position = head.load(std::memory_order_relaxed);
+        return slots[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    // spin for a while, then park until a producer publishes
+    void wait_until_not_empty(int spin_rounds = 1024) {
+        for (int i = 0; i < spin_rounds; i++) {
+            if (!is_empty()) { return; }
+        }
+        while (is_empty()) {
+            consumer_parked.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!is_empty()) {
+                // a producer that already saw the flag owes us a release, consume it
+                if (!consumer_parked.exchange(false, std::memory_order_seq_cst)) { wakeup.acquire(); }
+                return;
+            }
+            wakeup.acquire();
+        }
+    }
+};
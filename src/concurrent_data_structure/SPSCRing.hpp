@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+// Bounded lock-free single-producer single-consumer ring.
+// Each side owns one index and keeps a cached copy of the other one, so the shared indices are only read when the cached
+// copy says the ring is full (producer) or empty (consumer). Neither side ever blocks: try_enqueue and try_dequeue fail
+// instead, and the caller decides whether to spin, do other work or try another ring.
+template <typename T> class SPSCRing {
+  private:
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<T[]> slots;
+
+    alignas(64) std::atomic<unsigned long> tail;   // only written by the producer
+    unsigned long cached_head = 0;
+    alignas(64) std::atomic<unsigned long> head;   // only written by the consumer
+    unsigned long cached_tail = 0;
+
+    static size_t round_up_to_power_of_two(size_t n) {
+        size_t power = 1;
+        while (power < n) { power <<= 1; }
+        return power;
+    }
+
+  public:
+    SPSCRing(size_t min_capacity) : capacity(round_up_to_power_of_two(min_capacity)), mask(capacity - 1), slots(new T[capacity]), tail(0), head(0) {}
+
+    size_t get_capacity() const { return capacity; }
+
+    // number of items not yet consumed, approximate while both sides run
+    size_t size_approx() const { return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed); }
+
+    // running totals of enqueued and dequeued items
+    unsigned long produced() const { return tail.load(std::memory_order_relaxed); }
+    unsigned long consumed() const { return head.load(std::memory_order_relaxed); }
+
+    // producer side, false if the ring is full
+    bool try_enqueue(T item) {
+        unsigned long position = tail.load(std::memory_order_relaxed);
+        if (position - cached_head == capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (position - cached_head == capacity) { return false; }
+        }
+        slots[position & mask] = std::move(item);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, false if the ring is empty
+    bool try_dequeue(T &item) {
+        unsigned long position = head.load(std::memory_order_relaxed);
+        if (position == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (position == cached_tail) { return false; }
+        }
+        item = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+};
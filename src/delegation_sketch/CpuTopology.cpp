@@ -0,0 +1,168 @@
+#include "CpuTopology.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+int read_int_from_file(const string &path, int default_value) {
+    std::ifstream in_file(path);
+    int value;
+    if (in_file >> value) { return value; }
+    return default_value;
+}
+
+// parse cpu lists such as "0-3,8-11"
+vector<int> read_cpu_list(const string &path) {
+    vector<int> cpus;
+    std::ifstream in_file(path);
+    string list;
+    if (!(in_file >> list)) { return cpus; }
+
+    std::stringstream ss(list);
+    string range;
+    while (std::getline(ss, range, ',')) {
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+int read_node_of_cpu(const string &cpu_path) {
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(cpu_path, ec)) {
+        string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::all_of(name.begin() + 4, name.end(), ::isdigit)) { return std::stoi(name.substr(4)); }
+    }
+    return 0;
+}
+
+}   // namespace
+
+vector<CpuTopologyEntry> read_cpu_topology(const string &sysfs_cpu_path) {
+    vector<int> online_cpus = read_cpu_list(sysfs_cpu_path + "/online");
+    if (online_cpus.empty()) {
+        // no sysfs, assume a single node without SMT
+        for (int cpu = 0; cpu < (int) std::thread::hardware_concurrency(); cpu++) { online_cpus.push_back(cpu); }
+    }
+
+    vector<CpuTopologyEntry> topology;
+    for (int cpu : online_cpus) {
+        string cpu_path = sysfs_cpu_path + "/cpu" + std::to_string(cpu);
+        int core_id = read_int_from_file(cpu_path + "/topology/core_id", cpu);
+        int package_id = read_int_from_file(cpu_path + "/topology/physical_package_id", 0);
+        topology.push_back({cpu, core_id, package_id, read_node_of_cpu(cpu_path), 0});
+    }
+
+    // number the hardware threads of each physical core in cpu order
+    std::map<std::pair<int, int>, int> threads_per_core;
+    for (auto &entry : topology) { entry.smt_index = threads_per_core[{entry.package_id, entry.core_id}]++; }
+
+    return topology;
+}
+
+ThreadPlacement ThreadPlacement::compute(const string &policy, int num_threads, const vector<CpuTopologyEntry> &topology) {
+    ThreadPlacement placement;
+    placement.cpus.resize(num_threads);
+    placement.nodes.resize(num_threads);
+
+    // nodes are renumbered densely so that they can index per-node arrays
+    vector<int> node_ids;
+    for (const auto &entry : topology) { node_ids.push_back(entry.node); }
+    std::sort(node_ids.begin(), node_ids.end());
+    node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+    if (node_ids.empty()) { node_ids.push_back(0); }
+    placement.num_nodes = node_ids.size();
+    auto dense_node = [&node_ids](int node) { return int(std::lower_bound(node_ids.begin(), node_ids.end(), node) - node_ids.begin()); };
+
+    std::map<int, int> node_of_cpu;
+    for (const auto &entry : topology) { node_of_cpu[entry.cpu] = dense_node(entry.node); }
+
+    if (policy == "sequential") {
+        for (int i = 0; i < num_threads; i++) {
+            placement.cpus[i] = i + 2;
+            placement.nodes[i] = node_of_cpu.count(i + 2) ? node_of_cpu[i + 2] : 0;
+        }
+        placement.group_threads_by_node();
+        return placement;
+    }
+
+    // keep cpu 0 (main) and cpu 1 (accuracy evaluator) free as long as there are enough cpus left
+    vector<CpuTopologyEntry> cpus;
+    for (const auto &entry : topology) {
+        if (topology.size() >= static_cast<size_t>(num_threads) + 2 && entry.cpu < 2) { continue; }
+        cpus.push_back(entry);
+    }
+    if (cpus.empty()) {
+        std::cerr << "No cpu available for thread placement" << std::endl;
+        exit(1);
+    }
+
+    auto compact_order = [](const CpuTopologyEntry &a, const CpuTopologyEntry &b) {
+        return std::tie(a.node, a.package_id, a.core_id, a.smt_index) < std::tie(b.node, b.package_id, b.core_id, b.smt_index);
+    };
+    auto physical_cores_first_order = [](const CpuTopologyEntry &a, const CpuTopologyEntry &b) {
+        return std::tie(a.smt_index, a.node, a.package_id, a.core_id) < std::tie(b.smt_index, b.node, b.package_id, b.core_id);
+    };
+
+    // per node, physical cores first
+    vector<vector<CpuTopologyEntry>> cpus_per_node(placement.num_nodes);
+    for (const auto &entry : cpus) { cpus_per_node[dense_node(entry.node)].push_back(entry); }
+    for (auto &node_cpus : cpus_per_node) { std::sort(node_cpus.begin(), node_cpus.end(), physical_cores_first_order); }
+    // a node may have all its cpus reserved, drop it from the rotation
+    std::erase_if(cpus_per_node, [](const auto &node_cpus) { return node_cpus.empty(); });
+
+    vector<CpuTopologyEntry> order;
+    if (policy == "compact") {
+        order = cpus;
+        std::sort(order.begin(), order.end(), compact_order);
+    } else if (policy == "core") {
+        order = cpus;
+        std::sort(order.begin(), order.end(), physical_cores_first_order);
+    } else if (policy == "scatter") {
+        for (size_t k = 0; order.size() < cpus.size(); k++) {
+            for (const auto &node_cpus : cpus_per_node) {
+                if (k < node_cpus.size()) { order.push_back(node_cpus[k]); }
+            }
+        }
+    } else if (policy == "numa") {
+        int num_used_nodes = cpus_per_node.size();
+        for (int i = 0; i < num_threads; i++) {
+            long k = (long) i * num_used_nodes / num_threads;
+            long first_thread_of_node = (k * num_threads + num_used_nodes - 1) / num_used_nodes;
+            const auto &node_cpus = cpus_per_node[k];
+            order.push_back(node_cpus[(i - first_thread_of_node) % node_cpus.size()]);
+        }
+    } else {
+        std::cerr << "Invalid placement policy: " << policy << " (sequential/compact/scatter/core/numa)" << std::endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        const auto &entry = order[i % order.size()];
+        placement.cpus[i] = entry.cpu;
+        placement.nodes[i] = dense_node(entry.node);
+    }
+    placement.group_threads_by_node();
+    return placement;
+}
+
+void ThreadPlacement::group_threads_by_node() {
+    threads_per_node.assign(num_nodes, vector<int>());
+    for (int i = 0; i < (int) nodes.size(); i++) { threads_per_node[nodes[i]].push_back(i); }
+}
+
+int ThreadPlacement::relay_of(int owner, int node) const {
+    if (nodes[owner] == node) { return owner; }
+    const auto &owner_node_threads = threads_per_node[nodes[owner]];
+    const auto &node_threads = threads_per_node[node];
+    int owner_rank = std::find(owner_node_threads.begin(), owner_node_threads.end(), owner) - owner_node_threads.begin();
+    return node_threads[owner_rank % node_threads.size()];
+}
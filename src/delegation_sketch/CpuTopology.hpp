@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "delegation_sketch/delegation_sketch_utils.hpp"
+
+using std::string, std::vector;
+
+// one online logical cpu as described by /sys/devices/system/cpu
+struct CpuTopologyEntry {
+    int cpu;
+    int core_id;
+    int package_id;
+    int node;
+    int smt_index;   // 0 for the first hardware thread of a physical core, 1 for its sibling, ...
+};
+
+vector<CpuTopologyEntry> read_cpu_topology(const string &sysfs_cpu_path = "/sys/devices/system/cpu");
+
+// cpu and NUMA node assigned to every delegation thread
+struct ThreadPlacement {
+    vector<int> cpus;
+    vector<int> nodes;
+    vector<vector<int>> threads_per_node;   // thread ids placed on each node, in increasing order
+    int num_nodes = 1;
+
+    // thread of node that aggregates the keys of owner before they cross the interconnect (owners of node relay for themselves)
+    int relay_of(int owner, int node) const;
+
+    // placement policies:
+    //   sequential - thread i on cpu i + 2 (cpu 0 runs main, cpu 1 the accuracy evaluator)
+    //   compact    - fill the SMT siblings of a core, then the cores of a node, then the next node
+    //   scatter    - round-robin over NUMA nodes, physical cores before SMT siblings
+    //   core       - one thread per physical core, SMT siblings only once all cores are used
+    //   numa       - contiguous, equally sized blocks of thread ids per NUMA node
+    static ThreadPlacement compute(const string &policy, int num_threads, const vector<CpuTopologyEntry> &topology);
+    static ThreadPlacement compute(const string &policy, int num_threads) { return compute(policy, num_threads, read_cpu_topology()); }
+
+  private:
+    void group_threads_by_node();
+};
+
+// run f on a thread pinned to cpu, so that whatever f allocates and touches first lands on that cpu's NUMA node
+template <typename F> void run_on_cpu(int cpu, F &&f) {
+    std::thread worker([cpu, &f]() {
+        setaffinity_oncpu(cpu);
+        f();
+    });
+    worker.join();
+}
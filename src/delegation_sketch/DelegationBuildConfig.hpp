@@ -17,7 +17,14 @@
 
 #ifndef PARALLEL_DESIGN
     #define PARALLEL_DESIGN GLOBAL_HASHMAP
+    #define PARALLEL_DESIGN HIERARCHICAL
     #define PARALLEL_DESIGN QPOPSS
+    #define PARALLEL_DESIGN SHARED
+#endif
+
+// int or five_tuple, the five_tuple targets set it explicitly
+#ifndef KEY_TYPE
+    #define KEY_TYPE int
 #endif
 
 #ifndef EVALUATE_MODE
@@ -44,6 +51,7 @@ struct DelegationBuildConfig {
     static constexpr std::string_view algorithm = STRINGIFYMACRO(ALGORITHM);
     static constexpr std::string_view mode = STRINGIFYMACRO(MODE);
     static constexpr std::string_view parallel_design = STRINGIFYMACRO(PARALLEL_DESIGN);
+    static constexpr std::string_view key_type = STRINGIFYMACRO(KEY_TYPE);
     static constexpr std::string_view evaluate_mode = STRINGIFYMACRO(EVALUATE_MODE);
     static constexpr std::string_view evaluate_accuracy_when = STRINGIFYMACRO(EVALUATE_ACCURACY_WHEN);
     static constexpr std::string_view evaluate_accuracy_error_sources = STRINGIFYMACRO(EVALUATE_ACCURACY_ERROR_SOURCES);
@@ -51,7 +59,7 @@ struct DelegationBuildConfig {
 
     auto to_tuple() const {
         return std::make_tuple("algorithm", std::string(DelegationBuildConfig::algorithm), "mode", std::string(DelegationBuildConfig::mode), "evaluate_mode",
-                               std::string(DelegationBuildConfig::evaluate_mode), "parallel_design", std::string(DelegationBuildConfig::parallel_design), "evaluate_accuracy_when",
+                               std::string(DelegationBuildConfig::evaluate_mode), "parallel_design", std::string(DelegationBuildConfig::parallel_design), "key_type", std::string(DelegationBuildConfig::key_type), "evaluate_accuracy_when",
                                std::string(DelegationBuildConfig::evaluate_accuracy_when), "evaluate_accuracy_error_sources",
                                std::string(DelegationBuildConfig::evaluate_accuracy_error_sources), "evaluate_accuracy_stream_size",
                                DelegationBuildConfig::evaluate_accuracy_stream_size);
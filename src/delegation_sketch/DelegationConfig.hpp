@@ -28,6 +28,19 @@ struct DelegationHeavyHitterConfig {
     int FILTER_SIZE;
     double QUERY_RATE;
     double HEAVY_QUERY_RATE;   // rate for querying the all heavy hitters
+    int METRICS_INTERVAL_MS;   // 0 disables the live metrics reporter
+    std::string METRICS_OUTPUT;
+    std::string METRICS_SOCKET;
+    int INITIAL_THREADS;            // workers active at start, 0 means all NUM_THREADS
+    std::string RESHARD_SCHEDULE;   // "ms:threads,..." e.g. "2000:4,4000:8", only tracked heavy hitters carry their counts over
+    std::string CHECKPOINT_PATH;    // empty disables checkpoints
+    int CHECKPOINT_INTERVAL_MS;     // 0 only checkpoints once the benchmark ended
+    std::string RESTORE_PATH;       // checkpoint loaded before the threads start
+    std::string INGEST;             // direct: workers read the relation, memory/file/mmap: reader threads feed them
+    int INGEST_READERS;
+    int INGEST_BLOCK_SIZE;   // items per block handed to a worker
+    int INGEST_RING_SIZE;    // blocks in flight per worker
+    std::string INGEST_PATH;   // stream file of the file and mmap sources, empty means one in the temp directory
     static void add_params_to_config_parser(DelegationHeavyHitterConfig &delegation_heavyhitter_config, ConfigParser &parser) {
         // DelegationHeavyHitter configs prefix will be "delegationheavyhitter."
         parser.AddParameter(
@@ -37,6 +50,33 @@ struct DelegationHeavyHitterConfig {
             new DoubleParameter("delegationheavyhitter.query_rate", "0", &delegation_heavyhitter_config.QUERY_RATE, false, "Query rate for the delegation heavy hitter sketch"));
         parser.AddParameter(new DoubleParameter("delegationheavyhitter.heavy_query_rate", "0.1", &delegation_heavyhitter_config.HEAVY_QUERY_RATE, false,
                                                 "Query rate for the delegation heavy hitter sketch for querying all heavy hitters"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.metrics_interval_ms", "0", &delegation_heavyhitter_config.METRICS_INTERVAL_MS, false,
+                                             "Interval in ms between live metrics samples, 0 disables the reporter"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.metrics_output", "", &delegation_heavyhitter_config.METRICS_OUTPUT, false,
+                                                "File to append live metrics to as JSON lines"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.metrics_socket", "", &delegation_heavyhitter_config.METRICS_SOCKET, false,
+                                                "Unix socket path serving live metrics as Prometheus text"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.initial_threads", "0", &delegation_heavyhitter_config.INITIAL_THREADS, false,
+                                             "Number of workers active at start (at most app.num_threads), 0 means all"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.reshard_schedule", "", &delegation_heavyhitter_config.RESHARD_SCHEDULE, false,
+                                                "Comma separated ms:threads pairs, the number of active workers is changed to threads after ms. Only the tracked heavy hitters take "
+                                                "their counts to the new owner, other keys that move are counted from zero there"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.checkpoint_path", "", &delegation_heavyhitter_config.CHECKPOINT_PATH, false,
+                                                "File the per-thread sketches are checkpointed to, empty disables checkpoints"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.checkpoint_interval_ms", "0", &delegation_heavyhitter_config.CHECKPOINT_INTERVAL_MS, false,
+                                             "Interval in ms between checkpoints taken during ingest, 0 only checkpoints at the end"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.restore_path", "", &delegation_heavyhitter_config.RESTORE_PATH, false,
+                                                "Checkpoint (memory mapped) to restore the per-thread sketches from before the benchmark starts"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.ingest", "direct", &delegation_heavyhitter_config.INGEST, false,
+                                                "Where workers get items: direct (read the relation themselves), or from reader threads decoding memory/file/mmap"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.ingest_readers", "1", &delegation_heavyhitter_config.INGEST_READERS, false,
+                                             "Reader threads of the ingest pipeline, each feeds its share of the workers"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.ingest_block_size", "256", &delegation_heavyhitter_config.INGEST_BLOCK_SIZE, false,
+                                             "Items per block a reader hands to a worker"));
+        parser.AddParameter(new IntParameter("delegationheavyhitter.ingest_ring_size", "64", &delegation_heavyhitter_config.INGEST_RING_SIZE, false,
+                                             "Blocks in flight between a reader and each of its workers"));
+        parser.AddParameter(new StringParameter("delegationheavyhitter.ingest_path", "", &delegation_heavyhitter_config.INGEST_PATH, false,
+                                                "Stream file the relation is written to and read back from by the file and mmap sources"));
     }
 
     // cast from DelegationHeavyHitterConfig to DelegationConfig
@@ -47,7 +87,12 @@ struct DelegationHeavyHitterConfig {
         return delegation_configs;
     }
 
-    auto to_tuple() const { return std::make_tuple("FILTER_SIZE", FILTER_SIZE, "QUERY_RATE", QUERY_RATE, "HEAVY_QUERY_RATE", HEAVY_QUERY_RATE); }
+    auto to_tuple() const {
+        return std::make_tuple("FILTER_SIZE", FILTER_SIZE, "QUERY_RATE", QUERY_RATE, "HEAVY_QUERY_RATE", HEAVY_QUERY_RATE, "METRICS_INTERVAL_MS", METRICS_INTERVAL_MS,
+                               "METRICS_OUTPUT", METRICS_OUTPUT, "METRICS_SOCKET", METRICS_SOCKET, "INITIAL_THREADS", INITIAL_THREADS, "RESHARD_SCHEDULE", RESHARD_SCHEDULE,
+                               "CHECKPOINT_PATH", CHECKPOINT_PATH, "CHECKPOINT_INTERVAL_MS", CHECKPOINT_INTERVAL_MS, "RESTORE_PATH", RESTORE_PATH, "INGEST", INGEST,
+                               "INGEST_READERS", INGEST_READERS, "INGEST_BLOCK_SIZE", INGEST_BLOCK_SIZE, "INGEST_RING_SIZE", INGEST_RING_SIZE, "INGEST_PATH", INGEST_PATH);
+    }
 
     friend std::ostream &operator<<(std::ostream &os, const DelegationHeavyHitterConfig &config) {
         ConfigPrinter<DelegationHeavyHitterConfig>::print(os, config);
@@ -2,36 +2,32 @@
 #include <algorithm>
 
 // DelegationFilter implementation
-DelegationFilter::DelegationFilter() {}
+DelegationFilter<int>::DelegationFilter() {}
 
-DelegationFilter::DelegationFilter(int max_size) {
-    keys = std::vector<int>(max_size);
-    counts = std::vector<int>(max_size);
+DelegationFilter<int>::DelegationFilter(int max_size, std::pmr::memory_resource *resource) : keys(max_size, resource), counts(max_size, resource) {
     FILTER_SIZE = max_size;
     size = 0;
     lock = false;
 }
 
-DelegationFilter::DelegationFilter(DelegationFilter &&other) {
-    keys = std::move(other.keys);
-    counts = std::move(other.counts);
+DelegationFilter<int>::DelegationFilter(DelegationFilter &&other) : keys(std::move(other.keys)), counts(std::move(other.counts)) {
     size.store(other.size.load(std::memory_order_relaxed), std::memory_order_relaxed);
     lock.store(other.lock.load(std::memory_order_relaxed), std::memory_order_relaxed);
 }
 
-int DelegationFilter::lookup_value(const int &key) {
+int DelegationFilter<int>::lookup_value(const int &key) {
     auto it = std::find(keys.begin(), keys.end(), key);
     if (it != keys.end()) { return counts[it - keys.begin()]; }
     return 0;
 }
 
-int DelegationFilter::lookup_index(const int &key) {
+int DelegationFilter<int>::lookup_index(const int &key) {
     auto it = std::find(keys.begin(), keys.end(), key);
     if (it != keys.end()) { return it - keys.begin(); }
     return -1;
 }
 
-int DelegationFilter::update_or_insert_if_not_full(const int &key) {
+int DelegationFilter<int>::update_or_insert_if_not_full(const int &key) {
     auto it = std::find(keys.begin(), keys.end(), key);
     if (it != keys.end()) {
         counts[it - keys.begin()] += 1;
@@ -49,7 +45,7 @@ int DelegationFilter::update_or_insert_if_not_full(const int &key) {
     return 0;
 }
 
-int DelegationFilter::lookup_index_simd(const int &key) {
+int DelegationFilter<int>::lookup_index_simd(const int &key) {
     const int *keys = this->keys.data();
     const int num_elements = this->size.load(std::memory_order_relaxed);
 
@@ -64,7 +60,7 @@ int DelegationFilter::lookup_index_simd(const int &key) {
     return -1;
 }
 
-int DelegationFilter::lookup_value_simd(const int &key) {
+int DelegationFilter<int>::lookup_value_simd(const int &key) {
     const int *keys = this->keys.data();
     const int *counts = this->counts.data();
     const int num_elements = this->size.load(std::memory_order_relaxed);
@@ -81,7 +77,7 @@ int DelegationFilter::lookup_value_simd(const int &key) {
     return 0;
 }
 
-int DelegationFilter::update_or_insert_if_not_full_simd(const int &key) {
+int DelegationFilter<int>::update_or_insert_if_not_full_simd(const int &key, int count) {
     const int *keys = this->keys.data();
     const int num_elements = this->size.load(std::memory_order_relaxed);
 
@@ -91,16 +87,16 @@ int DelegationFilter::update_or_insert_if_not_full_simd(const int &key) {
     for (int i = 0; i < num_elements; i += 4) {
         __m128i comparison = _mm_cmpeq_epi32(key_vec, keys_vec[i / 4]);
         int found = _mm_movemask_epi8(comparison);
-        if (found) { return ++counts[i + __builtin_ctz(found) / 4]; }
+        if (found) { return counts[i + __builtin_ctz(found) / 4] += count; }
     }
 
     int size = num_elements;
 
     if (size < FILTER_SIZE) {
         this->keys[size] = key;
-        counts[size] = 1;
+        counts[size] = count;
         this->size.store(size + 1, std::memory_order_relaxed);
-        return 1;
+        return count;
     }
     return 0;
 }
@@ -1,18 +1,80 @@
 #pragma once
 #include <atomic>
 #include <emmintrin.h>
+#include <memory_resource>
 #include <vector>
 
-// Delegation Filter
-struct DelegationFilter {
-    std::vector<int> keys;
-    std::vector<int> counts;
+#include "delegation_sketch/DelegationKey.hpp"
+#include "utils/CacheLineArena.hpp"
+
+// Delegation Filter, keys other than int are probed through their 32-bit hash and confirmed on the full key.
+// The arrays come from the given memory resource, the delegation designs pass the arena of the thread that fills the filter.
+template <typename KeyType> struct DelegationFilter {
+    std::pmr::vector<uint32_t> hashes;   // padded to a multiple of 4 for the SIMD probe
+    std::pmr::vector<KeyType> keys;
+    std::pmr::vector<int> counts;
+    std::atomic<int> size;
+    std::atomic<bool> lock;
+    int FILTER_SIZE;
+
+    DelegationFilter() {}
+    DelegationFilter(int max_size, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : hashes((max_size + 3) / 4 * 4, resource), keys(max_size, resource), counts(max_size, resource), size(0), lock(false), FILTER_SIZE(max_size) {}
+
+    int lookup_index_simd(const KeyType &key, uint32_t key_hash) {
+        const int num_elements = this->size.load(std::memory_order_relaxed);
+        const __m128i *hashes_vec = (const __m128i *) this->hashes.data();
+        __m128i hash_vec = _mm_set1_epi32(key_hash);
+
+        for (int i = 0; i < num_elements; i += 4) {
+            int found = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hash_vec, _mm_loadu_si128(hashes_vec + i / 4))));
+            // lanes past the end still hold hashes of the previous round
+            if (num_elements - i < 4) { found &= (1 << (num_elements - i)) - 1; }
+            while (found) {
+                int index = i + __builtin_ctz(found);
+                if (keys[index] == key) { return index; }
+                found &= found - 1;
+            }
+        }
+        return -1;
+    }
+
+    int lookup_index_simd(const KeyType &key) { return lookup_index_simd(key, DelegationKeyTraits<KeyType>::hash(key)); }
+
+    int lookup_value_simd(const KeyType &key) {
+        int index = lookup_index_simd(key);
+        return index < 0 ? 0 : counts[index];
+    }
+
+    int update_or_insert_if_not_full_simd(const KeyType &key, int count = 1) { return update_or_insert_if_not_full_simd(key, DelegationKeyTraits<KeyType>::hash(key), count); }
+
+    // with the hash computed upstream (the ingest pipeline hashes while decoding)
+    int update_or_insert_if_not_full_simd(const KeyType &key, uint32_t key_hash, int count) {
+        int index = lookup_index_simd(key, key_hash);
+        if (index >= 0) { return counts[index] += count; }
+
+        int size = this->size.load(std::memory_order_relaxed);
+        if (size < FILTER_SIZE) {
+            hashes[size] = key_hash;
+            keys[size] = key;
+            counts[size] = count;
+            this->size.store(size + 1, std::memory_order_relaxed);
+            return count;
+        }
+        return 0;
+    }
+};
+
+// int keys are compared directly, see DelegationFilter.cpp
+template <> struct DelegationFilter<int> {
+    std::pmr::vector<int> keys;
+    std::pmr::vector<int> counts;
     std::atomic<int> size;
     std::atomic<bool> lock;
     int FILTER_SIZE;
 
     DelegationFilter();
-    DelegationFilter(int max_size);
+    DelegationFilter(int max_size, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     DelegationFilter(DelegationFilter &&other);
 
     int lookup_value(const int &key);
@@ -20,5 +82,13 @@ struct DelegationFilter {
     int update_or_insert_if_not_full(const int &key);
     int lookup_index_simd(const int &key);
     int lookup_value_simd(const int &key);
-    int update_or_insert_if_not_full_simd(const int &key);
-};
\ No newline at end of file
+    int update_or_insert_if_not_full_simd(const int &key, int count = 1);
+};
+
+// bytes a filter of max_size keys takes in a CacheLineArena, the struct and each of its arrays start on a cache line
+template <typename KeyType> constexpr size_t delegation_filter_arena_bytes(int max_size) {
+    auto lines = [](size_t bytes) { return (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE; };
+    size_t bytes = lines(sizeof(DelegationFilter<KeyType>)) + lines(max_size * sizeof(KeyType)) + lines(max_size * sizeof(int));
+    if constexpr (!std::is_same_v<KeyType, int>) { bytes += lines((max_size + 3) / 4 * 4 * sizeof(uint32_t)); }
+    return bytes;
+}
@@ -4,20 +4,28 @@
 #include <atomic>
 #include <barrier>
 #include <condition_variable>
+#include <cstdint>
 #include <filesystem>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <random>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "concurrent_data_structure/LCRQueue.hpp"
 #include "concurrent_data_structure/TreiberStack.hpp"
 #include "concurrent_data_structure/libcuckoo/cuckoohash_map.hh"
+#include "delegation_sketch/CpuTopology.hpp"
 #include "delegation_sketch/DelegationConfig.hpp"
 #include "delegation_sketch/DelegationFilter.hpp"
+#include "delegation_sketch/DelegationKey.hpp"
+#include "delegation_sketch/IngestPipeline.hpp"
+#include "delegation_sketch/MetricsReporter.hpp"
 #include "delegation_sketch/PendingQuery.hpp"
 #include "delegation_sketch/StatCollector.hpp"
 #include "delegation_sketch/delegation_sketch_utils.hpp"
@@ -25,8 +33,11 @@
 #include "frequency_estimator/BoundedKeyValuePriorityQueue.hpp"
 #include "frequency_estimator/CuckooHeavyKeeper.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "frequency_estimator/SharedCuckooHeavyKeeper.hpp"
 #include "heavy_hitter_app/AppConfig.hpp"
 #include "heavy_hitter_app/Relation.hpp"
+#include "utils/BinarySnapshot.hpp"
+#include "utils/CacheLineArena.hpp"
 #include "utils/getticks.hpp"
 
 using AppConfig = ParallelAppConfig;
@@ -38,111 +49,193 @@ struct DelegationSketchContext {
     Relation *r1;   // input data
     std::atomic<bool> &START_BENCHMARK;
     std::atomic<bool> &START_ACCURACY_EVALUATION;
+    ThreadPlacement placement;   // cpu and NUMA node of every delegation thread
 
     DelegationSketchContext(AppConfig app_configs, DelegationHeavyHitterConfig delegation_configs, Relation *r1, std::atomic<bool> &START_BENCHMARK,
                             std::atomic<bool> &START_ACCURACY_EVALUATION)
-        : app_configs(app_configs), delegation_configs(delegation_configs), r1(r1), START_BENCHMARK(START_BENCHMARK), START_ACCURACY_EVALUATION(START_ACCURACY_EVALUATION) {}
+        : app_configs(app_configs), delegation_configs(delegation_configs), r1(r1), START_BENCHMARK(START_BENCHMARK), START_ACCURACY_EVALUATION(START_ACCURACY_EVALUATION),
+          placement(ThreadPlacement::compute(app_configs.PLACEMENT, app_configs.NUM_THREADS)) {}
 };
 
+// construct one object per delegation thread on the cpu of that thread, so that its memory is first touched on the thread's NUMA node
+template <typename T, typename Factory> vector<T> construct_on_thread_cpus(DelegationSketchContext &delegation_sketch_context, Factory factory) {
+    int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
+    vector<T> objects;
+    objects.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        run_on_cpu(delegation_sketch_context.placement.cpus[i], [&objects, &factory, i]() { objects.push_back(factory(i)); });
+    }
+    return objects;
+}
+
 // GlobalHeavyHitterTracker
-struct GlobalHeavyHitterTracker {
+template <typename KeyType> struct GlobalHeavyHitterTracker {
     DelegationSketchContext &delegation_sketch_context;
-    libcuckoo::cuckoohash_map<int, int> global_heavy_hitters;
-    atomic<int> stream_size = 0;
+    libcuckoo::cuckoohash_map<KeyType, int> global_heavy_hitters;
+    atomic<int64_t> stream_size = 0;   // sum of the weights, may pass INT_MAX with weighted inserts
 
     GlobalHeavyHitterTracker(DelegationSketchContext &delegation_sketch_context) : delegation_sketch_context(delegation_sketch_context) {}
 };
 
 // LocalHeavyHitterTracker
-struct LocalHeavyHitterTracker {
+template <typename KeyType> struct LocalHeavyHitterTracker {
     DelegationSketchContext &delegation_sketch_context;
-    BoundedKeyValuePriorityQueue<int> local_heavy_hitters;
-    vector<tuple<int, int, int>> local_heavy_hitter_differences;
-    int threshold = 0;
+    BoundedKeyValuePriorityQueue<KeyType> local_heavy_hitters;
+    vector<tuple<KeyType, int, int>> local_heavy_hitter_differences;
+    unordered_map<KeyType, int> shared_heavy_hitter_counts;   // SHARED: latest count of the candidates seen since the last publish
+    int64_t threshold = 0;
 
     LocalHeavyHitterTracker(DelegationSketchContext &delegation_sketch_context) : delegation_sketch_context(delegation_sketch_context) {}
 
-    bool add_if_is_local_heavy_hitter(int key, int difference, int count);
-    void update_threshold(int threshold);
-    void update_global_heavy_hitters(GlobalHeavyHitterTracker &global_heavy_hitter_tracker, int total_differences);
+    bool add_if_is_local_heavy_hitter(const KeyType &key, int difference, int count);
+    bool add_if_is_shared_heavy_hitter(const KeyType &key, int count);
+    void update_threshold(int64_t threshold);
+    void update_global_heavy_hitters(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker, int total_differences);
+    void update_shared_global_heavy_hitters(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker, int64_t total_differences);
+    void check_evaluation_start(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker);
+    // the tracked local heavy hitters and the threshold, part of the thread's checkpoint
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
 };
 
 // Declare Thread-Local Delegation Sketch
-template <typename FrequencyEstimator> class ThreadLocalDelegationHeavyHitter;
+template <typename FrequencyEstimator, typename KeyType = int> class ThreadLocalDelegationHeavyHitter;
 
-// DelegationHeavyHitter
-template <typename FrequencyEstimator> class DelegationHeavyHitter {
+// DelegationHeavyHitter, keys are int by default, see DelegationKeyTraits for other key types
+template <typename FrequencyEstimator, typename KeyType = int> class DelegationHeavyHitter {
   public:
     DelegationSketchContext &delegation_sketch_context;
-    std::vector<ThreadLocalDelegationHeavyHitter<FrequencyEstimator> *> thread_local_delegation_sketches;
-    map<int, int> accuracy_evaluator_heavy_hitter_counter;
+    std::vector<ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType> *> thread_local_delegation_sketches;
+    map<KeyType, int> accuracy_evaluator_heavy_hitter_counter;
     vector<int> latency_evaluator_cache;
-    GlobalHeavyHitterTracker global_heavy_hitter_tracker;
-    atomic<int> QPOPSS_stream_size = 0;
+    GlobalHeavyHitterTracker<KeyType> global_heavy_hitter_tracker;
+    atomic<int64_t> QPOPSS_stream_size = 0;
+    atomic<int> heavy_hitter_snapshot_request = 0;   // QPOPSS: bumped by every query_all_heavy_hitters
+    atomic<int> checkpoint_request = 0;               // bumped by every save, see ThreadLocalDelegationHeavyHitter::take_checkpoint
+    std::mutex checkpoint_mutex;
+
+    // online resharding: threads [0, num_active_threads) read the stream and own keys, the others only drain what is still delegated to them
+    atomic<int> num_active_threads;
+    atomic<int> reshard_epoch = 0;
+    std::mutex reshard_mutex;
+
+    std::unique_ptr<IngestPipeline<KeyType>> ingest_pipeline;   // null when the workers read the relation themselves
 
     DelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, std::vector<FrequencyEstimator> &frequency_estimators);
     DelegationHeavyHitter() = default;
 
-    int direct_query(const int &key);
-    void query_all_heavy_hitters(map<int, int> &results);
-    template <typename T> float ARE(const std::map<T, int> &exact_counter);
-    template <typename T> float AAE(const std::map<T, int> &exact_counter);
-    template <typename T> void print_compare(const std::map<T, int> &exact_counter, string output_file_path = "");
+    int direct_query(const KeyType &key);
+    void query_all_heavy_hitters(map<KeyType, int> &results);
+    // changes the number of threads owning keys, the tracked heavy hitters move with their counts, see ThreadLocalDelegationHeavyHitter::apply_reshard
+    void reshard(int new_num_active_threads);
+    // versioned binary checkpoint of the per-thread sketches and the global heavy hitters; save runs next to ingest, load needs the threads stopped
+    void save(std::ostream &os);
+    void load(std::istream &is);
+    template <typename T, typename Count> float ARE(const std::map<T, Count> &exact_counter);
+    template <typename T, typename Count> float AAE(const std::map<T, Count> &exact_counter);
+    template <typename T, typename Count> void print_compare(const std::map<T, Count> &exact_counter, string output_file_path = "");
 };
 
-// Thread-Local Delegation Sketch
-template <typename FrequencyEstimator> class ThreadLocalDelegationHeavyHitter {
+// Thread-Local Delegation Sketch, on cache lines of its own since other threads poll its queues and snapshots
+template <typename FrequencyEstimator, typename KeyType> class alignas(CACHE_LINE_SIZE) ThreadLocalDelegationHeavyHitter {
   public:
     DelegationSketchContext &delegation_sketch_context;
     FrequencyEstimator &frequency_estimator;
-    std::vector<PendingQuery *> pending_queries;
-    std::vector<DelegationFilter *> delegation_filters;
-    std::array<std::vector<DelegationFilter *>, 2> double_buffer_delegation_filters;
+    CacheLineArena arena;   // one slab with the filters, pending queries and seeds of this thread, allocated on its cpu
+    std::vector<PendingQuery<KeyType> *> pending_queries;
+    std::vector<DelegationFilter<KeyType> *> delegation_filters;
+    std::array<std::vector<DelegationFilter<KeyType> *>, 2> double_buffer_delegation_filters;   // nullptr for threads we never delegate to
     std::vector<int> current_buffer_ids;
+    std::vector<int> delegation_targets;   // thread a key is handed to, indexed by the owner of the key
 
     std::vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors;
     ThreadOverallStatCollector thread_overall_stat_collector;
 
-    LCRQueue<DelegationFilter *> full_delegate_filters;
-    DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch;
-    LocalHeavyHitterTracker local_heavy_hitter_tracker;
+    LCRQueue<DelegationFilter<KeyType> *> full_delegate_filters;
+    DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch;
+    LocalHeavyHitterTracker<KeyType> local_heavy_hitter_tracker;
     int current_thread_id;
     unsigned long *seeds;
     std::mutex QPOPSS_mutex;
+    int reshard_epoch = -1;   // last epoch of DelegationHeavyHitter::reshard_epoch applied by this thread
+    int shared_pending_items = 0;        // SHARED: items inserted since the last publish of heavy hitter candidates
+    int64_t shared_pending_weight = 0;   // SHARED: their total weight, what the global stream size grows by
+
+    // QPOPSS: heavy hitters of this thread's sketch as of the request heavy_hitter_snapshot_epoch, see DelegationHeavyHitter::query_all_heavy_hitters
+    std::atomic<int> heavy_hitter_snapshot_epoch = 0;
+    std::atomic<std::shared_ptr<const vector<pair<KeyType, int>>>> heavy_hitter_snapshot;
+
+    // serialized sketch, local heavy hitters and reshard epoch of this thread as of the request checkpoint_epoch, see DelegationHeavyHitter::save
+    std::atomic<int> checkpoint_epoch = 0;
+    std::atomic<std::shared_ptr<const std::string>> checkpoint;
+    // one writer of the sketch at a time: the worker from before its start barrier to its end, otherwise a save, load or flush that claimed it
+    std::atomic<bool> sketch_claimed = false;
 
     ThreadLocalDelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, int current_thread_id, FrequencyEstimator &frequency_estimator,
-                                     DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch);
+                                     DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch);
 
     void process_pending_inserts();
     void process_pending_queries();
+    void take_heavy_hitter_snapshot();
+    void take_checkpoint();
+    void load_checkpoint(std::istream &is);
+    bool try_claim_sketch();
+    void claim_sketch();
+    void release_sketch();
     void flush_pending_inserts();
-    void insert(const int &key);
-    int query(const int &key);
-    void query_all_heavy_hitters(map<int, int> &results);
-    void insert_directly(const int &key);
-    int query_directly(const int &key);
+    void insert(const KeyType &key, int weight = 1);
+    void delegate(int target_thread_id, const KeyType &key, int count = 1);
+    void delegate(int target_thread_id, const KeyType &key, int count, uint32_t key_hash);
+    // an item the ingest pipeline already hashed and found the owner of
+    void insert_routed(const KeyType &key, uint32_t key_hash, int owner_thread_id, int weight);
+    void forward(const KeyType &key, int count);
+    void check_reshard();
+    void apply_reshard();
+    int query(const KeyType &key);
+    void query_all_heavy_hitters(map<KeyType, int> &results);
+    void insert_directly(const KeyType &key);
+    int query_directly(const KeyType &key);
 };
 
-template <typename FrequencyEstimator>
-void start_thread_heavy_hitter(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator> *thread_local_delegation_sketch, int start,
+template <typename FrequencyEstimator, typename KeyType>
+void start_thread_heavy_hitter(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType> *thread_local_delegation_sketch, int start,
                                int end, std::barrier<> &sync_point);
 
-template <typename FrequencyEstimator>
-void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch,
-                              map<int, int> &accuracy_evaluator_heavy_hitter_counter, std::barrier<> &sync_point);
+template <typename FrequencyEstimator, typename KeyType>
+void start_thread_heavy_hitter_pipelined(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType> *thread_local_delegation_sketch,
+                                         IngestPipeline<KeyType> *ingest_pipeline, std::barrier<> &sync_point);
 
-template <typename FrequencyEstimator>
-DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext &delegation_sketch_context, vector<FrequencyEstimator> &frequency_estimators);
+template <typename FrequencyEstimator, typename KeyType>
+void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                              map<KeyType, int> &accuracy_evaluator_heavy_hitter_counter, std::barrier<> &sync_point);
 
-template <typename FrequencyEstimator>
-pair<map<int, int>, long> calculate_exact_counter(DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch, Relation *r1, int num_threads, int tuples_no);
+// counters and filter states of every thread, read while the workers run
+template <typename FrequencyEstimator, typename KeyType>
+MetricsSnapshot collect_metrics_snapshot(DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, int num_threads);
 
-template <typename FrequencyEstimator>
-void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch,
+template <typename FrequencyEstimator, typename KeyType>
+void start_metrics_reporter(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                            std::atomic<bool> &STOP_METRICS_REPORTER);
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_checkpointer(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, std::atomic<bool> &STOP_CHECKPOINTER);
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_reshard_controller(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                              vector<pair<int, int>> reshard_schedule);
+
+template <typename FrequencyEstimator, typename KeyType = int>
+DelegationHeavyHitter<FrequencyEstimator, KeyType> *start_threads(DelegationSketchContext &delegation_sketch_context, vector<FrequencyEstimator> &frequency_estimators);
+
+template <typename FrequencyEstimator, typename KeyType>
+pair<map<KeyType, int64_t>, int64_t> calculate_exact_counter(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch);
+
+template <typename FrequencyEstimator, typename KeyType>
+void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
                                        string output_file_path = "");
 
 template <typename FrequencyEstimator, typename KeyType>
-void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch, string output_file_path = "");
+void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, string output_file_path = "");
 
 string create_file_path_from_context(DelegationSketchContext &delegation_sketch_context, string suffix = "") {
     auto now = std::chrono::system_clock::now();
@@ -1,5 +1,5 @@
 
-bool LocalHeavyHitterTracker::add_if_is_local_heavy_hitter(int key, int difference, int count) {
+template <typename KeyType> bool LocalHeavyHitterTracker<KeyType>::add_if_is_local_heavy_hitter(const KeyType &key, int difference, int count) {
     if (count < threshold) { return false; }
 
     local_heavy_hitter_differences.push_back(make_tuple(key, difference, count));
@@ -14,18 +14,54 @@ bool LocalHeavyHitterTracker::add_if_is_local_heavy_hitter(int key, int differen
     return false;
 }
 
-void LocalHeavyHitterTracker::update_threshold(int threshold) { this->threshold = threshold; }
+template <typename KeyType> void LocalHeavyHitterTracker<KeyType>::update_threshold(int64_t threshold) { this->threshold = threshold; }
 
-void LocalHeavyHitterTracker::update_global_heavy_hitters(GlobalHeavyHitterTracker &global_heavy_hitter_tracker, int total_differences) {
+template <typename KeyType>
+void LocalHeavyHitterTracker<KeyType>::update_global_heavy_hitters(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker, int total_differences) {
     for (auto &el : local_heavy_hitter_differences) {
-        int key = get<0>(el);
+        const KeyType &key = get<0>(el);
         int difference = get<1>(el);
         int count = get<2>(el);
         global_heavy_hitter_tracker.global_heavy_hitters.upsert(key, [difference](int &num) { num += difference; }, count);
     }
 
     global_heavy_hitter_tracker.stream_size.fetch_add(total_differences);
+    check_evaluation_start(global_heavy_hitter_tracker);
 
+    this->update_threshold(global_heavy_hitter_tracker.stream_size.load() * delegation_sketch_context.app_configs.THETA);
+
+    auto popped_items = local_heavy_hitters.pop_all_below(threshold);
+    for (auto &el : popped_items) { global_heavy_hitter_tracker.global_heavy_hitters.erase(el.first); }
+
+    local_heavy_hitter_differences.clear();
+}
+
+template <typename KeyType> bool LocalHeavyHitterTracker<KeyType>::add_if_is_shared_heavy_hitter(const KeyType &key, int count) {
+    if (count < threshold) { return false; }
+    shared_heavy_hitter_counts[key] = count;
+    return true;
+}
+
+template <typename KeyType>
+void LocalHeavyHitterTracker<KeyType>::update_shared_global_heavy_hitters(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker, int64_t total_differences) {
+    global_heavy_hitter_tracker.stream_size.fetch_add(total_differences);
+    check_evaluation_start(global_heavy_hitter_tracker);
+
+    this->update_threshold(global_heavy_hitter_tracker.stream_size.load() * delegation_sketch_context.app_configs.THETA);
+
+    // the counts come from the one shared sketch, so they replace the tracked count instead of adding to it,
+    // several threads may report the same key and the freshest (largest) count wins
+    for (auto &[key, count] : shared_heavy_hitter_counts) {
+        if (count >= threshold) {
+            global_heavy_hitter_tracker.global_heavy_hitters.upsert(key, [count](int &num) { num = std::max(num, count); }, count);
+        } else {
+            global_heavy_hitter_tracker.global_heavy_hitters.erase(key);
+        }
+    }
+    shared_heavy_hitter_counts.clear();
+}
+
+template <typename KeyType> void LocalHeavyHitterTracker<KeyType>::check_evaluation_start(GlobalHeavyHitterTracker<KeyType> &global_heavy_hitter_tracker) {
     if constexpr (DelegationBuildConfig::evaluate_mode == "accuracy") {
         if (global_heavy_hitter_tracker.stream_size.load() >= DelegationBuildConfig::evaluate_accuracy_stream_size) {
             if constexpr (DelegationBuildConfig::evaluate_accuracy_when == "start") { delegation_sketch_context.START_BENCHMARK.store(false, std::memory_order_relaxed); }
@@ -36,37 +72,205 @@ void LocalHeavyHitterTracker::update_global_heavy_hitters(GlobalHeavyHitterTrack
             delegation_sketch_context.START_ACCURACY_EVALUATION.store(true, std::memory_order_relaxed);
         }
     }
+}
 
-    this->update_threshold(global_heavy_hitter_tracker.stream_size.load() * delegation_sketch_context.app_configs.THETA);
-
-    auto popped_items = local_heavy_hitters.pop_all_below(threshold);
-    for (auto &el : popped_items) { global_heavy_hitter_tracker.global_heavy_hitters.erase(el.first); }
+template <typename KeyType> void LocalHeavyHitterTracker<KeyType>::save(std::ostream &os) const {
+    static_assert(std::is_trivially_copyable_v<KeyType>, "keys of the local heavy hitters are written as raw bytes");
+    write_binary(os, threshold);
+    write_binary(os, static_cast<uint64_t>(local_heavy_hitters.size()));
+    for (const auto &el : local_heavy_hitters) {
+        write_binary(os, el.first);
+        write_binary(os, el.second);
+    }
+}
 
+template <typename KeyType> void LocalHeavyHitterTracker<KeyType>::load(std::istream &is) {
+    uint64_t size;
+    read_binary(is, threshold);
+    read_binary(is, size);
+    local_heavy_hitters = BoundedKeyValuePriorityQueue<KeyType>(local_heavy_hitters.get_bound());
+    for (uint64_t i = 0; i < size; i++) {
+        KeyType key;
+        int count;
+        read_binary(is, key);
+        read_binary(is, count);
+        local_heavy_hitters.push(key, count);
+    }
+    // differences are published before every checkpoint, nothing is pending
     local_heavy_hitter_differences.clear();
 }
 
 // DelegationHeavyHitter implementation
-template <typename FrequencyEstimator>
-DelegationHeavyHitter<FrequencyEstimator>::DelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, std::vector<FrequencyEstimator> &frequency_estimators)
+template <typename FrequencyEstimator, typename KeyType>
+DelegationHeavyHitter<FrequencyEstimator, KeyType>::DelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, std::vector<FrequencyEstimator> &frequency_estimators)
     : delegation_sketch_context(delegation_sketch_context), global_heavy_hitter_tracker(delegation_sketch_context) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    static_assert(std::is_same_v<FrequencyEstimator, SharedCuckooHeavyKeeper>, "the SHARED design needs an estimator that can be updated concurrently");
+#endif
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
 
+    // filters, pending queries and stat collectors are allocated by a thread on the owner's cpu (first touch)
     for (int i = 0; i < num_threads; ++i) {
-        thread_local_delegation_sketches.push_back(new ThreadLocalDelegationHeavyHitter<FrequencyEstimator>(std::ref(delegation_sketch_context), i, frequency_estimators[i], this));
+        run_on_cpu(delegation_sketch_context.placement.cpus[i], [&, i]() {
+            thread_local_delegation_sketches.push_back(
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+                // all threads update the same estimator
+                new ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>(std::ref(delegation_sketch_context), i, frequency_estimators[0], this));
+#else
+                new ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>(std::ref(delegation_sketch_context), i, frequency_estimators[i], this));
+#endif
+        });
+    }
+
+    // app.num_threads threads are allocated, only the first initial_threads own keys until the first reshard
+    int initial_threads = delegation_sketch_context.delegation_configs.INITIAL_THREADS;
+    if (initial_threads <= 0 || initial_threads > num_threads) { initial_threads = num_threads; }
+    num_active_threads = initial_threads;
+    precompute_mods(initial_threads);
+    global_heavy_hitter_tracker.global_heavy_hitters = libcuckoo::cuckoohash_map<KeyType, int>(2048);
+}
+
+template <typename FrequencyEstimator, typename KeyType> void DelegationHeavyHitter<FrequencyEstimator, KeyType>::save([[maybe_unused]] std::ostream &os) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    throw std::runtime_error("Checkpoints are not supported by the SHARED design");
+#else
+    if constexpr (!Snapshottable<FrequencyEstimator>) {
+        throw std::runtime_error("The frequency estimator does not support checkpoints");
+    } else {
+        std::lock_guard<std::mutex> guard(checkpoint_mutex);
+        int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
+
+        // every running thread serializes its own sketch at its next process_pending_inserts, so ingest never stops for a checkpoint;
+        // the sketch of a thread that is not running is claimed and serialized here. Items still buffered in delegation filters are not
+        // part of the checkpoint.
+        int epoch = checkpoint_request.fetch_add(1, std::memory_order_acq_rel) + 1;
+        vector<std::shared_ptr<const std::string>> checkpoints(num_threads);
+        int remaining = num_threads;
+        while (remaining > 0) {
+            for (int i = 0; i < num_threads; i++) {
+                if (checkpoints[i]) { continue; }
+                auto thread_local_delegation_sketch = thread_local_delegation_sketches[i];
+                // a failed claim means the worker holds the sketch and answers the request itself
+                if (thread_local_delegation_sketch->try_claim_sketch()) {
+                    thread_local_delegation_sketch->take_checkpoint();
+                    thread_local_delegation_sketch->release_sketch();
+                }
+                if (thread_local_delegation_sketch->checkpoint_epoch.load(std::memory_order_acquire) < epoch) { continue; }
+                checkpoints[i] = thread_local_delegation_sketch->checkpoint.load(std::memory_order_acquire);
+                remaining--;
+            }
+            if (remaining > 0) { std::this_thread::yield(); }
+        }
+
+        write_snapshot_header(os, SnapshotKind::DELEGATION);
+        write_binary(os, num_threads);
+        // each thread's state is self-delimiting, the size lets a reader skip a thread
+        for (int i = 0; i < num_threads; i++) { write_binary(os, *checkpoints[i]); }
+
+        static_assert(std::is_trivially_copyable_v<KeyType>, "keys of the global heavy hitters are written as raw bytes");
+        write_binary(os, global_heavy_hitter_tracker.stream_size.load());
+        write_binary(os, QPOPSS_stream_size.load());
+        auto locked_global_heavy_hitters = global_heavy_hitter_tracker.global_heavy_hitters.lock_table();
+        write_binary(os, static_cast<uint64_t>(locked_global_heavy_hitters.size()));
+        for (const auto &[key, count] : locked_global_heavy_hitters) {
+            write_binary(os, key);
+            write_binary(os, count);
+        }
+
+        // the slot table the keys are partitioned by; the threads that had not applied the last reshard yet apply it after a restore
+        std::lock_guard<std::mutex> reshard_guard(reshard_mutex);
+        write_binary(os, num_active_threads.load());
+        write_binary(os, reshard_epoch.load());
+        write_binary_array(os, precomputed_mods, std::size(precomputed_mods));
     }
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> void DelegationHeavyHitter<FrequencyEstimator, KeyType>::load([[maybe_unused]] std::istream &is) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    throw std::runtime_error("Checkpoints are not supported by the SHARED design");
+#else
+    if constexpr (!Snapshottable<FrequencyEstimator>) {
+        throw std::runtime_error("The frequency estimator does not support checkpoints");
+    } else {
+        int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
+        // the claims keep the workers from starting while their sketches are replaced
+        for (int i = 0; i < num_threads; i++) {
+            if (thread_local_delegation_sketches[i]->try_claim_sketch()) { continue; }
+            for (int j = 0; j < i; j++) { thread_local_delegation_sketches[j]->release_sketch(); }
+            throw std::runtime_error("Checkpoints can only be restored while the threads are stopped");
+        }
+        auto release_sketches = [&]() {
+            for (auto thread_local_delegation_sketch : thread_local_delegation_sketches) { thread_local_delegation_sketch->release_sketch(); }
+        };
+
+        try {
+            uint32_t version = read_snapshot_header(is, SnapshotKind::DELEGATION);
+            if (version < 3) { throw std::runtime_error("Delegation checkpoints before format version 3 lack the slot table and cannot be restored"); }
+            int stored_num_threads;
+            read_binary(is, stored_num_threads);
+            // keys are partitioned by owner, a checkpoint only fits the thread count it was taken with
+            if (stored_num_threads != num_threads) {
+                throw std::runtime_error("Checkpoint was taken with " + std::to_string(stored_num_threads) + " threads, not " + std::to_string(num_threads));
+            }
+            for (int i = 0; i < num_threads; i++) {
+                // sketches are read straight from the stream (or the mapping), without going through the size-prefixed copy
+                uint64_t size;
+                read_binary(is, size);
+                thread_local_delegation_sketches[i]->load_checkpoint(is);
+            }
+
+            int64_t stream_size, stored_QPOPSS_stream_size;
+            uint64_t num_global_heavy_hitters;
+            read_binary(is, stream_size);
+            read_binary(is, stored_QPOPSS_stream_size);
+            read_binary(is, num_global_heavy_hitters);
+            global_heavy_hitter_tracker.stream_size.store(stream_size);
+            QPOPSS_stream_size.store(stored_QPOPSS_stream_size);
+            global_heavy_hitter_tracker.global_heavy_hitters.clear();
+            for (uint64_t i = 0; i < num_global_heavy_hitters; i++) {
+                KeyType key;
+                int count;
+                read_binary(is, key);
+                read_binary(is, count);
+                global_heavy_hitter_tracker.global_heavy_hitters.insert(key, count);
+            }
 
-    precompute_mods(num_threads);
-    global_heavy_hitter_tracker.global_heavy_hitters = libcuckoo::cuckoohash_map<int, int>(2048);
+            int stored_num_active_threads, stored_reshard_epoch;
+            std::lock_guard<std::mutex> reshard_guard(reshard_mutex);
+            read_binary(is, stored_num_active_threads);
+            read_binary(is, stored_reshard_epoch);
+            read_binary_array(is, precomputed_mods, std::size(precomputed_mods));
+            num_active_threads.store(stored_num_active_threads);
+            reshard_epoch.store(stored_reshard_epoch, std::memory_order_release);
+        } catch (...) {
+            release_sketches();
+            throw;
+        }
+        release_sketches();
+    }
+#endif
 }
 
-template <typename FrequencyEstimator> int DelegationHeavyHitter<FrequencyEstimator>::direct_query(const int &key) {
+template <typename FrequencyEstimator, typename KeyType> int DelegationHeavyHitter<FrequencyEstimator, KeyType>::direct_query(const KeyType &key) {
     int owner = find_owner(key);
-    return this->thread_local_delegation_sketches[owner]->frequency_estimator.estimate(key);
+    return this->thread_local_delegation_sketches[owner]->frequency_estimator.estimate(to_estimator_key(key));
+}
+
+template <typename FrequencyEstimator, typename KeyType> void DelegationHeavyHitter<FrequencyEstimator, KeyType>::reshard(int new_num_active_threads) {
+    std::lock_guard<std::mutex> lock(reshard_mutex);
+    new_num_active_threads = std::clamp(new_num_active_threads, 1, delegation_sketch_context.app_configs.NUM_THREADS);
+    if (new_num_active_threads == num_active_threads.load(std::memory_order_relaxed)) { return; }
+
+    // producers pick up the new slot table with their next find_owner, keys still in flight to the old owner are forwarded by it
+    reshard_mods(new_num_active_threads);
+    num_active_threads.store(new_num_active_threads, std::memory_order_relaxed);
+    reshard_epoch.fetch_add(1, std::memory_order_release);
 }
 
-template <typename FrequencyEstimator> void DelegationHeavyHitter<FrequencyEstimator>::query_all_heavy_hitters(map<int, int> &result) {
-#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP)
-    int threshold = global_heavy_hitter_tracker.stream_size.load(std::memory_order_relaxed) * delegation_sketch_context.app_configs.THETA;
+template <typename FrequencyEstimator, typename KeyType> void DelegationHeavyHitter<FrequencyEstimator, KeyType>::query_all_heavy_hitters(map<KeyType, int> &result) {
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP) || EQUAL(PARALLEL_DESIGN, HIERARCHICAL) || EQUAL(PARALLEL_DESIGN, SHARED)
+    int64_t threshold = global_heavy_hitter_tracker.stream_size.load(std::memory_order_relaxed) * delegation_sketch_context.app_configs.THETA;
 
     // collect the global heavy hitters
     if constexpr (DelegationBuildConfig::evaluate_mode == "accuracy" &&
@@ -75,7 +279,7 @@ template <typename FrequencyEstimator> void DelegationHeavyHitter<FrequencyEstim
         auto global_heavy_hitters = global_heavy_hitter_tracker.global_heavy_hitters.lock_table();
 
         for (const auto &it : global_heavy_hitters) {
-            int key = it.first;
+            const KeyType &key = it.first;
             int value = it.second;
             if (value >= threshold) { result[key] = value; }
         }
@@ -84,6 +288,15 @@ template <typename FrequencyEstimator> void DelegationHeavyHitter<FrequencyEstim
                          (DelegationBuildConfig::evaluate_mode == "accuracy" &&
                           (DelegationBuildConfig::evaluate_accuracy_when == "ivl" || DelegationBuildConfig::evaluate_accuracy_when == "end")) ||
                          DelegationBuildConfig::evaluate_mode == "latency") {
+        if constexpr (!std::is_trivially_copyable_v<KeyType>) {
+            // keys owning memory cannot be read from slots that may be written concurrently
+            auto global_heavy_hitters = global_heavy_hitter_tracker.global_heavy_hitters.lock_table();
+            for (const auto &it : global_heavy_hitters) {
+                if (it.second >= threshold) { result[it.first] = it.second; }
+            }
+            return;
+        }
+
         //  scan through the global heavy hitter tracker
         // auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -122,8 +335,10 @@ template <typename FrequencyEstimator> void DelegationHeavyHitter<FrequencyEstim
 
             // Iterate through values in the bucket
             for (size_t slot = 0; slot < slots_per_bucket; slot++) {
+                // empty and erased slots keep whatever bytes they held
+                if (!bucket.occupied(slot)) { continue; }
                 // Get value directly from storage
-                const auto &storage_kvpair = *static_cast<const std::pair<int, int> *>(static_cast<const void *>(&values[slot]));
+                const auto &storage_kvpair = *static_cast<const std::pair<KeyType, int> *>(static_cast<const void *>(&values[slot]));
                 const int value = storage_kvpair.second;
 
                 if (value >= threshold) { result[storage_kvpair.first] = value; }
@@ -137,41 +352,63 @@ template <typename FrequencyEstimator> void DelegationHeavyHitter<FrequencyEstim
         // std::cout << "num_buckets: " << num_buckets << std::endl;
     }
 #elif EQUAL(PARALLEL_DESIGN, QPOPSS)
+    int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
 
-    // collect the stream size
-    int stream_size = 0;
-    for (int i = 0; i < delegation_sketch_context.app_configs.NUM_THREADS; i++) {
-        stream_size += thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_items;
-    }
-
-    // find heavy hitters
-    int threshold = stream_size * delegation_sketch_context.app_configs.THETA;
-    for (int i = 0; i < delegation_sketch_context.app_configs.NUM_THREADS; i++) {
-        std::lock_guard<std::mutex> lock(thread_local_delegation_sketches[i]->QPOPSS_mutex);
-        for (auto const &el : thread_local_delegation_sketches[i]->frequency_estimator.get_heavy_hitters()) {
-            int key = el.first;
-            int count = el.second;
-            if (count >= threshold) { result[key] = count; }
+    // collect the stream size, the weight of the stream rather than its items
+    int64_t stream_size = 0;
+    for (int i = 0; i < num_threads; i++) { stream_size += relaxed_load(thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_weight); }
+
+    // every thread snapshots its own heavy hitters at its next process_pending_inserts, all in parallel, instead of the query locking
+    // every sketch in turn; the snapshots of threads that do not answer in time (stopped, or the querying thread itself) are taken here
+    // owners answer within one item of work, a few hundred cycles of spinning is plenty before helping
+    static constexpr int SNAPSHOT_SPIN_ROUNDS = 64;
+    int epoch = heavy_hitter_snapshot_request.fetch_add(1, std::memory_order_acq_rel) + 1;
+    int64_t threshold = stream_size * delegation_sketch_context.app_configs.THETA;
+    vector<bool> merged(num_threads, false);
+    int remaining = num_threads;
+    for (int round = 0; remaining > 0; round++) {
+        for (int i = 0; i < num_threads; i++) {
+            if (merged[i]) { continue; }
+            auto thread_local_delegation_sketch = thread_local_delegation_sketches[i];
+            if (round >= SNAPSHOT_SPIN_ROUNDS || !delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) {
+                thread_local_delegation_sketch->take_heavy_hitter_snapshot();
+            }
+            if (thread_local_delegation_sketch->heavy_hitter_snapshot_epoch.load(std::memory_order_acquire) < epoch) { continue; }
+
+            // keys are partitioned over the owners, so merging the snapshots is their union
+            auto snapshot = thread_local_delegation_sketch->heavy_hitter_snapshot.load(std::memory_order_acquire);
+            for (auto const &[key, count] : *snapshot) {
+                // a previous owner may still hold a stale entry of a key that moved in a reshard
+                if (find_owner(key) != i) { continue; }
+                if (count >= threshold) { result[key] = count; }
+            }
+            merged[i] = true;
+            remaining--;
         }
+        if (remaining > 0) { _mm_pause(); }
     }
 #endif
 }
 
-template <typename FrequencyEstimator> template <typename T> float DelegationHeavyHitter<FrequencyEstimator>::ARE(const std::map<T, int> &exact_counter) {
+template <typename FrequencyEstimator, typename KeyType>
+template <typename T, typename Count>
+float DelegationHeavyHitter<FrequencyEstimator, KeyType>::ARE(const std::map<T, Count> &exact_counter) {
     float relative_error = 0;
-    for (const auto &entry : exact_counter) { relative_error += float(abs(entry.second - (int) this->direct_query(entry.first))) / entry.second; }
+    for (const auto &entry : exact_counter) { relative_error += float(std::abs(entry.second - (Count) this->direct_query(entry.first))) / entry.second; }
     return relative_error / exact_counter.size();
 }
 
-template <typename FrequencyEstimator> template <typename T> float DelegationHeavyHitter<FrequencyEstimator>::AAE(const std::map<T, int> &exact_counter) {
+template <typename FrequencyEstimator, typename KeyType>
+template <typename T, typename Count>
+float DelegationHeavyHitter<FrequencyEstimator, KeyType>::AAE(const std::map<T, Count> &exact_counter) {
     float absolute_error = 0;
-    for (const auto &entry : exact_counter) { absolute_error += float(abs(entry.second - (int) this->direct_query(entry.first))); }
+    for (const auto &entry : exact_counter) { absolute_error += float(std::abs(entry.second - (Count) this->direct_query(entry.first))); }
     return absolute_error / exact_counter.size();
 }
 
-template <typename FrequencyEstimator>
-template <typename T>
-void DelegationHeavyHitter<FrequencyEstimator>::print_compare(const std::map<T, int> &exact_counter, string output_file_path) {
+template <typename FrequencyEstimator, typename KeyType>
+template <typename T, typename Count>
+void DelegationHeavyHitter<FrequencyEstimator, KeyType>::print_compare(const std::map<T, Count> &exact_counter, string output_file_path) {
     ofstream output_file;
     if (!output_file_path.empty()) {
         output_file.open(output_file_path);
@@ -193,74 +430,116 @@ void DelegationHeavyHitter<FrequencyEstimator>::print_compare(const std::map<T,
     }
 }
 // ThreadLocalDelegationHeavyHitter implementation
-template <typename FrequencyEstimator>
-ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::ThreadLocalDelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, int current_thread_id,
+template <typename FrequencyEstimator, typename KeyType>
+ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::ThreadLocalDelegationHeavyHitter(DelegationSketchContext &delegation_sketch_context, int current_thread_id,
                                                                                        FrequencyEstimator &frequency_estimator,
-                                                                                       DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch)
-    : delegation_sketch_context(delegation_sketch_context), local_heavy_hitter_tracker(delegation_sketch_context), current_thread_id(current_thread_id),
-      frequency_estimator(frequency_estimator) {
+                                                                                       DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch)
+    : delegation_sketch_context(delegation_sketch_context), frequency_estimator(frequency_estimator),
+      arena(delegation_sketch_context.app_configs.NUM_THREADS * (2 * delegation_filter_arena_bytes<KeyType>(delegation_sketch_context.delegation_configs.FILTER_SIZE) +
+                                                                   sizeof(PendingQuery<KeyType>)) +
+            CACHE_LINE_SIZE),
+      local_heavy_hitter_tracker(delegation_sketch_context), current_thread_id(current_thread_id) {
 
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
     int filter_size = delegation_sketch_context.delegation_configs.FILTER_SIZE;
     this->delegation_sketch = delegation_sketch;
-    this->delegation_filters = std::vector<DelegationFilter *>();
-    this->pending_queries = std::vector<PendingQuery *>();
+    this->delegation_filters = std::vector<DelegationFilter<KeyType> *>();
+    this->pending_queries = std::vector<PendingQuery<KeyType> *>();
     this->thread_pairwise_stat_collectors = std::vector<ThreadPairWiseStatCollector>(num_threads);
     this->thread_overall_stat_collector = ThreadOverallStatCollector();
-    this->seeds = seed_rand();
+    this->seeds = static_cast<unsigned long *>(arena.allocate(3 * sizeof(unsigned long)));
+    seed_rand(this->seeds);
 
+    const auto &placement = delegation_sketch_context.placement;
+    int node = placement.nodes[current_thread_id];
     for (int i = 0; i < num_threads; ++i) {
-        this->double_buffer_delegation_filters[0].push_back(std::move(new DelegationFilter(filter_size)));
-        this->double_buffer_delegation_filters[1].push_back(std::move(new DelegationFilter(filter_size)));
+#if EQUAL(PARALLEL_DESIGN, HIERARCHICAL)
+        // owners on other nodes are reached through the relay thread of our node
+        this->delegation_targets.push_back(placement.relay_of(i, node));
+#else
+        this->delegation_targets.push_back(i);
+#endif
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        // a filter towards i is needed if i is a delegation target, or if we relay the keys of our node to the remote owner i
+        bool is_target = std::find(delegation_targets.begin(), delegation_targets.end(), i) != delegation_targets.end();
+        bool is_relayed_owner = placement.nodes[i] != node && placement.relay_of(i, node) == current_thread_id;
+        bool has_filter = is_target || is_relayed_owner;
+
+        this->double_buffer_delegation_filters[0].push_back(has_filter ? arena.create<DelegationFilter<KeyType>>(filter_size, &arena) : nullptr);
+        this->double_buffer_delegation_filters[1].push_back(has_filter ? arena.create<DelegationFilter<KeyType>>(filter_size, &arena) : nullptr);
         current_buffer_ids.push_back(0);
-        this->delegation_filters.push_back((DelegationFilter *) this->double_buffer_delegation_filters[0][i]);
-        this->pending_queries.push_back(std::move(new PendingQuery()));
+        this->delegation_filters.push_back((DelegationFilter<KeyType> *) this->double_buffer_delegation_filters[0][i]);
+        this->pending_queries.push_back(arena.create<PendingQuery<KeyType>>());
     }
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::process_pending_inserts() {
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::process_pending_inserts() {
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+    take_heavy_hitter_snapshot();
+#endif
+    take_checkpoint();
     if (full_delegate_filters.is_empty()) { return; }
 
-#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP)
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP) || EQUAL(PARALLEL_DESIGN, HIERARCHICAL)
     while (!full_delegate_filters.is_empty()) {
-        DelegationFilter *filter;
+        DelegationFilter<KeyType> *filter;
         full_delegate_filters.pop(filter);
 
         int filter_size = filter->size.load(std::memory_order_relaxed);
         int total_differences = 0;
+        vector<pair<KeyType, int>> misrouted_items;
         for (int j = 0; j < filter_size; ++j) {
+            // keys of remote owners relayed by the threads of our node, or keys that changed owner in a reshard
+            if (find_owner(filter->keys[j]) != current_thread_id) {
+                misrouted_items.emplace_back(filter->keys[j], filter->counts[j]);
+                filter->counts[j] = 0;
+                filter->keys[j] = KeyType();
+                continue;
+            }
             total_differences += filter->counts[j];
-            int count = this->frequency_estimator.update_and_estimate(filter->keys[j], filter->counts[j]);
+            int count = this->frequency_estimator.update_and_estimate(to_estimator_key(filter->keys[j]), filter->counts[j]);
             this->local_heavy_hitter_tracker.add_if_is_local_heavy_hitter(filter->keys[j], filter->counts[j], count);
             filter->counts[j] = 0;
-            filter->keys[j] = 0;
+            filter->keys[j] = KeyType();
         }
 
         filter->size = 0;
         filter->lock.store(false, std::memory_order_relaxed);
         this->local_heavy_hitter_tracker.update_global_heavy_hitters(this->delegation_sketch->global_heavy_hitter_tracker, total_differences);
+
+        for (auto &[key, count] : misrouted_items) { this->forward(key, count); }
     }
 #elif EQUAL(PARALLEL_DESIGN, QPOPSS)
 
     if (!QPOPSS_mutex.try_lock()) { return; }
 
+    // keys that changed owner in a reshard, forwarded once the mutex is released since delegate may process our own queue again
+    vector<pair<KeyType, int>> misrouted_items;
     while (!full_delegate_filters.is_empty()) {
-        DelegationFilter *filter;
+        DelegationFilter<KeyType> *filter;
         full_delegate_filters.pop(filter);
 
         int total_differences = 0;
         int filter_size = filter->size.load(std::memory_order_relaxed);
         for (int j = 0; j < filter_size; ++j) {
+            if (find_owner(filter->keys[j]) != current_thread_id) {
+                misrouted_items.emplace_back(filter->keys[j], filter->counts[j]);
+                filter->counts[j] = 0;
+                filter->keys[j] = KeyType();
+                continue;
+            }
             total_differences += filter->counts[j];
-            this->frequency_estimator.update(filter->keys[j], filter->counts[j]);
+            this->frequency_estimator.update(to_estimator_key(filter->keys[j]), filter->counts[j]);
             filter->counts[j] = 0;
-            filter->keys[j] = 0;
+            filter->keys[j] = KeyType();
         }
 
         filter->size = 0;
         filter->lock.store(false, std::memory_order_relaxed);
 
-        int QPOPSS_stream_size = 0;
+        int64_t QPOPSS_stream_size = 0;
         // update stream size
         if constexpr (DelegationBuildConfig::evaluate_mode == "accuracy" || DelegationBuildConfig::evaluate_mode == "latency") {
             QPOPSS_stream_size = this->delegation_sketch->QPOPSS_stream_size.fetch_add(total_differences);
@@ -272,29 +551,131 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
             QPOPSS_stream_size = this->delegation_sketch->QPOPSS_stream_size.fetch_add(total_differences);
         }
 
-        this->frequency_estimator.update_threshold(QPOPSS_stream_size * delegation_sketch_context.app_configs.THETA);
+        // the estimator counts in int, a threshold past INT_MAX admits no key either way
+        int64_t threshold = QPOPSS_stream_size * delegation_sketch_context.app_configs.THETA;
+        this->frequency_estimator.update_threshold((int) std::min<int64_t>(threshold, std::numeric_limits<int>::max()));
     }
 
     QPOPSS_mutex.unlock();
+
+    for (auto &[key, count] : misrouted_items) { this->forward(key, count); }
 #endif
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::flush_pending_inserts() {
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::take_heavy_hitter_snapshot() {
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+    if (heavy_hitter_snapshot_epoch.load(std::memory_order_relaxed) >= this->delegation_sketch->heavy_hitter_snapshot_request.load(std::memory_order_acquire)) { return; }
+
+    // whoever gets the mutex first (this thread or a waiting query) takes the snapshot
+    std::unique_lock<std::mutex> lock(QPOPSS_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) { return; }
+    int requested = this->delegation_sketch->heavy_hitter_snapshot_request.load(std::memory_order_acquire);
+    if (heavy_hitter_snapshot_epoch.load(std::memory_order_relaxed) >= requested) { return; }
+
+    auto snapshot = std::make_shared<vector<pair<KeyType, int>>>();
+    for (auto const &el : this->frequency_estimator.get_heavy_hitters()) { snapshot->emplace_back(DelegationKeyTraits<KeyType>::from_estimator_key(el.first), el.second); }
+    heavy_hitter_snapshot.store(std::move(snapshot), std::memory_order_release);
+    heavy_hitter_snapshot_epoch.store(requested, std::memory_order_release);
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::take_checkpoint() {
+#if !EQUAL(PARALLEL_DESIGN, SHARED)
+    if constexpr (Snapshottable<FrequencyEstimator>) {
+        if (checkpoint_epoch.load(std::memory_order_relaxed) >= this->delegation_sketch->checkpoint_request.load(std::memory_order_acquire)) { return; }
+
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+        // the sketch is also updated by whoever holds the mutex
+        std::unique_lock<std::mutex> lock(QPOPSS_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) { return; }
+#endif
+        int requested = this->delegation_sketch->checkpoint_request.load(std::memory_order_acquire);
+        if (checkpoint_epoch.load(std::memory_order_relaxed) >= requested) { return; }
+
+        // only the copy into a buffer happens on the ingest path, writing to disk is left to the thread that asked for the checkpoint
+        std::ostringstream os(std::ios::binary);
+        this->frequency_estimator.save(os);
+        this->local_heavy_hitter_tracker.save(os);
+        write_binary(os, reshard_epoch);
+        checkpoint.store(std::make_shared<const std::string>(std::move(os).str()), std::memory_order_release);
+        checkpoint_epoch.store(requested, std::memory_order_release);
+    }
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::load_checkpoint(std::istream &is) {
+#if !EQUAL(PARALLEL_DESIGN, SHARED)
+    if constexpr (Snapshottable<FrequencyEstimator>) {
+        this->frequency_estimator.load(is);
+        this->local_heavy_hitter_tracker.load(is);
+        read_binary(is, reshard_epoch);
+    }
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> bool ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::try_claim_sketch() {
+    bool expected = false;
+    return sketch_claimed.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::claim_sketch() {
+    while (!try_claim_sketch()) { std::this_thread::yield(); }
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::release_sketch() {
+    sketch_claimed.store(false, std::memory_order_release);
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::flush_pending_inserts() {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    // the items inserted since the last publish, fewer than filter_size, still count towards the stream size and may hold candidates
+    if (shared_pending_items > 0) {
+        this->local_heavy_hitter_tracker.update_shared_global_heavy_hitters(this->delegation_sketch->global_heavy_hitter_tracker, shared_pending_weight);
+        shared_pending_items = 0;
+        shared_pending_weight = 0;
+    }
+#endif
     for (int i = 0; i < this->delegation_sketch_context.app_configs.NUM_THREADS; ++i) {
         auto filter = this->delegation_sketch->thread_local_delegation_sketches[i]->delegation_filters[current_thread_id];
+        if (filter == nullptr) { continue; }
         for (int j = 0; j < filter->size; ++j) {
-            this->frequency_estimator.update(filter->keys[j], filter->counts[j]);
+            // a relay holds keys of remote owners, only called after all threads joined so the owner can be updated directly (claimed, next to a save)
+            auto owner = this->delegation_sketch->thread_local_delegation_sketches[find_owner(filter->keys[j])];
+            owner->claim_sketch();
+            owner->frequency_estimator.update(to_estimator_key(filter->keys[j]), filter->counts[j]);
+            owner->release_sketch();
             filter->counts[j] = 0;
-            filter->keys[j] = 0;
+            filter->keys[j] = KeyType();
         }
         filter->size = 0;
     }
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::insert(const int &key) {
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::insert(const KeyType &key, int weight) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    // no owner, the key goes straight into the shared estimator and candidates are published every filter_size items
+    int count = this->frequency_estimator.update_and_estimate(to_estimator_key(key), weight);
+    this->local_heavy_hitter_tracker.add_if_is_shared_heavy_hitter(key, count);
+    shared_pending_weight += weight;
+    if (++shared_pending_items == this->delegation_sketch_context.delegation_configs.FILTER_SIZE) {
+        this->local_heavy_hitter_tracker.update_shared_global_heavy_hitters(this->delegation_sketch->global_heavy_hitter_tracker, shared_pending_weight);
+        shared_pending_items = 0;
+        shared_pending_weight = 0;
+    }
+#else
+    // the filters accumulate the weight, the owner applies it as one weighted update
     int owner_thread_id = find_owner(key);
+    this->delegate(this->delegation_targets[owner_thread_id], key, weight);
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::delegate(int owner_thread_id, const KeyType &key, int count) {
+    delegate(owner_thread_id, key, count, DelegationKeyTraits<KeyType>::hash(key));
+}
 
-    this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_items();
+template <typename FrequencyEstimator, typename KeyType>
+void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::delegate(int owner_thread_id, const KeyType &key, int count, uint32_t key_hash) {
+    this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_items(count);
 
     // if (owner_thread_id == current_thread_id) {
     //     this->insert_directly(key);
@@ -322,7 +703,13 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
         this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_blocked_loops();
     }
 
-    int count = filter->update_or_insert_if_not_full_simd(key);
+    int filter_count;
+    if constexpr (std::is_same_v<KeyType, int>) {
+        // int keys are their own hash
+        filter_count = filter->update_or_insert_if_not_full_simd(key, count);
+    } else {
+        filter_count = filter->update_or_insert_if_not_full_simd(key, key_hash, count);
+    }
 
     int filter_capacity = 1000;
     if (filter->size.load(std::memory_order_relaxed) == this->delegation_sketch_context.delegation_configs.FILTER_SIZE) {
@@ -331,7 +718,7 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
         owner_sketch->full_delegate_filters.push(filter);
 
         this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_filters();
-        if (count == filter_capacity) {
+        if (filter_count == filter_capacity) {
             this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_due_to_capacity_filters();
         } else {
             this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_due_to_filtersize_filters();
@@ -339,9 +726,89 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
     }
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::insert_directly(const int &key) { frequency_estimator.update(key); }
+template <typename FrequencyEstimator, typename KeyType>
+void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::insert_routed(const KeyType &key, [[maybe_unused]] uint32_t key_hash, [[maybe_unused]] int owner_thread_id,
+                                                                                  int weight) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    insert(key, weight);
+#else
+    this->delegate(this->delegation_targets[owner_thread_id], key, weight, key_hash);
+#endif
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::forward(const KeyType &key, int count) {
+    int owner_thread_id = find_owner(key);
+    int target_thread_id = this->delegation_targets[owner_thread_id];
+    // we are the relay of the owner on our node, hand the key over the interconnect
+    if (target_thread_id == current_thread_id) { target_thread_id = owner_thread_id; }
+    this->delegate(target_thread_id, key, count);
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::check_reshard() {
+    if (reshard_epoch == this->delegation_sketch->reshard_epoch.load(std::memory_order_acquire)) { return; }
+    apply_reshard();
+
+    // a deactivated thread stops reading the stream but keeps draining (and forwarding) what was delegated to it
+    while (current_thread_id >= this->delegation_sketch->num_active_threads.load(std::memory_order_relaxed) &&
+           delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) {
+        process_pending_inserts();
+        if (reshard_epoch != this->delegation_sketch->reshard_epoch.load(std::memory_order_acquire)) { apply_reshard(); }
+        std::this_thread::yield();
+    }
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::apply_reshard() {
+    reshard_epoch = this->delegation_sketch->reshard_epoch.load(std::memory_order_acquire);
+    int num_threads = this->delegation_sketch_context.app_configs.NUM_THREADS;
+
+    // hand over partially filled filters, their old owners forward whatever they no longer own
+    for (int i = 0; i < num_threads; ++i) {
+        auto filter = delegation_filters[i];
+        if (filter == nullptr || filter->lock.load(std::memory_order_relaxed) || filter->size.load(std::memory_order_relaxed) == 0) { continue; }
+        filter->lock.store(true, std::memory_order_relaxed);
+        this->delegation_sketch->thread_local_delegation_sketches[i]->full_delegate_filters.push(filter);
+    }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::process_pending_queries() {
+    // move the tracked heavy keys that changed owner: the old owner removes them from its sketch and forwards their count as one weighted
+    // update, so a count is only ever held by one sketch and the stream size is credited again when the new owner processes it.
+    // Keys below the heavy hitter threshold are not tracked and a sketch cannot list them, their counts stay behind in the old owner's
+    // sketch (which no longer answers for them) and the new owner counts them from zero. Without KeyRemovable nothing is moved.
+    vector<pair<KeyType, int>> migrated_items;
+    if constexpr (KeyRemovable<FrequencyEstimator>) {
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP) || EQUAL(PARALLEL_DESIGN, HIERARCHICAL)
+        vector<KeyType> moved_keys;
+        for (const auto &el : this->local_heavy_hitter_tracker.local_heavy_hitters) {
+            if (find_owner(el.first) != current_thread_id) { moved_keys.push_back(el.first); }
+        }
+        auto &global_heavy_hitter_tracker = this->delegation_sketch->global_heavy_hitter_tracker;
+        for (const auto &key : moved_keys) {
+            int count = this->frequency_estimator.remove(to_estimator_key(key));
+            this->local_heavy_hitter_tracker.local_heavy_hitters.remove(key);
+            global_heavy_hitter_tracker.global_heavy_hitters.erase(key);
+            global_heavy_hitter_tracker.stream_size.fetch_sub(count);
+            if (count > 0) { migrated_items.emplace_back(key, count); }
+        }
+#elif EQUAL(PARALLEL_DESIGN, QPOPSS)
+        std::lock_guard<std::mutex> lock(QPOPSS_mutex);
+        vector<estimator_key_t<KeyType>> moved_keys;
+        for (auto const &el : this->frequency_estimator.get_heavy_hitters()) {
+            if (find_owner(DelegationKeyTraits<KeyType>::from_estimator_key(el.first)) != current_thread_id) { moved_keys.push_back(el.first); }
+        }
+        for (const auto &estimator_key : moved_keys) {
+            int count = this->frequency_estimator.remove(estimator_key);
+            this->delegation_sketch->QPOPSS_stream_size.fetch_sub(count);
+            if (count > 0) { migrated_items.emplace_back(DelegationKeyTraits<KeyType>::from_estimator_key(estimator_key), count); }
+        }
+#endif
+    }
+    for (auto &[key, count] : migrated_items) { this->forward(key, count); }
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::insert_directly(const KeyType &key) {
+    frequency_estimator.update(to_estimator_key(key));
+}
+
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::process_pending_queries() {
     return;
     for (int i = 0; i < this->delegation_sketch_context.app_configs.NUM_THREADS; ++i) {
         auto query = this->pending_queries[i];
@@ -349,9 +816,9 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
             int count = 0;
             for (int j = 0; j < this->delegation_sketch_context.app_configs.NUM_THREADS; ++j) {
                 auto &filter = this->delegation_sketch->thread_local_delegation_sketches[j]->delegation_filters[current_thread_id];
-                count += filter->lookup_value_simd(query->key);
+                if (filter != nullptr) { count += filter->lookup_value_simd(query->key); }
             }
-            count += frequency_estimator.estimate(query->key);
+            count += frequency_estimator.estimate(to_estimator_key(query->key));
             query->count = count;
             query->flag = false;
 
@@ -366,7 +833,10 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<Fre
     }
 }
 
-template <typename FrequencyEstimator> int ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::query(const int &key) {
+template <typename FrequencyEstimator, typename KeyType> int ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::query(const KeyType &key) {
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+    return frequency_estimator.estimate(to_estimator_key(key));
+#endif
     int owner_thread_id = find_owner(key);
     if (owner_thread_id == current_thread_id) { return this->query_directly(key); }
     auto query = this->delegation_sketch->thread_local_delegation_sketches[owner_thread_id]->pending_queries[current_thread_id];
@@ -378,16 +848,16 @@ template <typename FrequencyEstimator> int ThreadLocalDelegationHeavyHitter<Freq
     return query->count;
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::query_all_heavy_hitters(map<int, int> &results) {
+template <typename FrequencyEstimator, typename KeyType> void ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::query_all_heavy_hitters(map<KeyType, int> &results) {
     this->delegation_sketch->query_all_heavy_hitters(results);
 }
-template <typename FrequencyEstimator> int ThreadLocalDelegationHeavyHitter<FrequencyEstimator>::query_directly(const int &key) {
+template <typename FrequencyEstimator, typename KeyType> int ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType>::query_directly(const KeyType &key) {
     int count = 0;
     for (int i = 0; i < this->delegation_sketch_context.app_configs.NUM_THREADS; ++i) {
         auto &filter = this->delegation_sketch->thread_local_delegation_sketches[i]->delegation_filters[current_thread_id];
-        count += filter->lookup_value_simd(key);
+        if (filter != nullptr) { count += filter->lookup_value_simd(key); }
     }
-    count += frequency_estimator.estimate(key);
+    count += frequency_estimator.estimate(to_estimator_key(key));
 
     for (int j = 0; j < this->delegation_sketch_context.app_configs.NUM_THREADS; ++j) {
         if (j == current_thread_id) { continue; }
@@ -400,39 +870,93 @@ template <typename FrequencyEstimator> int ThreadLocalDelegationHeavyHitter<Freq
     return count;
 }
 
-template <typename FrequencyEstimator>
-void start_thread_heavy_hitter(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator> *thread_local_delegation_sketch, int start,
+template <typename FrequencyEstimator, typename KeyType>
+void start_thread_heavy_hitter(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType> *thread_local_delegation_sketch, int start,
                                int end, std::barrier<> &sync_point) {
-    setaffinity_oncpu(thread_local_delegation_sketch->current_thread_id + 2);
+    setaffinity_oncpu(delegation_sketch_context.placement.cpus[thread_local_delegation_sketch->current_thread_id]);
+    // held until the end of the run, a save in the meantime waits for this thread to serialize its own sketch
+    thread_local_delegation_sketch->claim_sketch();
     sync_point.arrive_and_wait();
     while (delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) {
         for (int i = start; i < end; i++) {
+            thread_local_delegation_sketch->check_reshard();
+            if (!delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) { break; }
             if (delegation_sketch_context.delegation_configs.QUERY_RATE &&
                 should_perform_query(thread_local_delegation_sketch->seeds, delegation_sketch_context.delegation_configs.QUERY_RATE)) {
-                unsigned int key = delegation_sketch_context.r1->tuples->at(i);
-                int freq = thread_local_delegation_sketch->query(key);
+                KeyType key = delegation_sketch_context.r1->key_at<KeyType>(i);
+                thread_local_delegation_sketch->query(key);
             }
             if (delegation_sketch_context.delegation_configs.HEAVY_QUERY_RATE &&
                 should_perform_query(thread_local_delegation_sketch->seeds, delegation_sketch_context.delegation_configs.HEAVY_QUERY_RATE)) {
-                unsigned int key = delegation_sketch_context.r1->tuples->at(i);
-                map<int, int> results;
+                map<KeyType, int> results;
                 thread_local_delegation_sketch->query_all_heavy_hitters(results);
                 // std::cout << "result size: " << results.size() << std::endl;
             } else {
                 // std::cout << "no heavy query" << std::endl;
             }
-            unsigned int key = delegation_sketch_context.r1->tuples->at(i);
-            thread_local_delegation_sketch->insert(key);
+            KeyType key = delegation_sketch_context.r1->key_at<KeyType>(i);
+            int weight = delegation_sketch_context.r1->weight_at(i);
+            thread_local_delegation_sketch->insert(key, weight);
             thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_items();
+            thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_weight(weight);
             thread_local_delegation_sketch->process_pending_inserts();
             if (!delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) { break; }
         }
     }
+    thread_local_delegation_sketch->release_sketch();
 }
 
-template <typename FrequencyEstimator>
-void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch,
-                              map<int, int> &accuracy_evaluator_heavy_hitter_counter, std::barrier<> &sync_point) {
+// workers of the ingest pipeline: route the blocks the readers hand over, and keep draining the filters while none is ready
+template <typename FrequencyEstimator, typename KeyType>
+void start_thread_heavy_hitter_pipelined(DelegationSketchContext &delegation_sketch_context, ThreadLocalDelegationHeavyHitter<FrequencyEstimator, KeyType> *thread_local_delegation_sketch,
+                                         IngestPipeline<KeyType> *ingest_pipeline, std::barrier<> &sync_point) {
+    setaffinity_oncpu(delegation_sketch_context.placement.cpus[thread_local_delegation_sketch->current_thread_id]);
+    int worker = thread_local_delegation_sketch->current_thread_id;
+    // held until the end of the run, a save in the meantime waits for this thread to serialize its own sketch
+    thread_local_delegation_sketch->claim_sketch();
+    sync_point.arrive_and_wait();
+    while (delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) {
+        thread_local_delegation_sketch->check_reshard();
+        IngestBlock<KeyType> *block = ingest_pipeline->next_block(worker);
+        if (block == nullptr) {
+            // no block comes after a reader failed, the run stops and start_threads rethrows the error
+            if (ingest_pipeline->failed()) {
+                delegation_sketch_context.START_BENCHMARK.store(false, std::memory_order_relaxed);
+                break;
+            }
+            thread_local_delegation_sketch->process_pending_inserts();
+            continue;
+        }
+
+        int i = 0;
+        for (; i < block->size && delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed); i++) {
+            const KeyType &key = block->keys[i];
+            if (delegation_sketch_context.delegation_configs.QUERY_RATE &&
+                should_perform_query(thread_local_delegation_sketch->seeds, delegation_sketch_context.delegation_configs.QUERY_RATE)) {
+                thread_local_delegation_sketch->query(key);
+            }
+            if (delegation_sketch_context.delegation_configs.HEAVY_QUERY_RATE &&
+                should_perform_query(thread_local_delegation_sketch->seeds, delegation_sketch_context.delegation_configs.HEAVY_QUERY_RATE)) {
+                map<KeyType, int> results;
+                thread_local_delegation_sketch->query_all_heavy_hitters(results);
+            }
+            thread_local_delegation_sketch->insert_routed(key, block->hashes[i], block->owners[i], block->weights[i]);
+            thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_items();
+            thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_weight(block->weights[i]);
+            thread_local_delegation_sketch->process_pending_inserts();
+        }
+        if (i < block->size) {
+            ingest_pipeline->return_unconsumed(worker, block, i);
+            break;
+        }
+        ingest_pipeline->release_block(worker, block);
+    }
+    thread_local_delegation_sketch->release_sketch();
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                              map<KeyType, int> &accuracy_evaluator_heavy_hitter_counter, std::barrier<> &sync_point) {
 
     setaffinity_oncpu(1);
     sync_point.arrive_and_wait();
@@ -458,7 +982,7 @@ void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context
         int NUM_QUERIES = 1000;
         while (delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed) && NUM_QUERIES-- > 0) {
             auto start_time = std::chrono::high_resolution_clock::now();
-            map<int, int> results;
+            map<KeyType, int> results;
             delegation_sketch->query_all_heavy_hitters(results);
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
@@ -470,10 +994,105 @@ void start_accuracy_evaluator(DelegationSketchContext &delegation_sketch_context
     }
 };
 
-template <typename FrequencyEstimator>
-DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext &delegation_sketch_context, vector<FrequencyEstimator> &frequency_estimators) {
+template <typename FrequencyEstimator, typename KeyType>
+MetricsSnapshot collect_metrics_snapshot(DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, int num_threads) {
+    MetricsSnapshot snapshot;
+    snapshot.received_items.resize(num_threads);
+    snapshot.blocked_loops.resize(num_threads);
+    snapshot.queue_depth.resize(num_threads);
+    snapshot.backlog_items.resize(num_threads);
+    snapshot.buffered_items.resize(num_threads);
+
+    for (int i = 0; i < num_threads; i++) {
+        auto thread_local_delegation_sketch = delegation_sketch->thread_local_delegation_sketches[i];
+        snapshot.received_items[i] = relaxed_load(thread_local_delegation_sketch->thread_overall_stat_collector.count_received_from_stream_items);
+        snapshot.total_received_items += snapshot.received_items[i];
+
+        for (int j = 0; j < num_threads; j++) {
+            snapshot.blocked_loops[i] += relaxed_load(thread_local_delegation_sketch->thread_pairwise_stat_collectors[j].count_delegate_to_j_blocked_loops);
+
+            // a locked filter of thread i towards owner j sits in j's full_delegate_filters until j processes it
+            for (auto &filters : thread_local_delegation_sketch->double_buffer_delegation_filters) {
+                if (filters[j] == nullptr) { continue; }
+                int filter_size = filters[j]->size.load(std::memory_order_relaxed);
+                if (filters[j]->lock.load(std::memory_order_relaxed)) {
+                    snapshot.queue_depth[j]++;
+                    snapshot.backlog_items[j] += filter_size;
+                } else {
+                    snapshot.buffered_items[j] += filter_size;
+                }
+            }
+        }
+    }
+
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP) || EQUAL(PARALLEL_DESIGN, HIERARCHICAL) || EQUAL(PARALLEL_DESIGN, SHARED)
+    snapshot.heavy_hitter_count = delegation_sketch->global_heavy_hitter_tracker.global_heavy_hitters.size();
+#elif EQUAL(PARALLEL_DESIGN, QPOPSS)
+    for (int i = 0; i < num_threads; i++) {
+        std::lock_guard<std::mutex> lock(delegation_sketch->thread_local_delegation_sketches[i]->QPOPSS_mutex);
+        snapshot.heavy_hitter_count += delegation_sketch->thread_local_delegation_sketches[i]->frequency_estimator.get_heavy_hitters().size();
+    }
+#endif
+    return snapshot;
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_metrics_reporter(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                            std::atomic<bool> &STOP_METRICS_REPORTER) {
+    MetricsReporter metrics_reporter(delegation_sketch_context.delegation_configs.METRICS_INTERVAL_MS, delegation_sketch_context.delegation_configs.METRICS_OUTPUT,
+                                     delegation_sketch_context.delegation_configs.METRICS_SOCKET);
+
+    while (true) {
+        metrics_reporter.wait_for_next_sample();
+        // sample once more after the stop request so that the last line covers the whole run
+        bool stop = STOP_METRICS_REPORTER.load(std::memory_order_relaxed);
+        metrics_reporter.report(collect_metrics_snapshot(delegation_sketch, delegation_sketch_context.app_configs.NUM_THREADS));
+        if (stop) { break; }
+    }
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_checkpointer(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, std::atomic<bool> &STOP_CHECKPOINTER) {
+    auto interval = std::chrono::milliseconds(delegation_sketch_context.delegation_configs.CHECKPOINT_INTERVAL_MS);
+    auto next_checkpoint = std::chrono::steady_clock::now() + interval;
+    while (!STOP_CHECKPOINTER.load(std::memory_order_relaxed)) {
+        // wake up regularly so that stopping does not wait for a whole interval
+        if (std::chrono::steady_clock::now() < next_checkpoint) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        next_checkpoint += interval;
+        // a failed write (full disk, missing directory) skips this checkpoint, the previous file stays intact and ingest goes on
+        try {
+            save_snapshot_file(delegation_sketch_context.delegation_configs.CHECKPOINT_PATH, *delegation_sketch);
+        } catch (const std::exception &e) {
+            cerr << "checkpoint to " << delegation_sketch_context.delegation_configs.CHECKPOINT_PATH << " failed: " << e.what() << endl;
+            continue;
+        }
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        cout << "checkpoint written to " << delegation_sketch_context.delegation_configs.CHECKPOINT_PATH << " in " << duration.count() << " ms" << endl;
+    }
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+void start_reshard_controller(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch,
+                              vector<pair<int, int>> reshard_schedule) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto &[at_ms, num_active_threads] : reshard_schedule) {
+        // wake up regularly so that the controller does not outlive a benchmark that stops early
+        while (std::chrono::steady_clock::now() < start + std::chrono::milliseconds(at_ms)) {
+            if (!delegation_sketch_context.START_BENCHMARK.load(std::memory_order_relaxed)) { return; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        delegation_sketch->reshard(num_active_threads);
+    }
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+DelegationHeavyHitter<FrequencyEstimator, KeyType> *start_threads(DelegationSketchContext &delegation_sketch_context, vector<FrequencyEstimator> &frequency_estimators) {
     vector<thread> threads;
-    map<int, int> accuracy_evaluator_heavy_hitter_counter;
+    map<KeyType, int> accuracy_evaluator_heavy_hitter_counter;
 
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
     int tuples_no = delegation_sketch_context.app_configs.tuples_no;
@@ -481,7 +1100,27 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
     int THETA = delegation_sketch_context.app_configs.THETA;
 
     // init DelegationSketch
-    DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch = new DelegationHeavyHitter<FrequencyEstimator>(std::ref(delegation_sketch_context), frequency_estimators);
+    DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch = new DelegationHeavyHitter<FrequencyEstimator, KeyType>(std::ref(delegation_sketch_context), frequency_estimators);
+
+    // continue from a previous run
+    const auto &delegation_configs = delegation_sketch_context.delegation_configs;
+    if (!delegation_configs.RESTORE_PATH.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        load_snapshot_file(delegation_configs.RESTORE_PATH, *delegation_sketch);
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        cout << "checkpoint restored from " << delegation_configs.RESTORE_PATH << " in " << duration.count() << " ms" << endl;
+    }
+
+    // reader threads decode the stream and feed the workers, the stream file is written here, before the clock starts and before any
+    // thread is started, so that an I/O error leaves nothing to join
+    if (delegation_configs.INGEST != "direct") {
+        auto &app_configs = delegation_sketch_context.app_configs;
+        string stream_name = app_configs.DATASET + "_tuples" + to_string(tuples_no) + "_dist" + to_string(app_configs.DIST_TYPE) + "_" + to_string(app_configs.DIST_PARAM) +
+                             "_" + to_string(app_configs.DIST_SHUFF) + "_dom" + to_string(app_configs.DOM_SIZE) + "_" + app_configs.WEIGHTS + "_" +
+                             to_string(app_configs.WEIGHT_PARAM);
+        delegation_sketch->ingest_pipeline =
+            std::make_unique<IngestPipeline<KeyType>>(delegation_sketch_context.r1, tuples_no, num_threads, delegation_configs, app_configs.PLACEMENT, stream_name);
+    }
 
     // init sync_point and threads based on evaluate_mode
     const size_t barrier_count = (DelegationBuildConfig::evaluate_mode == "accuracy" || DelegationBuildConfig::evaluate_mode == "latency") ? num_threads + 2 : num_threads + 1;
@@ -489,16 +1128,22 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
 
     // if mode==accuracy, start the accuracy evaluator thread
     if constexpr (DelegationBuildConfig::evaluate_mode == "accuracy" || DelegationBuildConfig::evaluate_mode == "latency") {
-        threads.push_back(std::move(std::thread(start_accuracy_evaluator<FrequencyEstimator>, std::ref(delegation_sketch_context), delegation_sketch,
+        threads.push_back(std::move(std::thread(start_accuracy_evaluator<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context), delegation_sketch,
                                                 std::ref(accuracy_evaluator_heavy_hitter_counter), std::ref(sync_point))));
     }
 
     // start threads
     for (int i = 0; i < num_threads; i++) {
+        if (delegation_sketch->ingest_pipeline) {
+            threads.push_back(std::move(std::thread(start_thread_heavy_hitter_pipelined<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context),
+                                                    delegation_sketch->thread_local_delegation_sketches[i], delegation_sketch->ingest_pipeline.get(), std::ref(sync_point))));
+            continue;
+        }
         int start = i * (tuples_no / num_threads);
         int end = i == num_threads - 1 ? tuples_no : (i + 1) * (tuples_no / num_threads);
-        cout << "thread: " << i << " start: " << start << " end: " << end << " end-start:" << end - start << endl;
-        threads.push_back(std::move(std::thread(start_thread_heavy_hitter<FrequencyEstimator>, std::ref(delegation_sketch_context),
+        cout << "thread: " << i << " start: " << start << " end: " << end << " end-start:" << end - start << " cpu: " << delegation_sketch_context.placement.cpus[i]
+             << " node: " << delegation_sketch_context.placement.nodes[i] << endl;
+        threads.push_back(std::move(std::thread(start_thread_heavy_hitter<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context),
                                                 delegation_sketch->thread_local_delegation_sketches[i], start, end, std::ref(sync_point))));
     }
 
@@ -506,6 +1151,29 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
     delegation_sketch_context.START_BENCHMARK.store(true, std::memory_order_relaxed);
     sync_point.arrive_and_wait();
     start_time();
+    if (delegation_sketch->ingest_pipeline) { delegation_sketch->ingest_pipeline->start(); }
+
+    // thread count changes scheduled relative to the start of the benchmark
+    std::thread reshard_controller_thread;
+    if (!delegation_sketch_context.delegation_configs.RESHARD_SCHEDULE.empty()) {
+        reshard_controller_thread = std::thread(start_reshard_controller<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context), delegation_sketch,
+                                                parse_reshard_schedule(delegation_sketch_context.delegation_configs.RESHARD_SCHEDULE));
+    }
+
+    // live metrics run next to the benchmark and are stopped after all worker threads joined
+    std::atomic<bool> STOP_METRICS_REPORTER = false;
+    std::thread metrics_reporter_thread;
+    if (delegation_sketch_context.delegation_configs.METRICS_INTERVAL_MS > 0) {
+        metrics_reporter_thread =
+            std::thread(start_metrics_reporter<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context), delegation_sketch, std::ref(STOP_METRICS_REPORTER));
+    }
+
+    // periodic checkpoints taken while the threads keep ingesting
+    std::atomic<bool> STOP_CHECKPOINTER = false;
+    std::thread checkpointer_thread;
+    if (!delegation_configs.CHECKPOINT_PATH.empty() && delegation_configs.CHECKPOINT_INTERVAL_MS > 0) {
+        checkpointer_thread = std::thread(start_checkpointer<FrequencyEstimator, KeyType>, std::ref(delegation_sketch_context), delegation_sketch, std::ref(STOP_CHECKPOINTER));
+    }
 
     if constexpr (DelegationBuildConfig::evaluate_mode == "latency") {
         // for latency
@@ -524,9 +1192,12 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
         }
     } else {
 
-        // sleep for DURATION seconds and then stop the benchmark
+        // sleep for DURATION seconds and then stop the benchmark, earlier if the ingest readers failed
         if (DURATION > 0) {
-            std::this_thread::sleep_for(std::chrono::seconds(DURATION));
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(DURATION);
+            while (!(delegation_sketch->ingest_pipeline && delegation_sketch->ingest_pipeline->failed()) && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_until(std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(10)));
+            }
             delegation_sketch_context.START_BENCHMARK.store(false, std::memory_order_relaxed);
             stop_time();
         }
@@ -534,6 +1205,17 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
 
     // join threads
     for (int i = 0; i < threads.size(); i++) { threads[i].join(); }
+    if (reshard_controller_thread.joinable()) { reshard_controller_thread.join(); }
+    if (delegation_sketch->ingest_pipeline) { delegation_sketch->ingest_pipeline->stop(); }
+
+    STOP_METRICS_REPORTER.store(true, std::memory_order_relaxed);
+    if (metrics_reporter_thread.joinable()) { metrics_reporter_thread.join(); }
+
+    STOP_CHECKPOINTER.store(true, std::memory_order_relaxed);
+    if (checkpointer_thread.joinable()) { checkpointer_thread.join(); }
+
+    // every thread is joined, a reader's I/O error surfaces here like any other
+    if (delegation_sketch->ingest_pipeline) { delegation_sketch->ingest_pipeline->rethrow_reader_error(); }
 
     // process all pending inserts before joining
     for (int i = 0; i < num_threads; i++) {
@@ -541,10 +1223,13 @@ DelegationHeavyHitter<FrequencyEstimator> *start_threads(DelegationSketchContext
         delegation_sketch->thread_local_delegation_sketches[i]->flush_pending_inserts();
     }
 
+    // the final checkpoint includes the flushed filters
+    if (!delegation_configs.CHECKPOINT_PATH.empty()) { save_snapshot_file(delegation_configs.CHECKPOINT_PATH, *delegation_sketch); }
+
     return delegation_sketch;
 }
-template <typename FrequencyEstimator>
-void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch, string output_file_path) {
+template <typename FrequencyEstimator, typename KeyType>
+void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, string output_file_path) {
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
 
     // Create an output file stream if output_file_path is specified
@@ -565,7 +1250,7 @@ void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketc
 
     // Rest of the function remains largely the same, replace cout with print
 
-    long long total_insert_processed = 0, total_query_processed = 0, total_insert_processed_from_sketch = 0;
+    long long total_insert_processed = 0, total_query_processed = 0, total_insert_processed_from_sketch = 0, total_weight_processed = 0;
     long long total_need_to_wait = 0, total_no_need_to_wait = 0, total_count_looping_when_waiting = 0;
 
     vector<vector<ThreadPairWiseStatCollector>> all_thread_pairwise_stat_collectors;
@@ -573,7 +1258,13 @@ void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketc
 
     for (int i = 0; i < num_threads; i++) {
         total_insert_processed += delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_items;
+        total_weight_processed += delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_weight;
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+        // every thread reports the same estimator
+        if (i == 0) { total_insert_processed_from_sketch += delegation_sketch->thread_local_delegation_sketches[i]->frequency_estimator.total; }
+#else
         total_insert_processed_from_sketch += delegation_sketch->thread_local_delegation_sketches[i]->frequency_estimator.total;
+#endif
         total_query_processed += delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_query_processed;
         print("thread " + to_string(i) +
               " proccessed:" + to_string(delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_items) + "\n");
@@ -586,7 +1277,7 @@ void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketc
             delegation_sketch->thread_local_delegation_sketches[i]->thread_pairwise_stat_collectors[j].update_delegated_from_j_filters(
                 delegation_sketch->thread_local_delegation_sketches[j]->thread_pairwise_stat_collectors[i].count_delegate_to_j_filters);
         }
-        map<string, int> metrics = delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.calculate_all_metrics(
+        map<string, int64_t> metrics = delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.calculate_all_metrics(
             delegation_sketch->thread_local_delegation_sketches[i]->thread_pairwise_stat_collectors,
             delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector);
         print_metrics(metrics);
@@ -605,36 +1296,60 @@ void print_stats_for_delegation_sketch(DelegationSketchContext &delegation_sketc
     print("num_threads: " + to_string(delegation_sketch_context.app_configs.NUM_THREADS) + " total query processed: " + to_string(float(total_query_processed) / 1000000) +
           "Mops time process: " + to_string(get_time_ms() / 1000) + "\n");
     print("Throughput: " + to_string(float(total_insert_processed) / 1000000) + "\n");
+    print("Weighted throughput: " + to_string(float(total_weight_processed) / 1000000) + "\n");
+    if (delegation_sketch->ingest_pipeline) {
+        long total_handed_over = 0;
+        for (int i = 0; i < delegation_sketch->ingest_pipeline->num_readers(); i++) { total_handed_over += delegation_sketch->ingest_pipeline->items_handed_over(i); }
+        print("Ingest: " + delegation_sketch_context.delegation_configs.INGEST + " readers: " + to_string(delegation_sketch->ingest_pipeline->num_readers()) +
+              " handed over: " + to_string(float(total_handed_over) / 1000000) + " unconsumed: " + to_string(delegation_sketch->ingest_pipeline->unconsumed_items().size()) + "\n");
+    }
 
     // Close the file if it was opened
     if (output_file.is_open()) { output_file.close(); }
 }
 
-template <typename FrequencyEstimator>
-pair<map<int, int>, long> calculate_exact_counter(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch) {
+template <typename FrequencyEstimator, typename KeyType>
+pair<map<KeyType, int64_t>, int64_t> calculate_exact_counter(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch) {
     Relation *r1 = delegation_sketch_context.r1;
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
     int tuples_no = delegation_sketch_context.app_configs.tuples_no;
 
-    map<int, int> exact_counter;
-    long total_processed = 0;
+    map<KeyType, int64_t> exact_counter;
+    int64_t total_processed = 0;
+
+    // the tuples [start, end) were read in order num_processed times over, passes full passes and rest items into the next one
+    auto count_range = [&](int start, int end, long num_processed) {
+        if (end == start) { return; }
+        long passes = num_processed / (end - start);
+        for (int j = start; j < end; j++) {
+            KeyType key = r1->key_at<KeyType>(j);
+            exact_counter[key] += passes * r1->weight_at(j);
+        }
+
+        long rest = num_processed - (end - start) * passes;
+        for (int j = start; j < start + rest; j++) {
+            KeyType key = r1->key_at<KeyType>(j);
+            exact_counter[key] += r1->weight_at(j);
+        }
+    };
 
     for (int i = 0; i < num_threads; i++) {
+        total_processed += delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_weight;
+        if (delegation_sketch->ingest_pipeline) { continue; }
         int start = i * (tuples_no / num_threads);
         int end = i == num_threads - 1 ? tuples_no : (i + 1) * (tuples_no / num_threads);
-        int num_processed = delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_items;
-        total_processed += num_processed;
+        count_range(start, end, delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.count_received_from_stream_items);
+    }
 
-        int weight = num_processed / (end - start);
-        for (int j = start; j < end; j++) {
-            unsigned int key = r1->tuples->at(j);
-            exact_counter[key] += weight;
+    if (delegation_sketch->ingest_pipeline) {
+        // the readers went over their ranges, minus what was still on its way to the workers when they stopped
+        auto &ingest_pipeline = *delegation_sketch->ingest_pipeline;
+        for (int i = 0; i < ingest_pipeline.num_readers(); i++) {
+            auto [start, end] = ingest_pipeline.reader_range(i);
+            count_range(start, end, ingest_pipeline.items_handed_over(i));
         }
-
-        int rest = num_processed - (end - start) * weight;
-        for (int j = start; j < start + rest; j++) {
-            unsigned int key = r1->tuples->at(j);
-            exact_counter[key]++;
+        for (const auto &[key, weight] : ingest_pipeline.unconsumed_items()) {
+            if ((exact_counter[key] -= weight) == 0) { exact_counter.erase(key); }
         }
     }
 
@@ -642,19 +1357,19 @@ pair<map<int, int>, long> calculate_exact_counter(DelegationSketchContext &deleg
 }
 
 template <typename FrequencyEstimator, typename KeyType>
-void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator> *delegation_sketch, string output_file_path) {
+void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_context, DelegationHeavyHitter<FrequencyEstimator, KeyType> *delegation_sketch, string output_file_path) {
     int num_threads = delegation_sketch_context.app_configs.NUM_THREADS;
     int tuples_no = delegation_sketch_context.app_configs.tuples_no;
     float theta = delegation_sketch_context.app_configs.THETA;
-    map<int, int> accuracy_evaluator_heavy_hitter_counter = delegation_sketch->accuracy_evaluator_heavy_hitter_counter;
-    map<int, int> exact_counter;
-    long total_processed = 0;
-    tie(exact_counter, total_processed) = calculate_exact_counter<FrequencyEstimator>(std::ref(delegation_sketch_context), delegation_sketch);
+    map<KeyType, int> accuracy_evaluator_heavy_hitter_counter = delegation_sketch->accuracy_evaluator_heavy_hitter_counter;
+    map<KeyType, int64_t> exact_counter;
+    int64_t total_processed = 0;
+    tie(exact_counter, total_processed) = calculate_exact_counter<FrequencyEstimator, KeyType>(std::ref(delegation_sketch_context), delegation_sketch);
 
-    int threshold = total_processed * theta;
+    int64_t threshold = total_processed * theta;
 
-    map<int, int> heavy_hitter_counter;
-    map<int, int> heavy_hitter_counter_2;
+    map<KeyType, int64_t> heavy_hitter_counter;
+    map<KeyType, int64_t> heavy_hitter_counter_2;
     int count_correct = 0;
 
     // Calculate heavy hitters and error
@@ -662,7 +1377,7 @@ void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_co
         if (el.second > threshold) { heavy_hitter_counter[el.first] = el.second; }
     }
 
-#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP)
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP) || EQUAL(PARALLEL_DESIGN, HIERARCHICAL) || EQUAL(PARALLEL_DESIGN, SHARED)
     if constexpr (DelegationBuildConfig::evaluate_mode == "throughput" || DelegationBuildConfig::evaluate_mode == "latency") {
         auto global_heavy_hitters = delegation_sketch->global_heavy_hitter_tracker.global_heavy_hitters.lock_table();
         for (const auto &top : global_heavy_hitters) {
@@ -681,8 +1396,9 @@ void print_stats_for_heavy_hitters(DelegationSketchContext &delegation_sketch_co
     if constexpr (DelegationBuildConfig::evaluate_mode == "throughput" || DelegationBuildConfig::evaluate_mode == "latency") {
         for (int i = 0; i < num_threads; i++) {
             for (auto const &el : delegation_sketch->thread_local_delegation_sketches[i]->frequency_estimator.get_heavy_hitters()) {
-                int key = el.first;
+                KeyType key = DelegationKeyTraits<KeyType>::from_estimator_key(el.first);
                 int count = el.second;
+                if (find_owner(key) != i) { continue; }
                 if (count >= threshold) {
                     heavy_hitter_counter_2[key] = exact_counter[key];
                     if (heavy_hitter_counter.count(key)) { count_correct += 1; }
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "delegation_sketch/delegation_sketch_utils.hpp"
+#include "heavy_hitter_app/FiveTuple.hpp"
+
+// murmur3 finalizer folded to 32 bits
+inline uint32_t mix_key_hash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return uint32_t(h ^ (h >> 32));
+}
+
+inline uint32_t hash_key_bytes(const char *data, size_t length) {
+    uint64_t h = length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    if (i < length) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, length - i);
+        h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    return mix_key_hash(h);
+}
+
+// How the delegation framework sees a key: a 32-bit hash for routing and filter probes, and the key the frequency
+// estimators are updated with (estimators take int or std::string). Fixed-width keys without a dedicated trait are
+// hashed and handed to the estimators through their bytes.
+template <typename KeyType> struct DelegationKeyTraits {
+    static_assert(std::has_unique_object_representations_v<KeyType>, "keys without a dedicated trait are hashed through their bytes and must not contain padding");
+    using EstimatorKey = std::string;
+
+    static uint32_t hash(const KeyType &key) { return hash_key_bytes(reinterpret_cast<const char *>(&key), sizeof(KeyType)); }
+    static EstimatorKey to_estimator_key(const KeyType &key) { return EstimatorKey(reinterpret_cast<const char *>(&key), sizeof(KeyType)); }
+    static KeyType from_estimator_key(const EstimatorKey &estimator_key) {
+        KeyType key;
+        std::memcpy(&key, estimator_key.data(), sizeof(KeyType));
+        return key;
+    }
+};
+
+// int keys are their own hash, which keeps the key & 511 routing and the key-based SIMD filter
+template <> struct DelegationKeyTraits<int> {
+    using EstimatorKey = int;
+
+    static uint32_t hash(const int &key) { return key; }
+    static const int &to_estimator_key(const int &key) { return key; }
+    static int from_estimator_key(const int &estimator_key) { return estimator_key; }
+};
+
+// the 13 payload bytes, which stay within the small string buffer of std::string
+template <> struct DelegationKeyTraits<FiveTuple> {
+    using EstimatorKey = std::string;
+
+    static uint32_t hash(const FiveTuple &key) {
+        uint64_t hi = (uint64_t(key.src_ip) << 32) | key.dst_ip;
+        uint64_t lo = (uint64_t(key.src_port) << 24) | (uint64_t(key.dst_port) << 8) | key.protocol;
+        return mix_key_hash(hi * 0x9E3779B97F4A7C15ULL ^ lo);
+    }
+    static EstimatorKey to_estimator_key(const FiveTuple &key) {
+        char bytes[13];
+        std::memcpy(bytes, &key.src_ip, 4);
+        std::memcpy(bytes + 4, &key.dst_ip, 4);
+        std::memcpy(bytes + 8, &key.src_port, 2);
+        std::memcpy(bytes + 10, &key.dst_port, 2);
+        bytes[12] = key.protocol;
+        return EstimatorKey(bytes, 13);
+    }
+    static FiveTuple from_estimator_key(const EstimatorKey &estimator_key) {
+        FiveTuple key;
+        std::memcpy(&key.src_ip, estimator_key.data(), 4);
+        std::memcpy(&key.dst_ip, estimator_key.data() + 4, 4);
+        std::memcpy(&key.src_port, estimator_key.data() + 8, 2);
+        std::memcpy(&key.dst_port, estimator_key.data() + 10, 2);
+        key.protocol = estimator_key[12];
+        return key;
+    }
+};
+
+// variable-length keys, the estimators already take them as they are
+template <> struct DelegationKeyTraits<std::string> {
+    using EstimatorKey = std::string;
+
+    static uint32_t hash(const std::string &key) { return hash_key_bytes(key.data(), key.size()); }
+    static const std::string &to_estimator_key(const std::string &key) { return key; }
+    static const std::string &from_estimator_key(const std::string &estimator_key) { return estimator_key; }
+};
+
+template <typename KeyType> decltype(auto) to_estimator_key(const KeyType &key) { return DelegationKeyTraits<KeyType>::to_estimator_key(key); }
+
+template <typename KeyType> using estimator_key_t = typename DelegationKeyTraits<KeyType>::EstimatorKey;
+
+// owners are assigned on the key hash, for int keys this is the key itself
+template <typename KeyType> inline int find_owner(const KeyType &key) { return find_owner(DelegationKeyTraits<KeyType>::hash(key)); }
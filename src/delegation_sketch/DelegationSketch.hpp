@@ -26,6 +26,7 @@
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 #include "heavy_hitter_app/AppConfig.hpp"
 #include "heavy_hitter_app/Relation.hpp"
+#include "utils/CacheLineArena.hpp"
 #include "utils/getticks.hpp"
 
 using AppConfig = ParallelAppConfig;
@@ -51,12 +52,13 @@ template <typename FrequencyEstimator> class DelegationSketch {
 };
 
 // Thread-Local Delegation Sketch
-template <typename FrequencyEstimator> class ThreadLocalDelegationSketch {
+template <typename FrequencyEstimator> class alignas(CACHE_LINE_SIZE) ThreadLocalDelegationSketch {
   public:
     FrequencyEstimator frequency_estimator;
-    std::vector<PendingQuery *> pending_queries;
-    std::vector<DelegationFilter *> delegation_filters;
-    std::array<std::vector<DelegationFilter *>, 2> double_buffer_delegation_filters;
+    CacheLineArena arena;   // one slab with the filters, pending queries and seeds of this thread
+    std::vector<PendingQuery<int> *> pending_queries;
+    std::vector<DelegationFilter<int> *> delegation_filters;
+    std::array<std::vector<DelegationFilter<int> *>, 2> double_buffer_delegation_filters;
     std::vector<int> current_buffer_ids;
     atomic<bool> START_BENCHMARK;
 
@@ -64,7 +66,7 @@ template <typename FrequencyEstimator> class ThreadLocalDelegationSketch {
     ThreadOverallStatCollector thread_overall_stat_collector;
     DelegationConfig delegation_configs;
 
-    LCRQueue<DelegationFilter *> full_delegate_filters;
+    LCRQueue<DelegationFilter<int> *> full_delegate_filters;
     DelegationSketch<FrequencyEstimator> *delegation_sketch;
     int current_thread_id;
     long long element_processed_during_time_interval = 0, query_processed_during_time_interval = 0;
@@ -77,9 +79,9 @@ template <typename FrequencyEstimator> class ThreadLocalDelegationSketch {
     void process_pending_inserts();
     void process_pending_queries();
     void flush_pending_inserts();
-    void insert(const int &key);
+    void insert(const int &key, int weight = 1);
     int query(const int &key);
-    void insert_directly(const int &key);
+    void insert_directly(const int &key, int weight = 1);
     int query_directly(const int &key);
 };
 
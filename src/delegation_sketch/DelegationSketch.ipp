@@ -32,25 +32,27 @@ template <typename FrequencyEstimator> template <typename T> float DelegationSke
 // ThreadLocalDelegationSketch implementation
 template <typename FrequencyEstimator>
 ThreadLocalDelegationSketch<FrequencyEstimator>::ThreadLocalDelegationSketch(ParallelAppConfig app_configs, DelegationConfig delegation_configs, int current_thread_id,
-                                                                             FrequencyEstimator frequency_estimator, DelegationSketch<FrequencyEstimator> *delegation_sketch) {
+                                                                             FrequencyEstimator frequency_estimator, DelegationSketch<FrequencyEstimator> *delegation_sketch)
+    : arena(delegation_sketch->num_threads * (2 * delegation_filter_arena_bytes<int>(delegation_configs.FILTER_SIZE) + sizeof(PendingQuery<int>)) + CACHE_LINE_SIZE) {
     this->current_thread_id = current_thread_id;
     this->frequency_estimator = frequency_estimator;
     this->delegation_configs = delegation_configs;
     this->FILTER_SIZE = delegation_configs.FILTER_SIZE;
     this->delegation_sketch = delegation_sketch;
-    this->delegation_filters = std::vector<DelegationFilter *>();
-    this->pending_queries = std::vector<PendingQuery *>();
+    this->delegation_filters = std::vector<DelegationFilter<int> *>();
+    this->pending_queries = std::vector<PendingQuery<int> *>();
 
     this->thread_pairwise_stat_collectors = std::vector<ThreadPairWiseStatCollector>(delegation_sketch->num_threads);
     this->thread_overall_stat_collector = ThreadOverallStatCollector();
 
-    this->seeds = seed_rand();
+    this->seeds = static_cast<unsigned long *>(arena.allocate(3 * sizeof(unsigned long)));
+    seed_rand(this->seeds);
     for (int i = 0; i < delegation_sketch->num_threads; ++i) {
-        this->double_buffer_delegation_filters[0].push_back(std::move(new DelegationFilter(FILTER_SIZE)));
-        this->double_buffer_delegation_filters[1].push_back(std::move(new DelegationFilter(FILTER_SIZE)));
+        this->double_buffer_delegation_filters[0].push_back(arena.create<DelegationFilter<int>>(FILTER_SIZE, &arena));
+        this->double_buffer_delegation_filters[1].push_back(arena.create<DelegationFilter<int>>(FILTER_SIZE, &arena));
         current_buffer_ids.push_back(0);
-        this->delegation_filters.push_back((DelegationFilter *) this->double_buffer_delegation_filters[0][i]);
-        this->pending_queries.push_back(std::move(new PendingQuery()));
+        this->delegation_filters.push_back((DelegationFilter<int> *) this->double_buffer_delegation_filters[0][i]);
+        this->pending_queries.push_back(arena.create<PendingQuery<int>>());
     }
 }
 
@@ -58,7 +60,7 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<Frequenc
     if (full_delegate_filters.is_empty()) { return; }
 
     while (!full_delegate_filters.is_empty()) {
-        DelegationFilter *filter;
+        DelegationFilter<int> *filter;
         full_delegate_filters.pop(filter);
 
         int filter_size = filter->size.load(std::memory_order_relaxed);
@@ -86,13 +88,13 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<Frequenc
     }
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<FrequencyEstimator>::insert(const int &key) {
+template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<FrequencyEstimator>::insert(const int &key, int weight) {
     int owner_thread_id = find_owner(key);
 
     this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_items();
 
     if (owner_thread_id == current_thread_id) {
-        this->insert_directly(key);
+        this->insert_directly(key, weight);
         return;
     }
 
@@ -117,7 +119,7 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<Frequenc
         this->thread_pairwise_stat_collectors[owner_thread_id].update_delegate_to_j_blocked_loops();
     }
 
-    int count = filter->update_or_insert_if_not_full_simd(key);
+    int count = filter->update_or_insert_if_not_full_simd(key, weight);
 
     int filter_capacity = 1000;
     if (filter->size.load(std::memory_order_relaxed) == FILTER_SIZE) {
@@ -134,7 +136,7 @@ template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<Frequenc
     }
 }
 
-template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<FrequencyEstimator>::insert_directly(const int &key) { frequency_estimator.update(key); }
+template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<FrequencyEstimator>::insert_directly(const int &key, int weight) { frequency_estimator.update(key, weight); }
 
 template <typename FrequencyEstimator> void ThreadLocalDelegationSketch<FrequencyEstimator>::process_pending_queries() {
     return;
@@ -206,9 +208,11 @@ void start_thread(DelegationConfig delegation_configs, ThreadLocalDelegationSket
                 thread_local_delegation_sketch->query_processed_during_time_interval++;
             }
             unsigned int key = r1->tuples->at(i);
-            thread_local_delegation_sketch->insert(key);
+            int weight = r1->weight_at(i);
+            thread_local_delegation_sketch->insert(key, weight);
 
             thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_items();
+            thread_local_delegation_sketch->thread_overall_stat_collector.update_received_from_stream_weight(weight);
 
             thread_local_delegation_sketch->process_pending_inserts();
             thread_local_delegation_sketch->element_processed_during_time_interval++;
@@ -277,7 +281,7 @@ template <typename FrequencyEstimator> void print_stats_for_delegation_sketch(Ap
             delegation_sketch->thread_local_delegation_sketches[i]->thread_pairwise_stat_collectors[j].update_delegated_from_j_filters(
                 delegation_sketch->thread_local_delegation_sketches[j]->thread_pairwise_stat_collectors[i].count_delegate_to_j_filters);
         }
-        map<string, int> metrics = delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.calculate_all_metrics(
+        map<string, int64_t> metrics = delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector.calculate_all_metrics(
             delegation_sketch->thread_local_delegation_sketches[i]->thread_pairwise_stat_collectors,
             delegation_sketch->thread_local_delegation_sketches[i]->thread_overall_stat_collector);
         print_metrics(metrics);
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_data_structure/SPSCRing.hpp"
+#include "delegation_sketch/CpuTopology.hpp"
+#include "delegation_sketch/DelegationConfig.hpp"
+#include "delegation_sketch/DelegationKey.hpp"
+#include "heavy_hitter_app/Relation.hpp"
+#include "utils/CacheLineArena.hpp"
+
+// items a reader decoded, hashed and assigned to their owner, handed to one worker at once
+template <typename KeyType> struct IngestBlock {
+    vector<KeyType> keys;
+    vector<uint32_t> hashes;
+    vector<int> owners;
+    vector<int> weights;
+    int size = 0;
+
+    explicit IngestBlock(int capacity) : keys(capacity), hashes(capacity), owners(capacity), weights(capacity) {}
+};
+
+// Layout of the stream file: int keys are text lines "key[ weight]" like the integer datasets, so reading them costs a parse;
+// other keys are their bytes followed by the weight.
+template <typename KeyType> struct IngestCodec {
+    static void encode(std::ostream &os, const KeyType &key, int weight) {
+        os.write(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+        os.write(reinterpret_cast<const char *>(&weight), sizeof(int));
+    }
+
+    // decodes the item at p and moves p past it, false if [p, end) does not hold a whole item
+    static bool decode(const char *&p, const char *end, KeyType &key, int &weight) {
+        if (size_t(end - p) < sizeof(KeyType) + sizeof(int)) { return false; }
+        std::memcpy(&key, p, sizeof(KeyType));
+        std::memcpy(&weight, p + sizeof(KeyType), sizeof(int));
+        p += sizeof(KeyType) + sizeof(int);
+        return true;
+    }
+};
+
+template <> struct IngestCodec<int> {
+    static void encode(std::ostream &os, const int &key, int weight) {
+        os << key;
+        if (weight != 1) { os << ' ' << weight; }
+        os << '\n';
+    }
+
+    static bool decode(const char *&p, const char *end, int &key, int &weight) {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (newline == nullptr) { return false; }
+        const char *next = std::from_chars(p, newline, key).ptr;
+        weight = 1;
+        if (next < newline) { std::from_chars(next + 1, newline, weight); }
+        p = newline + 1;
+        return true;
+    }
+};
+
+// Streaming ingest in front of the delegation workers. Reader threads go over their share of the relation again and again,
+// either straight from memory or decoded from a stream file through read() (the path a socket takes) or an mmap, hash every
+// key and look up its owner, and hand blocks of items to their workers over SPSC rings. A worker only routes what it gets.
+// Blocks come from a fixed pool per worker and go back to its reader over a second ring, nothing is allocated while running.
+// A stale owner (after a reshard) is harmless, the old owner forwards the keys it no longer owns.
+// A reader that fails (the stream file cannot be opened or is cut short) stops the other readers, the workers stop once they run
+// out of blocks and the error is rethrown by rethrow_reader_error on the thread that started the pipeline.
+template <typename KeyType> class IngestPipeline {
+  public:
+    // stream_name names the stream file after the dataset and its parameters, runs of the same configuration reuse the file
+    IngestPipeline(Relation *r1, int tuples_no, int num_workers, const DelegationHeavyHitterConfig &configs, const string &placement_policy,
+                   const string &stream_name);
+    ~IngestPipeline();
+    IngestPipeline(const IngestPipeline &) = delete;
+    IngestPipeline &operator=(const IngestPipeline &) = delete;
+
+    void start();
+    // once the workers are joined: stops the readers after their current block and sets aside what no worker inserted
+    void stop();
+    // a reader failed, no more blocks will be handed over
+    bool failed() const { return reader_failed.load(std::memory_order_acquire); }
+    // after stop(): rethrows the error of the first reader that failed, if any
+    void rethrow_reader_error();
+
+    // worker side, nullptr if no block is ready
+    IngestBlock<KeyType> *next_block(int worker) {
+        IngestBlock<KeyType> *block;
+        return workers[worker]->full_blocks.try_dequeue(block) ? block : nullptr;
+    }
+    void release_block(int worker, IngestBlock<KeyType> *block) {
+        block->size = 0;
+        workers[worker]->free_blocks.try_enqueue(block);
+    }
+    // the worker stopped before the item at position, the rest of the block was never inserted
+    void return_unconsumed(int worker, IngestBlock<KeyType> *block, int position) {
+        workers[worker]->unconsumed_block = block;
+        workers[worker]->unconsumed_position = position;
+    }
+
+    int num_readers() const { return readers.size(); }
+    // the tuples [start, end) of the relation reader goes over
+    pair<int, int> reader_range(int reader) const { return {readers[reader]->start, readers[reader]->end}; }
+    // items reader handed to the workers, read in order from the start of its range
+    long items_handed_over(int reader) const { return readers[reader]->items_handed_over.load(std::memory_order_relaxed); }
+
+    // (key, weight) of the items handed over that no worker inserted, filled by stop()
+    const vector<pair<KeyType, int>> &unconsumed_items() const { return unconsumed; }
+
+  private:
+    struct alignas(CACHE_LINE_SIZE) Reader {
+        int start, end;                      // tuples of the relation
+        size_t begin_offset, end_offset;     // bytes of the stream file holding them
+        std::atomic<long> items_handed_over = 0;
+        std::thread thread;
+        std::exception_ptr error;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Worker {
+        SPSCRing<IngestBlock<KeyType> *> full_blocks;   // reader -> worker
+        SPSCRing<IngestBlock<KeyType> *> free_blocks;   // worker -> reader
+        vector<std::unique_ptr<IngestBlock<KeyType>>> pool;
+        IngestBlock<KeyType> *unconsumed_block = nullptr;
+        int unconsumed_position = 0;
+
+        Worker(int num_blocks, int block_size) : full_blocks(num_blocks), free_blocks(num_blocks) {
+            for (size_t i = 0; i < full_blocks.get_capacity(); i++) {
+                pool.push_back(std::make_unique<IngestBlock<KeyType>>(block_size));
+                free_blocks.try_enqueue(pool.back().get());
+            }
+        }
+    };
+
+    Relation *r1;
+    string source;   // memory, file or mmap
+    string path;
+    int block_size;
+    vector<std::unique_ptr<Reader>> readers;
+    vector<std::unique_ptr<Worker>> workers;
+    vector<int> reader_cpus;
+    std::atomic<bool> stop_readers = false;
+    std::atomic<bool> reader_failed = false;
+    vector<pair<KeyType, int>> unconsumed;
+    char *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    uint64_t relation_fingerprint() const;
+    bool load_stream_index(uint64_t fingerprint);
+    void write_stream_file(uint64_t fingerprint);
+    void run_reader(int reader);
+    void read_items(int reader);
+    template <typename NextItem> void produce(int reader, NextItem &&next_item);
+};
+
+template <typename KeyType>
+IngestPipeline<KeyType>::IngestPipeline(Relation *r1, int tuples_no, int num_workers, const DelegationHeavyHitterConfig &configs, const string &placement_policy,
+                                        const string &stream_name)
+    : r1(r1), source(configs.INGEST), path(configs.INGEST_PATH), block_size(configs.INGEST_BLOCK_SIZE) {
+    if (source != "memory" && source != "file" && source != "mmap") {
+        cerr << "Invalid ingest source: " << source << " (direct/memory/file/mmap)" << endl;
+        exit(1);
+    }
+    int num_readers = configs.INGEST_READERS;
+    if (num_readers < 1 || num_readers > num_workers || block_size < 1 || configs.INGEST_RING_SIZE < 1) {
+        cerr << "Invalid ingest pipeline: needs 1 to app.num_threads readers and positive block and ring sizes" << endl;
+        exit(1);
+    }
+
+    // the readers take the cpus after the workers'
+    ThreadPlacement placement = ThreadPlacement::compute(placement_policy, num_workers + num_readers);
+    reader_cpus.assign(placement.cpus.begin() + num_workers, placement.cpus.end());
+
+    for (int i = 0; i < num_readers; i++) {
+        auto reader = std::make_unique<Reader>();
+        reader->start = i * (tuples_no / num_readers);
+        reader->end = i == num_readers - 1 ? tuples_no : (i + 1) * (tuples_no / num_readers);
+        readers.push_back(std::move(reader));
+    }
+    for (int i = 0; i < num_workers; i++) { workers.push_back(std::make_unique<Worker>(configs.INGEST_RING_SIZE, block_size)); }
+
+    if (source == "memory") { return; }
+    if (path.empty()) {
+        string file_name = "delegation_ingest_" + stream_name + "_key" + std::to_string(sizeof(KeyType)) + "_readers" + std::to_string(num_readers) + ".stream";
+        path = (std::filesystem::temp_directory_path() / file_name).string();
+    }
+    uint64_t fingerprint = relation_fingerprint();
+    if (!load_stream_index(fingerprint)) { write_stream_file(fingerprint); }
+    if (source == "mmap") {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("Cannot open ingest stream " + path); }
+        mapping_size = readers.back()->end_offset;
+        void *data = mapping_size > 0 ? mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (data == MAP_FAILED) { throw std::runtime_error("Cannot map ingest stream " + path); }
+        mapping = static_cast<char *>(data);
+        if (mapping) { madvise(mapping, mapping_size, MADV_SEQUENTIAL); }
+    }
+}
+
+template <typename KeyType> IngestPipeline<KeyType>::~IngestPipeline() {
+    stop();
+    if (mapping != nullptr) { munmap(mapping, mapping_size); }
+}
+
+// FNV-1a over the key hashes and weights of the tuples the readers go over
+template <typename KeyType> uint64_t IngestPipeline<KeyType>::relation_fingerprint() const {
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+    uint64_t fingerprint = 14695981039346656037ULL;
+    fingerprint = (fingerprint ^ uint64_t(readers.back()->end)) * FNV_PRIME;
+    for (int i = 0; i < readers.back()->end; i++) {
+        fingerprint = (fingerprint ^ DelegationKeyTraits<KeyType>::hash(r1->key_at<KeyType>(i))) * FNV_PRIME;
+        fingerprint = (fingerprint ^ r1->weight_at(i)) * FNV_PRIME;
+    }
+    return fingerprint;
+}
+
+// the index next to the stream file holds the fingerprint of the relation it was written from and the byte range of every reader,
+// false if there is no stream file of this relation to reuse
+template <typename KeyType> bool IngestPipeline<KeyType>::load_stream_index(uint64_t fingerprint) {
+    std::ifstream index(path + ".index");
+    uint64_t stored_fingerprint;
+    size_t num_readers;
+    if (!(index >> stored_fingerprint >> num_readers) || stored_fingerprint != fingerprint || num_readers != readers.size()) { return false; }
+    for (auto &reader : readers) {
+        if (!(index >> reader->begin_offset >> reader->end_offset)) { return false; }
+    }
+    // a stream file cut short, by a run killed while writing it, is written again
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    return !error && size == readers.back()->end_offset;
+}
+
+// the relation is written out before the first benchmark of a configuration, every reader then decodes its byte range of it
+template <typename KeyType> void IngestPipeline<KeyType>::write_stream_file(uint64_t fingerprint) {
+    // the index goes first, a stream file is only reused once it is complete
+    std::error_code error;
+    std::filesystem::remove(path + ".index", error);
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    for (auto &reader : readers) {
+        reader->begin_offset = os.tellp();
+        for (int i = reader->start; i < reader->end; i++) { IngestCodec<KeyType>::encode(os, r1->key_at<KeyType>(i), r1->weight_at(i)); }
+        reader->end_offset = os.tellp();
+    }
+    if (!os.flush()) { throw std::runtime_error("Cannot write ingest stream " + path); }
+    os.close();
+
+    std::ofstream index(path + ".index", std::ios::trunc);
+    index << fingerprint << ' ' << readers.size() << '\n';
+    for (auto &reader : readers) { index << reader->begin_offset << ' ' << reader->end_offset << '\n'; }
+    if (!index.flush()) { throw std::runtime_error("Cannot write ingest stream index " + path + ".index"); }
+}
+
+template <typename KeyType> void IngestPipeline<KeyType>::start() {
+    stop_readers.store(false, std::memory_order_relaxed);
+    reader_failed.store(false, std::memory_order_relaxed);
+    for (int i = 0; i < (int) readers.size(); i++) { readers[i]->thread = std::thread(&IngestPipeline::run_reader, this, i); }
+}
+
+template <typename KeyType> void IngestPipeline<KeyType>::stop() {
+    stop_readers.store(true, std::memory_order_relaxed);
+    for (auto &reader : readers) {
+        if (reader->thread.joinable()) { reader->thread.join(); }
+    }
+
+    // the rest of the block a worker stopped in, and the blocks still waiting in its ring
+    for (int i = 0; i < (int) workers.size(); i++) {
+        IngestBlock<KeyType> *block = workers[i]->unconsumed_block;
+        if (block != nullptr) {
+            for (int j = workers[i]->unconsumed_position; j < block->size; j++) { unconsumed.emplace_back(block->keys[j], block->weights[j]); }
+            workers[i]->unconsumed_block = nullptr;
+            release_block(i, block);
+        }
+        while ((block = next_block(i)) != nullptr) {
+            for (int j = 0; j < block->size; j++) { unconsumed.emplace_back(block->keys[j], block->weights[j]); }
+            release_block(i, block);
+        }
+    }
+}
+
+template <typename KeyType> void IngestPipeline<KeyType>::rethrow_reader_error() {
+    for (auto &reader : readers) {
+        if (reader->error) { std::rethrow_exception(reader->error); }
+    }
+}
+
+// an exception must not leave the reader thread, it is kept for rethrow_reader_error
+template <typename KeyType> void IngestPipeline<KeyType>::run_reader(int reader_id) {
+    try {
+        read_items(reader_id);
+    } catch (...) {
+        readers[reader_id]->error = std::current_exception();
+        stop_readers.store(true, std::memory_order_relaxed);
+        reader_failed.store(true, std::memory_order_release);
+    }
+}
+
+template <typename KeyType> void IngestPipeline<KeyType>::read_items(int reader_id) {
+    setaffinity_oncpu(reader_cpus[reader_id]);
+    Reader &reader = *readers[reader_id];
+    if (reader.start == reader.end) { return; }
+
+    if (source == "memory") {
+        int i = reader.start;
+        produce(reader_id, [&](KeyType &key, int &weight) {
+            key = r1->key_at<KeyType>(i);
+            weight = r1->weight_at(i);
+            if (++i == reader.end) { i = reader.start; }
+        });
+    } else if (source == "mmap") {
+        const char *begin = mapping + reader.begin_offset, *end = mapping + reader.end_offset, *p = begin;
+        produce(reader_id, [&](KeyType &key, int &weight) {
+            if (!IngestCodec<KeyType>::decode(p, end, key, weight)) { throw std::runtime_error("Truncated item in ingest stream " + path); }
+            if (p == end) { p = begin; }
+        });
+    } else {
+        // buffered read() calls, an item cut at the end of the buffer is moved to its front before the next read
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("Cannot open ingest stream " + path); }
+        vector<char> buffer(BUFFER_SIZE);
+        const char *p = buffer.data(), *end = buffer.data();
+        size_t offset = reader.begin_offset;
+        auto next_item = [&](KeyType &key, int &weight) {
+            while (!IngestCodec<KeyType>::decode(p, end, key, weight)) {
+                size_t left = end - p;
+                std::memmove(buffer.data(), p, left);
+                if (offset == reader.end_offset) { offset = reader.begin_offset; }
+                ssize_t bytes = pread(fd, buffer.data() + left, std::min(BUFFER_SIZE - left, reader.end_offset - offset), offset);
+                if (bytes <= 0) { throw std::runtime_error("Cannot read ingest stream " + path); }
+                offset += bytes;
+                p = buffer.data();
+                end = buffer.data() + left + bytes;
+            }
+        };
+        try {
+            produce(reader_id, next_item);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+}
+
+// fill a free block of the next worker that has one, then publish it; readers serve the workers w with w % num_readers == reader
+template <typename KeyType> template <typename NextItem> void IngestPipeline<KeyType>::produce(int reader_id, NextItem &&next_item) {
+    int num_readers = readers.size(), num_workers = workers.size();
+    int worker = reader_id;
+    while (!stop_readers.load(std::memory_order_relaxed)) {
+        IngestBlock<KeyType> *block = nullptr;
+        for (int tries = 0; block == nullptr && tries < num_workers; tries += num_readers) {
+            if (!workers[worker]->free_blocks.try_dequeue(block)) { block = nullptr; }
+            if (block == nullptr) { worker = worker + num_readers < num_workers ? worker + num_readers : reader_id; }
+        }
+        if (block == nullptr) {
+            // all workers of this reader are busy with what they have
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (int i = 0; i < block_size; i++) {
+            next_item(block->keys[i], block->weights[i]);
+            block->hashes[i] = DelegationKeyTraits<KeyType>::hash(block->keys[i]);
+            block->owners[i] = find_owner(block->hashes[i]);
+        }
+        block->size = block_size;
+        // the ring holds the whole pool of the worker, it is never full
+        workers[worker]->full_blocks.try_enqueue(block);
+        readers[reader_id]->items_handed_over.fetch_add(block_size, std::memory_order_relaxed);
+        worker = worker + num_readers < num_workers ? worker + num_readers : reader_id;
+    }
+}
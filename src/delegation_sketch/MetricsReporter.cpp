@@ -0,0 +1,158 @@
+#include "MetricsReporter.hpp"
+
+#include "json/json.hpp"
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using std::cerr, std::endl;
+
+MetricsReporter::MetricsReporter(int interval_ms, const string &output_file_path, const string &socket_path) : interval_ms(interval_ms), socket_path(socket_path) {
+    if (!output_file_path.empty()) {
+        output_file.open(output_file_path, std::ios::app);
+        if (!output_file.is_open()) { cerr << "Failed to open metrics output file: " << output_file_path << endl; }
+    }
+    if (!socket_path.empty()) { open_socket(); }
+
+    start = std::chrono::steady_clock::now();
+    last_sample = start;
+    next_sample = start + std::chrono::milliseconds(interval_ms);
+}
+
+MetricsReporter::~MetricsReporter() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+    if (output_file.is_open()) { output_file.close(); }
+}
+
+void MetricsReporter::open_socket() {
+    sockaddr_un addr = {};
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Metrics socket path is too long: " << socket_path << endl;
+        return;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        cerr << "Failed to create metrics socket" << endl;
+        return;
+    }
+
+    addr.sun_family = AF_UNIX;
+    socket_path.copy(addr.sun_path, socket_path.size());
+    // a stale socket file from a previous run would make bind fail
+    unlink(socket_path.c_str());
+
+    if (bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 8) < 0) {
+        cerr << "Failed to listen on metrics socket: " << socket_path << endl;
+        close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+}
+
+void MetricsReporter::serve_pending_clients() {
+    while (true) {
+        int client_fd = accept(listen_fd, nullptr, nullptr);
+        if (client_fd < 0) { return; }
+
+        // read the request header if the client sends one (e.g. an HTTP GET from curl --unix-socket), we answer everything the same way.
+        // clients that only read (socat, nc) get the answer after the short timeout
+        timeval timeout = {0, 100000};
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        string request;
+        char buffer[1024];
+        ssize_t received;
+        while (request.find("\r\n\r\n") == string::npos && (received = recv(client_fd, buffer, sizeof(buffer), 0)) > 0) { request.append(buffer, received); }
+
+        string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(latest_exposition.size()) + "\r\n\r\n" +
+                          latest_exposition;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) { break; }
+            sent += n;
+        }
+        close(client_fd);
+    }
+}
+
+void MetricsReporter::wait_for_next_sample() {
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_sample) { break; }
+        int timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(next_sample - now).count() + 1;
+
+        if (listen_fd < 0) {
+            poll(nullptr, 0, timeout_ms);
+            continue;
+        }
+
+        pollfd pfd = {listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) > 0) { serve_pending_clients(); }
+    }
+    next_sample += std::chrono::milliseconds(interval_ms);
+}
+
+void MetricsReporter::report(const MetricsSnapshot &snapshot) {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(now - start).count();
+    double interval = std::chrono::duration<double, std::milli>(now - last_sample).count();
+    double throughput_mops = interval > 0 ? (snapshot.total_received_items - last_total_received_items) / interval / 1000 : 0;
+
+    last_sample = now;
+    last_total_received_items = snapshot.total_received_items;
+
+    if (output_file.is_open()) { output_file << to_json_line(snapshot, elapsed_ms, throughput_mops) << endl; }
+    if (listen_fd >= 0) {
+        latest_exposition = to_prometheus_text(snapshot, elapsed_ms, throughput_mops);
+        serve_pending_clients();
+    }
+}
+
+string MetricsReporter::to_json_line(const MetricsSnapshot &snapshot, double elapsed_ms, double throughput_mops) const {
+    using json = nlohmann::json;
+    json sample;
+    sample["elapsed_ms"] = elapsed_ms;
+    sample["throughput_mops"] = throughput_mops;
+    sample["total_received_items"] = snapshot.total_received_items;
+    sample["heavy_hitter_count"] = snapshot.heavy_hitter_count;
+    sample["received_items"] = snapshot.received_items;
+    sample["blocked_loops"] = snapshot.blocked_loops;
+    sample["queue_depth"] = snapshot.queue_depth;
+    sample["backlog_items"] = snapshot.backlog_items;
+    sample["buffered_items"] = snapshot.buffered_items;
+    return sample.dump();
+}
+
+string MetricsReporter::to_prometheus_text(const MetricsSnapshot &snapshot, double elapsed_ms, double throughput_mops) const {
+    std::ostringstream os;
+    auto print_header = [&os](const string &name, const string &type, const string &help) {
+        os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+    auto print_per_thread = [&os, &print_header](const string &name, const string &type, const string &label, const string &help, const auto &values) {
+        print_header(name, type, help);
+        for (size_t i = 0; i < values.size(); i++) { os << name << "{" << label << "=\"" << i << "\"} " << values[i] << "\n"; }
+    };
+
+    print_header("delegation_elapsed_ms", "gauge", "Time since the reporter started.");
+    os << "delegation_elapsed_ms " << elapsed_ms << "\n";
+    print_header("delegation_throughput_mops", "gauge", "Million items received from the stream per second over the last interval.");
+    os << "delegation_throughput_mops " << throughput_mops << "\n";
+    print_header("delegation_heavy_hitters", "gauge", "Number of tracked heavy hitter candidates.");
+    os << "delegation_heavy_hitters " << snapshot.heavy_hitter_count << "\n";
+    print_per_thread("delegation_received_items_total", "counter", "thread", "Items taken from the stream.", snapshot.received_items);
+    print_per_thread("delegation_blocked_loops_total", "counter", "thread", "Loops spent waiting on a locked delegation filter.", snapshot.blocked_loops);
+    print_per_thread("delegation_queue_depth", "gauge", "owner", "Full delegation filters waiting for the owner.", snapshot.queue_depth);
+    print_per_thread("delegation_backlog_items", "gauge", "owner", "Items in full delegation filters waiting for the owner.", snapshot.backlog_items);
+    print_per_thread("delegation_buffered_items", "gauge", "owner", "Items in delegation filters that are still being filled.", snapshot.buffered_items);
+    return os.str();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::string, std::vector, std::ofstream;
+
+// point-in-time view of a running delegation benchmark, filled by the reporter thread
+struct MetricsSnapshot {
+    long long total_received_items = 0;
+    int heavy_hitter_count = 0;
+    vector<long long> received_items;       // per thread: items taken from the stream
+    vector<long long> blocked_loops;        // per thread: loops spent waiting on a locked filter
+    vector<int> queue_depth;                // per owner: full filters delegated to the owner and not yet processed
+    vector<long long> backlog_items;        // per owner: items held in those filters
+    vector<long long> buffered_items;       // per owner: items in filters that are still being filled
+};
+
+// Periodic exporter for MetricsSnapshot. Each sample is appended as one JSON line to output_file_path
+// and/or served as Prometheus exposition text to every client connecting to the unix socket at socket_path.
+class MetricsReporter {
+  public:
+    MetricsReporter(int interval_ms, const string &output_file_path, const string &socket_path);
+    ~MetricsReporter();
+
+    // block until the next sample is due, serving socket clients meanwhile
+    void wait_for_next_sample();
+    void report(const MetricsSnapshot &snapshot);
+
+  private:
+    int interval_ms;
+    string socket_path;
+    ofstream output_file;
+    int listen_fd = -1;
+    string latest_exposition;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point next_sample;
+    std::chrono::steady_clock::time_point last_sample;
+    long long last_total_received_items = 0;
+
+    void open_socket();
+    void serve_pending_clients();
+    string to_json_line(const MetricsSnapshot &snapshot, double elapsed_ms, double throughput_mops) const;
+    string to_prometheus_text(const MetricsSnapshot &snapshot, double elapsed_ms, double throughput_mops) const;
+};
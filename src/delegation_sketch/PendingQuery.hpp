@@ -1,12 +1,18 @@
 #pragma once
 
-// Pending Query
-struct PendingQuery {
-    int key;
+#include "utils/CacheLineArena.hpp"
+
+// Pending Query, one per (asking thread, owner) pair: the asker spins on flag while the owner answers, so every query has a cache line of its own
+template <typename KeyType> struct alignas(CACHE_LINE_SIZE) PendingQuery {
+    KeyType key;
     volatile int count;
     volatile bool flag;
 
-    PendingQuery();
-    PendingQuery(PendingQuery &&other);
-    void add_query(int key);
-};
\ No newline at end of file
+    PendingQuery() : key(), count(0), flag(false) {}
+    PendingQuery(PendingQuery &&other) : key(other.key), count(other.count), flag(other.flag) {}
+
+    void add_query(const KeyType &key) {
+        this->key = key;
+        this->flag = true;
+    }
+};
@@ -1,25 +1,25 @@
 #include "StatCollector.hpp"
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_items(int count) { count_delegate_to_j_items += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_items(int count) { relaxed_add<int64_t>(count_delegate_to_j_items, count); }
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_filters(int count) { count_delegate_to_j_filters += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_filters(int count) { relaxed_add<int64_t>(count_delegate_to_j_filters, count); }
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_due_to_filtersize_filters(int count) { count_delegate_to_j_due_to_filtersize_filters += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_due_to_filtersize_filters(int count) { relaxed_add<int64_t>(count_delegate_to_j_due_to_filtersize_filters, count); }
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_due_to_capacity_filters(int count) { count_delegate_to_j_due_to_capacity_filters += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_due_to_capacity_filters(int count) { relaxed_add<int64_t>(count_delegate_to_j_due_to_capacity_filters, count); }
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_blocked(int count) { count_delegate_to_j_blocked += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_blocked(int count) { relaxed_add<int64_t>(count_delegate_to_j_blocked, count); }
 
-void ThreadPairWiseStatCollector::update_delegate_to_j_blocked_loops(int count) { count_delegate_to_j_blocked_loops += count; }
+void ThreadPairWiseStatCollector::update_delegate_to_j_blocked_loops(int count) { relaxed_add<int64_t>(count_delegate_to_j_blocked_loops, count); }
 
-void ThreadPairWiseStatCollector::update_delegated_from_j_items(int count) { count_delegated_from_j_items += count; }
+void ThreadPairWiseStatCollector::update_delegated_from_j_items(int64_t count) { relaxed_add<int64_t>(count_delegated_from_j_items, count); }
 
-void ThreadPairWiseStatCollector::update_delegated_from_j_filters(int count) { count_delegated_from_j_filters += count; }
+void ThreadPairWiseStatCollector::update_delegated_from_j_filters(int64_t count) { relaxed_add<int64_t>(count_delegated_from_j_filters, count); }
 
-void ThreadPairWiseStatCollector::update_use_double_buffering(int count) { count_use_double_buffering += count; }
+void ThreadPairWiseStatCollector::update_use_double_buffering(int count) { relaxed_add<int64_t>(count_use_double_buffering, count); }
 
-map<string, int> ThreadPairWiseStatCollector::get_all_metrics() {
-    map<string, int> metrics;
+map<string, int64_t> ThreadPairWiseStatCollector::get_all_metrics() {
+    map<string, int64_t> metrics;
     metrics["count_delegate_to_j_items"] = count_delegate_to_j_items;
     metrics["count_delegate_to_j_filters"] = count_delegate_to_j_filters;
     metrics["count_delegate_to_j_due_to_filtersize_filters"] = count_delegate_to_j_due_to_filtersize_filters;
@@ -43,75 +43,80 @@ void ThreadPairWiseStatCollector::reset() {
     count_delegated_from_j_filters = 0;
 }
 
-void ThreadOverallStatCollector::update_received_from_stream_items(int count) { count_received_from_stream_items += count; }
+void ThreadOverallStatCollector::update_received_from_stream_items(int count) { relaxed_add<int64_t>(count_received_from_stream_items, count); }
 
-void ThreadOverallStatCollector::update_query_processed(int count) { count_query_processed += count; }
+void ThreadOverallStatCollector::update_received_from_stream_weight(int weight) { relaxed_add<int64_t>(count_received_from_stream_weight, weight); }
 
-void ThreadOverallStatCollector::reset() { count_received_from_stream_items = 0; }
+void ThreadOverallStatCollector::update_query_processed(int count) { relaxed_add<int64_t>(count_query_processed, count); }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_items(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+void ThreadOverallStatCollector::reset() {
+    count_received_from_stream_items = 0;
+    count_received_from_stream_weight = 0;
+}
+
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_items(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (int i = 0; i < thread_pairwise_stat_collectors.size(); i++) { count += thread_pairwise_stat_collectors[i].count_delegate_to_j_items; }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) { count += thread_pairwise_stat_collector.count_delegate_to_j_filters; }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_due_to_filtersize_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_due_to_filtersize_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) {
         count += thread_pairwise_stat_collector.count_delegate_to_j_due_to_filtersize_filters;
     }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_due_to_capacity_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_due_to_capacity_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) {
         count += thread_pairwise_stat_collector.count_delegate_to_j_due_to_capacity_filters;
     }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_blocked(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_blocked(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) { count += thread_pairwise_stat_collector.count_delegate_to_j_blocked; }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegate_to_threads_blocked_loops(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegate_to_threads_blocked_loops(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) {
         count += thread_pairwise_stat_collector.count_delegate_to_j_blocked_loops;
     }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegated_from_threads_items(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegated_from_threads_items(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) { count += thread_pairwise_stat_collector.count_delegated_from_j_items; }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_delegated_from_threads_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_delegated_from_threads_filters(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) { count += thread_pairwise_stat_collector.count_delegated_from_j_filters; }
     return count;
 }
 
-int ThreadOverallStatCollector::calculate_count_use_double_buffering(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
-    int count = 0;
+int64_t ThreadOverallStatCollector::calculate_count_use_double_buffering(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors) {
+    int64_t count = 0;
     for (ThreadPairWiseStatCollector thread_pairwise_stat_collector : thread_pairwise_stat_collectors) { count += thread_pairwise_stat_collector.count_use_double_buffering; }
     return count;
 }
 
-map<string, int> ThreadOverallStatCollector::calculate_all_metrics(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors,
+map<string, int64_t> ThreadOverallStatCollector::calculate_all_metrics(vector<ThreadPairWiseStatCollector> thread_pairwise_stat_collectors,
                                                                    ThreadOverallStatCollector thread_overall_stat_collector) {
-    map<string, int> metrics;
+    map<string, int64_t> metrics;
     metrics["count_delegate_to_threads_items"] = calculate_count_delegate_to_threads_items(thread_pairwise_stat_collectors);
     metrics["count_delegate_to_threads_filters"] = calculate_count_delegate_to_threads_filters(thread_pairwise_stat_collectors);
     metrics["count_delegate_to_threads_due_to_filtersize_filters"] = calculate_count_delegate_to_threads_due_to_filtersize_filters(thread_pairwise_stat_collectors);
@@ -125,7 +130,7 @@ map<string, int> ThreadOverallStatCollector::calculate_all_metrics(vector<Thread
     return metrics;
 }
 
-void print_metrics(map<string, int> metrics) {
+void print_metrics(map<string, int64_t> metrics) {
     for (auto metric : metrics) { cout << metric.first << " : " << metric.second << endl; }
 }
 
@@ -1,13 +1,20 @@
 #include "delegation_sketch_utils.hpp"
 
+#include <algorithm>
+#include <sstream>
+
 using std::default_random_engine;
 
 unsigned long *seed_rand() {
     unsigned long *seeds = (unsigned long *) calloc(3, sizeof(unsigned long));
+    seed_rand(seeds);
+    return seeds;
+}
+
+void seed_rand(unsigned long *seeds) {
     seeds[0] = getticks() % 123456789;
     seeds[1] = getticks() % 362436069;
     seeds[2] = getticks() % 521288629;
-    return seeds;
 }
 
 unsigned long xorshf96(unsigned long *x, unsigned long *y, unsigned long *z) {
@@ -57,4 +64,46 @@ void precompute_mods(int num_threads) {
     }
 }
 
+void reshard_mods(int num_threads) {
+    // every owner ends up with 512 / num_threads slots, the first 512 % num_threads owners get one more
+    vector<int> quota(num_threads), owned(num_threads, 0);
+    for (int i = 0; i < num_threads; i++) { quota[i] = 512 / num_threads + (i < 512 % num_threads); }
+
+    // slots stay with their owner while it is under quota, everything else is up for grabs
+    vector<int> free_slots;
+    for (int i = 0; i < 512; i++) {
+        int owner = precomputed_mods[i];
+        if (owner < num_threads && owned[owner] < quota[owner]) {
+            owned[owner]++;
+        } else {
+            free_slots.push_back(i);
+        }
+    }
+
+    int owner = 0;
+    for (int slot : free_slots) {
+        while (owned[owner] >= quota[owner]) { owner++; }
+        std::atomic_ref<unsigned short>(precomputed_mods[slot]).store(owner, std::memory_order_relaxed);
+        owned[owner]++;
+    }
+}
+
+vector<std::pair<int, int>> parse_reshard_schedule(const string &schedule) {
+    vector<std::pair<int, int>> steps;
+    std::stringstream ss(schedule);
+    string step;
+    while (std::getline(ss, step, ',')) {
+        int at_ms, num_threads;
+        char colon;
+        std::stringstream step_ss(step);
+        if (!(step_ss >> at_ms >> colon >> num_threads) || colon != ':' || at_ms < 0 || num_threads < 1) {
+            std::cerr << "Invalid reshard schedule step: " << step << " (expected ms:threads)" << std::endl;
+            exit(1);
+        }
+        steps.emplace_back(at_ms, num_threads);
+    }
+    std::sort(steps.begin(), steps.end());
+    return steps;
+}
+
 // inline int find_owner(unsigned int key) { return precomputed_mods[key & 511]; }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
@@ -17,6 +18,8 @@
 using std::vector, std::default_random_engine, std::begin, std::shuffle;
 
 unsigned long *seed_rand();
+// fills the three xorshf96 seeds at seeds
+void seed_rand(unsigned long *seeds);
 unsigned long xorshf96(unsigned long *x, unsigned long *y, unsigned long *z);
 bool should_perform_query(unsigned long *seeds, double query_rate);
 
@@ -28,16 +31,22 @@ void setaffinity_oncpu(unsigned int cpu);
 
 extern unsigned short precomputed_mods[512];
 
-inline int find_owner(unsigned int key) { return precomputed_mods[key & 511]; }
+// the slot table may be resharded while workers route keys, hence the relaxed atomic load (a plain mov on x86)
+inline int find_owner(unsigned int key) { return std::atomic_ref<unsigned short>(precomputed_mods[key & 511]).load(std::memory_order_relaxed); }
 
 void precompute_mods(int num_threads);
+// reassign the 512 slots to num_threads owners moving as few slots as possible, so only ~1/N of the keys change owner
+void reshard_mods(int num_threads);
+// "2000:4,4000:8" -> {(2000, 4), (4000, 8)}, sorted by time
+vector<std::pair<int, int>> parse_reshard_schedule(const string &schedule);
 
-template <typename T> float ARE(const std::map<T, int> &exact_counter, const std::map<T, int> &approx_counter) {
+// the exact counts may be wider than the approximate ones, see calculate_exact_counter
+template <typename T, typename Count, typename ApproxCount> float ARE(const std::map<T, Count> &exact_counter, const std::map<T, ApproxCount> &approx_counter) {
     float relative_error = 0;
     for (const auto &entry : exact_counter) {
         auto it = approx_counter.find(entry.first);
         if (it != approx_counter.end()) {
-            relative_error += float(abs(entry.second - it->second) / entry.second);
+            relative_error += float(std::abs(entry.second - (Count) it->second) / entry.second);
         } else {
             relative_error += 1.0f;
         }
@@ -45,12 +54,12 @@ template <typename T> float ARE(const std::map<T, int> &exact_counter, const std
     return relative_error / exact_counter.size();
 }
 
-template <typename T> float AAE(const std::map<T, int> &exact_counter, const std::map<T, int> &approx_counter) {
+template <typename T, typename Count, typename ApproxCount> float AAE(const std::map<T, Count> &exact_counter, const std::map<T, ApproxCount> &approx_counter) {
     float absolute_error = 0;
     for (const auto &entry : exact_counter) {
         auto it = approx_counter.find(entry.first);
         if (it != approx_counter.end()) {
-            absolute_error += abs(entry.second - it->second);
+            absolute_error += std::abs(entry.second - (Count) it->second);
         } else {
             absolute_error += entry.second;
         }
@@ -58,7 +67,8 @@ template <typename T> float AAE(const std::map<T, int> &exact_counter, const std
     return absolute_error / exact_counter.size();
 }
 
-template <typename T> void print_compare(const std::map<T, int> &exact_counter, const std::map<T, int> &approx_counter, string output_file_path = "") {
+template <typename T, typename Count, typename ApproxCount>
+void print_compare(const std::map<T, Count> &exact_counter, const std::map<T, ApproxCount> &approx_counter, string output_file_path = "") {
     std::ofstream output_file;
     if (!output_file_path.empty()) {
         output_file.open(output_file_path);
@@ -74,12 +84,13 @@ template <typename T> void print_compare(const std::map<T, int> &exact_counter,
         if (output_file.is_open()) output_file << x;
     };
 
+    using std::to_string;
     for (const auto &entry : exact_counter) {
         auto it = approx_counter.find(entry.first);
         if (it != approx_counter.end()) {
-            print("Key: " + std::to_string(entry.first) + " Exact: " + std::to_string(entry.second) + " Approx: " + std::to_string(it->second) + "\n");
+            print("Key: " + to_string(entry.first) + " Exact: " + std::to_string(entry.second) + " Approx: " + std::to_string(it->second) + "\n");
         } else {
-            print("Key: " + std::to_string(entry.first) + " Exact: " + std::to_string(entry.second) + " Approx: 0\n");
+            print("Key: " + to_string(entry.first) + " Exact: " + std::to_string(entry.second) + " Approx: 0\n");
         }
     }
 }
\ No newline at end of file
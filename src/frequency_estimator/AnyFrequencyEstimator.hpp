@@ -0,0 +1,89 @@
+#pragma once
+
+#include "frequency_estimator/FrequencyEstimatorBase.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Owns any FrequencyEstimatorLike estimator behind one virtual call per operation, for tooling that picks the estimator at
+// run time (config dumps, comparisons over several estimators). The hot paths take the estimator as a template parameter
+// instead and never pay for this indirection. Optional parts fall back: memory_usage() is 0 for estimators that do not
+// report it and process_filter_batch updates one pair at a time.
+class AnyFrequencyEstimator {
+  public:
+    template <typename Estimator>
+        requires FrequencyEstimatorLike<std::decay_t<Estimator>> && (!std::is_same_v<std::decay_t<Estimator>, AnyFrequencyEstimator>)
+    AnyFrequencyEstimator(Estimator &&estimator) : model(std::make_unique<Model<std::decay_t<Estimator>>>(std::forward<Estimator>(estimator))) {}
+
+    void print_status() { model->print_status(); }
+    void update(const int &item, int c = 1) { model->update(item, c); }
+    void update(const std::string &item, int c = 1) { model->update(item, c); }
+    unsigned int estimate(const int &item) { return model->estimate(item); }
+    unsigned int estimate(const std::string &item) { return model->estimate(item); }
+    unsigned int update_and_estimate(const int &item, int c = 1) { return model->update_and_estimate(item, c); }
+    unsigned int update_and_estimate(const std::string &item, int c = 1) { return model->update_and_estimate(item, c); }
+    size_t memory_usage() const { return model->memory_usage(); }
+    void process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates = nullptr) {
+        model->process_filter_batch(keys, counts, n, estimates);
+    }
+
+    // the wrapped estimator, nullptr if it is not an Estimator
+    template <typename Estimator> Estimator *get() {
+        auto *typed = dynamic_cast<Model<Estimator> *>(model.get());
+        return typed ? &typed->estimator : nullptr;
+    }
+
+  private:
+    struct Concept {
+        virtual ~Concept() = default;
+        virtual void print_status() = 0;
+        virtual void update(const int &item, int c) = 0;
+        virtual void update(const std::string &item, int c) = 0;
+        virtual unsigned int estimate(const int &item) = 0;
+        virtual unsigned int estimate(const std::string &item) = 0;
+        virtual unsigned int update_and_estimate(const int &item, int c) = 0;
+        virtual unsigned int update_and_estimate(const std::string &item, int c) = 0;
+        virtual size_t memory_usage() const = 0;
+        virtual void process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates) = 0;
+    };
+
+    template <typename Estimator> struct Model final : Concept {
+        Estimator estimator;
+
+        template <typename... Args> explicit Model(Args &&...args) : estimator(std::forward<Args>(args)...) {}
+
+        void print_status() override { estimator.print_status(); }
+        void update(const int &item, int c) override { estimator.update(item, c); }
+        void update(const std::string &item, int c) override { estimator.update(item, c); }
+        unsigned int estimate(const int &item) override { return estimator.estimate(item); }
+        unsigned int estimate(const std::string &item) override { return estimator.estimate(item); }
+        unsigned int update_and_estimate(const int &item, int c) override { return estimator.update_and_estimate(item, c); }
+        unsigned int update_and_estimate(const std::string &item, int c) override { return estimator.update_and_estimate(item, c); }
+
+        size_t memory_usage() const override {
+            if constexpr (MemoryReporting<Estimator>) {
+                return estimator.memory_usage();
+            } else {
+                return 0;
+            }
+        }
+
+        void process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates) override {
+            if constexpr (FilterBatchProcessable<Estimator>) {
+                estimator.process_filter_batch(keys, counts, n, estimates);
+            } else {
+                for (int i = 0; i < n; i++) {
+                    if (estimates) {
+                        estimates[i] = estimator.update_and_estimate(keys[i], counts[i]);
+                    } else {
+                        estimator.update(keys[i], counts[i]);
+                    }
+                }
+            }
+        }
+    };
+
+    std::unique_ptr<Concept> model;
+};
@@ -1,24 +1,80 @@
 #include "AugmentedSketch.hpp"
 
+#include <immintrin.h>
+
 #define LONG_PRIME 2147483647
 
+// the AVX2 paths are compiled for AVX2 only, and taken when the cpu running the binary has it
+static const bool CPU_HAS_AVX2 = __builtin_cpu_supports("avx2");
+
+static constexpr int FILTER_LANES = 8;
+
+// lanes of the block starting at i that hold filter entries
+__attribute__((target("avx2"))) static inline __m256i valid_lanes(int size, int i) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(size - i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2"))) static int find_avx2(const int *keys, int size, int key) {
+    const __m256i key_vec = _mm256_set1_epi32(key);
+    for (int i = 0; i < size; i += FILTER_LANES) {
+        __m256i equal = _mm256_and_si256(_mm256_cmpeq_epi32(key_vec, _mm256_loadu_si256((const __m256i *) (keys + i))), valid_lanes(size, i));
+        int found = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (found) { return i + __builtin_ctz(found); }
+    }
+    return -1;
+}
+
+__attribute__((target("avx2"))) static int find_min_avx2(const int *counts, int size, int &min_count) {
+    const __m256i int_max = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    __m256i min_vec = int_max;
+    for (int i = 0; i < size; i += FILTER_LANES) {
+        __m256i block = _mm256_blendv_epi8(int_max, _mm256_loadu_si256((const __m256i *) (counts + i)), valid_lanes(size, i));
+        min_vec = _mm256_min_epi32(min_vec, block);
+    }
+    __m128i x = _mm_min_epi32(_mm256_castsi256_si128(min_vec), _mm256_extracti128_si256(min_vec, 1));
+    x = _mm_min_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_min_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    min_count = _mm_cvtsi128_si32(x);
+    return find_avx2(counts, size, min_count);
+}
+
 // AugmentedFilter Constructors
 AugmentedFilter::AugmentedFilter() {}
 
-AugmentedFilter::AugmentedFilter(int max_size) {
-    this->max_size = max_size;
-    keys = std::vector<int>(max_size);
-    counts = std::vector<int>(max_size);
-    old_counts = std::vector<int>(max_size);
-    size = 0;
-}
+AugmentedFilter::AugmentedFilter(int max_size) { init(max_size); }
 
 void AugmentedFilter::init(int max_size) {
+    int padded_size = (max_size + FILTER_LANES - 1) / FILTER_LANES * FILTER_LANES;
     this->max_size = max_size;
-    keys = std::vector<int>(max_size);
-    counts = std::vector<int>(max_size);
-    old_counts = std::vector<int>(max_size);
+    keys = std::vector<int>(padded_size);
+    counts = std::vector<int>(padded_size);
+    old_counts = std::vector<int>(padded_size);
     size = 0;
+    min_index = -1;
+}
+
+int AugmentedFilter::find(int key) const {
+    if (CPU_HAS_AVX2) { return find_avx2(keys.data(), size, key); }
+    for (int j = 0; j < size; ++j) {
+        if (keys[j] == key) { return j; }
+    }
+    return -1;
+}
+
+int AugmentedFilter::find_min() {
+    if (min_index >= 0) { return min_index; }
+    if (CPU_HAS_AVX2) {
+        min_index = find_min_avx2(counts.data(), size, min_count);
+        return min_index;
+    }
+    min_index = 0, min_count = counts[0];
+    for (int j = 1; j < size; ++j) {
+        if (counts[j] < min_count) {
+            min_count = counts[j];
+            min_index = j;
+        }
+    }
+    return min_index;
 }
 
 // AugmentedSketch Constructors
@@ -47,24 +103,23 @@ unsigned int AugmentedSketch::_get_hashitem(const std::string &item) {
 }
 
 // Update function for integers
-void AugmentedSketch::update(const int &item, int c) { return this->_update(item, c); }
+void AugmentedSketch::update(const int &item, int c) { this->_update_and_estimate(item, c); }
 
 // Update function for strings
 void AugmentedSketch::update(const std::string &item, int c) {
     unsigned int hashitem = this->_get_hashitem(item);
-    return this->_update(hashitem, c);
+    this->_update_and_estimate(hashitem, c);
 }
 
-// Internal update logic
-void AugmentedSketch::_update(const int item, int c) {
+// Internal update logic, returns the estimate of the item
+unsigned int AugmentedSketch::_update_and_estimate(const int item, int c) {
     this->total += c;
 
     // Check if key is in the filter
-    for (int j = 0; j < augmented_filter.size; ++j) {
-        if (augmented_filter.keys[j] == item) {
-            augmented_filter.counts[j] += c;
-            return;
-        }
+    int index = augmented_filter.find(item);
+    if (index >= 0) {
+        if (index == augmented_filter.min_index) { augmented_filter.min_index = -1; }
+        return augmented_filter.counts[index] += c;
     }
 
     // If key not in filter and filter not full
@@ -73,27 +128,23 @@ void AugmentedSketch::_update(const int item, int c) {
         augmented_filter.counts[augmented_filter.size] += c;
         augmented_filter.old_counts[augmented_filter.size] = 0;
         augmented_filter.size++;
-        return;
+        augmented_filter.min_index = -1;
+        return c;
     }
 
     // If key not in filter and filter is full
     int estimated_count = this->count_min_sketch.update_and_estimate(item, c);
 
-    int min_index = 0, min_count = augmented_filter.counts[0];
-    for (int j = 1; j < augmented_filter.size; ++j) {
-        if (augmented_filter.counts[j] < min_count) {
-            min_count = augmented_filter.counts[j];
-            min_index = j;
-        }
-    }
-
-    if (min_count < estimated_count) {
+    int min_index = augmented_filter.find_min();
+    if (augmented_filter.min_count < estimated_count) {
         int drift = augmented_filter.counts[min_index] - augmented_filter.old_counts[min_index];
         if (drift > 0) { this->count_min_sketch.update(augmented_filter.keys[min_index], drift); }
         augmented_filter.keys[min_index] = item;
         augmented_filter.counts[min_index] = estimated_count;
         augmented_filter.old_counts[min_index] = estimated_count;
+        augmented_filter.min_index = -1;
     }
+    return estimated_count;
 }
 
 // Estimate function for integers
@@ -107,57 +158,14 @@ unsigned int AugmentedSketch::estimate(const std::string &item) {
 
 // Internal estimate logic
 unsigned int AugmentedSketch::_estimate(const int &item) {
-    for (int j = 0; j < augmented_filter.size; ++j) {
-        if (augmented_filter.keys[j] == item) { return augmented_filter.counts[j]; }
-    }
+    int index = augmented_filter.find(item);
+    if (index >= 0) { return augmented_filter.counts[index]; }
 
     return this->count_min_sketch.estimate(item);
 }
 
 // Update and estimate function for integers
-unsigned int AugmentedSketch::update_and_estimate(const int &item, int c) {
-    // Update total count
-    this->total += c;
-
-    // Check if item is in the filter
-    for (int j = 0; j < augmented_filter.size; ++j) {
-        if (augmented_filter.keys[j] == item) {
-            augmented_filter.counts[j] += c;
-            return augmented_filter.counts[j];
-        }
-    }
-
-    // If key not in filter and filter not full
-    if (augmented_filter.size < augmented_filter.max_size) {
-        augmented_filter.keys[augmented_filter.size] = item;
-        augmented_filter.counts[augmented_filter.size] += c;
-        augmented_filter.old_counts[augmented_filter.size] = 0;
-        augmented_filter.size++;
-        return c;
-    }
-
-    // If key not in filter and filter is full
-    int estimated_count = this->count_min_sketch.update_and_estimate(item, c);
-
-    int min_index = 0, min_count = augmented_filter.counts[0];
-    for (int j = 1; j < augmented_filter.size; ++j) {
-        if (augmented_filter.counts[j] < min_count) {
-            min_count = augmented_filter.counts[j];
-            min_index = j;
-        }
-    }
-
-    if (min_count < estimated_count) {
-        int drift = augmented_filter.counts[min_index] - augmented_filter.old_counts[min_index];
-        if (drift > 0) { this->count_min_sketch.update(augmented_filter.keys[min_index], drift); }
-        augmented_filter.keys[min_index] = item;
-        augmented_filter.counts[min_index] = estimated_count;
-        augmented_filter.old_counts[min_index] = estimated_count;
-        return estimated_count;
-    }
-
-    return estimated_count;
-}
+unsigned int AugmentedSketch::update_and_estimate(const int &item, int c) { return this->_update_and_estimate(item, c); }
 
 // Update and estimate function for strings
 unsigned int AugmentedSketch::update_and_estimate(const std::string &item, int c) {
@@ -165,6 +173,13 @@ unsigned int AugmentedSketch::update_and_estimate(const std::string &item, int c
     return this->update_and_estimate(hashitem, c);
 }
 
+void AugmentedSketch::process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates) {
+    for (int i = 0; i < n; ++i) {
+        unsigned int estimate = this->_update_and_estimate(keys[i], counts[i]);
+        if (estimates) { estimates[i] = estimate; }
+    }
+}
+
 // Print status function
 void AugmentedSketch::print_status() {
     // Implementation of print status (if needed)
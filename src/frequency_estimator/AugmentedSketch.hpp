@@ -15,6 +15,8 @@
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 
+// Filter in front of the count-min sketch. Lookup and min-finding use AVX2 when the cpu has it, the vectors are padded
+// to a multiple of 8 lanes for that; the slot of the smallest count is cached until the counts change there.
 struct AugmentedFilter {
     std::vector<int> keys;
     std::vector<int> counts;
@@ -22,14 +24,19 @@ struct AugmentedFilter {
     int size;
     int max_size;
     int min_count;
+    int min_index = -1;   // -1 once the cached minimum is stale
 
     AugmentedFilter();
     AugmentedFilter(int max_size);
 
     void init(int max_size);
+    // slot of key, -1 if it is not in the filter
+    int find(int key) const;
+    // slot with the smallest count (the first one on ties), its count is left in min_count
+    int find_min();
 };
 
-class AugmentedSketch : public FrequencyEstimatorBase {
+class AugmentedSketch : public FrequencyEstimatorBase<AugmentedSketch> {
   public:
     int total;
 
@@ -38,21 +45,25 @@ class AugmentedSketch : public FrequencyEstimatorBase {
     AugmentedSketch(float epsilon, float delta, int max_filter_size);
     AugmentedSketch(AugmentedSketchConfig augmented_configs);
 
-    void update(const int &item, int c = 1) override;
+    void update(const int &item, int c = 1);
     void update(const std::string &item, int c = 1);
 
-    unsigned int estimate(const int &item) override;
-    unsigned int estimate(const std::string &item) override;
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
 
     unsigned int update_and_estimate(const int &item, int c = 1);
     unsigned int update_and_estimate(const std::string &item, int c = 1);
 
+    // feeds n (key, count) pairs in order, the same as n update_and_estimate calls (each pair depends on the filter left by the ones
+    // before it); estimates[i] gets the estimate of keys[i] when estimates is given
+    void process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates = nullptr);
+
     void print_status();
 
   private:
     CountMinSketch count_min_sketch;
     AugmentedFilter augmented_filter;
-    void _update(const int item, int c = 1);
+    unsigned int _update_and_estimate(const int item, int c);
     unsigned int _estimate(const int &item);
     unsigned int _get_hashitem(const std::string &item);
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
 #include <unordered_map>
@@ -132,8 +133,29 @@ template <typename KeyType> class BoundedKeyValuePriorityQueue {
         }
     }
 
+    void remove(const KeyType &key) {
+        auto it = key_to_index.find(key);
+        if (it == key_to_index.end()) return;
+
+        size_t index = it->second;
+        key_to_index.erase(it);
+        if (index == heap.size() - 1) {
+            heap.pop_back();
+            return;
+        }
+
+        heap[index] = heap.back();
+        key_to_index[heap[index].key] = index;
+        heap.pop_back();
+        if (index > 0 && heap[index].weight < heap[(index - 1) / 2].weight) {
+            sift_up(index);
+        } else {
+            sift_down(index);
+        }
+    }
+
     // pop all items with priority < weight and return the list of popped items
-    std::vector<std::pair<KeyType, int>> pop_all_below(int weight) {
+    std::vector<std::pair<KeyType, int>> pop_all_below(int64_t weight) {
         std::vector<std::pair<KeyType, int>> popped_items;
         while (!empty() && heap[0].weight < weight) {
             popped_items.emplace_back(heap[0].key, heap[0].weight);
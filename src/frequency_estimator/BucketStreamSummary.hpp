@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+// Space-Saving counters kept in a stream-summary (Metwally et al.): counters with the same count share a bucket and the buckets
+// form a list sorted by count, so the minimum counter is the first node of the first bucket.
+//  - nodes and buckets live in arrays sized to the capacity k (there are never more distinct counts than counters),
+//    released nodes and buckets are reused through free lists
+//  - keys are found through an open-addressing index of node positions (linear probing, backward shift deletion)
+//  - an update of weight c moves the node to the bucket of count + c, found by walking up from its current bucket (one step for c = 1)
+// paper:
+// https://home.cse.ust.hk/~raywong/comp5331/References/EfficientComputationOfFrequentAndTop-kElementsInDataStreams.pdf
+template <typename Key, typename Hash = std::hash<Key>> class BucketStreamSummary {
+  public:
+    using count_t = uint64_t;
+    static constexpr int32_t NONE = -1;
+
+    explicit BucketStreamSummary(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {
+        m_nodes.resize(m_capacity);
+        // one spare bucket: a moved node may open its new bucket before its old one is released
+        m_buckets.resize(m_capacity + 1);
+        size_t slots = 2;
+        while (slots < 2 * m_capacity) { slots <<= 1; }
+        m_index.resize(slots);
+        m_index_mask = slots - 1;
+        clear();
+    }
+
+    void clear() {
+        for (size_t i = 0; i < m_buckets.size(); ++i) { m_buckets[i].next = i + 1 < m_buckets.size() ? int32_t(i + 1) : NONE; }
+        m_free_bucket = 0;
+        m_min_bucket = m_max_bucket = NONE;
+        std::fill(m_index.begin(), m_index.end(), Slot{NONE, 0});
+        m_size = m_allocated = 0;
+        m_free_node = NONE;
+    }
+
+    // adds c to key, the minimum counter is taken over when key is not monitored and all counters are in use; returns the new count
+    count_t update(const Key &key, count_t c = 1) {
+        uint32_t hash = _hash(key);
+        size_t slot = _find_slot(key, hash);
+        int32_t node = m_index[slot].node;
+        if (node == NONE) {
+            if (m_size < m_capacity) {
+                node = _new_node(key, 0);
+                m_index[slot] = Slot{node, hash};
+                _place(node, c, NONE);
+                return c;
+            }
+            // evict the minimum, the new key inherits its count as error
+            node = m_buckets[m_min_bucket].first;
+            _erase_slot(_find_slot(m_nodes[node].key, _hash(m_nodes[node].key)));
+            m_nodes[node].key = key;
+            m_nodes[node].error = m_buckets[m_min_bucket].count;
+            // the erase may have shifted the probe sequence of key
+            m_index[_find_slot(key, hash)] = Slot{node, hash};
+        }
+        return _increment(node, c);
+    }
+
+    // adds c to key when it is monitored and returns its new count, 0 when it is not monitored
+    count_t increment(const Key &key, count_t c) {
+        int32_t node = m_index[_find_slot(key, _hash(key))].node;
+        return node == NONE ? 0 : _increment(node, c);
+    }
+
+    // adds a key that is not monitored with the given count and error, searching its bucket from the smallest count up
+    void insert(const Key &key, count_t count, count_t error = 0) { _place(_add_node(key, error), count, NONE); }
+
+    // drops every key whose count is at most bound, from the lowest bucket up; returns how many were dropped
+    size_t erase_up_to(count_t bound) {
+        size_t erased = 0;
+        while (m_min_bucket != NONE && m_buckets[m_min_bucket].count <= bound) {
+            int32_t bucket = m_min_bucket;
+            for (int32_t node = m_buckets[bucket].first; node != NONE;) {
+                int32_t next = m_nodes[node].next;
+                _erase_slot(_find_slot(m_nodes[node].key, _hash(m_nodes[node].key)));
+                m_nodes[node].next = m_free_node;
+                m_free_node = node;
+                --m_size;
+                ++erased;
+                node = next;
+            }
+            m_buckets[bucket].first = NONE;
+            _release_bucket(bucket);
+        }
+        return erased;
+    }
+
+    // count of key, 0 when it is not monitored
+    count_t estimate(const Key &key) const {
+        int32_t node = m_index[_find_slot(key, _hash(key))].node;
+        return node == NONE ? 0 : m_buckets[m_nodes[node].bucket].count;
+    }
+
+    // overestimation bound of key, 0 when it is not monitored
+    count_t error(const Key &key) const {
+        int32_t node = m_index[_find_slot(key, _hash(key))].node;
+        return node == NONE ? 0 : m_nodes[node].error;
+    }
+
+    // smallest monitored count, 0 while some counters are unused
+    count_t min_count() const { return m_size < m_capacity || m_min_bucket == NONE ? 0 : m_buckets[m_min_bucket].count; }
+
+    // smallest monitored count, 0 when nothing is monitored
+    count_t lowest_count() const { return m_min_bucket == NONE ? 0 : m_buckets[m_min_bucket].count; }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+
+    // adds a key that is not monitored with the given count and error, used to restore snapshots; O(1) when keys come by increasing count
+    void restore(const Key &key, count_t count, count_t error) {
+        int32_t node = _add_node(key, error);
+        int32_t next = NONE, bucket = m_max_bucket;
+        while (bucket != NONE && m_buckets[bucket].count > count) {
+            next = bucket;
+            bucket = m_buckets[bucket].prev;
+        }
+        if (bucket == NONE || m_buckets[bucket].count != count) { bucket = _new_bucket(count, bucket, next); }
+        _attach(node, bucket);
+    }
+
+    struct Counter {
+        const Key &key;
+        count_t count;
+        count_t error;   // the true count lies in [count - error, count]
+    };
+
+    // walks the monitored keys from the largest count to the smallest
+    class Iterator {
+      public:
+        Iterator() = default;
+        Iterator(const BucketStreamSummary *summary, int32_t bucket)
+            : m_summary(summary), m_bucket(bucket), m_node(bucket == NONE ? NONE : summary->m_buckets[bucket].first) {}
+
+        Counter operator*() const {
+            const Node &node = m_summary->m_nodes[m_node];
+            return Counter{node.key, m_summary->m_buckets[m_bucket].count, node.error};
+        }
+
+        Iterator &operator++() {
+            m_node = m_summary->m_nodes[m_node].next;
+            if (m_node == NONE) {
+                m_bucket = m_summary->m_buckets[m_bucket].prev;
+                if (m_bucket != NONE) { m_node = m_summary->m_buckets[m_bucket].first; }
+            }
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const { return m_node != other.m_node; }
+
+      private:
+        const BucketStreamSummary *m_summary = nullptr;
+        int32_t m_bucket = NONE, m_node = NONE;
+    };
+
+    Iterator begin() const { return Iterator(this, m_max_bucket); }
+    Iterator end() const { return Iterator(); }
+
+    size_t memory_bytes() const { return m_nodes.size() * sizeof(Node) + m_buckets.size() * sizeof(Bucket) + m_index.size() * sizeof(Slot); }
+
+    // a node, a bucket and at most four index slots per counter
+    static constexpr size_t bytes_per_counter() { return sizeof(Node) + sizeof(Bucket) + 4 * sizeof(Slot); }
+
+  private:
+    struct Node {
+        Key key{};
+        count_t error = 0;
+        int32_t bucket = NONE;
+        int32_t prev = NONE, next = NONE;   // siblings in the bucket
+    };
+
+    struct Bucket {
+        count_t count = 0;
+        int32_t first = NONE;
+        int32_t prev = NONE, next = NONE;   // neighbouring buckets, by increasing count
+    };
+
+    // the hash is kept next to the node position so probes rarely touch the nodes of other keys
+    struct Slot {
+        int32_t node = NONE;
+        uint32_t hash = 0;
+    };
+
+    size_t m_capacity;
+    size_t m_size = 0, m_allocated = 0;   // monitored keys, nodes handed out so far
+    int32_t m_free_node = NONE;           // nodes of erased keys, linked through next
+    std::vector<Node> m_nodes;
+    std::vector<Bucket> m_buckets;
+    std::vector<Slot> m_index;
+    size_t m_index_mask;
+    int32_t m_min_bucket, m_max_bucket, m_free_bucket;
+
+    static uint32_t _hash(const Key &key) {
+        uint64_t h = Hash{}(key);
+        // std::hash of integers is the identity, spread the bits before masking
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return uint32_t(h);
+    }
+
+    // slot holding key, or the empty slot ending its probe sequence
+    size_t _find_slot(const Key &key, uint32_t hash) const {
+        size_t slot = hash & m_index_mask;
+        while (m_index[slot].node != NONE) {
+            if (m_index[slot].hash == hash && m_nodes[m_index[slot].node].key == key) { return slot; }
+            slot = (slot + 1) & m_index_mask;
+        }
+        return slot;
+    }
+
+    // backward shift deletion keeps every probe sequence free of holes without tombstones
+    void _erase_slot(size_t slot) {
+        size_t next = slot;
+        while (true) {
+            next = (next + 1) & m_index_mask;
+            if (m_index[next].node == NONE) { break; }
+            size_t home = m_index[next].hash & m_index_mask;
+            // an entry moves back unless its home lies cyclically in (slot, next]
+            if (((next - home) & m_index_mask) >= ((next - slot) & m_index_mask)) {
+                m_index[slot] = m_index[next];
+                slot = next;
+            }
+        }
+        m_index[slot].node = NONE;
+    }
+
+    int32_t _new_node(const Key &key, count_t error) {
+        int32_t node;
+        if (m_free_node != NONE) {
+            node = m_free_node;
+            m_free_node = m_nodes[node].next;
+        } else {
+            node = int32_t(m_allocated++);
+        }
+        m_nodes[node].key = key;
+        m_nodes[node].error = error;
+        ++m_size;
+        return node;
+    }
+
+    // indexes a key that is not monitored on a new node, which is not in any bucket yet
+    int32_t _add_node(const Key &key, count_t error) {
+        if (m_size >= m_capacity) { throw std::runtime_error("Stream-summary holds more keys than its capacity"); }
+        uint32_t hash = _hash(key);
+        size_t slot = _find_slot(key, hash);
+        if (m_index[slot].node != NONE) { throw std::runtime_error("Stream-summary already monitors the inserted key"); }
+        int32_t node = _new_node(key, error);
+        m_index[slot] = Slot{node, hash};
+        return node;
+    }
+
+    int32_t _new_bucket(count_t count, int32_t prev, int32_t next) {
+        int32_t bucket = m_free_bucket;
+        m_free_bucket = m_buckets[bucket].next;
+        m_buckets[bucket] = Bucket{count, NONE, prev, next};
+        if (prev != NONE) {
+            m_buckets[prev].next = bucket;
+        } else {
+            m_min_bucket = bucket;
+        }
+        if (next != NONE) {
+            m_buckets[next].prev = bucket;
+        } else {
+            m_max_bucket = bucket;
+        }
+        return bucket;
+    }
+
+    void _release_bucket(int32_t bucket) {
+        int32_t prev = m_buckets[bucket].prev, next = m_buckets[bucket].next;
+        if (prev != NONE) {
+            m_buckets[prev].next = next;
+        } else {
+            m_min_bucket = next;
+        }
+        if (next != NONE) {
+            m_buckets[next].prev = prev;
+        } else {
+            m_max_bucket = prev;
+        }
+        m_buckets[bucket].next = m_free_bucket;
+        m_free_bucket = bucket;
+    }
+
+    void _attach(int32_t node, int32_t bucket) {
+        Node &n = m_nodes[node];
+        n.bucket = bucket;
+        n.prev = NONE;
+        n.next = m_buckets[bucket].first;
+        if (n.next != NONE) { m_nodes[n.next].prev = node; }
+        m_buckets[bucket].first = node;
+    }
+
+    // returns true when the bucket of node is left empty
+    bool _detach(int32_t node) {
+        Node &n = m_nodes[node];
+        if (n.prev != NONE) {
+            m_nodes[n.prev].next = n.next;
+        } else {
+            m_buckets[n.bucket].first = n.next;
+        }
+        if (n.next != NONE) { m_nodes[n.next].prev = n.prev; }
+        return m_buckets[n.bucket].first == NONE;
+    }
+
+    // puts node into the bucket of count, searching upwards from the bucket after prev (from the minimum when prev is NONE)
+    void _place(int32_t node, count_t count, int32_t prev) {
+        int32_t bucket = prev == NONE ? m_min_bucket : m_buckets[prev].next;
+        while (bucket != NONE && m_buckets[bucket].count < count) {
+            prev = bucket;
+            bucket = m_buckets[bucket].next;
+        }
+        if (bucket == NONE || m_buckets[bucket].count != count) { bucket = _new_bucket(count, prev, bucket); }
+        _attach(node, bucket);
+    }
+
+    count_t _increment(int32_t node, count_t c) {
+        int32_t bucket = m_nodes[node].bucket;
+        count_t count = m_buckets[bucket].count + c;
+        if (c == 0) { return count; }
+        if (_detach(node)) {
+            int32_t next = m_buckets[bucket].next;
+            if (next == NONE || m_buckets[next].count > count) {
+                // the node was alone and keeps its place in the order, its bucket just takes the new count
+                m_buckets[bucket].count = count;
+                _attach(node, bucket);
+                return count;
+            }
+            _place(node, count, bucket);
+            _release_bucket(bucket);
+        } else {
+            _place(node, count, bucket);
+        }
+        return count;
+    }
+};
@@ -1,22 +1,68 @@
 #include "CountMinSketch.hpp"
 
-#define LONG_PRIME 2147483647
+#include <immintrin.h>
+
+#include <random>
+#include <stdexcept>
+
+// the AVX2 paths are compiled for AVX2 only, and taken (use_avx2) when the cpu running the binary has it
+__attribute__((target("avx2"))) static void offsets_avx2(uint32_t h1, uint32_t h2, uint32_t mask, unsigned int width_bits, unsigned int depth, uint32_t *offsets) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i h1_vec = _mm256_set1_epi32(h1);
+    const __m256i h2_vec = _mm256_set1_epi32(h2);
+    const __m256i mask_vec = _mm256_set1_epi32(mask);
+    for (unsigned int i = 0; i < depth; i += 8) {
+        __m256i rows = _mm256_add_epi32(_mm256_set1_epi32(i), lanes);
+        __m256i columns = _mm256_and_si256(_mm256_add_epi32(h1_vec, _mm256_mullo_epi32(rows, h2_vec)), mask_vec);
+        __m256i row_starts = _mm256_sll_epi32(rows, _mm_cvtsi32_si128(width_bits));
+        _mm256_storeu_si256((__m256i *) (offsets + i), _mm256_add_epi32(row_starts, columns));
+    }
+}
+
+__attribute__((target("avx2"))) static int min_avx2(const int *counters, const uint32_t *offsets, unsigned int depth) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i depth_vec = _mm256_set1_epi32(depth);
+    const __m256i max_vec = _mm256_set1_epi32(numeric_limits<int>::max());
+    __m256i minimum = max_vec;
+    for (unsigned int i = 0; i < depth; i += 8) {
+        // lanes past the last row are neither read from offsets nor gathered, they keep INT_MAX
+        __m256i valid = _mm256_cmpgt_epi32(depth_vec, _mm256_add_epi32(_mm256_set1_epi32(i), lanes));
+        __m256i indices = _mm256_maskload_epi32((const int *) (offsets + i), valid);
+        __m256i values = _mm256_mask_i32gather_epi32(max_vec, counters, indices, valid, 4);
+        minimum = _mm256_min_epi32(minimum, values);
+    }
+    __m128i half = _mm_min_epi32(_mm256_castsi256_si128(minimum), _mm256_extracti128_si256(minimum, 1));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+}
 
-CountMinSketch::CountMinSketch() {}
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+CountMinSketch::CountMinSketch() : width(0), depth(0), epsilon(0), delta(0) {}
 
-CountMinSketch::CountMinSketch(unsigned int width, unsigned int depth) {
+CountMinSketch::CountMinSketch(unsigned int width, unsigned int depth, bool conservative_update) {
     this->depth = depth;
     this->width = width;
-    epsilon = exp(1) / width;
-    delta = 1 / pow(exp(1), depth);
+    this->conservative_update = conservative_update;
     this->init_countmin_sketch();
+    epsilon = exp(1) / this->width;
+    delta = 1 / pow(exp(1), depth);
 }
 
-CountMinSketch::CountMinSketch(float epsilon, float delta) {
+CountMinSketch::CountMinSketch(float epsilon, float delta, bool conservative_update) {
     this->epsilon = epsilon;
     this->delta = delta;
     this->width = ceil(exp(1) / epsilon);
     this->depth = ceil(log(1 / delta));
+    this->conservative_update = conservative_update;
     this->init_countmin_sketch();
 }
 
@@ -24,110 +70,135 @@ CountMinSketch::CountMinSketch(const CountMinConfig &countmin_configs) {
     if (countmin_configs.CALCULATE_FROM == "WIDTH_DEPTH") {
         this->width = countmin_configs.WIDTH;
         this->depth = countmin_configs.DEPTH;
-        this->epsilon = exp(1) / this->width;
-        this->delta = 1 / pow(exp(1), this->depth);
     } else if (countmin_configs.CALCULATE_FROM == "EPSILON_DELTA") {
-        this->epsilon = countmin_configs.EPSILON;
-        this->delta = countmin_configs.DELTA;
-        this->width = ceil(exp(1) / this->epsilon);
-        this->depth = ceil(log(1 / delta));
+        this->width = ceil(exp(1) / countmin_configs.EPSILON);
+        this->depth = ceil(log(1 / countmin_configs.DELTA));
     } else {
         cout << "Init CountMinSketch: Invalid calculate from" << endl;
         exit(1);
     }
+    this->conservative_update = countmin_configs.CONSERVATIVE_UPDATE;
     this->init_countmin_sketch();
+    // the rounded width only tightens the requested bound
+    this->epsilon = exp(1) / this->width;
+    this->delta = 1 / pow(exp(1), this->depth);
 }
 
 void CountMinSketch::init_countmin_sketch() {
-    // Initialize counter array of arrays, C
-    this->C = new int *[this->depth];
-    for (int i = 0; i < this->depth; i++) {
-        this->C[i] = new int[this->width];
-        for (int j = 0; j < this->width; j++) { this->C[i][j] = 0; }
-    }
+    if (this->depth == 0 || this->depth > MAX_DEPTH) { throw std::runtime_error("CountMinSketch depth must be between 1 and " + std::to_string(MAX_DEPTH)); }
 
-    // Initialize d pairwise independent hashes
-    srand((unsigned int) clock());
-    this->hashes = new int *[this->depth];
-    for (int i = 0; i < this->depth; i++) {
-        this->hashes[i] = new int[2];
-        genajbj(this->hashes, i);
-    }
-}
+    // round the width up (never down) to a power of two, columns are then taken with a mask; callers with a memory budget pass a power of two
+    this->width_bits = 0;
+    while ((1u << this->width_bits) < std::max(this->width, 1u)) { this->width_bits++; }
+    this->width = 1u << this->width_bits;
 
-void CountMinSketch::genajbj(int **hashes, int i) {
-    hashes[i][0] = int(float(rand()) * float(LONG_PRIME) / float(RAND_MAX) + 1);
-    hashes[i][1] = int(float(rand()) * float(LONG_PRIME) / float(RAND_MAX) + 1);
-}
+    // Initialize all counters in one array, C
+    this->C.assign(size_t(this->width) * this->depth, 0);
 
-unsigned int CountMinSketch::_get_hashitem(const string &item) {
-    unsigned long hash = 5381;
-    for (char c : item) { hash = (((hash << 5) + hash) + c) % LONG_PRIME; /* hash * 33 + c */ }
-    return hash;
+    std::random_device random_device;
+    this->seed = (uint64_t(random_device()) << 32) | random_device();
 }
 
-void CountMinSketch::update(const int &item, int c) { this->_update(item, c); }
-
-void CountMinSketch::update(const string &item, int c) {
-    unsigned int hashitem = this->_get_hashitem(item);
-    this->_update(hashitem, c);
-}
+uint64_t CountMinSketch::_hash(const int &item) const { return mix64(uint64_t(uint32_t(item)) + this->seed); }
 
-void CountMinSketch::_update(const int &item, int c) {
-    this->total = this->total + c;
-    unsigned int hashval = 0;
-    for (int i = 0; i < this->depth; i++) {
-        hashval = ((long) hashes[i][0] * item + hashes[i][1]) % LONG_PRIME % this->width;
-        this->C[i][hashval] = this->C[i][hashval] + c;
+uint64_t CountMinSketch::_hash(const string &item) const {
+    // FNV-1a, then mixed with the seed
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : item) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ULL;
     }
+    return mix64(hash ^ this->seed);
 }
 
-unsigned int CountMinSketch::estimate(const int &item) { return this->_estimate(item); }
-
-unsigned int CountMinSketch::estimate(const string &item) {
-    unsigned int hashitem = this->_get_hashitem(item);
-    return this->_estimate(hashitem);
+void CountMinSketch::_offsets(uint64_t hash, uint32_t *offsets) const {
+    uint32_t h1 = uint32_t(hash);
+    uint32_t h2 = uint32_t(hash >> 32) | 1;   // odd, so that rows never share the same column sequence
+    uint32_t mask = this->width - 1;
+    if (this->use_avx2) {
+        offsets_avx2(h1, h2, mask, this->width_bits, this->depth, offsets);
+        return;
+    }
+    for (unsigned int i = 0; i < this->depth; i++) { offsets[i] = (i << this->width_bits) + ((h1 + i * h2) & mask); }
 }
 
-unsigned int CountMinSketch::_estimate(const int &item) {
+unsigned int CountMinSketch::_min(const uint32_t *offsets) const {
+    if (this->use_avx2) { return min_avx2(this->C.data(), offsets, this->depth); }
     int minval = numeric_limits<int>::max();
-    unsigned int hashval = 0;
-    for (unsigned int j = 0; j < this->depth; j++) {
-        hashval = ((long) hashes[j][0] * item + hashes[j][1]) % LONG_PRIME % this->width;
-        minval = min(minval, C[j][hashval]);
-    }
+    for (unsigned int i = 0; i < this->depth; i++) { minval = min(minval, this->C[offsets[i]]); }
     return minval;
 }
 
-unsigned int CountMinSketch::update_and_estimate(const int &item, int c) {
-    int minval = numeric_limits<int>::max();
+unsigned int CountMinSketch::_update(uint64_t hash, int c) {
     this->total = this->total + c;
-    unsigned int hashval = 0;
-    for (int i = 0; i < this->depth; i++) {
-        hashval = ((long) hashes[i][0] * item + hashes[i][1]) % LONG_PRIME % this->width;
-        this->C[i][hashval] = this->C[i][hashval] + c;
-        minval = min(minval, C[i][hashval]);
+    uint32_t offsets[MAX_DEPTH];
+    this->_offsets(hash, offsets);
+
+    if (this->conservative_update) {
+        // raise every counter to at least the new estimate, counters already above it keep their value
+        int new_estimate = this->_min(offsets) + c;
+        for (unsigned int i = 0; i < this->depth; i++) { this->C[offsets[i]] = max(this->C[offsets[i]], new_estimate); }
+        return new_estimate;
     }
-    return minval;
-}
 
-unsigned int CountMinSketch::update_and_estimate(const string &item, int c) {
     int minval = numeric_limits<int>::max();
-    unsigned int hashitem = this->_get_hashitem(item);
-    this->total = this->total + c;
-    unsigned int hashval = 0;
-    for (int i = 0; i < this->depth; i++) {
-        hashval = ((long) hashes[i][0] * hashitem + hashes[i][1]) % LONG_PRIME % this->width;
-        this->C[i][hashval] = this->C[i][hashval] + c;
-        minval = min(minval, C[i][hashval]);
+    for (unsigned int i = 0; i < this->depth; i++) {
+        this->C[offsets[i]] += c;
+        minval = min(minval, this->C[offsets[i]]);
     }
+    return minval;
 }
 
+unsigned int CountMinSketch::_estimate(uint64_t hash) const {
+    uint32_t offsets[MAX_DEPTH];
+    this->_offsets(hash, offsets);
+    return this->_min(offsets);
+}
+
+void CountMinSketch::update(const int &item, int c) { this->_update(this->_hash(item), c); }
+
+void CountMinSketch::update(const string &item, int c) { this->_update(this->_hash(item), c); }
+
+unsigned int CountMinSketch::estimate(const int &item) { return this->_estimate(this->_hash(item)); }
+
+unsigned int CountMinSketch::estimate(const string &item) { return this->_estimate(this->_hash(item)); }
+
+unsigned int CountMinSketch::update_and_estimate(const int &item, int c) { return this->_update(this->_hash(item), c); }
+
+unsigned int CountMinSketch::update_and_estimate(const string &item, int c) { return this->_update(this->_hash(item), c); }
+
 void CountMinSketch::print_status() {
     cout << "Width: " << this->width << endl;
     cout << "Depth: " << this->depth << endl;
     cout << "Epsilon: " << this->epsilon << endl;
     cout << "Delta: " << this->delta << endl;
     cout << "Total: " << this->total << endl;
-    cout << "Estimated size in bytes: " << this->width * this->depth * sizeof(int) << endl;
-}
\ No newline at end of file
+    cout << "Conservative update: " << (this->conservative_update ? "yes" : "no") << endl;
+    cout << "Estimated size in bytes: " << memory_usage() << endl;
+}
+
+void CountMinSketch::save(std::ostream &os) const {
+    write_snapshot_header(os, SnapshotKind::COUNT_MIN);
+    write_binary(os, this->width);
+    write_binary(os, this->depth);
+    write_binary(os, this->epsilon);
+    write_binary(os, this->delta);
+    write_binary(os, this->total);
+    write_binary(os, this->conservative_update);
+    write_binary(os, this->seed);
+    write_binary_array(os, this->C.data(), this->C.size());
+}
+
+void CountMinSketch::load(std::istream &is) {
+    uint32_t version = read_snapshot_header(is, SnapshotKind::COUNT_MIN);
+    if (version < 2) { throw std::runtime_error("CountMinSketch snapshots before format version 2 use per-row pairwise hashes and cannot be restored"); }
+    read_binary(is, this->width);
+    read_binary(is, this->depth);
+    this->init_countmin_sketch();
+    read_binary(is, this->epsilon);
+    read_binary(is, this->delta);
+    read_binary(is, this->total);
+    read_binary(is, this->conservative_update);
+    read_binary(is, this->seed);
+    read_binary_array(is, this->C.data(), this->C.size());
+}
@@ -2,19 +2,30 @@
 
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "utils/BinarySnapshot.hpp"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <ctime>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
-class CountMinSketch : public FrequencyEstimatorBase {
+// Count-Min sketch with all rows in one flat array, row after row (not blocked: the counters of a key are width apart). A blocked
+// layout, all counters of a key in one cache line, is only faster once the sketch is past the last level cache and loses accuracy,
+// most of all with conservative update.
+// A key is hashed once to 64 bits; the halves h1, h2 give the column of row i as (h1 + i * h2) & (width - 1), so the width is
+// rounded up to a power of two. Only the column offsets and the minimum over rows use AVX2 when the cpu has it (gather across
+// rows); counters are incremented one by one since AVX2 has no scatter. See microbench/countmin_layout.txt.
+class CountMinSketch : public FrequencyEstimatorBase<CountMinSketch> {
   public:
-    // width, depth
+    static constexpr unsigned int MAX_DEPTH = 32;
+
+    // width (rounded up to a power of two), depth
     unsigned int width, depth;
 
     // epsilon, delta
@@ -23,40 +34,53 @@ class CountMinSketch : public FrequencyEstimatorBase {
     float epsilon, delta;
     unsigned int total = 0;
 
+    // conservative update: a key only raises the counters below its new estimate, which never adds error and removes most of it on skewed streams
+    bool conservative_update = false;
+
+    // take the AVX2 paths, on when the cpu has them (off to check the scalar paths against them)
+    bool use_avx2 = __builtin_cpu_supports("avx2");
+
     // declare function prototypes
     void init_countmin_sketch();
-    void genajbj(int **, int);
 
     // constructors
     CountMinSketch();
-    CountMinSketch(unsigned int, unsigned int);
-    CountMinSketch(float, float);
+    CountMinSketch(unsigned int, unsigned int, bool = false);
+    CountMinSketch(float, float, bool = false);
     CountMinSketch(const CountMinConfig &);
 
-    // update and estimate functions (override from base class)
-    void update(const int &, int = 1) override;
-    void update(const string &, int = 1) override;
-    unsigned int estimate(const int &) override;
-    unsigned int estimate(const string &) override;
-    unsigned int update_and_estimate(const int &, int = 1) override;
-    unsigned int update_and_estimate(const string &, int = 1) override;
+    // update and estimate functions (FrequencyEstimatorLike)
+    void update(const int &, int = 1);
+    void update(const string &, int = 1);
+    unsigned int estimate(const int &);
+    unsigned int estimate(const string &);
+    unsigned int update_and_estimate(const int &, int = 1);
+    unsigned int update_and_estimate(const string &, int = 1);
 
     // Utility function
     template <typename T> float correct_probability(const map<T, int> &);
 
-    // print function (override from base class)
-    void print_status() override;
+    // print function
+    void print_status();
+    size_t memory_usage() const { return C.size() * sizeof(int); }
+
+    // binary snapshot of the dimensions, hash seed and counters
+    void save(std::ostream &) const;
+    void load(std::istream &);
 
   private:
-    // internal variables
-    int **C;
-    unsigned int aj, bj;
-    int **hashes;
-
-    // internal update function
-    void _update(const int &, int = 1);
-    unsigned int _estimate(const int &);
-    unsigned int _get_hashitem(const string &);
+    // counters of all rows, row i starts at i * width
+    std::vector<int> C;
+    unsigned int width_bits = 0;
+    uint64_t seed = 0;
+
+    // internal functions
+    uint64_t _hash(const int &) const;
+    uint64_t _hash(const string &) const;
+    void _offsets(uint64_t, uint32_t *) const;
+    unsigned int _min(const uint32_t *) const;
+    unsigned int _update(uint64_t, int = 1);
+    unsigned int _estimate(uint64_t) const;
 };
 
 template <typename T> float CountMinSketch::correct_probability(const map<T, int> &exact_counter) {
@@ -66,4 +90,4 @@ template <typename T> float CountMinSketch::correct_probability(const map<T, int
     }
     // cout << "Count wrong: " << count_wrong << endl;
     return 1 - (float) count_wrong / exact_counter.size();
-}
\ No newline at end of file
+}
@@ -1,27 +1,27 @@
 #include "CuckooHeavyKeeper.hpp"
+#include <algorithm>
 #include <cassert>
 #include <ctime>
 #include <iomanip>
+#include <map>
+#include <stdexcept>
 
-CuckooHeavyKeeper::CuckooHeavyKeeper(size_t bucket_num, double theta, counter_t promotion_threshold, double decay_base)
-    : m_bucket_num(bucket_num), m_theta(theta), m_promotion_threshold(promotion_threshold), m_decay_base(decay_base) {
+CuckooHeavyKeeper::CuckooHeavyKeeper(size_t bucket_num, double theta, counter_t promotion_threshold, double decay_base, int seed)
+    : m_bucket_num(bucket_num), m_promotion_threshold(promotion_threshold), m_decay_base(decay_base), m_theta(theta) {
     assert(_is_power_of_two(bucket_num) && "bucket_num must be power of 2");
 
     m_tables[0].resize(bucket_num);
     m_tables[1].resize(bucket_num);
 
     srand(static_cast<unsigned int>(clock()));
-    m_bobhash = new BOBHash64(rand() % 1228);
+    m_seed = seed >= 0 ? seed % 1228 : rand() % 1228;
+    m_bobhash = std::make_shared<BOBHash64>(m_seed);
     rng.seed(std::random_device()());
     dist = std::uniform_real_distribution<double>(0.0, 1.0);
     _init_decay_expectations();
 }
 
-CuckooHeavyKeeper::CuckooHeavyKeeper(CuckooHeavyKeeperConfig config) : CuckooHeavyKeeper(config.BUCKET_NUM, config.THETA, 16, 1.08) {}
-
-CuckooHeavyKeeper::~CuckooHeavyKeeper() {
-    // delete m_bobhash;
-}
+CuckooHeavyKeeper::CuckooHeavyKeeper(CuckooHeavyKeeperConfig config) : CuckooHeavyKeeper(config.BUCKET_NUM, config.THETA, 16, 1.08, config.SEED) {}
 
 void CuckooHeavyKeeper::_init_decay_expectations() {
     m_decay_expectations[0] = 0;
@@ -194,7 +194,10 @@ counter_t CuckooHeavyKeeper::_update_impl(const std::string &item, int weight) {
     size_t idx1;
     _generate_fingerprint_and_index(item, fp, idx1);
     size_t idx2 = _generate_alt_index(fp, idx1);
+    return _update_fingerprint(fp, idx1, idx2, weight);
+}
 
+counter_t CuckooHeavyKeeper::_update_fingerprint(fingerprint_t fp, size_t idx1, size_t idx2, int weight) {
     counter_t result;
 
     // check if it is in heavy entries first -> update and return
@@ -209,8 +212,8 @@ counter_t CuckooHeavyKeeper::_update_impl(const std::string &item, int weight) {
         Entry &lobby = m_tables[table_idx][idx].get_lobby();
 
         if (lobby.is_empty()) {
+            lobby = Entry{fp, weight};
             if (weight < m_promotion_threshold) {
-                lobby = Entry{fp, weight};
                 return weight;
             } else {
                 Entry &smallest = m_tables[table_idx][idx].get_smallest_heavy();
@@ -262,6 +265,113 @@ counter_t CuckooHeavyKeeper::_estimate_impl(const std::string &item) const {
     return max_count;
 }
 
+counter_t CuckooHeavyKeeper::_remove_impl(const std::string &item) {
+    fingerprint_t fp;
+    size_t idx1;
+    _generate_fingerprint_and_index(item, fp, idx1);
+    size_t idx2 = _generate_alt_index(fp, idx1);
+
+    // a failed promotion can leave the key in a lobby next to its heavy entry, the estimate is the larger one and both go
+    counter_t max_count = 0;
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        size_t idx = (table_idx == 0) ? idx1 : idx2;
+        for (auto &entry : m_tables[table_idx][idx].entries) {
+            if (entry.counter > 0 && entry.fingerprint == fp) {
+                max_count = std::max(max_count, entry.counter);
+                entry = Entry{};
+            }
+        }
+    }
+    total -= std::min<size_t>(total, max_count);
+    return max_count;
+}
+
+bool CuckooHeavyKeeper::is_mergeable_with(const CuckooHeavyKeeper &other) const {
+    return m_bucket_num == other.m_bucket_num && m_seed == other.m_seed && m_promotion_threshold == other.m_promotion_threshold && m_decay_base == other.m_decay_base;
+}
+
+void CuckooHeavyKeeper::merge(const CuckooHeavyKeeper &other) {
+    if (!is_mergeable_with(other)) { throw std::runtime_error("CuckooHeavyKeeper::merge needs sketches with the same bucket number, seed and decay parameters"); }
+    if (&other == this) {
+        CuckooHeavyKeeper copy = other;
+        merge(copy);
+        return;
+    }
+
+    // other may hold a key in more than one entry (a heavy slot and a lobby left from before the key took a freed heavy slot),
+    // and estimates it by the largest of them, so each (fingerprint, primary index) is merged once with its largest counter
+    struct MergedEntry {
+        counter_t counter;
+        bool is_heavy;
+    };
+    std::map<std::pair<fingerprint_t, size_t>, MergedEntry> merged_entries;
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        for (size_t idx = 0; idx < m_bucket_num; ++idx) {
+            const Bucket &bucket = other.m_tables[table_idx][idx];
+            for (size_t i = 0; i < Bucket::ENTRIES_PER_BUCKET; ++i) {
+                const Entry &entry = bucket.entries[i];
+                if (entry.is_empty()) { continue; }
+                // entries of table 0 sit at their primary index, entries of table 1 at the alternate one
+                size_t idx1 = table_idx == 0 ? idx : _generate_alt_index(entry.fingerprint, idx);
+                auto [it, inserted] = merged_entries.try_emplace({entry.fingerprint, idx1}, MergedEntry{entry.counter, i > 0});
+                if (!inserted && (entry.counter > it->second.counter || (entry.counter == it->second.counter && i > 0))) { it->second = MergedEntry{entry.counter, i > 0}; }
+            }
+        }
+    }
+
+    // heavy entries first, so that they claim the free heavy slots before lobby entries are merged
+    for (bool is_heavy : {true, false}) {
+        for (const auto &[key, merged_entry] : merged_entries) {
+            if (merged_entry.is_heavy != is_heavy) { continue; }
+            auto [fingerprint, idx1] = key;
+            _update_fingerprint(fingerprint, idx1, _generate_alt_index(fingerprint, idx1), merged_entry.counter);
+        }
+    }
+    total += other.total;
+}
+
+void CuckooHeavyKeeper::clear_buckets(size_t first_bucket, size_t last_bucket) {
+    last_bucket = std::min(last_bucket, m_bucket_num);
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        std::fill(m_tables[table_idx].begin() + first_bucket, m_tables[table_idx].begin() + last_bucket, Bucket{});
+    }
+}
+
+void CuckooHeavyKeeper::save(std::ostream &os) const {
+    static_assert(std::is_trivially_copyable_v<Bucket>, "buckets are written as raw bytes");
+    write_snapshot_header(os, SnapshotKind::CUCKOO_HEAVY_KEEPER);
+    write_binary(os, static_cast<uint64_t>(m_bucket_num));
+    write_binary(os, m_theta);
+    write_binary(os, m_promotion_threshold);
+    write_binary(os, m_decay_base);
+    write_binary(os, m_seed);
+    write_binary(os, static_cast<uint64_t>(total));
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) { write_binary_array(os, m_tables[table_idx].data(), m_bucket_num); }
+}
+
+void CuckooHeavyKeeper::load(std::istream &is) {
+    read_snapshot_header(is, SnapshotKind::CUCKOO_HEAVY_KEEPER);
+    uint64_t bucket_num, stored_total;
+    read_binary(is, bucket_num);
+    read_binary(is, m_theta);
+    read_binary(is, m_promotion_threshold);
+    read_binary(is, m_decay_base);
+    read_binary(is, m_seed);
+    read_binary(is, stored_total);
+    if (!_is_power_of_two(bucket_num)) { throw std::runtime_error("CuckooHeavyKeeper snapshot: bucket_num must be power of 2"); }
+
+    m_bucket_num = bucket_num;
+    total = stored_total;
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        m_tables[table_idx].resize(m_bucket_num);
+        read_binary_array(is, m_tables[table_idx].data(), m_bucket_num);
+    }
+
+    // fingerprints and indexes only match under the hash seed the snapshot was taken with
+    m_bobhash = std::make_shared<BOBHash64>(m_seed);
+    _init_decay_expectations();
+}
+
 void CuckooHeavyKeeper::update(const int &item, int c) { update(std::to_string(item), c); }
 
 void CuckooHeavyKeeper::update(const std::string &item, int c) { _update_impl(item, c); }
@@ -274,6 +384,10 @@ unsigned int CuckooHeavyKeeper::update_and_estimate(const int &item, int c) { re
 
 unsigned int CuckooHeavyKeeper::update_and_estimate(const std::string &item, int c) { return _update_impl(item, c); }
 
+unsigned int CuckooHeavyKeeper::remove(const int &item) { return remove(std::to_string(item)); }
+
+unsigned int CuckooHeavyKeeper::remove(const std::string &item) { return _remove_impl(item); }
+
 void CuckooHeavyKeeper::print_status() { std::cout << *this << std::endl; }
 
 std::ostream &operator<<(std::ostream &os, const CuckooHeavyKeeper &ck) {
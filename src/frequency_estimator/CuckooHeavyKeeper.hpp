@@ -5,9 +5,11 @@
 #include "frequency_estimator/MacroPreprocessor.hpp"
 #include "hash/BOBHash32.hpp"
 #include "hash/BOBHash64.hpp"
+#include "utils/BinarySnapshot.hpp"
 #include <array>
 #include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
@@ -17,7 +19,7 @@
 using fingerprint_t = int;
 using counter_t = int;
 
-class CuckooHeavyKeeper : public FrequencyEstimatorBase {
+class CuckooHeavyKeeper : public FrequencyEstimatorBase<CuckooHeavyKeeper> {
   public:
     struct Entry {
         fingerprint_t fingerprint{0};
@@ -41,19 +43,43 @@ class CuckooHeavyKeeper : public FrequencyEstimatorBase {
         }
     };
 
-    explicit CuckooHeavyKeeper(size_t bucket_num = 128, double theta = 0.01, counter_t promotion_threshold = 16, double decay_base = 1.08);
+    explicit CuckooHeavyKeeper(size_t bucket_num = 128, double theta = 0.01, counter_t promotion_threshold = 16, double decay_base = 1.08, int seed = -1);
     explicit CuckooHeavyKeeper(CuckooHeavyKeeperConfig config);
 
-    ~CuckooHeavyKeeper();
-
     size_t total{0};
-    void update(const int &item, int c = 1) override;
-    void update(const std::string &item, int c = 1) override;
-    unsigned int estimate(const int &item) override;
-    unsigned int estimate(const std::string &item) override;
-    unsigned int update_and_estimate(const int &item, int c = 1) override;
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override;
-    void print_status() override;
+    void update(const int &item, int c = 1);
+    void update(const std::string &item, int c = 1);
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
+    unsigned int update_and_estimate(const int &item, int c = 1);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    // empties the heavy and lobby entries holding the fingerprint of item and returns its estimate, a colliding key loses its count too
+    unsigned int remove(const int &item);
+    unsigned int remove(const std::string &item);
+    void print_status();
+    size_t memory_usage() const { return (m_tables[0].size() + m_tables[1].size()) * sizeof(Bucket); }
+
+    // Adds the counts of other into this sketch; both need the same bucket number and hash seed, since entries only keep their fingerprint
+    // and are re-inserted at the buckets they were found in. A key other holds in several entries is merged once, with the largest of
+    // their counters (which is its estimate b(x) there); heavy entries go first, then lobby entries, each as one weighted update through
+    // the usual path (heavy slot, lobby, weighted _decay_counter). For a key x whose heavy slot here holds h(x):
+    //  - x in a heavy slot here: that slot ends at exactly h(x) + b(x), the merged estimate is a(x) + b(x) unless a stale lobby
+    //    entry of x here was larger than h(x)
+    //  - otherwise b(x) takes an empty heavy slot (exact), or enters the lobby: a failed promotion clips x to the promotion threshold T, and
+    //    the resident lobby entry absorbs at most E = sum_{i<MAX_COUNTER} b^i (~30 for b = 1.08) of its weight, so the merged estimate is
+    //    at least min(a(x) + b(x) - E, T); a key heavy in other that has to displace a larger heavy entry here is promoted with the
+    //    probability (b(x) - T) / (smallest - T) of a single update
+    //  - the merged estimate exceeds a(x) + b(x) only through fingerprint collisions and promotions, as for a single sketch
+    bool is_mergeable_with(const CuckooHeavyKeeper &other) const;
+    void merge(const CuckooHeavyKeeper &other);
+
+    // empties buckets [first_bucket, last_bucket) of both tables, lets a caller spread a reset over many updates
+    void clear_buckets(size_t first_bucket, size_t last_bucket);
+    size_t get_bucket_num() const { return m_bucket_num; }
+
+    // binary snapshot of the parameters, hash seed and both tables; load replaces the whole state, bucket number included
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
 
     friend std::ostream &operator<<(std::ostream &os, const CuckooHeavyKeeper &ck);
 
@@ -67,9 +93,10 @@ class CuckooHeavyKeeper : public FrequencyEstimatorBase {
     counter_t m_promotion_threshold;
     double m_decay_base;
     double m_theta;
+    int m_seed;
 
     std::array<std::vector<Bucket>, 2> m_tables;
-    BOBHash64 *m_bobhash;
+    std::shared_ptr<BOBHash64> m_bobhash;   // shared by copies of the sketch
     std::array<double, MAX_COUNTER + 1> m_decay_expectations;
     std::array<double, MAX_COUNTER + 1> m_min_decay_amounts;
     std::mt19937_64 rng;
@@ -83,7 +110,9 @@ class CuckooHeavyKeeper : public FrequencyEstimatorBase {
     unsigned long long _hash(const std::string &item) const;
 
     counter_t _update_impl(const std::string &item, int weight);
+    counter_t _update_fingerprint(fingerprint_t fp, size_t idx1, size_t idx2, int weight);
     counter_t _estimate_impl(const std::string &item) const;
+    counter_t _remove_impl(const std::string &item);
 
     bool _check_and_update_heavy(fingerprint_t fp, size_t idx1, size_t idx2, int weight, counter_t &result);
     bool _check_and_update_lobby(fingerprint_t fp, size_t idx1, size_t idx2, int weight, counter_t &result);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// Exponential-weakening decay of HeavyKeeper and HeavyGuardian: every colliding unit decrements a counter C with probability b^-C.
+// The probabilities are tabulated once per sketch and drawn from a per-sketch xorshift generator instead of rand() and pow().
+// A weighted collision of n units does not draw n times: the number of units until the next decay is geometric, so it is
+// sampled directly and the cost follows the number of decays, not the weight.
+class ExponentialDecay {
+  public:
+    explicit ExponentialDecay(double base = 1.08, uint64_t seed = 1) : m_state(seed | 1) {
+        for (size_t c = 0; c < TABLE_SIZE; ++c) {
+            double p = std::pow(base, -double(c));
+            m_thresholds[c] = p >= 1.0 ? UINT32_MAX : uint32_t(p * 4294967296.0);
+            m_log_survival[c] = p >= 1.0 ? -INFINITY : std::log1p(-p);
+        }
+    }
+
+    // colliding units, at most max_units, until a counter at C decays once; max_units + 1 when it survives them all
+    uint64_t units_until_decay(int64_t counter, uint64_t max_units) {
+        if (counter <= 0) { return 1; }
+        if (counter >= int64_t(TABLE_SIZE) || m_thresholds[counter] == 0) { return max_units + 1; }
+        if (max_units == 1) { return uint32_t(_next()) < m_thresholds[counter] ? 1 : 2; }
+        // inverse transform of the geometric distribution, 1 - u lies in (0, 1]
+        double u = double(_next() >> 11) * 0x1.0p-53;
+        double units = 1.0 + std::floor(std::log1p(-u) / m_log_survival[counter]);
+        return units > double(max_units) ? max_units + 1 : uint64_t(units);
+    }
+
+  private:
+    // b^-C * 2^32 is below one from C = 289 on for b = 1.08, larger counters never decay
+    static constexpr size_t TABLE_SIZE = 320;
+
+    std::array<uint32_t, TABLE_SIZE> m_thresholds;   // b^-C scaled to 32 bits
+    std::array<double, TABLE_SIZE> m_log_survival;   // log(1 - b^-C)
+    uint64_t m_state;
+
+    uint64_t _next() {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 0x2545F4914F6CDD1DULL;
+    }
+};
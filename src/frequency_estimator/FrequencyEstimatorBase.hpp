@@ -1,25 +1,49 @@
 #pragma once
 
+#include <concepts>
+#include <cstddef>
 #include <iostream>
 #include <map>
 #include <string>
 
-class FrequencyEstimatorBase {
-  public:
-    virtual void print_status() = 0;
-    virtual void update(const int &item, int c = 1) = 0;
-    virtual void update(const std::string &item, int c = 1) = 0;
-    virtual unsigned int estimate(const int &item) = 0;
-    virtual unsigned int estimate(const std::string &item) = 0;
-    virtual unsigned int update_and_estimate(const int &item, int c = 1) = 0;
-    virtual unsigned int update_and_estimate(const std::string &item, int c = 1) = 0;
+// The estimators are bound at compile time: wrappers and examples take the estimator as a template parameter, so every
+// update is a direct (and mostly inlined) call. FrequencyEstimatorLike states the interface they rely on; the base only adds
+// the error metrics, through CRTP rather than virtual functions. AnyFrequencyEstimator type-erases an estimator for tooling.
+template <typename T> concept FrequencyEstimatorLike = requires(T &estimator, const int &int_item, const std::string &string_item, int c) {
+    estimator.print_status();
+    estimator.update(int_item, c);
+    estimator.update(string_item, c);
+    { estimator.estimate(int_item) } -> std::convertible_to<unsigned int>;
+    { estimator.estimate(string_item) } -> std::convertible_to<unsigned int>;
+    { estimator.update_and_estimate(int_item, c) } -> std::convertible_to<unsigned int>;
+    { estimator.update_and_estimate(string_item, c) } -> std::convertible_to<unsigned int>;
+};
+
+// estimators that report the bytes their counters take
+template <typename T> concept MemoryReporting = requires(const T &estimator) {
+    { estimator.memory_usage() } -> std::convertible_to<size_t>;
+};
+
+// estimators that list their monitored (key, count) counters of Key, largest count first
+template <typename T, typename Key> concept HeavyHitterIterable = requires(T &estimator) {
+    { (*estimator.template counters<Key>().begin()).key } -> std::convertible_to<Key>;
+    { (*estimator.template counters<Key>().begin()).count } -> std::convertible_to<unsigned int>;
+};
+
+// estimators that can drop a key and return the count they held for it, the key can then be counted in another sketch
+template <typename T> concept KeyRemovable = requires(T &estimator, const int &int_item, const std::string &string_item) {
+    { estimator.remove(int_item) } -> std::convertible_to<unsigned int>;
+    { estimator.remove(string_item) } -> std::convertible_to<unsigned int>;
+};
 
+template <typename Derived> class FrequencyEstimatorBase {
+  public:
     // Average Relative Error (ARE)
     template <typename T> float ARE(const std::map<T, int> &exact_counter) {
         float relative_error = 0;
         for (const auto &entry : exact_counter) {
             relative_error +=
-                float(abs(entry.second - (int) this->estimate(entry.first))) / entry.second;
+                float(abs(entry.second - (int) _derived().estimate(entry.first))) / entry.second;
         }
         return relative_error / exact_counter.size();
     }
@@ -28,7 +52,7 @@ class FrequencyEstimatorBase {
     template <typename T> float AAE(const std::map<T, int> &exact_counter) {
         float absolute_error = 0;
         for (const auto &entry : exact_counter) {
-            absolute_error += float(abs(entry.second - (int) this->estimate(entry.first)));
+            absolute_error += float(abs(entry.second - (int) _derived().estimate(entry.first)));
         }
         return absolute_error / exact_counter.size();
     }
@@ -36,8 +60,25 @@ class FrequencyEstimatorBase {
     // print expected value from map's key
     template <typename T> void print_compare(const std::map<T, int> &exact_counter) {
         for (const auto &entry : exact_counter) {
-            std::cout << entry.first << " estimate:" << this->estimate(entry.first)
+            std::cout << entry.first << " estimate:" << _derived().estimate(entry.first)
                       << " real:" << entry.second << '\n';
         }
     }
-};
\ No newline at end of file
+
+  protected:
+    // only derived estimators construct the base, which keeps deleting through a base pointer from compiling
+    FrequencyEstimatorBase() = default;
+    ~FrequencyEstimatorBase() = default;
+    FrequencyEstimatorBase(const FrequencyEstimatorBase &) = default;
+    FrequencyEstimatorBase(FrequencyEstimatorBase &&) = default;
+    FrequencyEstimatorBase &operator=(const FrequencyEstimatorBase &) = default;
+    FrequencyEstimatorBase &operator=(FrequencyEstimatorBase &&) = default;
+
+  private:
+    Derived &_derived() { return static_cast<Derived &>(*this); }
+};
+
+// estimators that take a drained delegation filter, n (key, count) pairs, in one call
+template <typename T> concept FilterBatchProcessable = requires(T &estimator, const int *keys, const int *counts, int n, unsigned int *estimates) {
+    estimator.process_filter_batch(keys, counts, n, estimates);
+};
@@ -13,19 +13,24 @@ struct CountMinConfig {
     float DELTA;
     float EPSILON;
     string CALCULATE_FROM;   // CALCULATE_FROM WIDTH_DEPTH or EPSILON_DELTA
+    bool CONSERVATIVE_UPDATE;
 
     static void add_params_to_config_parser(CountMinConfig &countmin_config, ConfigParser &parser) {
         // CountMin configs prefix will be "countmin."
-        parser.AddParameter(new UnsignedInt32Parameter("countmin.width", "128", &countmin_config.WIDTH, false, "Width of the count min sketch"));
+        parser.AddParameter(new UnsignedInt32Parameter("countmin.width", "128", &countmin_config.WIDTH, false, "Width of the count min sketch, rounded up to a power of two"));
         parser.AddParameter(new UnsignedInt32Parameter("countmin.depth", "8", &countmin_config.DEPTH, false, "Depth of the count min sketch"));
         parser.AddParameter(new FloatParameter("countmin.epsilon", "0.01", &countmin_config.EPSILON, false, "Epsilon value for the count min sketch"));
         parser.AddParameter(new FloatParameter("countmin.delta", "0.01", &countmin_config.DELTA, false, "Delta value for the count min sketch"));
         parser.AddParameter(new StringParameter("countmin.calculate_from", "WIDTH_DEPTH", &countmin_config.CALCULATE_FROM, false,
                                                 "Calculate the count min sketch from "
                                                 "WIDTH_DEPTH or EPSILON_DELTA"));
+        parser.AddParameter(new BooleanParameter("countmin.conservative_update", false, &countmin_config.CONSERVATIVE_UPDATE, false,
+                                                 "Only raise the counters below the new estimate of a key"));
     }
 
-    auto to_tuple() const { return std::make_tuple("WIDTH", WIDTH, "DEPTH", DEPTH, "DELTA", DELTA, "EPSILON", EPSILON, "CALCULATE_FROM", CALCULATE_FROM); }
+    auto to_tuple() const {
+        return std::make_tuple("WIDTH", WIDTH, "DEPTH", DEPTH, "DELTA", DELTA, "EPSILON", EPSILON, "CALCULATE_FROM", CALCULATE_FROM, "CONSERVATIVE_UPDATE", CONSERVATIVE_UPDATE);
+    }
 
     friend std::ostream &operator<<(std::ostream &os, const CountMinConfig &config) {
         ConfigPrinter<CountMinConfig>::print(os, config);
@@ -48,12 +53,29 @@ struct HeavyKeeperConfig {
         return os;
     }
 };
+struct ElasticSketchConfig {
+    int BUCKET_NUM;
+    int MEMORY_IN_BYTES;
+    static void add_params_to_config_parser(ElasticSketchConfig &elasticsketch_config, ConfigParser &parser) {
+        // ElasticSketch configs prefix will be "elasticsketch."
+        parser.AddParameter(new IntParameter("elasticsketch.bucket_num", "1000", &elasticsketch_config.BUCKET_NUM, false, "Number of buckets in the heavy part"));
+        parser.AddParameter(
+            new IntParameter("elasticsketch.memory_in_bytes", "256000", &elasticsketch_config.MEMORY_IN_BYTES, false, "Memory of the heavy and the light part in bytes"));
+    }
+
+    auto to_tuple() const { return std::make_tuple("BUCKET_NUM", BUCKET_NUM, "MEMORY_IN_BYTES", MEMORY_IN_BYTES); }
+    friend std::ostream &operator<<(std::ostream &os, const ElasticSketchConfig &config) {
+        ConfigPrinter<ElasticSketchConfig>::print(os, config);
+        return os;
+    }
+};
 struct CuckooHeavyKeeperConfig {
     int BUCKET_NUM;
     int MAX_LOOP;
     int BITS_PER_ITEM;
     float THETA;
     float HK_b;
+    int SEED;
     // string CALCULATE_WORTH_REINSERTING_FROM; // total,passed_total
     // this is set in CuckooHeavyKeeper macro as it will be fixed
     // int NUM_ENTRY_PER_BUCKET;
@@ -68,13 +90,14 @@ struct CuckooHeavyKeeperConfig {
         // entries per bucket"));
         parser.AddParameter(new FloatParameter("cuckooheavykeeper.theta", "0.1", &cuckooheavykeeper_config.THETA, false, "Theta value for the cuckoo heavy keeper"));
         parser.AddParameter(new FloatParameter("cuckooheavykeeper.HK_b", "1.08", &cuckooheavykeeper_config.HK_b, false, "b value for the cuckoo heavy keeper"));
+        parser.AddParameter(new IntParameter("cuckooheavykeeper.seed", "-1", &cuckooheavykeeper_config.SEED, false, "Hash seed, sketches with the same seed can be merged (-1 picks a random one)"));
         // parser.AddParameter(new
         // StringParameter("cuckooheavykeeper.calculate_worth_reinserting_from",
         // "total", &cuckooheavykeeper_config.CALCULATE_WORTH_REINSERTING_FROM,
         // false, "Calculate worth reinserting from total or passed_total"));
     }
 
-    auto to_tuple() const { return std::make_tuple("BUCKET_NUM", BUCKET_NUM, "MAX_LOOP", MAX_LOOP, "BITS_PER_ITEM", BITS_PER_ITEM, "THETA", THETA, "HK_b", HK_b); }
+    auto to_tuple() const { return std::make_tuple("BUCKET_NUM", BUCKET_NUM, "MAX_LOOP", MAX_LOOP, "BITS_PER_ITEM", BITS_PER_ITEM, "THETA", THETA, "HK_b", HK_b, "SEED", SEED); }
 
     friend std::ostream &operator<<(std::ostream &os, const CuckooHeavyKeeperConfig &config) {
         ConfigPrinter<CuckooHeavyKeeperConfig>::print(os, config);
@@ -82,6 +105,29 @@ struct CuckooHeavyKeeperConfig {
     }
 };
 
+// the shared (concurrent) CHK takes the same parameters as the per-thread one
+struct SharedCuckooHeavyKeeperConfig : public CuckooHeavyKeeperConfig {};
+
+struct WindowedCuckooHeavyKeeperConfig : public CuckooHeavyKeeperConfig {
+    int NUM_WINDOWS;
+    int WINDOW_SIZE;
+
+    static void add_params_to_config_parser(WindowedCuckooHeavyKeeperConfig &windowedcuckooheavykeeper_config, ConfigParser &parser) {
+        CuckooHeavyKeeperConfig::add_params_to_config_parser(windowedcuckooheavykeeper_config, parser);
+        parser.AddParameter(new IntParameter("windowedcuckooheavykeeper.num_windows", "4", &windowedcuckooheavykeeper_config.NUM_WINDOWS, false,
+                                             "Number of sub-windows covered by queries"));
+        parser.AddParameter(new IntParameter("windowedcuckooheavykeeper.window_size", "1000000", &windowedcuckooheavykeeper_config.WINDOW_SIZE, false,
+                                             "Items per sub-window, the sketch slides by this many items"));
+    }
+
+    auto to_tuple() const { return std::tuple_cat(CuckooHeavyKeeperConfig::to_tuple(), std::make_tuple("NUM_WINDOWS", NUM_WINDOWS, "WINDOW_SIZE", WINDOW_SIZE)); }
+
+    friend std::ostream &operator<<(std::ostream &os, const WindowedCuckooHeavyKeeperConfig &config) {
+        ConfigPrinter<WindowedCuckooHeavyKeeperConfig>::print(os, config);
+        return os;
+    }
+};
+
 struct AugmentedSketchConfig {
     int FILTER_SIZE;
     unsigned int WIDTH;
@@ -89,16 +135,19 @@ struct AugmentedSketchConfig {
     float DELTA;
     float EPSILON;
     string CALCULATE_FROM;   // CALCULATE_FROM WIDTH_DEPTH or EPSILON_DELTA
+    bool CONSERVATIVE_UPDATE;
     static void add_params_to_config_parser(AugmentedSketchConfig &augmentedsketch_config, ConfigParser &parser) {
         // AugmentedSketch configs prefix will be "augmentedsketch."
         parser.AddParameter(new IntParameter("augmentedsketch.filter_size", "16", &augmentedsketch_config.FILTER_SIZE, false, "Filter size for the augmented sketch"));
-        parser.AddParameter(new UnsignedInt32Parameter("augmentedsketch.width", "128", &augmentedsketch_config.WIDTH, false, "Width of the augmented sketch"));
+        parser.AddParameter(new UnsignedInt32Parameter("augmentedsketch.width", "128", &augmentedsketch_config.WIDTH, false, "Width of the count min sketch behind the filter, rounded up to a power of two"));
         parser.AddParameter(new UnsignedInt32Parameter("augmentedsketch.depth", "8", &augmentedsketch_config.DEPTH, false, "Depth of the augmented sketch"));
         parser.AddParameter(new FloatParameter("augmentedsketch.epsilon", "0.01", &augmentedsketch_config.EPSILON, false, "Epsilon value for the augmented sketch"));
         parser.AddParameter(new FloatParameter("augmentedsketch.delta", "0.01", &augmentedsketch_config.DELTA, false, "Delta value for the augmented sketch"));
         parser.AddParameter(new StringParameter("augmentedsketch.calculate_from", "WIDTH_DEPTH", &augmentedsketch_config.CALCULATE_FROM, false,
                                                 "Calculate the augmented sketch from "
                                                 "WIDTH_DEPTH or EPSILON_DELTA"));
+        parser.AddParameter(new BooleanParameter("augmentedsketch.conservative_update", false, &augmentedsketch_config.CONSERVATIVE_UPDATE, false,
+                                                 "Use conservative update in the count min sketch behind the filter"));
     }
 
     // cast from AugmentedSketchConfig to CountMinConfig
@@ -109,11 +158,13 @@ struct AugmentedSketchConfig {
         countmin_config.DELTA = this->DELTA;
         countmin_config.EPSILON = this->EPSILON;
         countmin_config.CALCULATE_FROM = this->CALCULATE_FROM;
+        countmin_config.CONSERVATIVE_UPDATE = this->CONSERVATIVE_UPDATE;
         return countmin_config;
     }
 
     auto to_tuple() const {
-        return std::make_tuple("FILTER_SIZE", FILTER_SIZE, "WIDTH", WIDTH, "DEPTH", DEPTH, "DELTA", DELTA, "EPSILON", EPSILON, "CALCULATE_FROM", CALCULATE_FROM);
+        return std::make_tuple("FILTER_SIZE", FILTER_SIZE, "WIDTH", WIDTH, "DEPTH", DEPTH, "DELTA", DELTA, "EPSILON", EPSILON, "CALCULATE_FROM", CALCULATE_FROM,
+                               "CONSERVATIVE_UPDATE", CONSERVATIVE_UPDATE);
     }
 
     friend std::ostream &operator<<(std::ostream &os, const AugmentedSketchConfig &config) {
@@ -136,6 +187,18 @@ struct SpaceSavingConfig {
     }
 };
 
+// same parameters as SpaceSavingConfig, selects the stream-summary engine
+struct StreamSummarySpaceSavingConfig : public SpaceSavingConfig {
+    static void add_params_to_config_parser(StreamSummarySpaceSavingConfig &streamsummaryspacesaving_config, ConfigParser &parser) {
+        SpaceSavingConfig::add_params_to_config_parser(streamsummaryspacesaving_config, parser);
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const StreamSummarySpaceSavingConfig &config) {
+        ConfigPrinter<StreamSummarySpaceSavingConfig>::print(os, config);
+        return os;
+    }
+};
+
 struct WeightedFrequentConfig {
     unsigned int N;
     float EPSILON;
@@ -157,3 +220,5 @@ struct WeightedFrequentConfig {
 };
 
 struct OptimizedWeightedFrequentConfig : public WeightedFrequentConfig {};
+
+struct MisraGriesConfig : public WeightedFrequentConfig {};
@@ -2,25 +2,35 @@
 #include "frequency_estimator/CuckooHeavyKeeper.hpp"
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/HeapHashMapSpaceSaving.hpp"
+#include "frequency_estimator/HeavyGuardian.hpp"
 #include "frequency_estimator/HeavyKeeper.hpp"
 #include "frequency_estimator/SpaceSaving.hpp"
 #include "frequency_estimator/StreamSummarySpaceSaving.hpp"
+#include "frequency_estimator/elastic_sketch/ElasticSketch.hpp"
+#include <algorithm>
+#include <bit>
 
 class Experiment1FrequencyEstimatorFactory {
   public:
     template <typename T, typename... Args>
-        requires std::derived_from<T, FrequencyEstimatorBase>
+        requires FrequencyEstimatorLike<T>
     static T create_frequency_estimator(const int byte_size, Args &&...args) {
         if constexpr (std::same_as<T, HeavyKeeper>) {
             return Experiment1FrequencyEstimatorFactory::create_HeavyKeeper(byte_size);
+        } else if constexpr (std::same_as<T, HeavyGuardian>) {
+            return Experiment1FrequencyEstimatorFactory::create_HeavyGuardian(byte_size);
         } else if constexpr (std::same_as<T, CuckooHeavyKeeper>) {
             return Experiment1FrequencyEstimatorFactory::create_CuckooHeavyKeeper(byte_size);
+        } else if constexpr (std::same_as<T, ElasticSketch>) {
+            return Experiment1FrequencyEstimatorFactory::create_ElasticSketch(byte_size);
         } else if constexpr (std::same_as<T, CountMinSketch>) {
             return Experiment1FrequencyEstimatorFactory::create_CountMinSketch(byte_size);
         } else if constexpr (std::same_as<T, HeapHashMapSpaceSaving>) {
             return Experiment1FrequencyEstimatorFactory::create_HeapHashMapSpaceSaving(byte_size);
         } else if constexpr (std::same_as<T, SpaceSaving>) {
             return Experiment1FrequencyEstimatorFactory::create_SpaceSaving(byte_size);
+        } else if constexpr (std::same_as<T, StreamSummarySpaceSaving>) {
+            return Experiment1FrequencyEstimatorFactory::create_StreamSummarySpaceSaving(byte_size);
         } else {
             static_assert(std::false_type::value, "Unsupported type");
         }
@@ -31,15 +41,25 @@ class Experiment1FrequencyEstimatorFactory {
         int num_buckets = byte_size / sizeof(HeavyKeeper::node) / HeavyKeeper::HK_d;
         return HeavyKeeper(num_buckets);
     }
+    static HeavyGuardian create_HeavyGuardian(const int byte_size) {
+        int num_buckets = byte_size / sizeof(HeavyGuardian::Bucket);
+        return HeavyGuardian(num_buckets);
+    }
     static CuckooHeavyKeeper create_CuckooHeavyKeeper(const int byte_size) {
         int bucket_size = (sizeof(CuckooHeavyKeeper::bucket_t) - 3);
         int num_buckets = byte_size / bucket_size / 2;
         return CuckooHeavyKeeper(num_buckets, 0.001);
     }
+    static ElasticSketch create_ElasticSketch(const int byte_size) {
+        // a quarter of the memory for the heavy part, as in the Elastic sketch evaluation
+        int num_buckets = std::max(byte_size / 4 / int(sizeof(Bucket)), 1);
+        return ElasticSketch(num_buckets, byte_size);
+    }
 
     static CountMinSketch create_CountMinSketch(const int byte_size) {
         unsigned int depth = 8;
-        unsigned int width = byte_size / sizeof(int) / depth;
+        // the sketch rounds its width up to a power of two, a power of two at or below the budget is passed so that it is kept as is
+        unsigned int width = std::bit_floor(unsigned(byte_size / sizeof(int) / depth));
         return CountMinSketch(width, depth);
     }
 
@@ -52,4 +72,9 @@ class Experiment1FrequencyEstimatorFactory {
         int num_buckets = byte_size / (sizeof(std::string) + sizeof(unsigned int));
         return SpaceSaving(num_buckets);
     }
+
+    static StreamSummarySpaceSaving create_StreamSummarySpaceSaving(const int byte_size) {
+        int num_counters = byte_size / BucketStreamSummary<int>::bytes_per_counter();
+        return StreamSummarySpaceSaving(num_counters, num_counters);
+    }
 };
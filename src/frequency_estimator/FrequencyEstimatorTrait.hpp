@@ -4,14 +4,19 @@
 #include "frequency_estimator/BoundedKeyValuePriorityQueue.hpp"
 #include "frequency_estimator/CountMinSketch.hpp"
 #include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include "frequency_estimator/elastic_sketch/ElasticSketch.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 #include "frequency_estimator/HeapHashMapSpaceSaving.hpp"
+#include "frequency_estimator/HeavyGuardian.hpp"
 #include "frequency_estimator/HeavyKeeper.hpp"
 #include "frequency_estimator/MacroPreprocessor.hpp"
+#include "frequency_estimator/MisraGries.hpp"
 #include "frequency_estimator/OptimizedWeightedFrequent.hpp"
+#include "frequency_estimator/SharedCuckooHeavyKeeper.hpp"
 #include "frequency_estimator/SpaceSaving.hpp"
 #include "frequency_estimator/StreamSummarySpaceSaving.hpp"
 #include "frequency_estimator/WeightedFrequent.hpp"
+#include "frequency_estimator/WindowedCuckooHeavyKeeper.hpp"
 
 template <typename T> struct FrequencyEstimatorTrait;
 
@@ -24,18 +29,33 @@ template <> struct FrequencyEstimatorTrait<AugmentedSketchConfig> {
 template <> struct FrequencyEstimatorTrait<CuckooHeavyKeeperConfig> {
     using type = CuckooHeavyKeeper;
 };
+template <> struct FrequencyEstimatorTrait<SharedCuckooHeavyKeeperConfig> {
+    using type = SharedCuckooHeavyKeeper;
+};
+template <> struct FrequencyEstimatorTrait<WindowedCuckooHeavyKeeperConfig> {
+    using type = WindowedCuckooHeavyKeeper;
+};
 template <> struct FrequencyEstimatorTrait<HeavyKeeperConfig> {
     using type = HeavyKeeper;
 };
+template <> struct FrequencyEstimatorTrait<ElasticSketchConfig> {
+    using type = ElasticSketch;
+};
 template <> struct FrequencyEstimatorTrait<SpaceSavingConfig> {
     using type = HeapHashMapSpaceSavingV2;
 };
+template <> struct FrequencyEstimatorTrait<StreamSummarySpaceSavingConfig> {
+    using type = StreamSummarySpaceSaving;
+};
 template <> struct FrequencyEstimatorTrait<WeightedFrequentConfig> {
     using type = WeightedFrequent;
 };
 template <> struct FrequencyEstimatorTrait<OptimizedWeightedFrequentConfig> {
     using type = OptimizedWeightedFrequent;
 };
+template <> struct FrequencyEstimatorTrait<MisraGriesConfig> {
+    using type = MisraGries;
+};
 
 template <typename T> struct FrequencyEstimatorConfigTrait;
 
@@ -51,14 +71,30 @@ template <> struct FrequencyEstimatorConfigTrait<CuckooHeavyKeeper> {
     using type = CuckooHeavyKeeperConfig;
 };
 
+template <> struct FrequencyEstimatorConfigTrait<SharedCuckooHeavyKeeper> {
+    using type = SharedCuckooHeavyKeeperConfig;
+};
+
+template <> struct FrequencyEstimatorConfigTrait<WindowedCuckooHeavyKeeper> {
+    using type = WindowedCuckooHeavyKeeperConfig;
+};
+
 template <> struct FrequencyEstimatorConfigTrait<HeavyKeeper> {
     using type = HeavyKeeperConfig;
 };
 
+template <> struct FrequencyEstimatorConfigTrait<ElasticSketch> {
+    using type = ElasticSketchConfig;
+};
+
 template <> struct FrequencyEstimatorConfigTrait<HeapHashMapSpaceSavingV2> {
     using type = SpaceSavingConfig;
 };
 
+template <> struct FrequencyEstimatorConfigTrait<StreamSummarySpaceSaving> {
+    using type = StreamSummarySpaceSavingConfig;
+};
+
 template <> struct FrequencyEstimatorConfigTrait<WeightedFrequent> {
     using type = WeightedFrequentConfig;
 };
@@ -66,3 +102,17 @@ template <> struct FrequencyEstimatorConfigTrait<WeightedFrequent> {
 template <> struct FrequencyEstimatorConfigTrait<OptimizedWeightedFrequent> {
     using type = OptimizedWeightedFrequentConfig;
 };
+
+template <> struct FrequencyEstimatorConfigTrait<MisraGries> {
+    using type = MisraGriesConfig;
+};
+
+// every estimator is called directly through the template parameter of the wrappers, none of them goes through a vtable
+static_assert(FrequencyEstimatorLike<AugmentedSketch> && FrequencyEstimatorLike<CountMinSketch> && FrequencyEstimatorLike<CuckooHeavyKeeper>);
+static_assert(FrequencyEstimatorLike<ElasticSketch> && FrequencyEstimatorLike<HeapHashMapSpaceSaving> && FrequencyEstimatorLike<HeapHashMapSpaceSavingV2>);
+static_assert(FrequencyEstimatorLike<HeapHashMapSpaceSavingV3> && FrequencyEstimatorLike<HeavyGuardian> && FrequencyEstimatorLike<HeavyKeeper>);
+static_assert(FrequencyEstimatorLike<MisraGries> && FrequencyEstimatorLike<OptimizedWeightedFrequent> && FrequencyEstimatorLike<SharedCuckooHeavyKeeper>);
+static_assert(FrequencyEstimatorLike<SpaceSaving> && FrequencyEstimatorLike<StreamSummarySpaceSaving> && FrequencyEstimatorLike<WeightedFrequent>);
+static_assert(FrequencyEstimatorLike<WindowedCuckooHeavyKeeper>);
+static_assert(!std::is_polymorphic_v<CountMinSketch> && !std::is_polymorphic_v<CuckooHeavyKeeper> && !std::is_polymorphic_v<HeavyKeeper>);
+static_assert(HeavyHitterIterable<StreamSummarySpaceSaving, int> && HeavyHitterIterable<ElasticSketch, int> && !HeavyHitterIterable<ElasticSketch, std::string>);
@@ -2,6 +2,7 @@
 
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "utils/BinarySnapshot.hpp"
 #include <algorithm>
 #include <iostream>
 #include <queue>
@@ -11,7 +12,7 @@
 #include <vector>
 
 // HeapHashMapSpaceSaving using naive heapify
-class HeapHashMapSpaceSaving : public FrequencyEstimatorBase {
+class HeapHashMapSpaceSaving : public FrequencyEstimatorBase<HeapHashMapSpaceSaving> {
   public:
     struct Item {
         std::string name;
@@ -64,28 +65,30 @@ class HeapHashMapSpaceSaving : public FrequencyEstimatorBase {
         for (auto &pair : item_map) { delete pair.second; }
     }
 
-    void print_status() override {
+    void print_status() {
         std::cout << "Size: " << k << std::endl;
-        std::cout << "Estimated size in bytes: " << k * (sizeof(Item) + sizeof(std::string) + sizeof(void *)) << std::endl;
+        std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
     }
 
-    void update(const int &item, int c = 1) override { _update(int_to_string(item), c); }
+    size_t memory_usage() const { return k * (sizeof(Item) + sizeof(std::string) + sizeof(void *)); }
+
+    void update(const int &item, int c = 1) { _update(int_to_string(item), c); }
 
-    void update(const std::string &item, int c = 1) override { _update(item, c); }
+    void update(const std::string &item, int c = 1) { _update(item, c); }
 
-    unsigned int estimate(const int &item) override { return estimate(int_to_string(item)); }
+    unsigned int estimate(const int &item) { return estimate(int_to_string(item)); }
 
-    unsigned int estimate(const std::string &item) override {
+    unsigned int estimate(const std::string &item) {
         auto it = item_map.find(item);
         return (it != item_map.end()) ? it->second->count : 0;
     }
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override {
+    unsigned int update_and_estimate(const int &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
 
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override {
+    unsigned int update_and_estimate(const std::string &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
@@ -115,7 +118,7 @@ class HeapHashMapSpaceSaving : public FrequencyEstimatorBase {
 
 // V2 is faster compared to V3 due to using pointer to Item instead of placing item directly in the
 // vector
-class HeapHashMapSpaceSavingV2 : public FrequencyEstimatorBase {
+class HeapHashMapSpaceSavingV2 : public FrequencyEstimatorBase<HeapHashMapSpaceSavingV2> {
   private:
     struct Item {
         std::string name;
@@ -199,28 +202,65 @@ class HeapHashMapSpaceSavingV2 : public FrequencyEstimatorBase {
         for (auto &pair : item_map) { delete pair.second; }
     }
 
-    void print_status() override {
+    void print_status() {
         std::cout << "Size: " << k << std::endl;
-        std::cout << "Estimated size in bytes: " << k * (sizeof(Item) + sizeof(std::string) + 2 * sizeof(void *)) << std::endl;
+        std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
+    }
+
+    size_t memory_usage() const { return k * (sizeof(Item) + sizeof(std::string) + 2 * sizeof(void *)); }
+
+    // binary snapshot of the monitored items in heap order, so load rebuilds the heap without sifting
+    void save(std::ostream &os) const {
+        write_snapshot_header(os, SnapshotKind::SPACE_SAVING);
+        write_binary(os, k);
+        write_binary(os, total);
+        write_binary(os, static_cast<uint64_t>(heap.size()));
+        for (const Item *item : heap) {
+            write_binary(os, item->name);
+            write_binary(os, item->count);
+        }
     }
 
-    void update(const int &item, int c = 1) override { _update(int_to_string(item), c); }
+    void load(std::istream &is) {
+        read_snapshot_header(is, SnapshotKind::SPACE_SAVING);
+        uint64_t size;
+        read_binary(is, k);
+        read_binary(is, total);
+        read_binary(is, size);
+        if (size > static_cast<uint64_t>(k)) { throw std::runtime_error("SpaceSaving snapshot holds more items than its capacity"); }
 
-    void update(const std::string &item, int c = 1) override { _update(item, c); }
+        for (auto &pair : item_map) { delete pair.second; }
+        item_map.clear();
+        heap.clear();
+        heap.reserve(k);
+        for (uint64_t i = 0; i < size; i++) {
+            std::string name;
+            unsigned int count;
+            read_binary(is, name);
+            read_binary(is, count);
+            Item *item = new Item(name, count, heap.size());
+            item_map[name] = item;
+            heap.push_back(item);
+        }
+    }
 
-    unsigned int estimate(const int &item) override { return estimate(int_to_string(item)); }
+    void update(const int &item, int c = 1) { _update(int_to_string(item), c); }
 
-    unsigned int estimate(const std::string &item) override {
+    void update(const std::string &item, int c = 1) { _update(item, c); }
+
+    unsigned int estimate(const int &item) { return estimate(int_to_string(item)); }
+
+    unsigned int estimate(const std::string &item) {
         auto it = item_map.find(item);
         return (it != item_map.end()) ? it->second->count : 0;
     }
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override {
+    unsigned int update_and_estimate(const int &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
 
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override {
+    unsigned int update_and_estimate(const std::string &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
@@ -248,7 +288,7 @@ class HeapHashMapSpaceSavingV2 : public FrequencyEstimatorBase {
     Iterator end() const { return Iterator(heap.end()); }
 };
 
-class HeapHashMapSpaceSavingV3 : public FrequencyEstimatorBase {
+class HeapHashMapSpaceSavingV3 : public FrequencyEstimatorBase<HeapHashMapSpaceSavingV3> {
   private:
     struct Item {
         uint32_t count;
@@ -329,30 +369,32 @@ class HeapHashMapSpaceSavingV3 : public FrequencyEstimatorBase {
     }
 
   public:
-    void update(const int &item, int c = 1) override { _update(int_to_string(item), c); }
+    void update(const int &item, int c = 1) { _update(int_to_string(item), c); }
 
-    void update(const std::string &item, int c = 1) override { _update(item, c); }
+    void update(const std::string &item, int c = 1) { _update(item, c); }
 
-    unsigned int estimate(const int &item) override { return estimate(int_to_string(item)); }
+    unsigned int estimate(const int &item) { return estimate(int_to_string(item)); }
 
-    unsigned int estimate(const std::string &item) override {
+    unsigned int estimate(const std::string &item) {
         auto it = item_map.find(item);
         return (it != item_map.end()) ? items[it->second].count : 0;
     }
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override {
+    unsigned int update_and_estimate(const int &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
 
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override {
+    unsigned int update_and_estimate(const std::string &item, int c = 1) {
         update(item, c);
         return estimate(item);
     }
     void print_status() {
         std::cout << "Size: " << k << std::endl;
-        std::cout << "Estimated size in bytes: " << (k * (sizeof(Item) + sizeof(std::string)) + sizeof(std::unordered_map<std::string, int>)) << std::endl;
+        std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
     }
+
+    size_t memory_usage() const { return k * (sizeof(Item) + sizeof(std::string)) + sizeof(std::unordered_map<std::string, int>); }
     class Iterator {
       private:
         std::unordered_map<std::string, int>::const_iterator it;
@@ -1,102 +1,80 @@
-
 #include "HeavyGuardian.hpp"
 
-unsigned long long HeavyGuardian::hash(std::string ST) {
-    return (bobhash->run(ST.c_str(), ST.size()));
+HeavyGuardian::HeavyGuardian(int M) : M(std::max(M, 1)) {
+    HK.resize(this->M);
+    // generate random number between 0 and 1228
+    srand((unsigned int) clock());
+    int random_seed = rand() % 1228;
+    bobhash = BOBHash64(random_seed);
+    decay = ExponentialDecay(HK_b, (uint64_t(rand()) << 32) ^ uint64_t(rand()) ^ uint64_t(random_seed));
 }
 
-void HeavyGuardian::_insert(const std::string &item) {
-    this->total += 1;
-    unsigned long long H = hash(item);
-    unsigned int FP = (H >> 48), Hsh = H % M;
-    bool FLAG = false;
+void HeavyGuardian::_insert(unsigned long long H, int c) {
+    this->total += c;
+    unsigned int FP = (H >> 48);
+    Bucket &bucket = HK[H % M];
     for (int k = 0; k < G; k++) {
-        int c = HK[Hsh][k].C;
-        if (HK[Hsh][k].FP == FP) {
-            HK[Hsh][k].C++;
-            FLAG = true;
-            break;
+        if (bucket.heavy[k].FP == FP && bucket.heavy[k].C > 0) {
+            bucket.heavy[k].C += c;
+            return;
         }
-        if (FLAG) break;
     }
-    if (!FLAG) {
-        int X, MIN = 1000000000;
-        for (int k = 0; k < G; k++) {
-            int c = HK[Hsh][k].C;
-            if (c < MIN) {
-                MIN = c;
-                X = k;
-            }
-        }
-        if (!(rand() % int(pow(HK_b, HK[Hsh][X].C)))) {
-            HK[Hsh][X].C--;
-            if (HK[Hsh][X].C <= 0) {
-                HK[Hsh][X].FP = FP;
-                HK[Hsh][X].C = 1;
-            } else {
-                int p = Hsh % ct;
-                ext[Hsh][p]++;
-            }
+
+    // the weakest heavy entry decays, an empty entry is taken right away
+    node *weakest = &bucket.heavy[0];
+    for (int k = 1; k < G; k++) {
+        if (bucket.heavy[k].C < weakest->C) { weakest = &bucket.heavy[k]; }
+    }
+    uint64_t remaining = c;
+    while (remaining > 0) {
+        uint64_t units = decay.units_until_decay(weakest->C, remaining);
+        if (units > remaining) { break; }
+        remaining -= units;
+        if (--weakest->C <= 0) {
+            weakest->FP = FP;
+            weakest->C = remaining + 1;
+            return;
         }
     }
+    // the light counter is picked by other hash bits than the bucket
+    bucket.light[(H >> 32) % ct] += remaining;
 }
 
-void HeavyGuardian::update(const std::string &item, int c) {
-    this->_assert_not_implemented(c);
-    this->_insert(item.c_str());
+unsigned int HeavyGuardian::_estimate(unsigned long long H) const {
+    unsigned int FP = (H >> 48);
+    const Bucket &bucket = HK[H % M];
+    for (int k = 0; k < G; k++) {
+        if (bucket.heavy[k].FP == FP && bucket.heavy[k].C > 0) return bucket.heavy[k].C;
+    }
+    return std::max(1, bucket.light[(H >> 32) % ct]);
 }
 
-void HeavyGuardian::update(const int &item, int c) {
-    this->_assert_not_implemented(c);
-    char buffer[20];
-    sprintf(buffer, "%d", item);
-    this->_insert(buffer);
+void HeavyGuardian::update(const std::string &item, int c) {
+    if (c > 0) { this->_insert(_hash(item), c); }
 }
 
-unsigned int HeavyGuardian::_estimate(const std::string &item) {
-    unsigned long long H = hash(item);
-    unsigned int FP = (H >> 48), Hsh = H % M;
-    for (int k = 0; k < G; k++) {
-        int c = HK[Hsh][k].C;
-        if (HK[Hsh][k].FP == FP) return max(1, HK[Hsh][k].C);
-    }
-    int p = Hsh % ct;
-    return max(1, ext[Hsh][p]);
+void HeavyGuardian::update(const int &item, int c) {
+    if (c > 0) { this->_insert(_hash(item), c); }
 }
 
-unsigned int HeavyGuardian::estimate(const std::string &item) { return this->_estimate(item); }
+unsigned int HeavyGuardian::estimate(const std::string &item) { return this->_estimate(_hash(item)); }
 
-unsigned int HeavyGuardian::estimate(const int &item) {
-    char buffer[20];
-    sprintf(buffer, "%d", item);
-    std::string str(buffer);
-    return this->_estimate(str);
-}
+unsigned int HeavyGuardian::estimate(const int &item) { return this->_estimate(_hash(item)); }
 
 unsigned int HeavyGuardian::update_and_estimate(const std::string &item, int c) {
-    this->_assert_not_implemented(c);
-    this->_insert(item);
-    return this->_estimate(item);
+    unsigned long long H = _hash(item);
+    if (c > 0) { this->_insert(H, c); }
+    return this->_estimate(H);
 }
 
 unsigned int HeavyGuardian::update_and_estimate(const int &item, int c) {
-    this->_assert_not_implemented(c);
-    char buffer[20];
-    sprintf(buffer, "%d", item);
-    std::string str(buffer);
-    this->_insert(str);
-    return this->_estimate(str);
-}
-
-void HeavyGuardian::_assert_not_implemented(int c) {
-    if (c != 1) {
-        throw std::runtime_error("Not implemented for cases where the number is not equal to 1");
-    }
+    unsigned long long H = _hash(item);
+    if (c > 0) { this->_insert(H, c); }
+    return this->_estimate(H);
 }
 
 void HeavyGuardian::print_status() {
     std::cout << "Width: " << this->M << std::endl;
     std::cout << "Depth: " << G << std::endl;
-    std::cout << "Estimated size in bytes: "
-              << this->M * sizeof(node) * G + this->M * sizeof(int) * ct << std::endl;
+    std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
 }
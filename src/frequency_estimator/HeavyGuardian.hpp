@@ -1,51 +1,56 @@
 #pragma once
 
+#include "frequency_estimator/ExponentialDecay.hpp"
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 #include "frequency_estimator/MacroPreprocessor.hpp"
-#include "frequency_estimator/StreamSummary.hpp"
-#include "hash/BOBHash32.hpp"
 #include "hash/BOBHash64.hpp"
 #include <algorithm>
-#include <cmath>
-#include <cstdio>
+#include <cstdint>
 #include <cstdlib>
-#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <string>
+#include <vector>
 
-constexpr int G = 8;
-constexpr int ct = 16;
-constexpr double HK_b = 1.08;
-using std::string;
-
-class HeavyGuardian : public FrequencyEstimatorBase {
+// HeavyGuardian with M buckets allocated at construction, each bucket (G heavy entries and ct light counters) fills two cache lines.
+// Integer keys are hashed from their bytes; a weighted update decays the weakest heavy entry for every unit and
+// counts the units the heavy part does not absorb in the light part.
+class HeavyGuardian : public FrequencyEstimatorBase<HeavyGuardian> {
   public:
+    static constexpr int G = 8;
+    static constexpr int ct = 16;
+    static constexpr double HK_b = 1.08;
+
+    struct node {
+        int C = 0;
+        unsigned int FP = 0;
+    };
+    struct alignas(64) Bucket {
+        node heavy[G];
+        int light[ct] = {};
+    };
+
     int total = 0;
-    HeavyGuardian(int M) : M(M) {
-        // generate random number between 0 and 1228
-        srand((unsigned int) clock());
-        int random_seed = rand() % 1228;
-        bobhash = new BOBHash64(random_seed);
-    }
+    HeavyGuardian(int M);
     void print_status();
-    void update(const std::string &item, int c = 1) override;
-    void update(const int &item, int c = 1) override;
-    unsigned int estimate(const std::string &item) override;
-    unsigned int estimate(const int &item) override;
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override;
-    unsigned int update_and_estimate(const int &item, int c = 1) override;
+    size_t memory_usage() const { return HK.size() * sizeof(Bucket); }
+    void update(const std::string &item, int c = 1);
+    void update(const int &item, int c = 1);
+    unsigned int estimate(const std::string &item);
+    unsigned int estimate(const int &item);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    unsigned int update_and_estimate(const int &item, int c = 1);
 
   private:
-    struct node {
-        int C;
-        unsigned int FP;
-    } HK[10005][20];
-    int ext[10005][40];
-    BOBHash64 *bobhash;
+    std::vector<Bucket> HK;
+    BOBHash64 bobhash;
+    ExponentialDecay decay;
     int M;
-    void _insert(const std::string &item);
-    unsigned int _estimate(const std::string &item);
-    void _assert_not_implemented(int c);
-    unsigned long long hash(std::string ST);
+
+    unsigned long long _hash(const std::string &item) { return bobhash.run(item.c_str(), item.size()); }
+    unsigned long long _hash(const int &item) { return bobhash.run(reinterpret_cast<const char *>(&item), sizeof(item)); }
+
+    void _insert(unsigned long long H, int c);
+    unsigned int _estimate(unsigned long long H) const;
 };
@@ -1,26 +1,25 @@
 #pragma once
 
+#include "frequency_estimator/ExponentialDecay.hpp"
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 #include "frequency_estimator/MacroPreprocessor.hpp"
-#include "frequency_estimator/StreamSummary.hpp"
-#include "hash/BOBHash32.hpp"
 #include "hash/BOBHash64.hpp"
 #include <algorithm>
-#include <cmath>
-#include <cstdio>
+#include <cstdint>
 #include <cstdlib>
-#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <string>
+#include <vector>
 
-class HeavyKeeper : public FrequencyEstimatorBase {
+// HeavyKeeper with HK_d rows of M2 buckets, allocated at construction so the sketch can be sized to any memory budget.
+// The rows are stored one after the other in cache-line aligned blocks; integer keys are hashed from their bytes,
+// without the round-trip through std::to_string.
+class HeavyKeeper : public FrequencyEstimatorBase<HeavyKeeper> {
   public:
     constexpr static int HK_d = 2;
     constexpr static double HK_b = 1.08;
-    constexpr static int N = 1000000;      // maximum flow
-    constexpr static int M = 1000000;      // maximum size of stream-summary or CSS
-    constexpr static int MAX_MEM = 3000;   // maximum memory size
     struct node {
         int C = 0, FP = 0;
     };
@@ -33,33 +32,35 @@ class HeavyKeeper : public FrequencyEstimatorBase {
     void generate_new_seed();
     void clear();
 
-    void work();
-    std::pair<std::string, int> query(const int &k);
     void print_status();
-    void update(const std::string &item, int c = 1) override;
-    void update(const int &item, int c = 1) override;
-    unsigned int estimate(const std::string &item) override;
-    unsigned int estimate(const int &item) override;
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override;
-    unsigned int update_and_estimate(const int &item, int c = 1) override;
+    size_t memory_usage() const { return HK.size() * sizeof(CacheLine); }
+    void update(const std::string &item, int c = 1);
+    void update(const int &item, int c = 1);
+    unsigned int estimate(const std::string &item);
+    unsigned int estimate(const int &item);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    unsigned int update_and_estimate(const int &item, int c = 1);
 
   private:
-    StreamSummary *ss;
-    node HK[HK_d][MAX_MEM + 10];
-    BOBHash64 *bobhash;
+    static constexpr int NODES_PER_LINE = 64 / sizeof(node);
+    struct alignas(64) CacheLine {
+        node nodes[NODES_PER_LINE];
+    };
+
+    std::vector<CacheLine> HK;
+    size_t lines_per_row;
+    BOBHash64 bobhash;
+    ExponentialDecay decay;
     int K, M2;
 
-    struct Node {
-        std::string x;
-        int y;
-    } q[MAX_MEM + 10];
+    void _allocate();
+    node &_node(int row, size_t index) { return HK[row * lines_per_row + index / NODES_PER_LINE].nodes[index % NODES_PER_LINE]; }
+    size_t _index(unsigned long long H, int row) const { return H % (M2 - (2 * HK_d) + 2 * row + 3); }
 
-    static int cmp(Node i, Node j) { return i.y > j.y; }
+    unsigned long long _hash(const std::string &item) { return bobhash.run(item.c_str(), item.size()); }
+    unsigned long long _hash(const int &item) { return bobhash.run(reinterpret_cast<const char *>(&item), sizeof(item)); }
 
-    // internal update function
-    void _insert_with_StreamSummary(const std::string &x);
-    void _insert(const std::string &x);
-    unsigned int _estimate(const std::string &item);
-    unsigned long long hash(const std::string &ST);
-    void _assert_not_implemented(int c);
+    // internal update function, returns the largest counter of the item over the rows
+    unsigned int _insert(unsigned long long H, int c);
+    unsigned int _estimate(unsigned long long H);
 };
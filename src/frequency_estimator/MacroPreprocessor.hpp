@@ -18,16 +18,20 @@
 #define EQUAL(a, b)  XEQUAL(a, b)
 
 // define available algorithm
-#define cuckoo_heavy_keeper_cuckoo_heavy_keeper                 TRUE
-#define heavy_keeper_heavy_keeper                               TRUE
-#define wide_heavy_keeper_wide_heavy_keeper                     TRUE
-#define count_min_count_min                                     TRUE
-#define augmented_sketch_augmented_sketch                       TRUE
-#define stream_summary_space_saving_stream_summary_space_saving TRUE
-#define simple_space_saving_simple_space_saving                 TRUE
-#define heap_hashmap_space_saving_heap_hashmap_space_saving     TRUE
-#define weighted_frequent_weighted_frequent                     TRUE
-#define optimized_weighted_frequent_optimized_weighted_frequent TRUE
+#define cuckoo_heavy_keeper_cuckoo_heavy_keeper                   TRUE
+#define heavy_keeper_heavy_keeper                                 TRUE
+#define wide_heavy_keeper_wide_heavy_keeper                       TRUE
+#define elastic_sketch_elastic_sketch                             TRUE
+#define count_min_count_min                                       TRUE
+#define augmented_sketch_augmented_sketch                         TRUE
+#define stream_summary_space_saving_stream_summary_space_saving   TRUE
+#define simple_space_saving_simple_space_saving                   TRUE
+#define heap_hashmap_space_saving_heap_hashmap_space_saving       TRUE
+#define weighted_frequent_weighted_frequent                       TRUE
+#define optimized_weighted_frequent_optimized_weighted_frequent   TRUE
+#define misra_gries_misra_gries                                   TRUE
+#define shared_cuckoo_heavy_keeper_shared_cuckoo_heavy_keeper     TRUE
+#define windowed_cuckoo_heavy_keeper_windowed_cuckoo_heavy_keeper TRUE
 
 // define available mode
 #define heavy_hitter_heavy_hitter TRUE
@@ -36,3 +40,9 @@
 // define avaiable parallel design
 #define GLOBAL_HASHMAP_GLOBAL_HASHMAP TRUE
 #define QPOPSS_QPOPSS                 TRUE
+#define HIERARCHICAL_HIERARCHICAL     TRUE
+#define SHARED_SHARED                 TRUE
+
+// define available key types of the delegation framework
+#define int_int               TRUE
+#define five_tuple_five_tuple TRUE
@@ -0,0 +1,101 @@
+#include "MisraGries.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+MisraGries::MisraGries(int n) : n(std::max(n, 1)), epsilon(1.0 / this->n) {}
+
+MisraGries::MisraGries(double epsilon) : n(std::max(int(std::ceil(1.0 / epsilon)), 1)), epsilon(epsilon) {}
+
+MisraGries::MisraGries(const WeightedFrequentConfig &config) : MisraGries(int(config.N)) {
+    if (config.CALCULATE_FROM == "EPSILON") {
+        epsilon = config.EPSILON;
+        n = std::max(int(std::ceil(1.0 / epsilon)), 1);
+    }
+}
+
+MisraGriesSummary<int> &MisraGries::_int_summary() {
+    if (!int_summary) { int_summary = std::make_unique<MisraGriesSummary<int>>(n); }
+    return *int_summary;
+}
+
+MisraGriesSummary<std::string> &MisraGries::_string_summary() {
+    if (!string_summary) { string_summary = std::make_unique<MisraGriesSummary<std::string>>(n); }
+    return *string_summary;
+}
+
+void MisraGries::_check_weight(int c) {
+    if (c < 0) { throw std::runtime_error("Misra-Gries does not support negative weights"); }
+}
+
+void MisraGries::update(const int &item, int c) { update_and_estimate(item, c); }
+
+void MisraGries::update(const std::string &item, int c) { update_and_estimate(item, c); }
+
+unsigned int MisraGries::estimate(const int &item) { return int_summary ? int_summary->estimate(item) : 0; }
+
+unsigned int MisraGries::estimate(const std::string &item) { return string_summary ? string_summary->estimate(item) : 0; }
+
+unsigned int MisraGries::update_and_estimate(const int &item, int c) {
+    _check_weight(c);
+    total += c;
+    return _int_summary().update(item, c);
+}
+
+unsigned int MisraGries::update_and_estimate(const std::string &item, int c) {
+    _check_weight(c);
+    total += c;
+    return _string_summary().update(item, c);
+}
+
+void MisraGries::update_batch(const std::vector<std::pair<int, int>> &items) {
+    for (const auto &[item, c] : items) { update_and_estimate(item, c); }
+}
+
+void MisraGries::update_batch(const std::vector<std::pair<std::string, int>> &items) {
+    for (const auto &[item, c] : items) { update_and_estimate(item, c); }
+}
+
+void MisraGries::merge(const MisraGries &other) {
+    if (other.int_summary) { _int_summary().merge(*other.int_summary); }
+    if (other.string_summary) { _string_summary().merge(*other.string_summary); }
+    total += other.total;
+}
+
+size_t MisraGries::memory_usage() const {
+    return (int_summary ? int_summary->memory_bytes() : 0) + (string_summary ? string_summary->memory_bytes() : 0);
+}
+
+void MisraGries::print_status() {
+    std::cout << "MisraGries: " << std::endl;
+    std::cout << "N: " << n << std::endl;
+    std::cout << "Epsilon: " << epsilon << std::endl;
+    if (int_summary) { std::cout << "Error bound (int keys): " << int_summary->error_bound() << std::endl; }
+    if (string_summary) { std::cout << "Error bound (string keys): " << string_summary->error_bound() << std::endl; }
+    std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
+}
+
+void MisraGries::save(std::ostream &os) const {
+    write_snapshot_header(os, SnapshotKind::MISRA_GRIES);
+    write_binary(os, n);
+    write_binary(os, epsilon);
+    write_binary(os, total);
+    write_binary(os, bool(int_summary));
+    if (int_summary) { int_summary->save(os); }
+    write_binary(os, bool(string_summary));
+    if (string_summary) { string_summary->save(os); }
+}
+
+void MisraGries::load(std::istream &is) {
+    read_snapshot_header(is, SnapshotKind::MISRA_GRIES);
+    bool has_summary;
+    read_binary(is, n);
+    read_binary(is, epsilon);
+    read_binary(is, total);
+    int_summary.reset();
+    string_summary.reset();
+    read_binary(is, has_summary);
+    if (has_summary) { _int_summary().load(is); }
+    read_binary(is, has_summary);
+    if (has_summary) { _string_summary().load(is); }
+}
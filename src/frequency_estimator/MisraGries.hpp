@@ -0,0 +1,159 @@
+#pragma once
+
+#include "frequency_estimator/BucketStreamSummary.hpp"
+#include "frequency_estimator/FrequencyEstimatorBase.hpp"
+#include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "utils/BinarySnapshot.hpp"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Misra-Gries (Frequent) summary with k counters over a weighted stream.
+// Decrementing every counter is recorded in a global offset: the stream-summary stores count + offset, so a decrement costs one
+// addition and the counters it zeroes are the lowest buckets, dropped from the bottom up (each counter is dropped once, paid by
+// its insert). An update of weight 1 is O(1); an update of weight c walks past the buckets between the old and the new count, up to
+// O(k) for a large c.
+// Every estimate undercounts by at most error_bound() <= total / (k + 1), also after merges.
+template <typename Key> class MisraGriesSummary {
+  public:
+    using count_t = typename BucketStreamSummary<Key>::count_t;
+
+    explicit MisraGriesSummary(size_t k) : summary(k) {}
+
+    // returns the estimate of key after the update
+    count_t update(const Key &key, count_t c) {
+        total += c;
+        if (count_t count = summary.increment(key, c)) { return count - offset; }
+        if (summary.size() < summary.capacity()) {
+            summary.insert(key, offset + c);
+            return c;
+        }
+        // all k counters and the new key lose min(c, smallest counter)
+        count_t smallest = summary.lowest_count() - offset;
+        if (c < smallest) {
+            offset += c;
+            error += c;
+            return 0;
+        }
+        offset += smallest;
+        error += smallest;
+        summary.erase_up_to(offset);
+        if (c > smallest) { summary.insert(key, offset + c - smallest); }
+        return c - smallest;
+    }
+
+    count_t estimate(const Key &key) const {
+        count_t count = summary.estimate(key);
+        return count == 0 ? 0 : count - offset;
+    }
+
+    // mergeable summaries (Agarwal et al.): add up both sets of counters, then subtract the (k+1)-th largest from all of them
+    void merge(const MisraGriesSummary &other) {
+        std::unordered_map<Key, count_t> combined;
+        combined.reserve(size() + other.size());
+        for_each([&](const Key &key, count_t count) { combined[key] += count; });
+        other.for_each([&](const Key &key, count_t count) { combined[key] += count; });
+
+        std::vector<std::pair<Key, count_t>> counters(combined.begin(), combined.end());
+        std::sort(counters.begin(), counters.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+        count_t decrement = counters.size() > summary.capacity() ? counters[summary.capacity()].second : 0;
+
+        summary.clear();
+        offset = 0;
+        for (auto it = counters.rbegin(); it != counters.rend(); ++it) {
+            if (it->second > decrement) { summary.restore(it->first, it->second - decrement, 0); }
+        }
+        total += other.total;
+        error += other.error + decrement;
+    }
+
+    // f(key, estimate), largest estimate first
+    template <typename F> void for_each(F &&f) const {
+        for (const auto &counter : summary) { f(counter.key, counter.count - offset); }
+    }
+
+    size_t size() const { return summary.size(); }
+    size_t capacity() const { return summary.capacity(); }
+    count_t get_total() const { return total; }
+    count_t error_bound() const { return error; }
+    size_t memory_bytes() const { return summary.memory_bytes(); }
+
+    void save(std::ostream &os) const {
+        write_binary(os, total);
+        write_binary(os, error);
+        write_binary(os, static_cast<uint64_t>(size()));
+        for_each([&](const Key &key, count_t count) {
+            write_binary(os, key);
+            write_binary(os, count);
+        });
+    }
+
+    void load(std::istream &is) {
+        uint64_t size;
+        read_binary(is, total);
+        read_binary(is, error);
+        read_binary(is, size);
+        if (size > capacity()) { throw std::runtime_error("Misra-Gries snapshot holds more counters than its capacity"); }
+        std::vector<std::pair<Key, count_t>> counters(size);
+        for (auto &[key, count] : counters) {
+            read_binary(is, key);
+            read_binary(is, count);
+        }
+        summary.clear();
+        offset = 0;
+        for (auto it = counters.rbegin(); it != counters.rend(); ++it) { summary.restore(it->first, it->second, 0); }
+    }
+
+  private:
+    BucketStreamSummary<Key> summary;
+    count_t offset = 0;   // decrements applied to every counter since the last rebuild
+    count_t total = 0;    // weight of the summarized stream
+    count_t error = 0;    // decrements applied overall, the largest undercount of any key
+};
+
+// Frequency estimator on MisraGriesSummary, integer keys are counted as integers and string keys in a summary of their own.
+// Takes the WeightedFrequent parameters: n counters, or ceil(1 / epsilon). epsilon is a double, so that MisraGries(0.01) is not
+// ambiguous between the two (a float argument is promoted to it).
+class MisraGries : public FrequencyEstimatorBase<MisraGries> {
+  public:
+    unsigned long total = 0;
+
+    MisraGries(int n = 100);
+    MisraGries(double epsilon);
+    MisraGries(const WeightedFrequentConfig &config);
+
+    void update(const int &item, int c = 1);
+    void update(const std::string &item, int c = 1);
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
+    unsigned int update_and_estimate(const int &item, int c = 1);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+
+    // weighted updates of a batch of (key, weight) pairs, one update() each: O(1) per unit weight, O(buckets passed) per weight c
+    void update_batch(const std::vector<std::pair<int, int>> &items);
+    void update_batch(const std::vector<std::pair<std::string, int>> &items);
+
+    // folds another summary (e.g. of another node) into this one, the error bounds add up
+    void merge(const MisraGries &other);
+
+    void print_status();
+    size_t memory_usage() const;
+
+    // binary snapshot of both summaries, the format nodes exchange summaries in
+    void save(std::ostream &) const;
+    void load(std::istream &);
+
+  private:
+    int n;
+    float epsilon;
+    std::unique_ptr<MisraGriesSummary<int>> int_summary;
+    std::unique_ptr<MisraGriesSummary<std::string>> string_summary;
+
+    MisraGriesSummary<int> &_int_summary();
+    MisraGriesSummary<std::string> &_string_summary();
+    void _check_weight(int c);
+};
@@ -8,11 +8,11 @@
 
 #define LONG_PRIME 2147483647
 
-class OptimizedWeightedFrequent : public FrequencyEstimatorBase {
+class OptimizedWeightedFrequent : public FrequencyEstimatorBase<OptimizedWeightedFrequent> {
   public:
     OptimizedWeightedFrequent() = default;
-    OptimizedWeightedFrequent(float epsilon) : epsilon(epsilon), n(ceil(1.0 / epsilon)), M(0) {}
-    OptimizedWeightedFrequent(int n) : n(n), epsilon(1.0 / n), M(0) {}
+    OptimizedWeightedFrequent(float epsilon) : epsilon(epsilon), n(ceil(1.0 / epsilon)) {}
+    OptimizedWeightedFrequent(int n) : epsilon(1.0 / n), n(n) {}
     OptimizedWeightedFrequent(const WeightedFrequentConfig &config) {
         if (config.CALCULATE_FROM == "EPSILON") {
             epsilon = config.EPSILON;
@@ -23,32 +23,32 @@ class OptimizedWeightedFrequent : public FrequencyEstimatorBase {
         }
     }
 
-    void update(const int &item, int c = 1) override { _update(item, c); }
-    void update(const string &item, int c = 1) override { _update(_get_hashitem(item), c); }
+    void update(const int &item, int c = 1) { _update(item, c); }
+    void update(const string &item, int c = 1) { _update(_get_hashitem(item), c); }
 
-    unsigned int estimate(const int &item) override { return _estimate(item); }
-    unsigned int estimate(const string &item) override { return _estimate(_get_hashitem(item)); }
+    unsigned int estimate(const int &item) { return _estimate(item); }
+    unsigned int estimate(const string &item) { return _estimate(_get_hashitem(item)); }
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override {
+    unsigned int update_and_estimate(const int &item, int c = 1) {
         _update(item, c);
         return _estimate(item);
     }
 
-    unsigned int update_and_estimate(const string &item, int c = 1) override {
+    unsigned int update_and_estimate(const string &item, int c = 1) {
         unsigned int hashitem = _get_hashitem(item);
         _update(hashitem, c);
         return _estimate(hashitem);
     }
 
-    void print_status() override {
+    void print_status() {
         // Implementation depends on what you want to print
         std::cout << "OptimizedWeightedFrequent" << " heap size:" << heap.size() << std::endl;
     }
 
   private:
-    float epsilon;
-    int n;
-    long long M;
+    float epsilon = 0;
+    int n = 0;
+    long long M = 0;
     std::unordered_map<int, int> item_to_index;
     std::vector<std::pair<int, int>> heap;   // (item, frequency)
 
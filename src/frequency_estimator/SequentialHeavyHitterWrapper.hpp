@@ -17,6 +17,7 @@ template <typename FrequencyEstimator, typename T> class SequentialHeavyHitterWr
 
     void check_and_update_heavy_hitter(const std::string &item, unsigned int item_count);
     void check_and_update_heavy_hitter(const int &item, unsigned int item_count);
+    unsigned long threshold_total() const;
 
   public:
     unsigned long total;
@@ -2,14 +2,23 @@
 // sequential_heavy_hitter_wrapper.ipp
 #pragma once
 
+template <typename FrequencyEstimator, typename T> unsigned long SequentialHeavyHitterWrapper<FrequencyEstimator, T>::threshold_total() const {
+    // windowed estimators count only recent items, the threshold follows them
+    if constexpr (requires { frequency_estimator.window_total(); }) {
+        return frequency_estimator.window_total();
+    } else {
+        return total;
+    }
+}
+
 template <typename FrequencyEstimator, typename T>
 void SequentialHeavyHitterWrapper<FrequencyEstimator, T>::check_and_update_heavy_hitter(const std::string &item, unsigned int item_count) {
-    if (item_count > theta * total) { pq_heavy_hitters.update(item, item_count); }
+    if (item_count > theta * threshold_total()) { pq_heavy_hitters.update(item, item_count); }
 }
 
 template <typename FrequencyEstimator, typename T>
 void SequentialHeavyHitterWrapper<FrequencyEstimator, T>::check_and_update_heavy_hitter(const int &item, unsigned int item_count) {
-    if (item_count > theta * total) { pq_heavy_hitters.update(item, item_count); }
+    if (item_count > theta * threshold_total()) { pq_heavy_hitters.update(item, item_count); }
 }
 
 template <typename FrequencyEstimator, typename T>
@@ -6,6 +6,7 @@
 #include "FrequencyEstimatorTrait.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 template <typename FrequencyEstimator, typename T> class SequentialHeavyHitterWrapperForParallel {
     using FrequencyEstimatorConfig = typename FrequencyEstimatorConfigTrait<FrequencyEstimator>::type;
@@ -31,11 +32,20 @@ template <typename FrequencyEstimator, typename T> class SequentialHeavyHitterWr
     unsigned int estimate(const std::string &item);
     unsigned int update_and_estimate(const int &item, int c = 1);
     unsigned int update_and_estimate(const std::string &item, int c = 1);
+    // drops the key from the estimator and the heavy hitter candidates, returns the count the estimator held for it
+    unsigned int remove(const int &item) requires KeyRemovable<FrequencyEstimator>;
+    unsigned int remove(const std::string &item) requires KeyRemovable<FrequencyEstimator>;
+    // n (key, count) pairs in one batch of the estimator, the heavy hitters among them are tracked as in update
+    void process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates = nullptr) requires FilterBatchProcessable<FrequencyEstimator> && std::is_same_v<T, int>;
 
     // Helper methods
     const BoundedKeyValuePriorityQueue<T> &get_heavy_hitters() const;
     float get_theta() const;
     unsigned long get_count() const;
+
+    // binary snapshot of the wrapped estimator and the heavy hitter candidates
+    void save(std::ostream &os) const requires Snapshottable<FrequencyEstimator>;
+    void load(std::istream &is) requires Snapshottable<FrequencyEstimator>;
 };
 
 #include "SequentialHeavyHitterWrapperForParallel.ipp"
\ No newline at end of file
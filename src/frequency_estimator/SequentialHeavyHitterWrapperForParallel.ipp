@@ -35,6 +35,19 @@ template <typename FrequencyEstimator, typename T> void SequentialHeavyHitterWra
     check_and_update_heavy_hitter(item, item_count);
 }
 
+template <typename FrequencyEstimator, typename T>
+void SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::process_filter_batch(const int *keys, const int *counts, int n, unsigned int *estimates)
+    requires FilterBatchProcessable<FrequencyEstimator> && std::is_same_v<T, int>
+{
+    std::vector<unsigned int> batch_estimates;
+    if (!estimates) {
+        batch_estimates.resize(n);
+        estimates = batch_estimates.data();
+    }
+    frequency_estimator.process_filter_batch(keys, counts, n, estimates);
+    for (int i = 0; i < n; ++i) { check_and_update_heavy_hitter(keys[i], estimates[i]); }
+}
+
 template <typename FrequencyEstimator, typename T> void SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::update_threshold(int threshold) {
     this->threshold = threshold;
     this->pq_heavy_hitters.pop_all_below(threshold);
@@ -63,6 +76,20 @@ unsigned int SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::upd
     return item_count;
 }
 
+template <typename FrequencyEstimator, typename T>
+unsigned int SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::remove(const int &item) requires KeyRemovable<FrequencyEstimator>
+{
+    if constexpr (std::is_same_v<T, int>) { pq_heavy_hitters.remove(item); }
+    return frequency_estimator.remove(item);
+}
+
+template <typename FrequencyEstimator, typename T>
+unsigned int SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::remove(const std::string &item) requires KeyRemovable<FrequencyEstimator>
+{
+    if constexpr (std::is_same_v<T, std::string>) { pq_heavy_hitters.remove(item); }
+    return frequency_estimator.remove(item);
+}
+
 // template <typename FrequencyEstimator, typename T> const BoundedKeyValuePriorityQueue<T> &SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::get_heavy_hitters()
 // const {
 //     return pq_heavy_hitters;
@@ -85,9 +112,50 @@ const BoundedKeyValuePriorityQueue<T> &SequentialHeavyHitterWrapperForParallel<F
                 }
             }
         }
+    } else if constexpr (HeavyHitterIterable<FrequencyEstimator, T>) {
+        // stream-summaries list their counters largest first, with the keys as they were inserted
+        pq_heavy_hitters = BoundedKeyValuePriorityQueue<T>();
+        for (const auto &counter : frequency_estimator.template counters<T>()) {
+            if (counter.count < static_cast<unsigned int>(threshold)) { break; }
+            pq_heavy_hitters.push(counter.key, counter.count);
+        }
     }
     return pq_heavy_hitters;
 }
 template <typename FrequencyEstimator, typename T> float SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::get_theta() const { return theta; }
 
-template <typename FrequencyEstimator, typename T> unsigned long SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::get_count() const { return total; }
\ No newline at end of file
+template <typename FrequencyEstimator, typename T> unsigned long SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::get_count() const { return total; }
+
+template <typename FrequencyEstimator, typename T>
+void SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::save(std::ostream &os) const requires Snapshottable<FrequencyEstimator> {
+    write_snapshot_header(os, SnapshotKind::HEAVY_HITTER_WRAPPER);
+    write_binary(os, theta);
+    write_binary(os, total);
+    write_binary(os, threshold);
+    frequency_estimator.save(os);
+    write_binary(os, static_cast<uint64_t>(pq_heavy_hitters.size()));
+    for (const auto &el : pq_heavy_hitters) {
+        write_binary(os, el.first);
+        write_binary(os, el.second);
+    }
+}
+
+template <typename FrequencyEstimator, typename T>
+void SequentialHeavyHitterWrapperForParallel<FrequencyEstimator, T>::load(std::istream &is) requires Snapshottable<FrequencyEstimator> {
+    read_snapshot_header(is, SnapshotKind::HEAVY_HITTER_WRAPPER);
+    read_binary(is, theta);
+    read_binary(is, total);
+    read_binary(is, threshold);
+    frequency_estimator.load(is);
+
+    uint64_t size;
+    read_binary(is, size);
+    pq_heavy_hitters = BoundedKeyValuePriorityQueue<T>(pq_heavy_hitters.get_bound());
+    for (uint64_t i = 0; i < size; i++) {
+        T key;
+        int count;
+        read_binary(is, key);
+        read_binary(is, count);
+        pq_heavy_hitters.push(key, count);
+    }
+}
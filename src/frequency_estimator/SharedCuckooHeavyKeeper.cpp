@@ -0,0 +1,365 @@
+#include "SharedCuckooHeavyKeeper.hpp"
+#include <algorithm>
+#include <ctime>
+#include <emmintrin.h>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// promotion and decay draws are made by whichever thread updates, so each thread keeps its own generator
+std::mt19937_64 &thread_rng() {
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    return rng;
+}
+
+double random_probability() { return std::uniform_real_distribution<double>(0.0, 1.0)(thread_rng()); }
+}   // namespace
+
+void SharedCuckooHeavyKeeper::StripedCounter::add(size_t c) {
+    static std::atomic<size_t> next_stripe{0};
+    static thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+    stripes[stripe].value.fetch_add(c, std::memory_order_relaxed);
+}
+
+size_t SharedCuckooHeavyKeeper::StripedCounter::load() const {
+    size_t sum = 0;
+    for (size_t i = 0; i < NUM_STRIPES; i++) { sum += stripes[i].value.load(std::memory_order_relaxed); }
+    return sum;
+}
+
+SharedCuckooHeavyKeeper::SharedCuckooHeavyKeeper(size_t bucket_num, double theta, uint32_t promotion_threshold, double decay_base)
+    : m_bucket_num(bucket_num), m_promotion_threshold(promotion_threshold), m_decay_base(decay_base), m_theta(theta) {
+    if (!_is_power_of_two(bucket_num)) { throw std::runtime_error("SharedCuckooHeavyKeeper: bucket_num must be power of 2"); }
+
+    m_tables[0].reset(new Bucket[bucket_num]);
+    m_tables[1].reset(new Bucket[bucket_num]);
+
+    srand(static_cast<unsigned int>(clock()));
+    m_bobhash = std::make_unique<BOBHash64>(rand() % 1228);
+    _init_decay_expectations();
+}
+
+SharedCuckooHeavyKeeper::SharedCuckooHeavyKeeper(SharedCuckooHeavyKeeperConfig config) : SharedCuckooHeavyKeeper(config.BUCKET_NUM, config.THETA, 16, 1.08) {}
+
+void SharedCuckooHeavyKeeper::_init_decay_expectations() {
+    m_decay_expectations[0] = 0;
+    m_min_decay_amounts[0] = 0;
+
+    for (size_t i = 1; i <= MAX_COUNTER; i++) {
+        m_decay_expectations[i] = m_decay_expectations[i - 1] + std::pow(m_decay_base, i - 1);
+        m_min_decay_amounts[i] = m_decay_expectations[i] - m_decay_expectations[i - 1];
+    }
+}
+
+void SharedCuckooHeavyKeeper::_generate_fingerprint_and_index(const std::string &item, uint32_t &fp, size_t &idx) const {
+    unsigned long long h = m_bobhash->run(item.c_str(), item.size());
+    fp = h & ((1ULL << FINGERPRINT_BITS) - 1);
+    idx = (h >> 32) & (m_bucket_num - 1);
+}
+
+size_t SharedCuckooHeavyKeeper::_generate_alt_index(uint32_t fp, size_t idx) const { return (idx ^ (0x5bd1e995 * fp)) & (m_bucket_num - 1); }
+
+uint32_t SharedCuckooHeavyKeeper::_lock(Bucket &bucket) {
+    while (true) {
+        uint32_t version = bucket.version.load(std::memory_order_relaxed);
+        if (!(version & 1) && bucket.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed)) { return version; }
+        _mm_pause();
+    }
+}
+
+uint32_t SharedCuckooHeavyKeeper::_decay_counter(uint32_t current, int weight) const {
+    if (current == 0) return 0;
+
+    // Handle case where weight == 1
+    if (weight == 1) {
+        // Original Heavy Keeper decay with probability b^(-current)
+        double decay_prob = std::pow(m_decay_base, -double(current));
+        if (random_probability() < decay_prob) { return current - 1; }
+        return current;
+    }
+
+    // Handle case where weight > 1 but is too small to cause any decay
+    if (weight > 1 && weight < m_min_decay_amounts[current]) {
+        double decay_prob = weight / m_min_decay_amounts[current];
+        if (random_probability() < decay_prob) { return current - 1; }
+        return current;
+    }
+
+    // Handle case where weight is large enough to cause C decay to 0
+    if (weight >= m_decay_expectations[current]) return 0;
+
+    // Binary search to find first position where m_decay_expectations[idx] + weight >= m_decay_expectations[current]
+    uint32_t left = 0;
+    uint32_t right = current;
+    while (left < right) {
+        uint32_t mid = left + (right - left) / 2;
+        if (m_decay_expectations[mid] + weight >= m_decay_expectations[current]) {
+            right = mid;
+        } else {
+            left = mid + 1;
+        }
+    }
+    return left;
+}
+
+bool SharedCuckooHeavyKeeper::_check_and_update_heavy(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result) {
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        Bucket &bucket = _bucket(table_idx, table_idx == 0 ? idx1 : idx2);
+
+        for (size_t i = 1; i < Bucket::ENTRIES_PER_BUCKET; ++i) {
+            std::atomic<word_t> &slot = bucket.entries[i];
+            if (!_holds(slot.load(std::memory_order_relaxed), fp)) { continue; }
+
+            word_t old = slot.fetch_add(weight, std::memory_order_relaxed);
+            if (_holds(old, fp)) {
+                result = _counter(old) + weight;
+                return true;
+            }
+
+            // the slot was handed to another key between the load and the add, take the weight back unless the entry moved on again
+            word_t current = old + weight;
+            while (_fingerprint(current) == _fingerprint(old) && _counter(current) >= uint32_t(weight) &&
+                   !slot.compare_exchange_weak(current, current - weight, std::memory_order_relaxed)) {}
+        }
+    }
+    return false;
+}
+
+bool SharedCuckooHeavyKeeper::_insert_into_empty_heavy(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result) {
+    // not found, an empty heavy slot takes the key directly -> less collision
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        Bucket &bucket = _bucket(table_idx, table_idx == 0 ? idx1 : idx2);
+
+        for (size_t i = 1; i < Bucket::ENTRIES_PER_BUCKET; ++i) {
+            word_t expected = 0;
+            if (bucket.entries[i].load(std::memory_order_relaxed) == 0 &&
+                bucket.entries[i].compare_exchange_strong(expected, _pack(fp, weight), std::memory_order_relaxed)) {
+                result = weight;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SharedCuckooHeavyKeeper::_check_and_update_lobby(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result) {
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        size_t idx = (table_idx == 0) ? idx1 : idx2;
+        std::atomic<word_t> &lobby = _bucket(table_idx, idx).entries[0];
+
+        word_t current = lobby.load(std::memory_order_relaxed);
+        while (_holds(current, fp)) {
+            uint32_t new_count = _counter(current) + weight;
+            if (!lobby.compare_exchange_weak(current, _pack(fp, new_count), std::memory_order_relaxed)) { continue; }
+
+            result = new_count >= m_promotion_threshold ? _promote(fp, table_idx, idx) : new_count;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SharedCuckooHeavyKeeper::_promote(uint32_t fp, size_t table_idx, size_t idx) {
+    Bucket &bucket = _bucket(table_idx, idx);
+    uint32_t version = _lock(bucket);
+
+    // take the lobby entry out, another thread may have promoted or decayed it before we got the bucket
+    word_t lobby = bucket.entries[0].load(std::memory_order_relaxed);
+    do {
+        if (!_holds(lobby, fp) || _counter(lobby) < m_promotion_threshold) {
+            _unlock(bucket, version);
+            return _holds(lobby, fp) ? _counter(lobby) : 0;
+        }
+    } while (!bucket.entries[0].compare_exchange_weak(lobby, 0, std::memory_order_relaxed));
+    uint32_t count = _counter(lobby);
+
+    while (true) {
+        std::atomic<word_t> *target = &bucket.entries[1];
+        word_t target_entry = target->load(std::memory_order_relaxed);
+        for (size_t i = 2; i < Bucket::ENTRIES_PER_BUCKET; ++i) {
+            word_t entry = bucket.entries[i].load(std::memory_order_relaxed);
+            if (_counter(entry) < _counter(target_entry)) {
+                target = &bucket.entries[i];
+                target_entry = entry;
+            }
+        }
+
+        // Calculate promotion probability only if target counter is greater
+        if (_counter(target_entry) > count) {
+            double prob = (count - m_promotion_threshold) * (1.0 / (_counter(target_entry) - m_promotion_threshold));
+            if (random_probability() >= prob) {
+                // the key stays in the lobby, unless a new key already took the emptied lobby
+                word_t expected = 0;
+                bucket.entries[0].compare_exchange_strong(expected, _pack(fp, m_promotion_threshold), std::memory_order_relaxed);
+                _unlock(bucket, version);
+                return m_promotion_threshold;
+            }
+        }
+
+        // fails when a concurrent fetch_add hit the target, pick again
+        uint32_t promoted_count = std::max(count, _counter(target_entry));
+        if (!target->compare_exchange_strong(target_entry, _pack(fp, promoted_count), std::memory_order_relaxed)) { continue; }
+
+        _unlock(bucket, version);
+        if (_counter(target_entry) > 0) { _do_kickout(target_entry, table_idx, idx); }
+        return promoted_count;
+    }
+}
+
+void SharedCuckooHeavyKeeper::_do_kickout(word_t kicked, size_t curr_table_idx, size_t curr_idx) {
+    // the kicked entry is carried from bucket to bucket, only one bucket is held at a time
+    size_t kicks = 0;
+    while (kicks < MAX_KICKS) {
+        if (!_is_heavy_hitter(_counter(kicked))) { return; }
+
+        curr_table_idx = 1 - curr_table_idx;
+        curr_idx = _generate_alt_index(_fingerprint(kicked), curr_idx);
+
+        Bucket &bucket = _bucket(curr_table_idx, curr_idx);
+        uint32_t version = _lock(bucket);
+        word_t smallest_entry;
+        while (true) {
+            std::atomic<word_t> *smallest = &bucket.entries[1];
+            smallest_entry = smallest->load(std::memory_order_relaxed);
+            for (size_t i = 2; i < Bucket::ENTRIES_PER_BUCKET; ++i) {
+                word_t entry = bucket.entries[i].load(std::memory_order_relaxed);
+                if (_counter(entry) < _counter(smallest_entry)) {
+                    smallest = &bucket.entries[i];
+                    smallest_entry = entry;
+                }
+            }
+            if (smallest->compare_exchange_strong(smallest_entry, kicked, std::memory_order_relaxed)) { break; }
+        }
+        _unlock(bucket, version);
+
+        if (_counter(smallest_entry) == 0) { return; }
+        kicked = smallest_entry;
+        kicks++;
+    }
+}
+
+uint32_t SharedCuckooHeavyKeeper::_update_impl(const std::string &item, int weight) {
+    total.add(weight);
+    uint32_t fp;
+    size_t idx1;
+    _generate_fingerprint_and_index(item, fp, idx1);
+    size_t idx2 = _generate_alt_index(fp, idx1);
+
+    uint32_t result;
+
+    // check if it is in heavy entries first -> update and return
+    if (_check_and_update_heavy(fp, idx1, idx2, weight, result)) { return result; }
+    if (_insert_into_empty_heavy(fp, idx1, idx2, weight, result)) { return result; }
+
+    // check if it is in lobby entries -> update and return
+    if (_check_and_update_lobby(fp, idx1, idx2, weight, result)) { return result; }
+
+    // check for empty lobby entries first
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        size_t idx = (table_idx == 0) ? idx1 : idx2;
+        word_t expected = 0;
+        if (_bucket(table_idx, idx).entries[0].compare_exchange_strong(expected, _pack(fp, weight), std::memory_order_relaxed)) {
+            return uint32_t(weight) >= m_promotion_threshold ? _promote(fp, table_idx, idx) : weight;
+        }
+    }
+
+    // if no empty entries found, use consistent table selection
+    size_t target_table_idx = fp & 1;
+    size_t target_idx = (target_table_idx == 0) ? idx1 : idx2;
+    std::atomic<word_t> &lobby = _bucket(target_table_idx, target_idx).entries[0];
+
+    word_t current = lobby.load(std::memory_order_relaxed);
+    word_t decayed;
+    do {
+        if (_holds(current, fp)) {
+            // our key got the lobby meanwhile
+            decayed = _pack(fp, _counter(current) + weight);
+            continue;
+        }
+        // a lobby counter may pass the threshold for the short time until its promotion
+        uint32_t current_count = std::min<uint32_t>(_counter(current), MAX_COUNTER);
+        uint32_t new_count = _decay_counter(current_count, weight);
+        decayed = (new_count == 0) ? _pack(fp, uint32_t(std::max(0.0, weight - m_decay_expectations[current_count]))) : _pack(_fingerprint(current), new_count);
+    } while (!lobby.compare_exchange_weak(current, decayed, std::memory_order_relaxed));
+
+    if (!_holds(decayed, fp)) { return 0; }
+    if (_counter(decayed) >= m_promotion_threshold) { return _promote(fp, target_table_idx, target_idx); }
+    return _counter(decayed);
+}
+
+uint32_t SharedCuckooHeavyKeeper::_estimate_impl(const std::string &item) const {
+    uint32_t fp;
+    size_t idx1;
+    _generate_fingerprint_and_index(item, fp, idx1);
+    size_t idx2 = _generate_alt_index(fp, idx1);
+
+    uint32_t max_count = 0;
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        const Bucket &bucket = _bucket(table_idx, table_idx == 0 ? idx1 : idx2);
+
+        // re-read the bucket if a promotion or kickout moved entries while we were reading it
+        uint32_t bucket_count, version;
+        do {
+            version = bucket.version.load(std::memory_order_acquire);
+            if (version & 1) {
+                _mm_pause();
+                continue;
+            }
+            bucket_count = 0;
+            for (const auto &slot : bucket.entries) {
+                word_t entry = slot.load(std::memory_order_relaxed);
+                if (_holds(entry, fp)) { bucket_count = std::max(bucket_count, _counter(entry)); }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((version & 1) || bucket.version.load(std::memory_order_relaxed) != version);
+
+        max_count = std::max(max_count, bucket_count);
+    }
+    return max_count;
+}
+
+void SharedCuckooHeavyKeeper::update(const int &item, int c) { update(std::to_string(item), c); }
+
+void SharedCuckooHeavyKeeper::update(const std::string &item, int c) { _update_impl(item, c); }
+
+unsigned int SharedCuckooHeavyKeeper::estimate(const int &item) { return estimate(std::to_string(item)); }
+
+unsigned int SharedCuckooHeavyKeeper::estimate(const std::string &item) { return _estimate_impl(item); }
+
+unsigned int SharedCuckooHeavyKeeper::update_and_estimate(const int &item, int c) { return update_and_estimate(std::to_string(item), c); }
+
+unsigned int SharedCuckooHeavyKeeper::update_and_estimate(const std::string &item, int c) { return _update_impl(item, c); }
+
+void SharedCuckooHeavyKeeper::print_status() { std::cout << *this << std::endl; }
+
+std::ostream &operator<<(std::ostream &os, const SharedCuckooHeavyKeeper &ck) {
+    os << "SharedCuckooHeavyKeeper Status:\n"
+       << "Bucket Number: " << ck.m_bucket_num << "\n"
+       << "Promotion Threshold: " << ck.m_promotion_threshold << "\n"
+       << "Decay Base: " << ck.m_decay_base << "\n"
+       << "Total Items: " << ck.total.load() << "\n\n";
+
+    auto draw_line = [&os](size_t width) { os << '+' << std::string(width * 4, '-') << "+\n"; };
+
+    for (size_t table_idx = 0; table_idx < 2; ++table_idx) {
+        os << "Table " << table_idx << ":\n";
+
+        for (size_t bucket_idx = 0; bucket_idx < ck.m_bucket_num; ++bucket_idx) {
+            const auto &bucket = ck.m_tables[table_idx][bucket_idx];
+
+            draw_line(15);
+            os << '|';
+            for (const auto &slot : bucket.entries) {
+                SharedCuckooHeavyKeeper::word_t entry = slot.load(std::memory_order_relaxed);
+                os << std::setw(7) << SharedCuckooHeavyKeeper::_fingerprint(entry) << "," << std::setw(6) << SharedCuckooHeavyKeeper::_counter(entry) << " |";
+            }
+            os << '\n';
+        }
+        draw_line(15);
+        os << '\n';
+    }
+
+    return os;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "frequency_estimator/FrequencyEstimatorBase.hpp"
+#include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "frequency_estimator/MacroPreprocessor.hpp"
+#include "hash/BOBHash64.hpp"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Cuckoo Heavy Keeper updated by all threads at once (the SHARED parallel design).
+// Every entry is a 64-bit word packing the fingerprint (high half) and the counter (low half), so that:
+//  - heavy counters are bumped with a single fetch_add, the returned word tells whether the slot still held our fingerprint
+//  - the lobby is updated (and decayed) with CAS on the packed word
+//  - promotions and kickouts, which move entries between slots, take the version of their bucket (odd while a move is in progress);
+//    estimate re-reads a bucket when its version changed, so it never sees a half-done move inside that bucket
+// An entry in flight between two buckets of a kickout chain is invisible to readers for that short moment, and two threads
+// inserting the same new key at the same time may both claim an empty slot; estimate takes the max, as the sequential CHK does.
+class SharedCuckooHeavyKeeper : public FrequencyEstimatorBase<SharedCuckooHeavyKeeper> {
+  public:
+    using word_t = uint64_t;
+
+    struct alignas(32) Bucket {
+        static constexpr size_t ENTRIES_PER_BUCKET = 3;
+        std::atomic<word_t> entries[ENTRIES_PER_BUCKET];   // First entry is lobby
+        std::atomic<uint32_t> version{0};
+
+        Bucket() {
+            for (auto &entry : entries) { entry.store(0, std::memory_order_relaxed); }
+        }
+    };
+
+    // item count split over cache-line sized stripes, a single shared counter would be written by every update
+    struct StripedCounter {
+        static constexpr size_t NUM_STRIPES = 64;
+        struct alignas(64) Stripe {
+            std::atomic<size_t> value{0};
+        };
+        std::unique_ptr<Stripe[]> stripes{new Stripe[NUM_STRIPES]};
+
+        void add(size_t c);
+        size_t load() const;
+        operator size_t() const { return load(); }
+    };
+
+    explicit SharedCuckooHeavyKeeper(size_t bucket_num = 128, double theta = 0.01, uint32_t promotion_threshold = 16, double decay_base = 1.08);
+    explicit SharedCuckooHeavyKeeper(SharedCuckooHeavyKeeperConfig config);
+
+    StripedCounter total;
+    void update(const int &item, int c = 1);
+    void update(const std::string &item, int c = 1);
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
+    unsigned int update_and_estimate(const int &item, int c = 1);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    void print_status();
+
+    friend std::ostream &operator<<(std::ostream &os, const SharedCuckooHeavyKeeper &ck);
+
+  private:
+    static constexpr size_t MAX_KICKS = 10;
+    static constexpr size_t FINGERPRINT_BITS = 16;
+    static constexpr size_t MAX_COUNTER = 16;
+    static constexpr double HEAVY_RATIO = 0.8;
+
+    size_t m_bucket_num;
+    uint32_t m_promotion_threshold;
+    double m_decay_base;
+    double m_theta;
+
+    std::array<std::unique_ptr<Bucket[]>, 2> m_tables;
+    std::unique_ptr<BOBHash64> m_bobhash;
+    std::array<double, MAX_COUNTER + 1> m_decay_expectations;
+    std::array<double, MAX_COUNTER + 1> m_min_decay_amounts;
+
+    static word_t _pack(uint32_t fp, uint32_t counter) { return (word_t(fp) << 32) | counter; }
+    static uint32_t _fingerprint(word_t entry) { return entry >> 32; }
+    static uint32_t _counter(word_t entry) { return uint32_t(entry); }
+    static bool _holds(word_t entry, uint32_t fp) { return _counter(entry) > 0 && _fingerprint(entry) == fp; }
+
+    bool _is_power_of_two(size_t x) const { return x && !(x & (x - 1)); }
+    void _init_decay_expectations();
+
+    void _generate_fingerprint_and_index(const std::string &item, uint32_t &fp, size_t &idx) const;
+    size_t _generate_alt_index(uint32_t fp, size_t idx) const;
+    Bucket &_bucket(size_t table_idx, size_t idx) const { return m_tables[table_idx][idx]; }
+
+    uint32_t _lock(Bucket &bucket);
+    void _unlock(Bucket &bucket, uint32_t version) { bucket.version.store(version + 2, std::memory_order_release); }
+
+    uint32_t _update_impl(const std::string &item, int weight);
+    uint32_t _estimate_impl(const std::string &item) const;
+
+    bool _check_and_update_heavy(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result);
+    bool _insert_into_empty_heavy(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result);
+    bool _check_and_update_lobby(uint32_t fp, size_t idx1, size_t idx2, int weight, uint32_t &result);
+    uint32_t _decay_counter(uint32_t current, int weight) const;
+
+    uint32_t _promote(uint32_t fp, size_t table_idx, size_t idx);
+    void _do_kickout(word_t kicked, size_t curr_table_idx, size_t curr_idx);
+
+    bool _is_heavy_hitter(uint32_t count) const { return count >= (total.load() * m_theta * HEAVY_RATIO); }
+};
+
+std::ostream &operator<<(std::ostream &os, const SharedCuckooHeavyKeeper &ck);
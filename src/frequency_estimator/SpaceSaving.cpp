@@ -24,7 +24,7 @@ void SpaceSaving::_update(const std::string &item, int c) {
 
 void SpaceSaving::print_status() {
     std::cout << "Size: " << k << std::endl;
-    std::cout << "Estimated size in bytes: " << k * (sizeof(std::string) + sizeof(unsigned int)) << std::endl;
+    std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
 }
 
 void SpaceSaving::update(const int &item, int c) { _update(int_to_string(item), c); }
@@ -8,7 +8,7 @@
 #include <unordered_map>
 #include <vector>
 
-class SpaceSaving : public FrequencyEstimatorBase {
+class SpaceSaving : public FrequencyEstimatorBase<SpaceSaving> {
   private:
     int k;
     std::vector<std::string> items;
@@ -23,17 +23,19 @@ class SpaceSaving : public FrequencyEstimatorBase {
 
     SpaceSaving(SpaceSavingConfig &config);
 
-    void print_status() override;
+    void print_status();
 
-    void update(const int &item, int c = 1) override;
+    size_t memory_usage() const { return k * (sizeof(std::string) + sizeof(unsigned int)); }
 
-    void update(const std::string &item, int c = 1) override;
+    void update(const int &item, int c = 1);
 
-    unsigned int estimate(const int &item) override;
+    void update(const std::string &item, int c = 1);
 
-    unsigned int estimate(const std::string &item) override;
+    unsigned int estimate(const int &item);
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override;
+    unsigned int estimate(const std::string &item);
 
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override;
+    unsigned int update_and_estimate(const int &item, int c = 1);
+
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
 };
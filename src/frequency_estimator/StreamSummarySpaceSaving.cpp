@@ -1,80 +1,125 @@
 #include "StreamSummarySpaceSaving.hpp"
 
-StreamSummarySpaceSaving::StreamSummarySpaceSaving(int M2, int K) : M2(M2), K(K) {
-    ss = new StreamSummary(M2);
-    ss->clear();
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// counters are written largest first, as the summary lists them
+template <typename Key> void save_summary(std::ostream &os, const BucketStreamSummary<Key> *summary) {
+    write_binary(os, static_cast<uint64_t>(summary ? summary->size() : 0));
+    if (!summary) { return; }
+    for (const auto &counter : *summary) {
+        write_binary(os, counter.key);
+        write_binary(os, counter.count);
+        write_binary(os, counter.error);
+    }
+}
+
+// and restored smallest first, so every key lands on top of the bucket list
+template <typename Key> void load_summary(std::istream &is, std::unique_ptr<BucketStreamSummary<Key>> &summary, int capacity) {
+    using count_t = typename BucketStreamSummary<Key>::count_t;
+    uint64_t size;
+    read_binary(is, size);
+    summary.reset();
+    if (size == 0) { return; }
+    if (size > static_cast<uint64_t>(capacity)) { throw std::runtime_error("SpaceSaving snapshot holds more items than its capacity"); }
+
+    std::vector<std::tuple<Key, count_t, count_t>> counters(size);
+    for (auto &[key, count, error] : counters) {
+        read_binary(is, key);
+        read_binary(is, count);
+        read_binary(is, error);
+    }
+    summary = std::make_unique<BucketStreamSummary<Key>>(capacity);
+    for (auto it = counters.rbegin(); it != counters.rend(); ++it) { summary->restore(std::get<0>(*it), std::get<1>(*it), std::get<2>(*it)); }
+}
+
+}   // namespace
+
+StreamSummarySpaceSaving::StreamSummarySpaceSaving(int M2, int K) : K(K), M2(M2) {}
+
+StreamSummarySpaceSaving::StreamSummarySpaceSaving(SpaceSavingConfig &config) : K(config.K), M2(config.K) {}
+
+BucketStreamSummary<int> &StreamSummarySpaceSaving::_int_summary() {
+    if (!int_summary) { int_summary = std::make_unique<BucketStreamSummary<int>>(M2); }
+    return *int_summary;
 }
 
-StreamSummarySpaceSaving::StreamSummarySpaceSaving(SpaceSavingConfig &config) : M2(config.K) {
-    ss = new StreamSummary(M2);
-    ss->clear();
+BucketStreamSummary<std::string> &StreamSummarySpaceSaving::_string_summary() {
+    if (!string_summary) { string_summary = std::make_unique<BucketStreamSummary<std::string>>(M2); }
+    return *string_summary;
+}
+
+void StreamSummarySpaceSaving::_check_weight(int c) {
+    if (c < 0) { throw std::runtime_error("Space-Saving does not support negative weights"); }
 }
 
 void StreamSummarySpaceSaving::update(const std::string &x, int c) {
-    _assert_not_implemented(c);
-    this->total++;
-    bool mon = false;
-    int p = ss->find(x);
-    if (p) mon = true;
-    if (!mon) {
-        int q;
-        if (ss->tot < M2)
-            q = 1;
-        else
-            q = ss->getmin() + 1;
-        int i = ss->getid();
-        ss->add2(ss->location(x), i);
-        ss->str[i] = x;
-        ss->sum[i] = q;
-        ss->link(i, 0);
-        while (ss->tot > M2) {
-            int t = ss->Right[0];
-            int tmp = ss->head[t];
-            ss->cut(ss->head[t]);
-            ss->recycling(tmp);
-        }
-    } else {
-        int tmp = ss->Left[ss->sum[p]];
-        ss->cut(p);
-        if (ss->head[ss->sum[p]]) tmp = ss->sum[p];
-        ss->sum[p]++;
-        ss->link(p, tmp);
-    }
+    _check_weight(c);
+    this->total += c;
+    _string_summary().update(x, c);
 }
 
 void StreamSummarySpaceSaving::update(const int &x, int c) {
-    _assert_not_implemented(c);
-    update(std::to_string(x));
+    _check_weight(c);
+    this->total += c;
+    _int_summary().update(x, c);
 }
 
 unsigned int StreamSummarySpaceSaving::estimate(const std::string &item) {
-    int p = ss->find(item);
-    if (p) return ss->sum[p];
-    return 0;
+    return string_summary ? string_summary->estimate(item) : 0;
 }
 
 unsigned int StreamSummarySpaceSaving::estimate(const int &item) {
-    return estimate(std::to_string(item));
+    return int_summary ? int_summary->estimate(item) : 0;
 }
 
 unsigned int StreamSummarySpaceSaving::update_and_estimate(const std::string &item, int c) {
-    update(item, c);
-    return estimate(item);
+    _check_weight(c);
+    this->total += c;
+    return _string_summary().update(item, c);
 }
 
 unsigned int StreamSummarySpaceSaving::update_and_estimate(const int &item, int c) {
-    return update_and_estimate(std::to_string(item), c);
+    _check_weight(c);
+    this->total += c;
+    return _int_summary().update(item, c);
 }
 
-void StreamSummarySpaceSaving::_assert_not_implemented(int c) {
-    if (c != 1) {
-        throw std::runtime_error("Not implemented for cases where the number is not equal to 1");
-    }
+size_t StreamSummarySpaceSaving::memory_usage() const {
+    return (int_summary ? int_summary->memory_bytes() : 0) + (string_summary ? string_summary->memory_bytes() : 0);
 }
 
 void StreamSummarySpaceSaving::print_status() {
     std::cout << "StreamSummarySpaceSaving: " << std::endl;
     std::cout << "M2: " << M2 << std::endl;
     std::cout << "K: " << K << std::endl;
-    std::cout << "Estimated size in bytes: " << sizeof(*this) << std::endl;
-}
\ No newline at end of file
+    std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
+}
+
+void StreamSummarySpaceSaving::save(std::ostream &os) const {
+    write_snapshot_header(os, SnapshotKind::STREAM_SUMMARY_SPACE_SAVING);
+    write_binary(os, K);
+    write_binary(os, M2);
+    write_binary(os, total);
+    save_summary(os, int_summary.get());
+    save_summary(os, string_summary.get());
+}
+
+void StreamSummarySpaceSaving::load(std::istream &is) {
+    uint32_t version = read_snapshot_header(is, SnapshotKind::STREAM_SUMMARY_SPACE_SAVING);
+    read_binary(is, K);
+    read_binary(is, M2);
+    if (version < 4) {
+        // the total was an int before format version 4
+        int old_total;
+        read_binary(is, old_total);
+        total = old_total;
+    } else {
+        read_binary(is, total);
+    }
+    load_summary(is, int_summary, M2);
+    load_summary(is, string_summary, M2);
+}
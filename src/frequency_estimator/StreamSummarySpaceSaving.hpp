@@ -1,50 +1,60 @@
 #pragma once
 
-#include "StreamSummary.hpp"
+#include "frequency_estimator/BucketStreamSummary.hpp"
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
-#include "hash/BOBHash32.hpp"
-#include "hash/BOBHash64.hpp"
-#include <algorithm>
-#include <cmath>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
+#include "utils/BinarySnapshot.hpp"
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <type_traits>
 
-#define rep(i, a, n) for (int i = a; i <= n; i++)
-
-constexpr int N = 1000000;      // maximum flow
-constexpr int M = 1000000;      // maximum size of stream-summary or CSS
-constexpr int MAX_MEM = 2000;   // maximum memory size
-
-using std::string, std::pair, std::make_pair, std::sort;
-
-class StreamSummarySpaceSaving : public FrequencyEstimatorBase {
+// Space-Saving on a stream-summary: O(1) updates of weight 1, weighted updates walk up the buckets they pass.
+// Integer keys are counted as integers, string keys in a summary of their own; each summary is allocated on first use with M2 counters.
+class StreamSummarySpaceSaving : public FrequencyEstimatorBase<StreamSummarySpaceSaving> {
   public:
-    int total = 0;
+    int64_t total = 0;   // sum of the weights, may pass INT_MAX with weighted updates
     StreamSummarySpaceSaving(int M2, int K);
 
     StreamSummarySpaceSaving(SpaceSavingConfig &config);
 
-    void update(const std::string &x, int c = 1) override;
+    void update(const std::string &x, int c = 1);
+
+    void update(const int &x, int c = 1);
+
+    unsigned int estimate(const std::string &item);
 
-    void update(const int &x, int c = 1) override;
+    unsigned int estimate(const int &item);
 
-    unsigned int estimate(const std::string &item) override;
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
 
-    unsigned int estimate(const int &item) override;
+    unsigned int update_and_estimate(const int &item, int c = 1);
 
-    unsigned int update_and_estimate(const std::string &item, int c = 1) override;
+    void print_status();
+    size_t memory_usage() const;
 
-    unsigned int update_and_estimate(const int &item, int c = 1) override;
+    // monitored (key, count, error) triples of the string or the integer keys, largest count first
+    template <typename Key> const auto &counters() const {
+        if constexpr (std::is_same_v<Key, std::string>) {
+            static const BucketStreamSummary<std::string> empty(1);
+            return string_summary ? *string_summary : empty;
+        } else {
+            static const BucketStreamSummary<int> empty(1);
+            return int_summary ? *int_summary : empty;
+        }
+    }
 
-    void print_status() override;
+    // binary snapshot of the counters of both summaries
+    void save(std::ostream &) const;
+    void load(std::istream &);
 
   private:
-    StreamSummary *ss;
     int K, M2;
+    std::unique_ptr<BucketStreamSummary<int>> int_summary;
+    std::unique_ptr<BucketStreamSummary<std::string>> string_summary;
 
-    void _assert_not_implemented(int c);
+    BucketStreamSummary<int> &_int_summary();
+    BucketStreamSummary<std::string> &_string_summary();
+    void _check_weight(int c);
 };
@@ -5,7 +5,7 @@
 
 #define LONG_PRIME 2147483647
 
-class WeightedFrequent : public FrequencyEstimatorBase {
+class WeightedFrequent : public FrequencyEstimatorBase<WeightedFrequent> {
   public:
     // Constructor
     WeightedFrequent() = default;
@@ -22,35 +22,35 @@ class WeightedFrequent : public FrequencyEstimatorBase {
     }
 
     // Update functions
-    void update(const int &item, int c = 1) override { _update(item, c); }
+    void update(const int &item, int c = 1) { _update(item, c); }
 
-    void update(const string &item, int c = 1) override { _update(_get_hashitem(item), c); }
+    void update(const string &item, int c = 1) { _update(_get_hashitem(item), c); }
 
     // Estimate functions
-    unsigned int estimate(const int &item) override { return _estimate(item); }
+    unsigned int estimate(const int &item) { return _estimate(item); }
 
-    unsigned int estimate(const string &item) override { return _estimate(_get_hashitem(item)); }
+    unsigned int estimate(const string &item) { return _estimate(_get_hashitem(item)); }
 
     // Update and estimate functions
-    unsigned int update_and_estimate(const int &item, int c = 1) override {
+    unsigned int update_and_estimate(const int &item, int c = 1) {
         _update(item, c);
         return _estimate(item);
     }
 
-    unsigned int update_and_estimate(const string &item, int c = 1) override {
+    unsigned int update_and_estimate(const string &item, int c = 1) {
         unsigned int hashitem = _get_hashitem(item);
         _update(hashitem, c);
         return _estimate(hashitem);
     }
 
     // Print status function
-    void print_status() override {
+    void print_status() {
         // Implementation depends on what you want to print
     }
 
   private:
-    float epsilon;
-    int n;
+    float epsilon = 0;
+    int n = 0;
     std::unordered_map<int, int> T;
 
     unsigned int _get_hashitem(const string &item) {
@@ -0,0 +1,102 @@
+#include "WindowedCuckooHeavyKeeper.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+WindowedCuckooHeavyKeeper::WindowedCuckooHeavyKeeper(size_t bucket_num, double theta, size_t num_windows, size_t window_size, int seed)
+    : m_num_windows(num_windows), m_window_size(window_size), m_bucket_num(bucket_num) {
+    if (num_windows == 0) { throw std::runtime_error("WindowedCuckooHeavyKeeper needs at least one window"); }
+
+    m_windows.reserve(num_windows + 2);
+    for (size_t i = 0; i < num_windows + 2; i++) { m_windows.emplace_back(bucket_num, theta, 16, 1.08, seed); }
+
+    // spread the clearing of one sub-sketch over one window of updates, manual rotation starts at one bucket per update
+    m_clear_step = window_size > 0 ? std::max<size_t>(1, (bucket_num + window_size - 1) / window_size) : 1;
+}
+
+WindowedCuckooHeavyKeeper::WindowedCuckooHeavyKeeper(WindowedCuckooHeavyKeeperConfig config)
+    : WindowedCuckooHeavyKeeper(config.BUCKET_NUM, config.THETA, config.NUM_WINDOWS, config.WINDOW_SIZE, config.SEED) {}
+
+void WindowedCuckooHeavyKeeper::_clear_some(size_t bucket_count) {
+    while (bucket_count > 0 && m_num_dirty > 0) {
+        size_t last_bucket = std::min(m_clear_cursor + bucket_count, m_bucket_num);
+        m_windows[m_num_dirty == 2 ? _spare() : _retired()].clear_buckets(m_clear_cursor, last_bucket);
+        bucket_count -= last_bucket - m_clear_cursor;
+        m_clear_cursor = last_bucket;
+        if (m_clear_cursor == m_bucket_num) {
+            m_num_dirty--;
+            m_clear_cursor = 0;
+        }
+    }
+}
+
+void WindowedCuckooHeavyKeeper::rotate() {
+    // the spare becomes the current sub-sketch, only the part of it the updates did not reach yet is cleared here
+    if (m_num_dirty == 2) { _clear_some(m_bucket_num - m_clear_cursor); }
+    // a sweep of the retired sub-sketch in progress carries over, that sub-sketch is the next spare
+    m_current = _spare();
+
+    // the oldest active sub-sketch leaves the window and is cleared after the spare
+    m_windows[_retired()].total = 0;
+    m_num_dirty++;
+
+    // one sub-sketch per window of updates, as long as the windows keep their length
+    m_clear_step = std::max<size_t>(1, (m_bucket_num + m_updates_in_window - 1) / std::max<size_t>(1, m_updates_in_window));
+    m_items_in_window = 0;
+    m_updates_in_window = 0;
+}
+
+size_t WindowedCuckooHeavyKeeper::window_total() const {
+    size_t sum = 0;
+    for (size_t i = 0; i < m_windows.size(); i++) {
+        if (i != _spare() && i != _retired()) { sum += m_windows[i].total; }
+    }
+    return sum;
+}
+
+void WindowedCuckooHeavyKeeper::_after_update(int c) {
+    total += c;
+    m_items_in_window += c;
+    m_updates_in_window++;
+    _clear_some(m_clear_step);
+    if (m_window_size > 0 && m_items_in_window >= m_window_size) { rotate(); }
+}
+
+unsigned int WindowedCuckooHeavyKeeper::_estimate_others(const std::string &item) {
+    unsigned int sum = 0;
+    for (size_t i = 0; i < m_windows.size(); i++) {
+        if (i != m_current && i != _spare() && i != _retired()) { sum += m_windows[i].estimate(item); }
+    }
+    return sum;
+}
+
+void WindowedCuckooHeavyKeeper::update(const int &item, int c) { update(std::to_string(item), c); }
+
+void WindowedCuckooHeavyKeeper::update(const std::string &item, int c) {
+    m_windows[m_current].update(item, c);
+    _after_update(c);
+}
+
+unsigned int WindowedCuckooHeavyKeeper::estimate(const int &item) { return estimate(std::to_string(item)); }
+
+unsigned int WindowedCuckooHeavyKeeper::estimate(const std::string &item) { return m_windows[m_current].estimate(item) + _estimate_others(item); }
+
+unsigned int WindowedCuckooHeavyKeeper::update_and_estimate(const int &item, int c) { return update_and_estimate(std::to_string(item), c); }
+
+unsigned int WindowedCuckooHeavyKeeper::update_and_estimate(const std::string &item, int c) {
+    // estimate before a possible rotation, so the result covers the window this item was counted in
+    unsigned int count = m_windows[m_current].update_and_estimate(item, c) + _estimate_others(item);
+    _after_update(c);
+    return count;
+}
+
+void WindowedCuckooHeavyKeeper::print_status() { std::cout << *this << std::endl; }
+
+std::ostream &operator<<(std::ostream &os, const WindowedCuckooHeavyKeeper &wck) {
+    os << "WindowedCuckooHeavyKeeper Status:\n"
+       << "Bucket Number: " << wck.m_bucket_num << "\n"
+       << "Windows: " << wck.m_num_windows << " x " << wck.m_window_size << " items\n"
+       << "Items In Current Window: " << wck.m_items_in_window << "\n"
+       << "Items In Window: " << wck.window_total() << "\n"
+       << "Total Items: " << wck.total << "\n";
+    return os;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include "frequency_estimator/FrequencyEstimatorBase.hpp"
+#include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Sliding-window Cuckoo Heavy Keeper: a ring of num_windows + 2 CHK sub-sketches sharing the same parameters.
+// Updates go to the current sub-sketch, queries sum the num_windows most recent ones (the current one is still filling, so a query covers
+// between (num_windows - 1) * window_size and num_windows * window_size items). The two others left the window: the spare, next in line
+// to become current, and the one that left last. They are emptied a few buckets per update, spare first, and the sweep carries over
+// rotations, so rotate() only clears what is left of the spare when two rotations come within one sweep.
+// The buckets cleared per update follow the number of updates of the last window, so that the sweep keeps up with the rotations.
+// With window_size = 0 the sketch never rotates on its own, callers rotate on event time by calling rotate().
+class WindowedCuckooHeavyKeeper : public FrequencyEstimatorBase<WindowedCuckooHeavyKeeper> {
+  public:
+    explicit WindowedCuckooHeavyKeeper(size_t bucket_num = 128, double theta = 0.01, size_t num_windows = 4, size_t window_size = 1000000, int seed = -1);
+    explicit WindowedCuckooHeavyKeeper(WindowedCuckooHeavyKeeperConfig config);
+
+    size_t total{0};   // items seen since the start, window_total() gives the items covered by queries
+    void update(const int &item, int c = 1);
+    void update(const std::string &item, int c = 1);
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
+    unsigned int update_and_estimate(const int &item, int c = 1);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    void print_status();
+
+    // starts a new sub-window, the oldest one leaves the query window
+    void rotate();
+    size_t window_total() const;
+    size_t get_num_windows() const { return m_num_windows; }
+    size_t get_window_size() const { return m_window_size; }
+
+    friend std::ostream &operator<<(std::ostream &os, const WindowedCuckooHeavyKeeper &wck);
+
+  private:
+    size_t m_num_windows;
+    size_t m_window_size;
+    size_t m_bucket_num;
+
+    std::vector<CuckooHeavyKeeper> m_windows;
+    size_t m_current{0};            // sub-sketch taking updates
+    size_t m_items_in_window{0};    // items in the current sub-sketch
+    size_t m_updates_in_window{0};  // update calls on the current sub-sketch
+    size_t m_num_dirty{0};          // sub-sketches left to clear: 0, the spare, or the spare and the one after it
+    size_t m_clear_cursor{0};       // next bucket to clear in the first of them
+    size_t m_clear_step;            // buckets cleared per update, enough to finish before the next rotation
+
+    size_t _spare() const { return (m_current + 1) % m_windows.size(); }
+    size_t _retired() const { return (m_current + 2) % m_windows.size(); }
+    void _clear_some(size_t bucket_count);
+    void _after_update(int c);
+    unsigned int _estimate_others(const std::string &item);
+};
+
+std::ostream &operator<<(std::ostream &os, const WindowedCuckooHeavyKeeper &wck);
@@ -1,7 +1,9 @@
 #pragma once
 #include "params.hpp"
 #include <stdint.h>
-struct Bucket {
+
+// MAX_VALID_COUNTER (key, count) pairs and the vote- counter in the last val, one cache line
+struct alignas(64) Bucket {
     uint32_t key[COUNTER_PER_BUCKET];
     uint32_t val[COUNTER_PER_BUCKET];
-};
\ No newline at end of file
+};
@@ -1,15 +1,29 @@
 #include "ElasticSketch.hpp"
-#include <memory>
+#include "params.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+ElasticSketch::ElasticSketch(int bucket_num, int tot_memory_in_bytes)
+    : heavy_part(bucket_num), light_part(tot_memory_in_bytes - std::max(bucket_num, 1) * (int) sizeof(Bucket)) {
+    if (tot_memory_in_bytes <= std::max(bucket_num, 1) * (int) sizeof(Bucket)) {
+        throw std::runtime_error("ElasticSketch: the heavy part takes up the whole memory, no room is left for the light part");
+    }
+    std::random_device rd;
+    string_hash = BOBHash32(rd() % MAX_PRIME32);
+}
+
+ElasticSketch::ElasticSketch(const ElasticSketchConfig &config) : ElasticSketch(config.BUCKET_NUM, config.MEMORY_IN_BYTES) {}
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::clear() {
+void ElasticSketch::clear() {
     heavy_part.clear();
     light_part.clear();
+    total = 0;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::insert(uint8_t *key, int f) {
-    uint8_t swap_key[KEY_LENGTH_4];
+void ElasticSketch::insert(uint32_t key, int f) {
+    uint32_t swap_key;
     uint32_t swap_val = 0;
     int result = heavy_part.insert(key, swap_key, swap_val, f);
     switch (result) {
@@ -23,21 +37,16 @@ void ElasticSketch<bucket_num, tot_memory_in_bytes>::insert(uint8_t *key, int f)
         return;
     }
     case 2:
-        light_part.insert(key, 1);
+        light_part.insert(key, f);
         return;
     default:
-        printf("error return value !\n");
-        exit(1);
+        throw std::runtime_error("ElasticSketch: unexpected return value of the heavy part");
     }
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::quick_insert(uint8_t *key, int f) {
-    heavy_part.quick_insert(key, f);
-}
+void ElasticSketch::quick_insert(uint32_t key, int f) { heavy_part.quick_insert(key, f); }
 
-template <int bucket_num, int tot_memory_in_bytes>
-int ElasticSketch<bucket_num, tot_memory_in_bytes>::query(uint8_t *key) {
+int ElasticSketch::query(uint32_t key) {
     uint32_t heavy_result = heavy_part.query(key);
     if (heavy_result == 0 || HIGHEST_BIT_IS_1(heavy_result)) {
         int light_result = light_part.query(key);
@@ -46,46 +55,47 @@ int ElasticSketch<bucket_num, tot_memory_in_bytes>::query(uint8_t *key) {
     return heavy_result;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-int ElasticSketch<bucket_num, tot_memory_in_bytes>::query_compressed_part(
-    uint8_t *key, uint8_t *compress_part, int compress_counter_num) {
+int ElasticSketch::query_compressed_part(uint32_t key, uint8_t *compress_part, int compress_counter_num) {
     uint32_t heavy_result = heavy_part.query(key);
     if (heavy_result == 0 || HIGHEST_BIT_IS_1(heavy_result)) {
-        int light_result =
-            light_part.query_compressed_part(key, compress_part, compress_counter_num);
+        int light_result = light_part.query_compressed_part(key, compress_part, compress_counter_num);
         return (int) GetCounterVal(heavy_result) + light_result;
     }
     return heavy_result;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-double ElasticSketch<bucket_num, tot_memory_in_bytes>::get_bandwidth(int compress_ratio) {
+double ElasticSketch::get_bandwidth(int compress_ratio) {
     int result = heavy_part.get_memory_usage();
     result += get_compress_width(compress_ratio) * sizeof(uint8_t);
     return result * 1.0 / 1024 / 1024;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::get_heavy_hitters(
-    int threshold, vector<pair<string, int>> &results) {
-    for (int i = 0; i < bucket_num; ++i)
+std::vector<ElasticSketch::Counter> ElasticSketch::_heavy_counters() {
+    std::vector<Counter> results;
+    for (int i = 0; i < heavy_part.get_bucket_num(); ++i) {
+        const Bucket &bucket = heavy_part.get_bucket(i);
         for (int j = 0; j < MAX_VALID_COUNTER; ++j) {
-            uint32_t key = heavy_part.buckets[i].key[j];
-            int val = query((uint8_t *) &key);
-            if (val >= threshold) {
-                results.push_back(make_pair(string((const char *) &key, 4), val));
-            }
+            if (GetCounterVal(bucket.val[j]) == 0) continue;
+            results.push_back({(int) bucket.key[j], (unsigned int) query(bucket.key[j])});
         }
+    }
+    std::sort(results.begin(), results.end(), [](const Counter &a, const Counter &b) { return a.count > b.count; });
+    return results;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-int ElasticSketch<bucket_num, tot_memory_in_bytes>::get_cardinality() {
+void ElasticSketch::get_heavy_hitters(int threshold, vector<pair<int, int>> &results) {
+    for (const Counter &counter : _heavy_counters()) {
+        if ((int) counter.count < threshold) break;
+        results.push_back(make_pair(counter.key, (int) counter.count));
+    }
+}
+
+int ElasticSketch::get_cardinality() {
     int card = light_part.get_cardinality();
-    for (int i = 0; i < bucket_num; ++i)
+    for (int i = 0; i < heavy_part.get_bucket_num(); ++i)
         for (int j = 0; j < MAX_VALID_COUNTER; ++j) {
-            uint8_t key[KEY_LENGTH_4];
-            *(uint32_t *) key = heavy_part.buckets[i].key[j];
-            int val = heavy_part.buckets[i].val[j];
+            uint32_t key = heavy_part.get_bucket(i).key[j];
+            int val = heavy_part.get_bucket(i).val[j];
             int ex_val = light_part.query(key);
 
             if (HIGHEST_BIT_IS_1(val) && ex_val) {
@@ -97,18 +107,16 @@ int ElasticSketch<bucket_num, tot_memory_in_bytes>::get_cardinality() {
     return card;
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-double ElasticSketch<bucket_num, tot_memory_in_bytes>::get_entropy() {
+double ElasticSketch::get_entropy() {
     int tot = 0;
     double entr = 0;
 
     light_part.get_entropy(tot, entr);
 
-    for (int i = 0; i < bucket_num; ++i)
+    for (int i = 0; i < heavy_part.get_bucket_num(); ++i)
         for (int j = 0; j < MAX_VALID_COUNTER; ++j) {
-            uint8_t key[KEY_LENGTH_4];
-            *(uint32_t *) key = heavy_part.buckets[i].key[j];
-            int val = heavy_part.buckets[i].val[j];
+            uint32_t key = heavy_part.get_bucket(i).key[j];
+            int val = heavy_part.get_bucket(i).val[j];
 
             int ex_val = light_part.query(key);
 
@@ -128,15 +136,13 @@ double ElasticSketch<bucket_num, tot_memory_in_bytes>::get_entropy() {
     return -entr / tot + log2(tot);
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::get_distribution(vector<double> &dist) {
+void ElasticSketch::get_distribution(vector<double> &dist) {
     light_part.get_distribution(dist);
 
-    for (int i = 0; i < bucket_num; ++i)
+    for (int i = 0; i < heavy_part.get_bucket_num(); ++i)
         for (int j = 0; j < MAX_VALID_COUNTER; ++j) {
-            uint8_t key[KEY_LENGTH_4];
-            *(uint32_t *) key = heavy_part.buckets[i].key[j];
-            int val = heavy_part.buckets[i].val[j];
+            uint32_t key = heavy_part.get_bucket(i).key[j];
+            int val = heavy_part.get_bucket(i).val[j];
 
             int ex_val = light_part.query(key);
 
@@ -152,19 +158,44 @@ void ElasticSketch<bucket_num, tot_memory_in_bytes>::get_distribution(vector<dou
         }
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void *ElasticSketch<bucket_num, tot_memory_in_bytes>::operator new(size_t sz) {
-    constexpr uint32_t alignment = 64;
-    size_t alloc_size = (2 * alignment + sz) / alignment * alignment;
-    void *ptr = ::operator new(alloc_size);
-    void *old_ptr = ptr;
-    void *new_ptr = ((char *) std::align(alignment, sz, ptr, alloc_size) + alignment);
-    ((void **) new_ptr)[-1] = old_ptr;
+void ElasticSketch::update(const int &item, int c) {
+    if (c > 0) {
+        this->total += c;
+        insert(_key(item), c);
+    }
+}
+
+void ElasticSketch::update(const std::string &item, int c) {
+    if (c > 0) {
+        this->total += c;
+        insert(_key(item), c);
+    }
+}
+
+unsigned int ElasticSketch::estimate(const int &item) { return query(_key(item)); }
 
-    return new_ptr;
+unsigned int ElasticSketch::estimate(const std::string &item) { return query(_key(item)); }
+
+unsigned int ElasticSketch::update_and_estimate(const int &item, int c) {
+    uint32_t key = _key(item);
+    if (c > 0) {
+        this->total += c;
+        insert(key, c);
+    }
+    return query(key);
+}
+
+unsigned int ElasticSketch::update_and_estimate(const std::string &item, int c) {
+    uint32_t key = _key(item);
+    if (c > 0) {
+        this->total += c;
+        insert(key, c);
+    }
+    return query(key);
 }
 
-template <int bucket_num, int tot_memory_in_bytes>
-void ElasticSketch<bucket_num, tot_memory_in_bytes>::operator delete(void *p) {
-    ::operator delete(((void **) p)[-1]);
+void ElasticSketch::print_status() {
+    std::cout << "Heavy buckets: " << heavy_part.get_bucket_num() << std::endl;
+    std::cout << "Light counters: " << light_part.get_memory_usage() << std::endl;
+    std::cout << "Estimated size in bytes: " << memory_usage() << std::endl;
 }
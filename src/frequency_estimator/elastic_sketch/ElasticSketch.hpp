@@ -1,26 +1,38 @@
+#pragma once
 
 #include "HeavyPart.hpp"
 #include "LightPart.hpp"
 #include "frequency_estimator/FrequencyEstimatorBase.hpp"
+#include "frequency_estimator/FrequencyEstimatorConfig.hpp"
+#include "hash/BOBHash32.hpp"
+#include <concepts>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
-template <int bucket_num, int tot_memory_in_bytes>
-class ElasticSketch : public FrequencyEstimatorBase {
-    static constexpr int heavy_mem = bucket_num * COUNTER_PER_BUCKET * 8;
-    static constexpr int light_mem = tot_memory_in_bytes - heavy_mem;
-
-    HeavyPart<bucket_num> heavy_part;
-    LightPart<light_mem> light_part;
+// Elastic sketch sized at runtime: bucket_num heavy buckets of one cache line, the rest of tot_memory_in_bytes is
+// one-byte light counters. Integer keys are stored in the heavy part as they are, string keys by a 32-bit hash.
+class ElasticSketch : public FrequencyEstimatorBase<ElasticSketch> {
+    HeavyPart heavy_part;
+    LightPart light_part;
+    BOBHash32 string_hash;
 
   public:
-    ElasticSketch() {}
-    ~ElasticSketch() {}
+    struct Counter {
+        int key;
+        unsigned int count;
+    };
+
+    ElasticSketch(int bucket_num, int tot_memory_in_bytes);
+    ElasticSketch(const ElasticSketchConfig &config);
     void clear();
 
-    void insert(uint8_t *key, int f = 1);
-    void quick_insert(uint8_t *key, int f = 1);
+    void insert(uint32_t key, int f = 1);
+    void quick_insert(uint32_t key, int f = 1);
 
-    int query(uint8_t *key);
-    int query_compressed_part(uint8_t *key, uint8_t *compress_part, int compress_counter_num);
+    int query(uint32_t key);
+    int query_compressed_part(uint32_t key, uint8_t *compress_part, int compress_counter_num);
 
     int get_compress_width(int ratio) { return light_part.get_compress_width(ratio); }
     void compress(int ratio, uint8_t *dst) { light_part.compress(ratio, dst); }
@@ -28,35 +40,33 @@ class ElasticSketch : public FrequencyEstimatorBase {
     int get_bucket_num() { return heavy_part.get_bucket_num(); }
     double get_bandwidth(int compress_ratio);
 
-    void get_heavy_hitters(int threshold, vector<pair<string, int>> &results);
+    void get_heavy_hitters(int threshold, vector<pair<int, int>> &results);
     int get_cardinality();
     double get_entropy();
     void get_distribution(vector<double> &dist);
 
-    // interface for FrequencyEstimatorBase
-    int total = 0;
-    void update(const int &item, int c = 1) {
-        this->total += c;
-        insert((uint8_t *) &item, c);
-    }
-    void update(const std::string &item, int c = 1) {
-        // what should be implemented here?
-    }
-    unsigned int estimate(const std::string &item) {
-        // what should be implemented here?
-        return 0;
+    // the keys of the heavy part with their estimates, largest first; only integer keys can be listed, string keys share the
+    // heavy part and would show up as their hashes
+    template <typename Key>
+        requires std::same_as<Key, int>
+    std::vector<Counter> counters() {
+        return _heavy_counters();
     }
-    unsigned int estimate(const int &item) { return query((uint8_t *) &item); }
-    unsigned int update_and_estimate(const int &item, int c = 1) {
-        update(item, c);
-        return query((uint8_t *) &item);
-    }
-    unsigned int update_and_estimate(const std::string &item, int c = 1) {
-        // what should be implemented here?
-        return 0;
-    }
-    void print_status() {}
 
-    void *operator new(size_t sz);
-    void operator delete(void *p);
-};
\ No newline at end of file
+    // FrequencyEstimatorLike interface
+    unsigned long total = 0;
+    void update(const int &item, int c = 1);
+    void update(const std::string &item, int c = 1);
+    unsigned int estimate(const int &item);
+    unsigned int estimate(const std::string &item);
+    unsigned int update_and_estimate(const int &item, int c = 1);
+    unsigned int update_and_estimate(const std::string &item, int c = 1);
+    void print_status();
+    size_t memory_usage() const { return heavy_part.get_memory_usage() + light_part.get_memory_usage(); }
+
+  private:
+    uint32_t _key(const int &item) { return (uint32_t) item; }
+    uint32_t _key(const std::string &item) { return string_hash.run(item.c_str(), item.size()); }
+
+    std::vector<Counter> _heavy_counters();
+};
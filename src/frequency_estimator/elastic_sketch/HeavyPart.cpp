@@ -1,267 +1,131 @@
 #include "HeavyPart.hpp"
 #include "params.hpp"
+#include <algorithm>
+#include <immintrin.h>
+
+// the AVX2 lookup is compiled for AVX2 only, and taken (use_avx2) when the cpu running the binary has it
+
+__attribute__((target("avx2"))) static int lookup_avx2(const Bucket &bucket, uint32_t key, bool &matched, uint32_t &min_val) {
+    /* find if there has matched bucket, the vote- slot is not a key */
+    const __m256i keys = _mm256_load_si256((const __m256i *) bucket.key);
+    int match = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(keys, _mm256_set1_epi32((int) key))));
+    match &= (1 << MAX_VALID_COUNTER) - 1;
+    if (match != 0) {
+        matched = true;
+        return __builtin_ctz(match);
+    }
 
-#ifdef USING_SIMD_ACCELERATION
-    #include <emmintrin.h>
-    #include <immintrin.h>
-    #include <smmintrin.h>
-#endif   // USING_SIMD_ACCELERATION
-
-template <int bucket_num> HeavyPart<bucket_num>::HeavyPart() { this->clear(); }
-
-template <int bucket_num> HeavyPart<bucket_num>::~HeavyPart() {}
-
-template <int bucket_num> void HeavyPart<bucket_num>::clear() {
-    memset(buckets, 0, sizeof(Bucket) * bucket_num);
+    /* find the minimal bucket, the vote- slot takes the largest count */
+    __m256i vals = _mm256_and_si256(_mm256_load_si256((const __m256i *) bucket.val), _mm256_set1_epi32(0x7FFFFFFF));
+    vals = _mm256_or_si256(vals, _mm256_set_epi32(0x7FFFFFFF, 0, 0, 0, 0, 0, 0, 0));
+    __m128i x = _mm_min_epu32(_mm256_castsi256_si128(vals), _mm256_extracti128_si256(vals, 1));
+    x = _mm_min_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_min_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    min_val = (uint32_t) _mm_cvtsi128_si32(x);
+
+    int is_min = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(vals, _mm256_set1_epi32((int) min_val))));
+    matched = false;
+    return __builtin_ctz(is_min);
 }
 
-template <int bucket_num>
-int HeavyPart<bucket_num>::insert(uint8_t *key, uint8_t *swap_key, uint32_t &swap_val, uint32_t f) {
-    uint32_t fp;
-    int pos = CalculateFP(key, fp);
-    uint32_t min_counter_val;
-    int min_counter;
-#ifdef USING_SIMD_ACCELERATION
-    do {
-        /* find if there has matched bucket */
-        const __m256i item = _mm256_set1_epi32((int) fp);
-        __m256i *keys_p = (__m256i *) (buckets[pos].key);
-        int matched = 0;
-
-        __m256i a_comp = _mm256_cmpeq_epi32(item, keys_p[0]);
-        matched = _mm256_movemask_ps((__m256) a_comp);
+HeavyPart::HeavyPart(int bucket_num) : buckets(std::max(bucket_num, 1)) { this->clear(); }
 
-        /* if matched */
-        if (matched != 0) {
-            // return 32 if input is zero;
-            int matched_index = _tzcnt_u32((uint32_t) matched);
-            buckets[pos].val[matched_index] += f;
-            return 0;
-        }
-
-        /* find the minimal bucket */
-        const uint32_t mask_base = 0x7FFFFFFF;
-        const __m256i *counters = (__m256i *) (buckets[pos].val);
-        __m256 masks = (__m256) _mm256_set1_epi32(mask_base);
-        __m256 results = (_mm256_and_ps(*(__m256 *) counters, masks));
-        __m256 mask2 = (__m256) _mm256_set_epi32(mask_base, 0, 0, 0, 0, 0, 0, 0);
-        results = _mm256_or_ps(results, mask2);
-
-        __m128i low_part = _mm_castps_si128(_mm256_extractf128_ps(results, 0));
-        __m128i high_part = _mm_castps_si128(_mm256_extractf128_ps(results, 1));
+void HeavyPart::clear() { std::fill(buckets.begin(), buckets.end(), Bucket{}); }
 
-        __m128i x = _mm_min_epi32(low_part, high_part);
-        __m128i min1 = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 0, 3, 2));
-        __m128i min2 = _mm_min_epi32(x, min1);
-        __m128i min3 = _mm_shuffle_epi32(min2, _MM_SHUFFLE(0, 0, 0, 1));
-        __m128i min4 = _mm_min_epi32(min2, min3);
-        min_counter_val = _mm_cvtsi128_si32(min4);
+int HeavyPart::Lookup(const Bucket &bucket, uint32_t key, bool &matched, uint32_t &min_val) {
+    if (use_avx2) { return lookup_avx2(bucket, key, matched, min_val); }
 
-        const __m256i ct_item = _mm256_set1_epi32(min_counter_val);
-        int ct_matched = 0;
-
-        __m256i ct_a_comp = _mm256_cmpeq_epi32(ct_item, (__m256i) results);
-        matched = _mm256_movemask_ps((__m256) ct_a_comp);
-        min_counter = _tzcnt_u32((uint32_t) matched);
-
-        /* if there has empty bucket */
-        if (min_counter_val == 0) {   // empty counter
-            buckets[pos].key[min_counter] = fp;
-            buckets[pos].val[min_counter] = f;
-            return 0;
+    int min_counter = 0;
+    min_val = GetCounterVal(bucket.val[0]);
+    for (int i = 0; i < MAX_VALID_COUNTER; i++) {
+        if (bucket.key[i] == key) {
+            matched = true;
+            return i;
         }
-    } while (0);
-
-#else    // USING_SIMD_ACCELERATION
-    do {
-        /* find if there has matched bucket */
-        int matched = -1, empty = -1;
-        min_counter = 0;
-        min_counter_val = GetCounterVal(buckets[pos].val[0]);
-        for (int i = 0; i < COUNTER_PER_BUCKET - 1; i++) {
-            if (buckets[pos].key[i] == fp) {
-                matched = i;
-                break;
-            }
-            if (buckets[pos].key[i] == 0 && empty == -1) empty = i;
-            if (min_counter_val > GetCounterVal(buckets[pos].val[i])) {
-                min_counter = i;
-                min_counter_val = GetCounterVal(buckets[pos].val[i]);
-            }
+        if (GetCounterVal(bucket.val[i]) < min_val) {
+            min_counter = i;
+            min_val = GetCounterVal(bucket.val[i]);
         }
+    }
+    matched = false;
+    return min_counter;
+}
 
-        /* if matched */
-        if (matched != -1) {
-            buckets[pos].val[matched] += f;
-            return 0;
-        }
+int HeavyPart::insert(uint32_t key, uint32_t &swap_key, uint32_t &swap_val, uint32_t f) {
+    Bucket &bucket = buckets[CalculatePos(key)];
+    bool matched;
+    uint32_t min_counter_val;
+    int slot = Lookup(bucket, key, matched, min_counter_val);
 
-        /* if there has empty bucket */
-        if (empty != -1) {
-            buckets[pos].key[empty] = fp;
-            buckets[pos].val[empty] = f;
-            return 0;
-        }
-    } while (0);
-#endif   // USING_SIMD_ACCELERATION
+    /* if matched */
+    if (matched) {
+        bucket.val[slot] += f;
+        return 0;
+    }
 
-    /* update guard val and comparison */
-    uint32_t guard_val = buckets[pos].val[MAX_VALID_COUNTER];
-    guard_val = UPDATE_GUARD_VAL(guard_val);
+    /* if there has empty bucket */
+    if (min_counter_val == 0) {
+        bucket.key[slot] = key;
+        bucket.val[slot] = f;
+        return 0;
+    }
 
-    if (!JUDGE_IF_SWAP(GetCounterVal(min_counter_val), guard_val)) {
-        buckets[pos].val[MAX_VALID_COUNTER] = guard_val;
+    /* update guard val and comparison, every unit of the weight is a vote against the smallest entry */
+    uint32_t guard_val = UPDATE_GUARD_VAL(bucket.val[MAX_VALID_COUNTER], f);
+    if (!JUDGE_IF_SWAP(min_counter_val, guard_val)) {
+        bucket.val[MAX_VALID_COUNTER] = guard_val;
         return 2;
     }
 
-    *((uint32_t *) swap_key) = buckets[pos].key[min_counter];
-    swap_val = buckets[pos].val[min_counter];
-
-    buckets[pos].val[MAX_VALID_COUNTER] = 0;
-    buckets[pos].key[min_counter] = fp;
-    buckets[pos].val[min_counter] = 0x80000001;
+    swap_key = bucket.key[slot];
+    swap_val = bucket.val[slot];
 
+    bucket.val[MAX_VALID_COUNTER] = 0;
+    bucket.key[slot] = key;
+    bucket.val[slot] = 0x80000000 | f;
     return 1;
 }
 
-template <int bucket_num> int HeavyPart<bucket_num>::quick_insert(uint8_t *key, uint32_t f) {
-    uint32_t fp;
-    int pos = CalculateFP(key, fp);
+int HeavyPart::quick_insert(uint32_t key, uint32_t f) {
+    Bucket &bucket = buckets[CalculatePos(key)];
+    bool matched;
     uint32_t min_counter_val;
-    int min_counter;
-#ifdef USING_SIMD_ACCELERATION
-    do {
-        /* find if there has matched bucket */
-        const __m256i item = _mm256_set1_epi32((int) fp);
-        __m256i *keys_p = (__m256i *) (buckets[pos].key);
-        int matched = 0;
-
-        __m256i a_comp = _mm256_cmpeq_epi32(item, keys_p[0]);
-        matched = _mm256_movemask_ps((__m256) a_comp);
-
-        /* if matched */
-        if (matched != 0) {
-            // return 32 if input is zero;
-            int matched_index = _tzcnt_u32((uint32_t) matched);
-            buckets[pos].val[matched_index] += f;
-            return 0;
-        }
+    int slot = Lookup(bucket, key, matched, min_counter_val);
 
-        /* find the minimal bucket */
-        const uint32_t mask_base = 0x7FFFFFFF;
-        const __m256i *counters = (__m256i *) (buckets[pos].val);
-        __m256 masks = (__m256) _mm256_set1_epi32(mask_base);
-        __m256 results = (_mm256_and_ps(*(__m256 *) counters, masks));
-        __m256 mask2 = (__m256) _mm256_set_epi32(mask_base, 0, 0, 0, 0, 0, 0, 0);
-        results = _mm256_or_ps(results, mask2);
-
-        __m128i low_part = _mm_castps_si128(_mm256_extractf128_ps(results, 0));
-        __m128i high_part = _mm_castps_si128(_mm256_extractf128_ps(results, 1));
-
-        __m128i x = _mm_min_epi32(low_part, high_part);
-        __m128i min1 = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 0, 3, 2));
-        __m128i min2 = _mm_min_epi32(x, min1);
-        __m128i min3 = _mm_shuffle_epi32(min2, _MM_SHUFFLE(0, 0, 0, 1));
-        __m128i min4 = _mm_min_epi32(min2, min3);
-        min_counter_val = _mm_cvtsi128_si32(min4);
-
-        const __m256i ct_item = _mm256_set1_epi32(min_counter_val);
-        int ct_matched = 0;
-
-        __m256i ct_a_comp = _mm256_cmpeq_epi32(ct_item, (__m256i) results);
-        matched = _mm256_movemask_ps((__m256) ct_a_comp);
-        min_counter = _tzcnt_u32((uint32_t) matched);
-
-        /* if there has empty bucket */
-        if (min_counter_val == 0) {   // empty counter
-            buckets[pos].key[min_counter] = fp;
-            buckets[pos].val[min_counter] = f;
-            return 0;
-        }
-    } while (0);
-
-#else    // USING_SIMD_ACCELERATION
-    do {
-        /* find if there has matched bucket */
-        int matched = -1, empty = -1;
-        min_counter = 0;
-        min_counter_val = GetCounterVal(buckets[pos].val[0]);
-        for (int i = 0; i < COUNTER_PER_BUCKET - 1; i++) {
-            if (buckets[pos].key[i] == fp) {
-                matched = i;
-                break;
-            }
-            if (buckets[pos].key[i] == 0 && empty == -1) empty = i;
-            if (min_counter_val > GetCounterVal(buckets[pos].val[i])) {
-                min_counter = i;
-                min_counter_val = GetCounterVal(buckets[pos].val[i]);
-            }
-        }
-
-        /* if matched */
-        if (matched != -1) {
-            buckets[pos].val[matched] += f;
-            return 0;
-        }
-
-        /* if there has empty bucket */
-        if (empty != -1) {
-            buckets[pos].key[empty] = fp;
-            buckets[pos].val[empty] = f;
-            return 0;
-        }
-    } while (0);
-#endif   // USING_SIMD_ACCELERATION
-
-    /* update guard val and comparison */
-    uint32_t guard_val = buckets[pos].val[MAX_VALID_COUNTER];
-    guard_val = UPDATE_GUARD_VAL(guard_val);
+    if (matched) {
+        bucket.val[slot] += f;
+        return 0;
+    }
+    if (min_counter_val == 0) {
+        bucket.key[slot] = key;
+        bucket.val[slot] = f;
+        return 0;
+    }
 
-    if (!JUDGE_IF_SWAP(GetCounterVal(min_counter_val), guard_val)) {
-        buckets[pos].val[MAX_VALID_COUNTER] = guard_val;
+    uint32_t guard_val = UPDATE_GUARD_VAL(bucket.val[MAX_VALID_COUNTER], f);
+    if (!JUDGE_IF_SWAP(min_counter_val, guard_val)) {
+        bucket.val[MAX_VALID_COUNTER] = guard_val;
         return 2;
     }
-    buckets[pos].val[MAX_VALID_COUNTER] = 0;
-    buckets[pos].key[min_counter] = fp;
+    // the new key takes over the count of the evicted one
+    bucket.val[MAX_VALID_COUNTER] = 0;
+    bucket.key[slot] = key;
     return 1;
 }
 
-template <int bucket_num> int HeavyPart<bucket_num>::query(uint8_t *key) {
-    uint32_t fp;
-    int pos = CalculateFP(key, fp);
-
-#ifdef USING_SIMD_ACCELERATION
-    do {
-        /* find if there has matched bucket */
-        const __m256i item = _mm256_set1_epi32((int) fp);
-        __m256i *keys_p = (__m256i *) (buckets[pos].key);
-        int matched = 0;
-
-        __m256i a_comp = _mm256_cmpeq_epi32(item, keys_p[0]);
-        matched = _mm256_movemask_ps((__m256) a_comp);
-
-        /* if matched */
-        if (matched != 0) {
-            // return 32 if input is zero;
-            int matched_index = _tzcnt_u32((uint32_t) matched);
-            return buckets[pos].val[matched_index];
-        }
-    } while (0);
-#else
-    for (int i = 0; i < MAX_VALID_COUNTER; ++i)
-        if (buckets[pos].key[i] == fp) return buckets[pos].val[i];
-#endif
-
-    return 0;
+uint32_t HeavyPart::query(uint32_t key) {
+    Bucket &bucket = buckets[CalculatePos(key)];
+    bool matched;
+    uint32_t min_counter_val;
+    int slot = Lookup(bucket, key, matched, min_counter_val);
+    return matched ? bucket.val[slot] : 0;
 }
 
-template <int bucket_num> int HeavyPart<bucket_num>::get_memory_usage() {
-    return bucket_num * sizeof(Bucket);
-}
+int HeavyPart::get_memory_usage() const { return buckets.size() * sizeof(Bucket); }
 
-template <int bucket_num> int HeavyPart<bucket_num>::get_bucket_num() { return bucket_num; }
+int HeavyPart::get_bucket_num() { return buckets.size(); }
 
-template <int bucket_num> int HeavyPart<bucket_num>::CalculateFP(uint8_t *key, uint32_t &fp) {
-    fp = *((uint32_t *) key);
-    return CalculateBucketPos(fp) % bucket_num;
-}
\ No newline at end of file
+int HeavyPart::CalculatePos(uint32_t key) {
+    // multiplicative hashing, the high bits pick the bucket
+    return (uint64_t(key * CONSTANT_NUMBER) * buckets.size()) >> 32;
+}
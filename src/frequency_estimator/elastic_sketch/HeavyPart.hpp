@@ -1,26 +1,32 @@
 #pragma once
 #include "Bucket.hpp"
 #include <stdint.h>
+#include <vector>
 
-#define USING_SIMD_ACCELERATION
-
-template <int bucket_num> class HeavyPart {
-    alignas(64) Bucket buckets[bucket_num];
+// heavy part with bucket_num buckets allocated at construction, keys are 32 bits and kept as they are
+class HeavyPart {
+    std::vector<Bucket> buckets;
 
   public:
-    HeavyPart();
-    ~HeavyPart();
+    explicit HeavyPart(int bucket_num = 1);
+
+    // take the AVX2 lookup, on when the cpu has it (off to check the scalar lookup against it)
+    bool use_avx2 = __builtin_cpu_supports("avx2");
 
     void clear();
 
-    int insert(uint8_t *key, uint8_t *swap_key, uint32_t &swap_val, uint32_t f = 1);
-    int quick_insert(uint8_t *key, uint32_t f = 1);
+    // 0: counted in the heavy part, 1: swap_key with swap_val was evicted, 2: goes to the light part
+    int insert(uint32_t key, uint32_t &swap_key, uint32_t &swap_val, uint32_t f = 1);
+    int quick_insert(uint32_t key, uint32_t f = 1);
 
-    int query(uint8_t *key);
+    uint32_t query(uint32_t key);
 
-    int get_memory_usage();
+    const Bucket &get_bucket(int i) const { return buckets[i]; }
+    int get_memory_usage() const;
     int get_bucket_num();
 
   private:
-    int CalculateFP(uint8_t *key, uint32_t &fp);
-};
\ No newline at end of file
+    int CalculatePos(uint32_t key);
+    // slot of key when matched, otherwise the slot with the smallest count (min_val)
+    int Lookup(const Bucket &bucket, uint32_t key, bool &matched, uint32_t &min_val);
+};
@@ -1,26 +1,26 @@
 #include "LightPart.hpp"
 #include "params.hpp"
-#include <cstring>   // Add this line
+#include <algorithm>
+#include <cstring>
 #include <math.h>
 #include <random>
 #include <string>
 
-template <int init_mem_in_bytes> LightPart<init_mem_in_bytes>::LightPart() {
+LightPart::LightPart(int counter_num) : counters(std::max(counter_num, 1)) {
     this->clear();
     std::random_device rd;
-    bobhash = new BOBHash32(rd() % MAX_PRIME32);
+    bobhash = BOBHash32(rd() % MAX_PRIME32);
 }
 
-template <int init_mem_in_bytes> LightPart<init_mem_in_bytes>::~LightPart() { delete bobhash; }
-
-template <int init_mem_in_bytes> void LightPart<init_mem_in_bytes>::clear() {
-    std::memset(counters, 0, counter_num);          // Use std::memset instead of memset
-    std::memset(mice_dist, 0, sizeof(int) * 256);   // Use std::memset instead of memset
+void LightPart::clear() {
+    std::fill(counters.begin(), counters.end(), 0);
+    std::memset(mice_dist, 0, sizeof(int) * 256);
 }
 
-template <int init_mem_in_bytes> void LightPart<init_mem_in_bytes>::insert(uint8_t *key, int f) {
-    uint32_t hash_val = (uint32_t) bobhash->run((const char *) key, KEY_LENGTH_4);
-    uint32_t pos = hash_val % (uint32_t) counter_num;
+uint32_t LightPart::CalculatePos(uint32_t key) { return bobhash.run((const char *) &key, KEY_LENGTH_4) % (uint32_t) counters.size(); }
+
+void LightPart::insert(uint32_t key, int f) {
+    uint32_t pos = CalculatePos(key);
 
     /* insert */
     int old_val = (int) counters[pos];
@@ -33,10 +33,8 @@ template <int init_mem_in_bytes> void LightPart<init_mem_in_bytes>::insert(uint8
     mice_dist[new_val]++;
 }
 
-template <int init_mem_in_bytes>
-void LightPart<init_mem_in_bytes>::swap_insert(uint8_t *key, int f) {
-    uint32_t hash_val = (uint32_t) bobhash->run((const char *) key, KEY_LENGTH_4);
-    uint32_t pos = hash_val % (uint32_t) counter_num;
+void LightPart::swap_insert(uint32_t key, int f) {
+    uint32_t pos = CalculatePos(key);
 
     /* swap_insert */
     f = f < 255 ? f : 255;
@@ -50,47 +48,33 @@ void LightPart<init_mem_in_bytes>::swap_insert(uint8_t *key, int f) {
     }
 }
 
-template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::query(uint8_t *key) {
-    uint32_t hash_val = (uint32_t) bobhash->run((const char *) key, KEY_LENGTH_4);
-    uint32_t pos = hash_val % (uint32_t) counter_num;
+int LightPart::query(uint32_t key) { return (int) counters[CalculatePos(key)]; }
 
-    return (int) counters[pos];
-}
-
-template <int init_mem_in_bytes>
-void LightPart<init_mem_in_bytes>::compress(int ratio, uint8_t *dst) {
+void LightPart::compress(int ratio, uint8_t *dst) {
+    int counter_num = counters.size();
     int width = get_compress_width(ratio);
 
     for (int i = 0; i < width && i < counter_num; ++i) {
         uint8_t max_val = 0;
-        for (int j = i; j < counter_num; j += width)
-            max_val = counters[j] > max_val ? counters[j] : max_val;
+        for (int j = i; j < counter_num; j += width) max_val = counters[j] > max_val ? counters[j] : max_val;
         dst[i] = max_val;
     }
 }
 
-template <int init_mem_in_bytes>
-int LightPart<init_mem_in_bytes>::query_compressed_part(uint8_t *key, uint8_t *compress_part,
-                                                        int compress_counter_num) {
-    uint32_t hash_val = (uint32_t) bobhash->run((const char *) key, KEY_LENGTH_4);
-    uint32_t pos = (hash_val % (uint32_t) counter_num) % compress_counter_num;
+int LightPart::query_compressed_part(uint32_t key, uint8_t *compress_part, int compress_counter_num) {
+    uint32_t pos = CalculatePos(key) % compress_counter_num;
 
     return (int) compress_part[pos];
 }
 
-template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::get_compress_width(int ratio) {
-    return (counter_num / ratio);
-}
+int LightPart::get_compress_width(int ratio) { return (counters.size() / ratio); }
 
-template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::get_compress_memory(int ratio) {
-    return (uint32_t) (counter_num / ratio);
-}
+int LightPart::get_compress_memory(int ratio) { return (uint32_t) (counters.size() / ratio); }
 
-template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::get_memory_usage() {
-    return counter_num;
-}
+int LightPart::get_memory_usage() const { return counters.size(); }
 
-template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::get_cardinality() {
+int LightPart::get_cardinality() {
+    int counter_num = counters.size();
     int mice_card = 0;
     for (int i = 1; i < 256; i++) mice_card += mice_dist[i];
 
@@ -98,32 +82,19 @@ template <int init_mem_in_bytes> int LightPart<init_mem_in_bytes>::get_cardinali
     return counter_num * log(1 / rate);
 }
 
-template <int init_mem_in_bytes>
-void LightPart<init_mem_in_bytes>::get_entropy(int &tot, double &entr) {
+void LightPart::get_entropy(int &tot, double &entr) {
     for (int i = 1; i < 256; i++) {
         tot += mice_dist[i] * i;
         entr += mice_dist[i] * i * log2(i);
     }
 }
 
-template <int init_mem_in_bytes>
-void LightPart<init_mem_in_bytes>::get_distribution(vector<double> &dist) {
-    uint32_t tmp_counters[counter_num];
-    for (int i = 0; i < counter_num; i++) tmp_counters[i] = counters[i];
-
-    em_fsd_algo = new EMFSD();
-    em_fsd_algo->set_counters(counter_num, tmp_counters);
-
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-    em_fsd_algo->next_epoch();
-
-    dist = em_fsd_algo->ns;
-}
\ No newline at end of file
+void LightPart::get_distribution(vector<double> &dist) {
+    std::vector<uint32_t> tmp_counters(counters.begin(), counters.end());
+
+    EMFSD em_fsd_algo;
+    em_fsd_algo.set_counters(tmp_counters.size(), tmp_counters.data());
+    for (int epoch = 0; epoch < 10; epoch++) { em_fsd_algo.next_epoch(); }
+
+    dist = em_fsd_algo.ns;
+}
@@ -2,32 +2,33 @@
 #include "EMFSD.hpp"
 #include "hash/BOBHash32.hpp"
 #include <stdint.h>
+#include <vector>
 
-template <int init_mem_in_bytes> class LightPart {
-    static constexpr int counter_num = init_mem_in_bytes;
-    BOBHash32 *bobhash = NULL;
-
-    uint8_t counters[counter_num];
+// light part with counter_num one-byte counters allocated at construction
+class LightPart {
+    std::vector<uint8_t> counters;
     int mice_dist[256];
-    EMFSD *em_fsd_algo = NULL;
+    BOBHash32 bobhash;
 
   public:
-    LightPart();
-    ~LightPart();
+    explicit LightPart(int counter_num = 1);
 
     void clear();
 
-    void insert(uint8_t *key, int f = 1);
-    void swap_insert(uint8_t *key, int f);
-    int query(uint8_t *key);
+    void insert(uint32_t key, int f = 1);
+    void swap_insert(uint32_t key, int f);
+    int query(uint32_t key);
 
     void compress(int ratio, uint8_t *dst);
-    int query_compressed_part(uint8_t *key, uint8_t *compress_part, int compress_counter_num);
+    int query_compressed_part(uint32_t key, uint8_t *compress_part, int compress_counter_num);
     int get_compress_width(int ratio);
     int get_compress_memory(int ratio);
-    int get_memory_usage();
+    int get_memory_usage() const;
 
     int get_cardinality();
     void get_entropy(int &tot, double &entr);
     void get_distribution(vector<double> &dist);
-};
\ No newline at end of file
+
+  private:
+    uint32_t CalculatePos(uint32_t key);
+};
@@ -12,14 +12,13 @@
 #define KEY_LENGTH_4  4
 #define KEY_LENGTH_13 13
 
-#define CONSTANT_NUMBER        2654435761u
-#define CalculateBucketPos(fp) (((fp) * CONSTANT_NUMBER) >> 15)
+#define CONSTANT_NUMBER 2654435761u
 
 #define GetCounterVal(val) ((uint32_t) ((val) & 0x7FFFFFFF))
 
 #define JUDGE_IF_SWAP(min_val, guard_val) ((guard_val) > ((min_val) << 3))
 
-#define UPDATE_GUARD_VAL(guard_val) ((guard_val) + 1)
+#define UPDATE_GUARD_VAL(guard_val, f) ((guard_val) + (f))
 
 #define SWAP_MIN_VAL_THRESHOLD 5
 
@@ -20,6 +20,8 @@ struct CommonAppConfig {
     string DATASET;
     float THETA;
     int DURATION;
+    string WEIGHTS;
+    double WEIGHT_PARAM;
 
     static void add_params_to_config_parser(CommonAppConfig &app_config, ConfigParser &parser) {
         // App configs prefix will be "app."
@@ -31,14 +33,17 @@ struct CommonAppConfig {
         parser.AddParameter(new IntParameter("delegation.dist_type", "1", &app_config.DIST_TYPE, false, "Distribution type for the dataset"));
         parser.AddParameter(new DoubleParameter("app.dist_param", "1.3", &app_config.DIST_PARAM, false, "Distribution parameter for the dataset"));
         parser.AddParameter(new DoubleParameter("app.dist_shuff", "0", &app_config.DIST_SHUFF, false, "Distribution shuffle for the dataset"));
-        parser.AddParameter(new StringParameter("app.dataset", "zipf", &app_config.DATASET, false, "Dataset: WebDocs/AdTracking/CAIDA_L/CAIDA_H/zipf"));
+        parser.AddParameter(new StringParameter("app.dataset", "zipf", &app_config.DATASET, false, "Dataset: WebDocs/AdTracking/CAIDA_L/CAIDA_H/CAIDA_5TUPLE/zipf"));
         parser.AddParameter(new FloatParameter("app.theta", "0.01", &app_config.THETA, false, "Theta value for the finding heavy hitters"));
         parser.AddParameter(new IntParameter("app.duration", "1", &app_config.DURATION, false, "Duration of the benchmark"));
+        parser.AddParameter(new StringParameter("app.weights", "unit", &app_config.WEIGHTS, false, "Weights of the stream items: unit/pareto"));
+        parser.AddParameter(new DoubleParameter("app.weight_param", "1.2", &app_config.WEIGHT_PARAM, false, "Shape (alpha) of the pareto weights, smaller is heavier-tailed"));
     }
 
     auto to_tuple() const {
         return std::make_tuple("MODE", MODE, "NUM_RUNS", NUM_RUNS, "LINE_READ", LINE_READ, "DOM_SIZE", DOM_SIZE, "tuples_no", tuples_no, "DIST_TYPE", DIST_TYPE, "DIST_PARAM",
-                               DIST_PARAM, "DIST_SHUFF", DIST_SHUFF, "DATASET", DATASET, "THETA", THETA, "DURATION", DURATION);
+                               DIST_PARAM, "DIST_SHUFF", DIST_SHUFF, "DATASET", DATASET, "THETA", THETA, "DURATION", DURATION, "WEIGHTS", WEIGHTS,
+                               "WEIGHT_PARAM", WEIGHT_PARAM);
     }
 
     friend std::ostream &operator<<(std::ostream &os, const CommonAppConfig &config) {
@@ -56,15 +61,18 @@ struct SequentialAppConfig : public CommonAppConfig {
 
 struct ParallelAppConfig : public CommonAppConfig {
     int NUM_THREADS;
+    std::string PLACEMENT;
 
     static void add_params_to_config_parser(ParallelAppConfig &parallel_app_config, ConfigParser &parser) {
         CommonAppConfig::add_params_to_config_parser(parallel_app_config, parser);
         parser.AddParameter(new IntParameter("app.num_threads", "20", &parallel_app_config.NUM_THREADS, false, "Number of threads for the parallel application"));
+        parser.AddParameter(new StringParameter("app.placement", "sequential", &parallel_app_config.PLACEMENT, false,
+                                                "Thread placement policy: sequential/compact/scatter/core/numa"));
     }
 
     auto to_tuple() const {
         auto common_tuple = CommonAppConfig::to_tuple();
-        return std::tuple_cat(common_tuple, std::make_tuple("NUM_THREADS", NUM_THREADS));
+        return std::tuple_cat(common_tuple, std::make_tuple("NUM_THREADS", NUM_THREADS, "PLACEMENT", PLACEMENT));
     }
 
     friend std::ostream &operator<<(std::ostream &os, const ParallelAppConfig &config) {
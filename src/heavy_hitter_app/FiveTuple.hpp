@@ -0,0 +1,60 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// flow key of the CAIDA traces (13 bytes of payload, padded to 16 in memory)
+struct FiveTuple {
+    uint32_t src_ip = 0;
+    uint32_t dst_ip = 0;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t protocol = 0;
+
+    auto operator<=>(const FiveTuple &) const = default;
+    bool operator==(const FiveTuple &) const = default;
+
+    // synthetic flow for integer datasets (e.g. zipf), distinct ids give distinct flows
+    static FiveTuple from_id(uint32_t id) { return {id, ~id, uint16_t(id), uint16_t(id >> 16), 6}; }
+};
+
+inline uint32_t parse_ipv4(const std::string &ip) {
+    std::stringstream ss(ip);
+    std::string octet;
+    uint32_t result = 0;
+    for (int j = 0; j < 4 && std::getline(ss, octet, '.'); j++) { result = (result << 8) + std::stoi(octet); }
+    return result;
+}
+
+// "src_ip,dst_ip,src_port,dst_port,protocol" with dotted IPv4 addresses
+inline FiveTuple parse_five_tuple(const std::string &line) {
+    std::stringstream ss(line);
+    std::string src_ip, dst_ip, src_port, dst_port, protocol;
+    std::getline(ss, src_ip, ',');
+    std::getline(ss, dst_ip, ',');
+    std::getline(ss, src_port, ',');
+    std::getline(ss, dst_port, ',');
+    std::getline(ss, protocol, ',');
+    return {parse_ipv4(src_ip), parse_ipv4(dst_ip), uint16_t(std::stoi(src_port)), uint16_t(std::stoi(dst_port)), uint8_t(std::stoi(protocol))};
+}
+
+inline std::string to_string(const FiveTuple &key) {
+    auto ip = [](uint32_t ip) {
+        return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 255) + "." + std::to_string((ip >> 8) & 255) + "." + std::to_string(ip & 255);
+    };
+    return ip(key.src_ip) + ":" + std::to_string(key.src_port) + "->" + ip(key.dst_ip) + ":" + std::to_string(key.dst_port) + "/" + std::to_string(key.protocol);
+}
+
+inline std::ostream &operator<<(std::ostream &os, const FiveTuple &key) { return os << to_string(key); }
+
+template <> struct std::hash<FiveTuple> {
+    size_t operator()(const FiveTuple &key) const noexcept {
+        uint64_t hi = (uint64_t(key.src_ip) << 32) | key.dst_ip;
+        uint64_t lo = (uint64_t(key.src_port) << 24) | (uint64_t(key.dst_port) << 8) | key.protocol;
+        return std::hash<uint64_t>()(hi * 0x9E3779B97F4A7C15ULL ^ lo);
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "heavy_hitter_app/FiveTuple.hpp"
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Flows of a packet trace in the classic libpcap format, the format the CAIDA Anonymized Internet Traces are distributed in
+// (equinix-*.pcap.gz, gunzipped). CAIDA traces hold bare IP packets (LINKTYPE_RAW), Ethernet and Linux cooked captures are read too.
+// Only IPv4 packets are kept; the ports of protocols other than TCP and UDP, of non-first fragments and of truncated headers are 0.
+static constexpr uint32_t PCAP_MAGIC_MICROSECONDS = 0xa1b2c3d4;
+static constexpr uint32_t PCAP_MAGIC_NANOSECONDS = 0xa1b23c4d;
+
+static constexpr uint32_t PCAP_LINKTYPE_ETHERNET = 1;
+static constexpr uint32_t PCAP_LINKTYPE_RAW = 101;
+static constexpr uint32_t PCAP_LINKTYPE_LINUX_SLL = 113;
+// DLT_RAW as written by some BSD and OpenBSD libpcap versions
+static constexpr uint32_t PCAP_DLT_RAW_BSD = 12;
+static constexpr uint32_t PCAP_DLT_RAW_OPENBSD = 14;
+
+inline uint32_t pcap_byte_swap(uint32_t value) { return __builtin_bswap32(value); }
+
+// network byte order fields of the packet headers
+inline uint16_t read_be16(const unsigned char *p) { return uint16_t(p[0] << 8 | p[1]); }
+inline uint32_t read_be32(const unsigned char *p) { return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3]; }
+
+inline bool is_pcap_file(const std::string &filename) {
+    std::ifstream in_file(filename, std::ios::binary);
+    uint32_t magic = 0;
+    if (!in_file.read(reinterpret_cast<char *>(&magic), sizeof(magic))) { return false; }
+    for (uint32_t expected : {PCAP_MAGIC_MICROSECONDS, PCAP_MAGIC_NANOSECONDS}) {
+        if (magic == expected || magic == pcap_byte_swap(expected)) { return true; }
+    }
+    return false;
+}
+
+// offset of the IPv4 header in a captured frame, -1 if the frame does not carry IPv4
+inline int pcap_ipv4_offset(uint32_t link_type, const unsigned char *frame, uint32_t length) {
+    switch (link_type) {
+    case PCAP_LINKTYPE_RAW:
+    case PCAP_DLT_RAW_BSD:
+    case PCAP_DLT_RAW_OPENBSD: return 0;
+    case PCAP_LINKTYPE_LINUX_SLL: return length >= 16 && read_be16(frame + 14) == 0x0800 ? 16 : -1;
+    case PCAP_LINKTYPE_ETHERNET: {
+        uint32_t offset = 12;
+        // 802.1Q and 802.1ad tags in front of the ethertype
+        while (offset + 2 <= length && (read_be16(frame + offset) == 0x8100 || read_be16(frame + offset) == 0x88a8)) { offset += 4; }
+        if (offset + 2 > length || read_be16(frame + offset) != 0x0800) { return -1; }
+        return offset + 2;
+    }
+    default: throw std::runtime_error("Unsupported pcap link type " + std::to_string(link_type));
+    }
+}
+
+// the flow of an IPv4 packet, false if the bytes are not a complete IPv4 header
+inline bool parse_ipv4_five_tuple(const unsigned char *packet, uint32_t length, FiveTuple &flow) {
+    if (length < 20 || (packet[0] >> 4) != 4) { return false; }
+    uint32_t header_length = (packet[0] & 0x0f) * 4;
+    if (header_length < 20 || header_length > length) { return false; }
+
+    flow = FiveTuple{};
+    flow.protocol = packet[9];
+    flow.src_ip = read_be32(packet + 12);
+    flow.dst_ip = read_be32(packet + 16);
+    bool is_first_fragment = (read_be16(packet + 6) & 0x1fff) == 0;
+    if ((flow.protocol == 6 || flow.protocol == 17) && is_first_fragment && header_length + 4 <= length) {
+        flow.src_port = read_be16(packet + header_length);
+        flow.dst_port = read_be16(packet + header_length + 2);
+    }
+    return true;
+}
+
+// appends the flows of up to max_flows IPv4 packets of the trace, returns the number of flows appended
+inline size_t read_pcap_five_tuples(const std::string &filename, size_t max_flows, std::vector<FiveTuple> &flows) {
+    std::ifstream in_file(filename, std::ios::binary);
+    if (!in_file) { throw std::runtime_error("Unable to open pcap file " + filename); }
+
+    // magic, version (2 + 2), thiszone, sigfigs, snaplen, link type
+    uint32_t header[6];
+    if (!in_file.read(reinterpret_cast<char *>(header), sizeof(header))) { throw std::runtime_error("Truncated pcap header in " + filename); }
+    bool swapped = header[0] == pcap_byte_swap(PCAP_MAGIC_MICROSECONDS) || header[0] == pcap_byte_swap(PCAP_MAGIC_NANOSECONDS);
+    if (!swapped && header[0] != PCAP_MAGIC_MICROSECONDS && header[0] != PCAP_MAGIC_NANOSECONDS) { throw std::runtime_error(filename + " is not a pcap file"); }
+    auto host_order = [swapped](uint32_t value) { return swapped ? pcap_byte_swap(value) : value; };
+    uint32_t link_type = host_order(header[5]) & 0x0fffffff;   // the upper bits hold FCS flags
+
+    size_t num_flows = 0;
+    std::vector<unsigned char> frame;
+    // ts_sec, ts_usec, captured length, original length
+    uint32_t record[4];
+    while (num_flows < max_flows && in_file.read(reinterpret_cast<char *>(record), sizeof(record))) {
+        uint32_t captured_length = host_order(record[2]);
+        frame.resize(captured_length);
+        if (!in_file.read(reinterpret_cast<char *>(frame.data()), captured_length)) { throw std::runtime_error("Truncated packet record in " + filename); }
+
+        int offset = pcap_ipv4_offset(link_type, frame.data(), captured_length);
+        FiveTuple flow;
+        if (offset < 0 || !parse_ipv4_five_tuple(frame.data() + offset, captured_length - offset, flow)) { continue; }
+        flows.push_back(flow);
+        num_flows++;
+    }
+    return num_flows;
+}
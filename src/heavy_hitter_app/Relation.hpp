@@ -1,6 +1,18 @@
 
 #pragma once
 
+#include "heavy_hitter_app/FiveTuple.hpp"
+#include "heavy_hitter_app/PcapReader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
 unsigned int generate_uniform(unsigned int sizedom, double totalmass, vector<unsigned int> &f);
 unsigned int generate_uniform_limited(unsigned int sizedom, double totalmass, double cutoff, vector<unsigned int> &f);
 unsigned int generate_zipf(unsigned int sizedom, double totalmass, double zipf_param, vector<unsigned int> &f);
@@ -17,11 +29,27 @@ class Relation {
     unsigned int dom_size;
     unsigned int tuples_no;
     vector<unsigned int> *tuples;
+    vector<FiveTuple> *flow_tuples;   // only filled by the CAIDA_5TUPLE dataset
+    vector<unsigned int> *weights;    // weight of every tuple, NULL for unit weights
 
     Relation(unsigned int dom_size, unsigned int tuples_no);
     virtual ~Relation();
 
     void Generate_Data(int type, double data_param, double decor_param);
+    // weights for the tuples, "unit" or "pareto": heavy-tailed like packet sizes or request costs, P(w >= x) = x^-param, capped at MAX_WEIGHT
+    void Generate_Weights(const string &distribution, double param);
+
+    static constexpr unsigned int MAX_WEIGHT = 1 << 16;
+    unsigned int weight_at(unsigned int i) const { return weights ? (*weights)[i] : 1; }
+
+    // i-th item of the stream as the key type of the benchmark, integer datasets are mapped to synthetic flows
+    template <typename KeyType> KeyType key_at(unsigned int i) const {
+        if constexpr (std::is_same_v<KeyType, FiveTuple>) {
+            return flow_tuples ? (*flow_tuples)[i] : FiveTuple::from_id((*tuples)[i]);
+        } else {
+            return (*tuples)[i];
+        }
+    }
 };
 
 template <typename AppConfig> Relation *generate_relation(AppConfig &app_configs);
@@ -161,6 +189,8 @@ Relation::Relation(unsigned int dom_size, unsigned int tuples_no) {
 
     this->tuples_no = tuples_no;
     tuples = NULL;
+    flow_tuples = NULL;
+    weights = NULL;
 }
 
 Relation::~Relation() {
@@ -169,6 +199,10 @@ Relation::~Relation() {
 
     delete tuples;
     tuples = NULL;
+    delete flow_tuples;
+    flow_tuples = NULL;
+    delete weights;
+    weights = NULL;
 }
 
 void Relation::Generate_Data(int type, double data_param, double decor_param) {
@@ -210,6 +244,25 @@ void Relation::Generate_Data(int type, double data_param, double decor_param) {
     }
 }
 
+void Relation::Generate_Weights(const string &distribution, double param) {
+    delete weights;
+    weights = NULL;
+    if (distribution == "unit") { return; }
+    if (distribution != "pareto" || param <= 0) {
+        cerr << "Invalid weights: " << distribution << " (unit/pareto, with app.weight_param > 0)" << endl;
+        exit(1);
+    }
+
+    // fixed seed, every run of a configuration sees the same weighted stream
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    weights = new vector<unsigned int>(tuples->size());
+    for (auto &weight : *weights) {
+        double w = std::floor(std::pow(1.0 - uniform(rng), -1.0 / param));
+        weight = (unsigned int) std::min<double>(w, MAX_WEIGHT);
+    }
+}
+
 template <typename AppConfig> Relation *generate_relation(AppConfig &app_configs) {
 
     Relation *r1 = new Relation(app_configs.DOM_SIZE, app_configs.tuples_no);
@@ -337,10 +390,49 @@ template <typename AppConfig> Relation *generate_relation(AppConfig &app_configs
         r1->tuples_no = i;
         app_configs.tuples_no = i;
         app_configs.LINE_READ = i;
+    } else if (app_configs.DATASET == "CAIDA_5TUPLE") {
+        // read file from repo folder ./data/CAIDA/caida_10000000_5tuple, either a CAIDA trace in pcap format (gunzipped equinix-*.pcap)
+        // or its flows as text, one "src_ip,dst_ip,src_port,dst_port,protocol" per line (see experimental_results/experimental_setup.md)
+        r1->tuples = new vector<unsigned int>(app_configs.LINE_READ);
+        r1->flow_tuples = new vector<FiveTuple>(app_configs.LINE_READ);
+
+        string current_path = __FILE__;
+        size_t pos = current_path.find("/src/");
+        string filename = current_path.substr(0, pos) + "/data/CAIDA/caida_10000000_5tuple";
+        std::cout << "Reading file: " << filename << std::endl;
+        ifstream in_file(filename);
+        if (!in_file) {
+            cerr << "Unable to open file" << endl;
+            exit(1);
+        }
+
+        int i = 0;
+        if (is_pcap_file(filename)) {
+            r1->flow_tuples->clear();
+            i = read_pcap_five_tuples(filename, app_configs.LINE_READ, *r1->flow_tuples);
+            for (int j = 0; j < i; j++) { (*r1->tuples)[j] = (*r1->flow_tuples)[j].src_ip; }
+        } else {
+            string line;
+            while (getline(in_file, line) && i < app_configs.LINE_READ) {
+                if (!line.empty()) {
+                    (*r1->flow_tuples)[i] = parse_five_tuple(line);
+                    // integer benchmarks on this dataset count source addresses, as CAIDA_L
+                    (*r1->tuples)[i] = (*r1->flow_tuples)[i].src_ip;
+                    i++;
+                }
+            }
+        }
+        r1->tuples->resize(i);
+        r1->flow_tuples->resize(i);
+        in_file.close();
+        r1->tuples_no = i;
+        app_configs.tuples_no = i;
+        app_configs.LINE_READ = i;
     }
 
     else {
         std::cerr << "Invalid dataset" << std::endl;
     }
+    if (r1->tuples) { r1->Generate_Weights(app_configs.WEIGHTS, app_configs.WEIGHT_PARAM); }
     return r1;
 }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "delegation_sketch/DelegationKey.hpp"
+#include <vector>
+
+// Open-addressing (linear probing) key -> count table for the per-thread PRIF deltas.
+// Keys, counts and occupancy live in flat arrays, so an update never allocates a node; the table doubles when it is half full.
+// Slots are only reset through the list of used slots, which keeps clear() proportional to the number of keys seen.
+template <typename KeyType> class DeltaTable {
+  private:
+    std::vector<KeyType> keys;
+    std::vector<int> counts;
+    std::vector<bool> occupied;
+    std::vector<unsigned int> used_slots;
+    size_t mask;
+
+    size_t _find_slot(const KeyType &key) const {
+        size_t slot = mix_key_hash(DelegationKeyTraits<KeyType>::hash(key)) & mask;
+        while (occupied[slot] && !(keys[slot] == key)) { slot = (slot + 1) & mask; }
+        return slot;
+    }
+
+    void _grow() {
+        std::vector<KeyType> old_keys = std::move(keys);
+        std::vector<int> old_counts = std::move(counts);
+        std::vector<unsigned int> old_used_slots = std::move(used_slots);
+
+        _allocate(old_keys.size() * 2);
+        for (unsigned int old_slot : old_used_slots) {
+            size_t slot = _find_slot(old_keys[old_slot]);
+            keys[slot] = old_keys[old_slot];
+            counts[slot] = old_counts[old_slot];
+            occupied[slot] = true;
+            used_slots.push_back(slot);
+        }
+    }
+
+    void _allocate(size_t capacity) {
+        keys.assign(capacity, KeyType());
+        counts.assign(capacity, 0);
+        occupied.assign(capacity, false);
+        used_slots.clear();
+        used_slots.reserve(capacity / 2);
+        mask = capacity - 1;
+    }
+
+  public:
+    DeltaTable(size_t initial_capacity = 1024) {
+        size_t capacity = 16;
+        while (capacity < initial_capacity) { capacity <<= 1; }
+        _allocate(capacity);
+    }
+
+    // reference to the count of key, inserted with 0 if absent
+    int &operator[](const KeyType &key) {
+        size_t slot = _find_slot(key);
+        if (!occupied[slot]) {
+            if ((used_slots.size() + 1) * 2 > keys.size()) {
+                _grow();
+                slot = _find_slot(key);
+            }
+            keys[slot] = key;
+            counts[slot] = 0;
+            occupied[slot] = true;
+            used_slots.push_back(slot);
+        }
+        return counts[slot];
+    }
+
+    // calls f(key, count) for every key with a non-zero count
+    template <typename Function> void for_each(Function f) const {
+        for (unsigned int slot : used_slots) {
+            if (counts[slot] != 0) { f(keys[slot], counts[slot]); }
+        }
+    }
+
+    void clear() {
+        for (unsigned int slot : used_slots) {
+            occupied[slot] = false;
+            counts[slot] = 0;
+        }
+        used_slots.clear();
+    }
+
+    size_t size() const { return used_slots.size(); }
+    bool empty() const { return used_slots.empty(); }
+};
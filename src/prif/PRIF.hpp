@@ -1,52 +1,68 @@
 #pragma once
 
+#include "concurrent_data_structure/MPSCRing.hpp"
 #include "delegation_sketch/DelegationConfig.hpp"
+#include "delegation_sketch/DelegationKey.hpp"
 #include "frequency_estimator/FrequencyEstimatorConfig.hpp"
 #include "frequency_estimator/FrequencyEstimatorTrait.hpp"
+#include "prif/DeltaTable.hpp"
 #include "prif/PRIFConfig.hpp"
-#include <mutex>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
 #include <semaphore>
-#include <unordered_map>
+#include <thread>
 #include <variant>
+#include <vector>
 
 enum class MessageType { Update, Query, STOP };
 
+// filled by the merger, lives on the stack of the querying thread until ready is released
+struct QueryReply {
+    std::binary_semaphore ready{0};
+    int frequency = 0;
+};
+
 template <typename KeyType> struct Message {
     MessageType type;
     KeyType item;
     int delta;
-};
-
-template <typename KeyType> struct QueryResult {
-    KeyType item;
-    int frequency;
+    QueryReply *reply = nullptr;   // only for queries
 };
 
 template <typename KeyType> struct SharedBuffer {
-    std::queue<Message<KeyType>> buffer;
-    std::counting_semaphore<> semmesgs;
-    std::counting_semaphore<> semslots;
-    std::mutex buffer_mutex;
-
-    std::queue<QueryResult<KeyType>> query_results;
-    std::counting_semaphore<> semqueries;
-    std::mutex query_mutex;
+    // workers -> merger, lock-free, the merger only parks on a semaphore when the ring is empty
+    MPSCRing<Message<KeyType>> messages;
 
-    SharedBuffer(int capacity) : semmesgs(0), semslots(capacity), semqueries(1) {}
+    SharedBuffer(int capacity) : messages(capacity) {}
 };
 
+// keys are partitioned over the mergers on their hash, each merger owns the counts (and answers the queries) of its keys
+template <typename KeyType> inline int merger_of(const KeyType &key, int num_mergers) {
+    return num_mergers == 1 ? 0 : mix_key_hash(DelegationKeyTraits<KeyType>::hash(key)) % num_mergers;
+}
+
 template <typename FrequencyEstimator, typename KeyType> class ThreadLocalPRIF {
   public:
     FrequencyEstimator frequency_estimator;
 
     using FrequencyEstimatorConfig = typename FrequencyEstimatorConfigTrait<FrequencyEstimator>::type;
     FrequencyEstimatorConfig frequency_estimator_configs;
-    int beta;
-    int total;
+    const std::atomic<float> *beta;   // owned by PRIF, moved by the adaptive beta controller
+    long total = 0;
     int current_thread_id;
-    std::unordered_map<KeyType, int> delta;
-    SharedBuffer<KeyType> *shared_buffer;
+    DeltaTable<KeyType> delta;
+    std::vector<SharedBuffer<KeyType> *> shared_buffers;   // one per merger
+
+    // forwarded deltas are staged per merger and published to its ring as one batch
+    std::vector<std::vector<Message<KeyType>>> outgoing;
+    int num_staged = 0;
+    size_t batch_size = 1;
+    std::chrono::microseconds batch_timeout{0};
+    std::chrono::steady_clock::time_point oldest_outgoing_time;
+    int updates_since_timeout_check = 0;
 
     ThreadLocalPRIF() = default;
     ThreadLocalPRIF(FrequencyEstimatorConfig frequency_estimator_configs) : frequency_estimator_configs(frequency_estimator_configs) {
@@ -64,29 +80,59 @@ template <typename FrequencyEstimator, typename KeyType> class ThreadLocalPRIF {
     void update(const KeyType &item, int c = 1) {
         this->total += c;
 
-        delta[item] += c;
-        int freq = frequency_estimator.update_and_estimate(item, c);
+        int &item_delta = delta[item];
+        item_delta += c;
+        int freq = frequency_estimator.update_and_estimate(to_estimator_key(item), c);
 
-        if (freq > beta * total) {
-            _send_message(item, delta[item]);
-            delta[item] = 0;   // Reset the frequency increment field
+        if (freq > beta->load(std::memory_order_relaxed) * total) {
+            _send_message(item, item_delta);
+            item_delta = 0;   // Reset the frequency increment field
+        }
+        if (num_staged > 0 && ++updates_since_timeout_check >= TIMEOUT_CHECK_INTERVAL) {
+            // a slow trickle of forwards must not stay staged forever, the clock is only read every TIMEOUT_CHECK_INTERVAL updates
+            updates_since_timeout_check = 0;
+            if (std::chrono::steady_clock::now() - oldest_outgoing_time >= batch_timeout) { _publish_all_outgoing(); }
         }
     }
 
     void flush() {
-        for (auto &entry : delta) { _send_message(entry.first, entry.second); }
+        delta.for_each([this](const KeyType &item, int delta_value) { _stage(item, delta_value); });
         delta.clear();
+        _publish_all_outgoing();
     }
 
   private:
+    static constexpr int TIMEOUT_CHECK_INTERVAL = 1024;
+
+    int _stage(const KeyType &item, int delta_value) {
+        int merger = merger_of(item, outgoing.size());
+        outgoing[merger].push_back({MessageType::Update, item, delta_value});
+        num_staged++;
+        return merger;
+    }
+
     void _send_message(const KeyType &item, int delta_value) {
-        Message<KeyType> msg{MessageType::Update, item, delta_value};
-        shared_buffer->semslots.acquire();
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer->buffer_mutex);
-            shared_buffer->buffer.push(msg);
+        int merger = _stage(item, delta_value);
+        if (outgoing[merger].size() >= batch_size) {
+            _publish_outgoing(merger);
+        } else if (num_staged == 1) {
+            // the first message staged after everything was published starts the timeout
+            oldest_outgoing_time = std::chrono::steady_clock::now();
+            updates_since_timeout_check = 0;
         }
-        shared_buffer->semmesgs.release();
+    }
+
+    // the whole batch is reserved with a single fetch_add on the merger's ring
+    void _publish_outgoing(int merger) {
+        if (outgoing[merger].empty()) { return; }
+        shared_buffers[merger]->messages.enqueue_batch(outgoing[merger].begin(), outgoing[merger].size());
+        num_staged -= outgoing[merger].size();
+        outgoing[merger].clear();
+    }
+
+    void _publish_all_outgoing() {
+        for (size_t merger = 0; merger < outgoing.size(); merger++) { _publish_outgoing(merger); }
+        updates_since_timeout_check = 0;
     }
 };
 
@@ -96,6 +142,7 @@ template <typename FrequencyEstimator, typename KeyType> class MergingThreadPRIF
     FrequencyEstimator frequency_estimator;
     FrequencyEstimatorConfig frequency_estimator_configs;
     SharedBuffer<KeyType> *shared_buffer;
+    int merger_id;
 
     MergingThreadPRIF() = default;
     MergingThreadPRIF(FrequencyEstimatorConfig frequency_estimator_configs) : frequency_estimator_configs(frequency_estimator_configs) {
@@ -103,39 +150,37 @@ template <typename FrequencyEstimator, typename KeyType> class MergingThreadPRIF
     }
 
     void run() {
+        std::vector<Message<KeyType>> batch(MERGE_BATCH_SIZE);
         while (true) {
-            Message<KeyType> msg = _receive_message();
-            if (msg.type == MessageType::Update) {
-                frequency_estimator.update(msg.item, msg.delta);
-            } else if (msg.type == MessageType::Query) {
-                int frequency = frequency_estimator.estimate(msg.item);
-                _send_query_result(msg.item, frequency);
-            } else if (msg.type == MessageType::STOP) {
-                break;
+            shared_buffer->messages.wait_until_not_empty();
+            size_t batch_size = shared_buffer->messages.dequeue_batch(batch.begin(), batch.size());
+            for (size_t i = 0; i < batch_size; i++) {
+                const Message<KeyType> &msg = batch[i];
+                if (msg.type == MessageType::Update) {
+                    pending_updates[msg.item] += msg.delta;
+                } else if (msg.type == MessageType::Query) {
+                    // a query must observe every update that was sent before it
+                    _apply_pending_updates();
+                    msg.reply->frequency = frequency_estimator.estimate(to_estimator_key(msg.item));
+                    msg.reply->ready.release();
+                } else if (msg.type == MessageType::STOP) {
+                    _apply_pending_updates();
+                    return;
+                }
             }
+            _apply_pending_updates();
         }
     }
 
   private:
-    Message<KeyType> _receive_message() {
-        shared_buffer->semmesgs.acquire();
-        Message<KeyType> msg;
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer->buffer_mutex);
-            msg = shared_buffer->buffer.front();
-            shared_buffer->buffer.pop();
-        }
-        shared_buffer->semslots.release();
-        return msg;
-    }
+    static constexpr size_t MERGE_BATCH_SIZE = 256;
 
-    void _send_query_result(const KeyType &item, int frequency) {
-        QueryResult<KeyType> result{item, frequency};
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer->query_mutex);
-            shared_buffer->query_results.push(result);
-        }
-        shared_buffer->semqueries.release();
+    // updates of one dequeued batch, coalesced per key so that each key hits the estimator once
+    DeltaTable<KeyType> pending_updates{MERGE_BATCH_SIZE * 2};
+
+    void _apply_pending_updates() {
+        pending_updates.for_each([this](const KeyType &item, int delta_value) { frequency_estimator.update(to_estimator_key(item), delta_value); });
+        pending_updates.clear();
     }
 };
 
@@ -145,63 +190,113 @@ template <typename FrequencyEstimator, typename KeyType> class PRIF {
     using FrequencyEstimatorConfig = typename FrequencyEstimatorConfigTrait<FrequencyEstimator>::type;
     FrequencyEstimatorConfig frequency_estimator_configs;
     int num_threads;
-    int beta;
+    int num_mergers;
+    std::atomic<float> beta;
     int total;
     std::vector<ThreadLocalPRIF<FrequencyEstimator, KeyType>> thread_local_prifs;
-    MergingThreadPRIF<FrequencyEstimator, KeyType> merging_thread_prif;
-    SharedBuffer<KeyType> shared_buffer;
+    std::vector<MergingThreadPRIF<FrequencyEstimator, KeyType>> merging_thread_prifs;
+    std::vector<std::unique_ptr<SharedBuffer<KeyType>>> shared_buffers;   // one ring per merger
 
     PRIF(PRIFConfig prif_configs, FrequencyEstimatorConfig frequency_estimator_configs)
-        : prif_configs(prif_configs), num_threads(prif_configs.NUM_THREADS), beta(prif_configs.BETA), shared_buffer(num_threads),
-          frequency_estimator_configs(frequency_estimator_configs) {
+        : prif_configs(prif_configs), frequency_estimator_configs(frequency_estimator_configs), num_threads(prif_configs.NUM_THREADS),
+          num_mergers(prif_configs.NUM_MERGERS), beta(prif_configs.BETA) {
         this->total = 0;
 
-        merging_thread_prif = MergingThreadPRIF<FrequencyEstimator, KeyType>(frequency_estimator_configs);
+        if (num_mergers < 1) {
+            std::cerr << "Invalid prif.num_mergers: " << num_mergers << std::endl;
+            exit(1);
+        }
+
+        for (int m = 0; m < num_mergers; m++) {
+            shared_buffers.emplace_back(std::make_unique<SharedBuffer<KeyType>>(prif_configs.QUEUE_CAPACITY));
+            merging_thread_prifs.emplace_back(frequency_estimator_configs);
+            merging_thread_prifs[m].shared_buffer = shared_buffers[m].get();
+            merging_thread_prifs[m].merger_id = m;
+        }
 
         for (int i = 0; i < num_threads; i++) {
             thread_local_prifs.emplace_back(frequency_estimator_configs);
-            thread_local_prifs[i].beta = this->beta;
+            thread_local_prifs[i].beta = &this->beta;
             thread_local_prifs[i].current_thread_id = i;
-            thread_local_prifs[i].shared_buffer = &this->shared_buffer;
+            thread_local_prifs[i].batch_size = prif_configs.BATCH_SIZE;
+            thread_local_prifs[i].batch_timeout = std::chrono::microseconds(prif_configs.BATCH_TIMEOUT_US);
+            thread_local_prifs[i].outgoing.resize(num_mergers);
+            for (int m = 0; m < num_mergers; m++) {
+                thread_local_prifs[i].shared_buffers.push_back(shared_buffers[m].get());
+                thread_local_prifs[i].outgoing[m].reserve(prif_configs.BATCH_SIZE);
+            }
         }
-        merging_thread_prif.shared_buffer = &this->shared_buffer;
     }
 
-    void send_stop_to_merging_thread() {
-        Message<KeyType> msg{MessageType::STOP, KeyType(), 0};
-        shared_buffer.semslots.acquire();
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer.buffer_mutex);
-            shared_buffer.buffer.push(msg);
-        }
-        shared_buffer.semmesgs.release();
+    void send_stop_to_merging_threads() {
+        for (auto &shared_buffer : shared_buffers) { shared_buffer->messages.enqueue({MessageType::STOP, KeyType(), 0}); }
     }
 
-    int query(const KeyType &item) {
-        _send_query(item);
-        QueryResult<KeyType> result = _receive_query_result();
-        return result.frequency;
-    }
+    // Adaptive beta, run on its own thread until running turns false. Every interval the controller samples the rings:
+    // beta is doubled while a merger ring is above the target occupancy, or above half of it and filling faster than it
+    // drains, and decays by 20% once all rings are below a quarter of the target. A worker under-reports a key by at most
+    // beta * its stream length, so the mergers hold at least (theta - beta) * N of a heavy hitter. beta is kept within
+    // [beta_min, min(beta_max, theta / 2)], a live query then still sees at least half of the heavy hitter threshold.
+    // beta is shared by all workers, each compares it against its own stream length.
+    void run_beta_controller(const std::atomic<bool> &running) {
+        float beta_max = std::min(prif_configs.BETA_MAX, prif_configs.THETA / 2);
+        float beta_min = std::min(prif_configs.BETA_MIN, beta_max);
+        float target_occupancy = prif_configs.TARGET_OCCUPANCY;
+        auto interval = std::chrono::milliseconds(prif_configs.BETA_CONTROL_INTERVAL_MS);
 
-  private:
-    void _send_query(const KeyType &item) {
-        Message<KeyType> msg{MessageType::Query, item, 0};
-        shared_buffer.semslots.acquire();
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer.buffer_mutex);
-            shared_buffer.buffer.push(msg);
+        std::ofstream log_file;
+        if (!prif_configs.BETA_LOG.empty()) { log_file.open(prif_configs.BETA_LOG, std::ios::app); }
+        std::ostream &log = log_file.is_open() ? log_file : std::cout;
+
+        auto start = std::chrono::steady_clock::now();
+        auto last_sample = start;
+        unsigned long last_produced = 0, last_consumed = 0;
+        for (auto &shared_buffer : shared_buffers) {
+            last_produced += shared_buffer->messages.produced();
+            last_consumed += shared_buffer->messages.consumed();
         }
-        shared_buffer.semmesgs.release();
-    }
 
-    QueryResult<KeyType> _receive_query_result() {
-        shared_buffer.semqueries.acquire();
-        QueryResult<KeyType> result;
-        {
-            std::lock_guard<std::mutex> lock(shared_buffer.query_mutex);
-            result = shared_buffer.query_results.front();
-            shared_buffer.query_results.pop();
+        while (running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(interval);
+
+            double occupancy = 0;
+            unsigned long produced = 0, consumed = 0;
+            for (auto &shared_buffer : shared_buffers) {
+                occupancy = std::max(occupancy, double(shared_buffer->messages.size_approx()) / shared_buffer->messages.get_capacity());
+                produced += shared_buffer->messages.produced();
+                consumed += shared_buffer->messages.consumed();
+            }
+            auto now = std::chrono::steady_clock::now();
+            double elapsed_s = std::chrono::duration<double>(now - last_sample).count();
+            double arrival_rate = (produced - last_produced) / elapsed_s;
+            double drain_rate = (consumed - last_consumed) / elapsed_s;
+            last_sample = now;
+            last_produced = produced;
+            last_consumed = consumed;
+
+            float old_beta = beta.load(std::memory_order_relaxed);
+            float new_beta = old_beta;
+            if (occupancy > target_occupancy || (occupancy > target_occupancy / 2 && arrival_rate > drain_rate)) {
+                new_beta = std::min(old_beta * 2, beta_max);
+            } else if (occupancy < target_occupancy / 4) {
+                new_beta = std::max(old_beta * 0.8f, beta_min);
+            }
+            if (new_beta == old_beta) { continue; }
+
+            beta.store(new_beta, std::memory_order_relaxed);
+            log << "{\"elapsed_ms\":" << std::chrono::duration<double, std::milli>(now - start).count() << ",\"occupancy\":" << occupancy << ",\"arrival_per_s\":" << arrival_rate
+                << ",\"drain_per_s\":" << drain_rate << ",\"old_beta\":" << old_beta << ",\"new_beta\":" << new_beta << "}" << std::endl;
         }
-        return result;
     }
+
+    // answered by the merger that owns the key, safe to call from any number of threads
+    int query(const KeyType &item) {
+        QueryReply reply;
+        shared_buffers[merger_of(item, num_mergers)]->messages.enqueue({MessageType::Query, item, 0, &reply});
+        reply.ready.acquire();
+        return reply.frequency;
+    }
+
+    // reads the owning merger's estimator directly, only valid once the mergers have stopped
+    int estimate_after_stop(const KeyType &item) { return merging_thread_prifs[merger_of(item, num_mergers)].frequency_estimator.estimate(to_estimator_key(item)); }
 };
\ No newline at end of file
@@ -12,15 +12,47 @@ struct PRIFConfig {
     float THETA;
     int NUM_THREADS;
     double QUERY_RATE;
+    int QUEUE_CAPACITY;
+    int BATCH_SIZE;
+    int BATCH_TIMEOUT_US;
+    int NUM_MERGERS;
+    string SWEEP_THREADS;
+    string SWEEP_MERGERS;
+    int BETA_CONTROL_INTERVAL_MS;   // 0 keeps beta fixed
+    float BETA_MIN;
+    float BETA_MAX;
+    float TARGET_OCCUPANCY;
+    string BETA_LOG;
 
     static void add_params_to_config_parser(PRIFConfig &prif_configs, ConfigParser &parser) {
         parser.AddParameter(new FloatParameter("prif.beta", "0.001", &prif_configs.BETA, false, "Beta value for the PRIF algorithm"));
         parser.AddParameter(new FloatParameter("prif.theta", "0.01", &prif_configs.THETA, false, "Theta value for the PRIF algorithm"));
         parser.AddParameter(new IntParameter("prif.num_threads", "20", &prif_configs.NUM_THREADS, false, "Number of threads for the PRIF algorithm"));
         parser.AddParameter(new DoubleParameter("prif.query_rate", "0", &prif_configs.QUERY_RATE, false, "Query rate for the PRIF algorithm"));
+        parser.AddParameter(new IntParameter("prif.queue_capacity", "4096", &prif_configs.QUEUE_CAPACITY, false,
+                                             "Slots of the worker-to-merger ring (rounded up to a power of two)"));
+        parser.AddParameter(new IntParameter("prif.batch_size", "64", &prif_configs.BATCH_SIZE, false, "Forwarded deltas a worker stages before publishing them as one batch"));
+        parser.AddParameter(new IntParameter("prif.batch_timeout_us", "100", &prif_configs.BATCH_TIMEOUT_US, false,
+                                             "Maximum time (us) a staged delta waits before its batch is published, checked every 1024 updates of its worker"));
+        parser.AddParameter(new IntParameter("prif.num_mergers", "1", &prif_configs.NUM_MERGERS, false, "Number of merging threads, keys are partitioned over them on their hash"));
+        parser.AddParameter(new StringParameter("prif.sweep_threads", "", &prif_configs.SWEEP_THREADS, false,
+                                                "Comma-separated worker counts to sweep, e.g. 2,4,8 (empty: only app.num_threads)"));
+        parser.AddParameter(new StringParameter("prif.sweep_mergers", "", &prif_configs.SWEEP_MERGERS, false,
+                                                "Comma-separated merger counts to sweep against every worker count (empty: only prif.num_mergers)"));
+        parser.AddParameter(new IntParameter("prif.beta_control_interval_ms", "0", &prif_configs.BETA_CONTROL_INTERVAL_MS, false,
+                                             "Period (ms) of the adaptive beta controller, 0 keeps beta fixed"));
+        parser.AddParameter(new FloatParameter("prif.beta_min", "0.0001", &prif_configs.BETA_MIN, false, "Lower bound of the adaptive beta"));
+        parser.AddParameter(new FloatParameter("prif.beta_max", "0.01", &prif_configs.BETA_MAX, false,
+                                               "Upper bound of the adaptive beta, capped at prif.theta / 2: the mergers may miss up to beta * N of a key until the workers flush"));
+        parser.AddParameter(new FloatParameter("prif.target_occupancy", "0.5", &prif_configs.TARGET_OCCUPANCY, false,
+                                               "Merger ring occupancy (0-1) above which the adaptive beta is raised"));
+        parser.AddParameter(new StringParameter("prif.beta_log", "", &prif_configs.BETA_LOG, false, "File receiving one JSON line per beta adjustment (empty: stdout)"));
     }
 
-    auto to_tuple() const { return std::make_tuple("BETA", BETA, "THETA", THETA, "NUM_THREADS", NUM_THREADS, "QUERY_RATE", QUERY_RATE); }
+    auto to_tuple() const { return std::make_tuple("BETA", BETA, "THETA", THETA, "NUM_THREADS", NUM_THREADS, "QUERY_RATE", QUERY_RATE, "QUEUE_CAPACITY", QUEUE_CAPACITY, "BATCH_SIZE", BATCH_SIZE,
+                                              "BATCH_TIMEOUT_US", BATCH_TIMEOUT_US, "NUM_MERGERS", NUM_MERGERS, "SWEEP_THREADS", SWEEP_THREADS,
+                                              "SWEEP_MERGERS", SWEEP_MERGERS, "BETA_CONTROL_INTERVAL_MS", BETA_CONTROL_INTERVAL_MS, "BETA_MIN", BETA_MIN, "BETA_MAX", BETA_MAX,
+                                              "TARGET_OCCUPANCY", TARGET_OCCUPANCY, "BETA_LOG", BETA_LOG); }
 
     friend std::ostream &operator<<(std::ostream &os, const PRIFConfig &config) {
         ConfigPrinter<PRIFConfig>::print(os, config);
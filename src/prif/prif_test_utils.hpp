@@ -1,71 +1,212 @@
+#include "delegation_sketch/CpuTopology.hpp"
 #include "delegation_sketch/delegation_sketch_utils.hpp"
 #include "frequency_estimator/FrequencyEstimatorTrait.hpp"
 #include "heavy_hitter_app/AppConfig.hpp"
+#include "heavy_hitter_app/Relation.hpp"
 #include "heavy_hitter_app/heavy_hitter_test_utils.hpp"
 #include "prif/PRIF.hpp"
+#include <algorithm>
 #include <barrier>
+#include <chrono>
 #include <iostream>
 #include <map>
+#include <numeric>
+#include <sstream>
 #include <string>
 #include <thread>
 
 extern atomic<bool> START_BENCHMARK;
 
+// what a worker did during one run, read after it joined
+struct PRIFWorkerStats {
+    long long processed_items = 0;
+    std::vector<long long> query_latencies;   // ns
+};
+
+// Workers loop over their slice of the stream until the benchmark stops, like the delegation threads do (a single pass
+// when app.duration is 0). Queries (prif.query_rate per 10000 items) ask the owning merger for the key just inserted and are timed end to end.
 template <typename FrequencyEstimator, typename KeyType>
-void run_worker_thread(const PRIF<FrequencyEstimator, KeyType> &prif, ThreadLocalPRIF<FrequencyEstimator, KeyType> &thread_local_prif, int start, int end,
-                       const std::vector<KeyType> &data, std::barrier<> &sync_point) {
-    setaffinity_oncpu(thread_local_prif.current_thread_id + 2);
+void run_worker_thread(PRIF<FrequencyEstimator, KeyType> &prif, ThreadLocalPRIF<FrequencyEstimator, KeyType> &thread_local_prif, int cpu, int start, int end, const Relation *r1,
+                       double query_rate, bool single_pass, PRIFWorkerStats &stats, std::barrier<> &sync_point) {
+    setaffinity_oncpu(cpu);
+    unsigned long *seeds = seed_rand();
     sync_point.arrive_and_wait();
 
-    while (START_BENCHMARK.load(std::memory_order_relaxed)) {
+    do {
         for (int i = start; i < end; i++) {
-            KeyType key = data[i];
+            KeyType key = r1->key_at<KeyType>(i);
             thread_local_prif.update(key, 1);
+            stats.processed_items++;
+
+            if (query_rate > 0 && should_perform_query(seeds, query_rate)) {
+                auto query_start = std::chrono::high_resolution_clock::now();
+                prif.query(key);
+                auto query_end = std::chrono::high_resolution_clock::now();
+                stats.query_latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(query_end - query_start).count());
+            }
             if (!START_BENCHMARK.load(std::memory_order_relaxed)) { break; }
         }
-    }
+    } while (!single_pass && START_BENCHMARK.load(std::memory_order_relaxed));
 
     // flush the local buffer
     thread_local_prif.flush();
+    free(seeds);
 }
 
 template <typename FrequencyEstimator, typename KeyType>
-void run_merging_thread(PRIF<FrequencyEstimator, KeyType> &prif, MergingThreadPRIF<FrequencyEstimator, KeyType> &merging_thread_prif, std::barrier<> &sync_point) {
-    setaffinity_oncpu(1);
+void run_merging_thread(MergingThreadPRIF<FrequencyEstimator, KeyType> &merging_thread_prif, int cpu, std::barrier<> &sync_point) {
+    setaffinity_oncpu(cpu);
     sync_point.arrive_and_wait();
-    while (START_BENCHMARK.load(std::memory_order_relaxed)) { merging_thread_prif.run(); }
+    merging_thread_prif.run();
+}
+
+// every worker went over its slice num_processed / slice_size times plus a prefix, as in calculate_exact_counter
+template <typename KeyType> std::map<KeyType, int> calculate_prif_exact_counter(const Relation *r1, int tuples_no, const std::vector<PRIFWorkerStats> &stats) {
+    int num_threads = stats.size();
+    std::map<KeyType, int> exact_counter;
+    for (int i = 0; i < num_threads; i++) {
+        int start = i * (tuples_no / num_threads);
+        int end = i == num_threads - 1 ? tuples_no : (i + 1) * (tuples_no / num_threads);
+        long long num_processed = stats[i].processed_items;
+
+        int weight = num_processed / (end - start);
+        for (int j = start; j < end; j++) { exact_counter[r1->key_at<KeyType>(j)] += weight; }
+
+        int rest = num_processed - (long long) (end - start) * weight;
+        for (int j = start; j < start + rest; j++) { exact_counter[r1->key_at<KeyType>(j)]++; }
+    }
+    return exact_counter;
+}
+
+template <typename FrequencyEstimator, typename KeyType>
+void print_stats_for_prif(ParallelAppConfig &app_configs, PRIF<FrequencyEstimator, KeyType> &prif, const Relation *r1, const std::vector<PRIFWorkerStats> &stats) {
+    int num_threads = stats.size();
+    double elapsed_s = get_time_ms() / 1000.0;
+
+    long long total_processed = 0;
+    for (int i = 0; i < num_threads; i++) {
+        total_processed += stats[i].processed_items;
+        std::cout << "thread " << i << " proccessed:" << stats[i].processed_items << std::endl;
+    }
+    double throughput = elapsed_s > 0 ? total_processed / elapsed_s / 1000000 : 0;
+    std::cout << "num_threads: " << num_threads << " num_mergers: " << prif.num_mergers << " total insert processed: " << float(total_processed) / 1000000
+              << "Mops time process: " << elapsed_s << std::endl;
+    std::cout << "Throughput: " << throughput << std::endl;
+
+    // heavy hitters, with the same threshold and error definitions as print_stats_for_heavy_hitters
+    std::map<KeyType, int> exact_counter = calculate_prif_exact_counter<KeyType>(r1, app_configs.tuples_no, stats);
+    int threshold = total_processed * app_configs.THETA;
+
+    std::map<KeyType, int> heavy_hitter_counter, heavy_hitter_candidates;
+    std::map<KeyType, int> estimates;
+    int count_correct = 0;
+    for (const auto &[key, count] : exact_counter) {
+        int estimate = prif.estimate_after_stop(key);
+        if (count > threshold) { heavy_hitter_counter[key] = count; }
+        if (estimate >= threshold) {
+            heavy_hitter_candidates[key] = count;
+            if (count > threshold) { count_correct++; }
+        }
+        estimates[key] = estimate;
+    }
+
+    auto error = [&estimates](const std::map<KeyType, int> &counter, bool relative) {
+        double total_error = 0;
+        for (const auto &[key, count] : counter) { total_error += std::abs(count - estimates[key]) / (relative ? double(count) : 1.0); }
+        return counter.empty() ? 0 : total_error / counter.size();
+    };
+    double are_hh = error(heavy_hitter_counter, true), aae_hh = error(heavy_hitter_counter, false);
+    double are_hh_candidates = error(heavy_hitter_candidates, true), aae_hh_candidates = error(heavy_hitter_candidates, false);
+    double precision = double(count_correct) / heavy_hitter_candidates.size();
+    double recall = double(count_correct) / heavy_hitter_counter.size();
+
+    std::cout << "# sketch + heap heavy hitters" << std::endl;
+    std::cout << "Execution Time: " << app_configs.DURATION << std::endl;
+    std::cout << "Count distinct: " << exact_counter.size() << std::endl;
+    std::cout << "Total heavy hitters: " << heavy_hitter_counter.size() << std::endl;
+    std::cout << "Total heavy_hitter candidates: " << heavy_hitter_candidates.size() << std::endl;
+    std::cout << "# sample set: true heavy_hitter_counter" << std::endl;
+    std::cout << "ARE: " << are_hh << std::endl;
+    std::cout << "AAE: " << aae_hh << std::endl;
+    std::cout << "Precision: " << count_correct << " over " << heavy_hitter_candidates.size() << std::endl;
+    std::cout << "Recall: " << count_correct << " over " << heavy_hitter_counter.size() << std::endl;
+    std::cout << "---------------------" << std::endl;
+    std::cout << "# sample set: heavy_hitter candidates" << std::endl;
+    std::cout << "ARE: " << are_hh_candidates << std::endl;
+    std::cout << "AAE: " << aae_hh_candidates << std::endl;
+    std::cout << "---------------------" << std::endl;
+
+    // query latency, merged over all workers
+    std::vector<long long> latencies;
+    for (const auto &worker_stats : stats) { latencies.insert(latencies.end(), worker_stats.query_latencies.begin(), worker_stats.query_latencies.end()); }
+    std::string latency_summary;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) { return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))]; };
+        double avg = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+
+        std::cout << "# Latency Evaluation" << std::endl;
+        std::cout << "Number of measurements: " << latencies.size() << std::endl;
+        std::cout << "Average latency (ns): " << avg << std::endl;
+        std::cout << "P50 latency (ns): " << percentile(0.5) << std::endl;
+        std::cout << "P90 latency (ns): " << percentile(0.9) << std::endl;
+        std::cout << "P99 latency (ns): " << percentile(0.99) << std::endl;
+        std::cout << "P999 latency (ns): " << percentile(0.999) << std::endl;
+        std::cout << "Maximum latency (ns): " << latencies.back() << std::endl;
+        std::cout << "Minimum latency (ns): " << latencies.front() << std::endl;
+        latency_summary = " LatencyP50=" + std::to_string(percentile(0.5)) + " LatencyP99=" + std::to_string(percentile(0.99));
+    }
+
+    std::cout << "RESULT_SUMMARY:"
+              << " FrequencyEstimator=" << ConfigPrinter<FrequencyEstimator>::demangle(typeid(FrequencyEstimator).name()) << " Workers=" << num_threads
+              << " Mergers=" << prif.num_mergers << " Throughput=" << throughput << " TotalHeavyHitters=" << heavy_hitter_counter.size()
+              << " TotalHeavyHitterCandidates=" << heavy_hitter_candidates.size() << " Precision=" << precision << " Recall=" << recall << " ARE=" << are_hh
+              << " AAE=" << aae_hh << latency_summary << " ExecutionTime=" << app_configs.DURATION << std::endl;
 }
 
 template <typename FrequencyEstimatorConfig, typename KeyType>
-void run_test(ParallelAppConfig app_configs, PRIFConfig prif_configs, FrequencyEstimatorConfig frequency_estimator_configs, const std::vector<KeyType> &data) {
+void run_test(ParallelAppConfig app_configs, PRIFConfig prif_configs, FrequencyEstimatorConfig frequency_estimator_configs, const Relation *r1) {
     using FrequencyEstimator = typename FrequencyEstimatorTrait<FrequencyEstimatorConfig>::type;
 
-    int line_read = app_configs.LINE_READ;
-    float theta = app_configs.THETA;
     int num_runs = app_configs.NUM_RUNS;
     int num_threads = app_configs.NUM_THREADS;
+    int tuples_no = app_configs.tuples_no;
     int DURATION = app_configs.DURATION;
+    int num_mergers = prif_configs.NUM_MERGERS;
+    // the workers are the application threads
+    prif_configs.NUM_THREADS = num_threads;
 
-    std::map<KeyType, int> exact_counter = get_exact_counter<KeyType>(data, line_read);
-
-    std::map<KeyType, int> heavy_hitter_counter;
-    float threshold = theta * line_read;
-    for (const auto &entry : exact_counter) {
-        if (entry.second >= threshold) { heavy_hitter_counter[entry.first] = entry.second; }
-    }
+    // workers first, then the mergers
+    ThreadPlacement placement = ThreadPlacement::compute(app_configs.PLACEMENT, num_threads + num_mergers);
 
-    for (int i = 0; i < num_runs; i++) {
-        std::cout << "## Run " << i << std::endl;
-        std::barrier sync_point(num_threads + 1);
+    for (int run = 0; run < num_runs; run++) {
+        std::cout << "## Run " << run << std::endl;
+        START_BENCHMARK.store(true, std::memory_order_relaxed);
+        std::barrier sync_point(num_threads + num_mergers + 1);
         // init prif
         PRIF<FrequencyEstimator, KeyType> prif(prif_configs, frequency_estimator_configs);
-        std::thread merging_thread(run_merging_thread<FrequencyEstimator, KeyType>, std::ref(prif), std::ref(prif.merging_thread_prif), std::ref(sync_point));
+        std::vector<PRIFWorkerStats> stats(num_threads);
+
+        std::vector<std::thread> merging_threads;
+        for (int m = 0; m < num_mergers; m++) {
+            merging_threads.push_back(std::thread(run_merging_thread<FrequencyEstimator, KeyType>, std::ref(prif.merging_thread_prifs[m]), placement.cpus[num_threads + m], std::ref(sync_point)));
+        }
         std::vector<std::thread> worker_threads;
-        for (int i = 0; i < num_threads - 1; i++) {
-            worker_threads.push_back(std::thread(run_worker_thread<FrequencyEstimator, KeyType>, std::ref(prif), std::ref(prif.thread_local_prifs[i]), i * line_read / num_threads,
-                                                 (i + 1) * line_read / num_threads, std::cref(data), std::ref(sync_point)));
+        for (int i = 0; i < num_threads; i++) {
+            int start = i * (tuples_no / num_threads);
+            int end = i == num_threads - 1 ? tuples_no : (i + 1) * (tuples_no / num_threads);
+            worker_threads.push_back(std::thread(run_worker_thread<FrequencyEstimator, KeyType>, std::ref(prif), std::ref(prif.thread_local_prifs[i]), placement.cpus[i], start,
+                                                 end, r1, prif_configs.QUERY_RATE, DURATION <= 0, std::ref(stats[i]), std::ref(sync_point)));
         }
         sync_point.arrive_and_wait();
+        start_time();
+
+        // the adaptive beta controller is stopped once the workers are done
+        std::atomic<bool> BETA_CONTROLLER_RUNNING = true;
+        std::thread beta_controller_thread;
+        if (prif_configs.BETA_CONTROL_INTERVAL_MS > 0) {
+            beta_controller_thread = std::thread(&PRIF<FrequencyEstimator, KeyType>::run_beta_controller, &prif, std::cref(BETA_CONTROLLER_RUNNING));
+        }
 
         // start benchmark
         if (DURATION > 0) {
@@ -74,39 +215,40 @@ void run_test(ParallelAppConfig app_configs, PRIFConfig prif_configs, FrequencyE
             stop_time();
         }
 
-        // join threads
+        // join threads, the workers flush their deltas before exiting
         for (auto &worker_thread : worker_threads) { worker_thread.join(); }
-        prif.send_stop_to_merging_thread();
-        merging_thread.join();
+        if (DURATION <= 0) { stop_time(); }
+        BETA_CONTROLLER_RUNNING.store(false, std::memory_order_relaxed);
+        if (beta_controller_thread.joinable()) { beta_controller_thread.join(); }
+        prif.send_stop_to_merging_threads();
+        for (auto &merging_thread : merging_threads) { merging_thread.join(); }
 
-        // print results
+        print_stats_for_prif<FrequencyEstimator, KeyType>(app_configs, prif, r1, stats);
     }
 }
 
-template <typename FrequencyEstimatorConfig> void test_CAIDA(ParallelAppConfig &app_configs, PRIFConfig &prif_configs, FrequencyEstimatorConfig &frequency_estimator_configs) {
-    std::string data_path = "/home/vinh/Q32024/CuckooHeavyKeeper/data/CAIDA/only_ip";
-    std::ifstream input_file(data_path);
-    std::string line;
-    std::vector<std::string> data;
-
-    while (getline(input_file, line) && data.size() < app_configs.LINE_READ) { data.push_back(line); }
-
-    run_test<FrequencyEstimatorConfig, std::string>(app_configs, prif_configs, frequency_estimator_configs, data);
+inline std::vector<int> parse_sweep_list(const std::string &list, int default_value) {
+    std::vector<int> values;
+    std::stringstream ss(list);
+    std::string value;
+    while (std::getline(ss, value, ',')) {
+        if (!value.empty()) { values.push_back(std::stoi(value)); }
+    }
+    if (values.empty()) { values.push_back(default_value); }
+    return values;
 }
 
-template <typename FrequencyEstimatorConfig> void test_Zipf(ParallelAppConfig &app_configs, PRIFConfig &prif_configs, FrequencyEstimatorConfig &frequency_estimator_configs) {
+// runs every workers x mergers combination of prif.sweep_threads and prif.sweep_mergers on the app.dataset stream
+template <typename FrequencyEstimatorConfig, typename KeyType>
+void test(ParallelAppConfig app_configs, PRIFConfig prif_configs, FrequencyEstimatorConfig frequency_estimator_configs) {
     Relation *r1 = generate_relation(app_configs);
-    std::vector<unsigned int> data(r1->tuples->begin(), r1->tuples->begin() + app_configs.LINE_READ);
 
-    run_test<FrequencyEstimatorConfig, unsigned int>(app_configs, prif_configs, frequency_estimator_configs, data);
-}
-
-template <typename FrequencyEstimatorConfig> void test(ParallelAppConfig app_configs, PRIFConfig prif_configs, FrequencyEstimatorConfig frequency_estimator_configs) {
-    if (app_configs.DATASET == "CAIDA") {
-        test_CAIDA(app_configs, prif_configs, frequency_estimator_configs);
-    } else if (app_configs.DATASET == "zipf") {
-        test_Zipf(app_configs, prif_configs, frequency_estimator_configs);
-    } else {
-        std::cerr << "Invalid dataset" << std::endl;
+    for (int num_threads : parse_sweep_list(prif_configs.SWEEP_THREADS, app_configs.NUM_THREADS)) {
+        for (int num_mergers : parse_sweep_list(prif_configs.SWEEP_MERGERS, prif_configs.NUM_MERGERS)) {
+            std::cout << "# Workers " << num_threads << " Mergers " << num_mergers << std::endl;
+            app_configs.NUM_THREADS = num_threads;
+            prif_configs.NUM_MERGERS = num_mergers;
+            run_test<FrequencyEstimatorConfig, KeyType>(app_configs, prif_configs, frequency_estimator_configs, r1);
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+
+// Versioned binary snapshots of the estimators and of the delegation state.
+// A snapshot starts with a header (magic, format version, kind of state), followed by the fields of the object in host byte order.
+// Counter tables are written as flat arrays, so saving and loading are a few large writes and reads.
+static constexpr uint32_t SNAPSHOT_MAGIC = 0x4b484353;   // "SCHK"
+static constexpr uint32_t SNAPSHOT_FORMAT_VERSION = 4;   // 2: flat CountMinSketch hashed once to 64 bits, 3: delegation slot table and local trackers,
+                                                          // 4: 64-bit StreamSummarySpaceSaving total
+
+enum class SnapshotKind : uint32_t { CUCKOO_HEAVY_KEEPER = 1, COUNT_MIN = 2, SPACE_SAVING = 3, HEAVY_HITTER_WRAPPER = 4, DELEGATION = 5, STREAM_SUMMARY_SPACE_SAVING = 6, MISRA_GRIES = 7 };
+
+// state that can be written to and restored from a snapshot
+template <typename T> concept Snapshottable = requires(const T &state, T &restored, std::ostream &os, std::istream &is) {
+    state.save(os);
+    restored.load(is);
+};
+
+template <typename T> inline void write_binary(std::ostream &os, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values are written as raw bytes");
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+inline void write_binary(std::ostream &os, const std::string &value) {
+    write_binary(os, static_cast<uint64_t>(value.size()));
+    os.write(value.data(), value.size());
+}
+
+template <typename T> inline void write_binary_array(std::ostream &os, const T *values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values are written as raw bytes");
+    os.write(reinterpret_cast<const char *>(values), sizeof(T) * count);
+}
+
+inline void check_snapshot_stream(std::istream &is) {
+    if (!is) { throw std::runtime_error("Snapshot is truncated or unreadable"); }
+}
+
+template <typename T> inline void read_binary(std::istream &is, T &value) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values are read as raw bytes");
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+    check_snapshot_stream(is);
+}
+
+inline void read_binary(std::istream &is, std::string &value) {
+    uint64_t size;
+    read_binary(is, size);
+    value.resize(size);
+    is.read(value.data(), size);
+    check_snapshot_stream(is);
+}
+
+template <typename T> inline void read_binary_array(std::istream &is, T *values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values are read as raw bytes");
+    is.read(reinterpret_cast<char *>(values), sizeof(T) * count);
+    check_snapshot_stream(is);
+}
+
+inline void write_snapshot_header(std::ostream &os, SnapshotKind kind) {
+    write_binary(os, SNAPSHOT_MAGIC);
+    write_binary(os, SNAPSHOT_FORMAT_VERSION);
+    write_binary(os, static_cast<uint32_t>(kind));
+}
+
+// checks the header and returns the format version the snapshot was written with
+inline uint32_t read_snapshot_header(std::istream &is, SnapshotKind kind) {
+    uint32_t magic, version, stored_kind;
+    read_binary(is, magic);
+    read_binary(is, version);
+    read_binary(is, stored_kind);
+    if (magic != SNAPSHOT_MAGIC) { throw std::runtime_error("Not a snapshot: bad magic number"); }
+    if (version == 0 || version > SNAPSHOT_FORMAT_VERSION) { throw std::runtime_error("Unsupported snapshot format version " + std::to_string(version)); }
+    if (stored_kind != static_cast<uint32_t>(kind)) { throw std::runtime_error("Snapshot holds another kind of state"); }
+    return version;
+}
+
+// Reads a snapshot file through a read-only mapping: the kernel reads the pages ahead, and load(std::istream &) copies the tables
+// out of the page cache without a stream buffer in between. Not a zero-copy restore, the estimators own their storage and every
+// table is still copied once.
+class SnapshotFileReader {
+  private:
+    int fd = -1;
+    char *data = nullptr;
+    size_t size = 0;
+
+    // lets load(std::istream &) read straight out of the mapping
+    struct MemoryStreamBuffer : public std::streambuf {
+        MemoryStreamBuffer(char *begin, size_t size) { setg(begin, begin, begin + size); }
+    };
+
+  public:
+    explicit SnapshotFileReader(const std::string &path) {
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("Cannot open snapshot " + path); }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat snapshot " + path);
+        }
+        size = file_stat.st_size;
+        if (size > 0) {
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map snapshot " + path);
+            }
+            data = static_cast<char *>(mapping);
+            madvise(data, size, MADV_SEQUENTIAL);
+            madvise(data, size, MADV_WILLNEED);
+        }
+    }
+
+    ~SnapshotFileReader() {
+        if (data != nullptr) { munmap(data, size); }
+        if (fd >= 0) { close(fd); }
+    }
+
+    SnapshotFileReader(const SnapshotFileReader &) = delete;
+    SnapshotFileReader &operator=(const SnapshotFileReader &) = delete;
+
+    template <typename T> void load_into(T &object) const {
+        MemoryStreamBuffer buffer(data, size);
+        std::istream is(&buffer);
+        object.load(is);
+    }
+};
+
+// written to a temporary file first, so a crash while saving leaves the previous snapshot intact
+template <typename T> void save_snapshot_file(const std::string &path, T &object) {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream os(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!os) { throw std::runtime_error("Cannot write snapshot " + tmp_path); }
+        object.save(os);
+        if (!os.flush()) { throw std::runtime_error("Cannot write snapshot " + tmp_path); }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) { throw std::runtime_error("Cannot move snapshot to " + path); }
+}
+
+template <typename T> void load_snapshot_file(const std::string &path, T &object) { SnapshotFileReader(path).load_into(object); }
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Bump allocator over contiguous slabs for the per-thread state of the delegation designs (filters, pending queries, seeds).
+// Every allocation starts on a cache line and is rounded up to whole lines, so two objects never share a line and a thread
+// writing its own object does not invalidate the line another thread reads. Slabs are zeroed when they are allocated: create
+// the arena on the thread (cpu) that owns the state and the pages are first touched, hence placed, on that thread's NUMA node.
+// Memory is released all at once when the arena is destroyed; objects made with create() are destroyed in reverse order first.
+class CacheLineArena : public std::pmr::memory_resource {
+  public:
+    explicit CacheLineArena(size_t slab_size = 64 * 1024) : slab_size(round_up(std::max(slab_size, CACHE_LINE_SIZE))) {}
+    CacheLineArena(const CacheLineArena &) = delete;
+    CacheLineArena &operator=(const CacheLineArena &) = delete;
+
+    ~CacheLineArena() override {
+        for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) { it->second(it->first); }
+        for (void *slab : slabs) { std::free(slab); }
+    }
+
+    // constructs a T in the arena, destroyed with the arena
+    template <typename T, typename... Args> T *create(Args &&...args) {
+        T *object = new (do_allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            destructors.emplace_back(object, [](void *p) { static_cast<T *>(p)->~T(); });
+        }
+        return object;
+    }
+
+    size_t bytes_allocated() const { return allocated; }
+    size_t num_slabs() const { return slabs.size(); }
+
+  private:
+    size_t slab_size;
+    std::vector<void *> slabs;
+    std::vector<std::pair<void *, void (*)(void *)>> destructors;
+    std::byte *current = nullptr;
+    size_t remaining = 0;
+    size_t allocated = 0;
+
+    static size_t round_up(size_t bytes) { return (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE; }
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        if (alignment > CACHE_LINE_SIZE) { throw std::bad_alloc(); }
+        bytes = round_up(std::max<size_t>(bytes, 1));
+        if (bytes > remaining) {
+            // a request larger than a slab gets a slab of its own, the rest of the current slab stays in use
+            size_t size = std::max(bytes, slab_size);
+            void *slab = std::aligned_alloc(CACHE_LINE_SIZE, size);
+            if (!slab) { throw std::bad_alloc(); }
+            std::memset(slab, 0, size);
+            slabs.push_back(slab);
+            if (size > slab_size) {
+                allocated += bytes;
+                return slab;
+            }
+            current = static_cast<std::byte *>(slab);
+            remaining = size;
+        }
+        void *p = current;
+        current += bytes;
+        remaining -= bytes;
+        allocated += bytes;
+        return p;
+    }
+
+    // memory goes back with the whole arena
+    void do_deallocate(void *, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
@@ -0,0 +1,95 @@
+#include "concurrent_data_structure/MPSCRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(MPSCRingTest, SingleThreadIsFifoAndRoundsCapacityUp) {
+    MPSCRing<int> ring(10);
+    EXPECT_EQ(ring.get_capacity(), 16u);
+    EXPECT_TRUE(ring.is_empty());
+
+    std::vector<int> out(16);
+    // several laps around the ring
+    for (int lap = 0; lap < 5; lap++) {
+        std::vector<int> items;
+        for (int i = 0; i < 12; i++) { items.push_back(lap * 100 + i); }
+        ring.enqueue_batch(items.begin(), items.size());
+        EXPECT_EQ(ring.size_approx(), 12u);
+        EXPECT_EQ(ring.dequeue_batch(out.begin(), 5), 5u);
+        EXPECT_EQ(ring.dequeue_batch(out.begin() + 5, 16), 7u);
+        EXPECT_TRUE(ring.is_empty());
+        for (int i = 0; i < 12; i++) { EXPECT_EQ(out[i], lap * 100 + i); }
+    }
+    EXPECT_EQ(ring.produced(), 60u);
+    EXPECT_EQ(ring.consumed(), 60u);
+}
+
+// Producers push (producer, sequence) pairs in batches of varying size through a ring much smaller than the stream, so they
+// wrap around and block on a full ring. Every item must arrive exactly once, and each producer's items in order.
+TEST(MPSCRingTest, ConcurrentProducersDeliverEveryItemOnceInProducerOrder) {
+    constexpr int NUM_PRODUCERS = 4;
+    constexpr int ITEMS_PER_PRODUCER = 20000;
+    MPSCRing<std::pair<int, int>> ring(16);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        producers.emplace_back([&ring, p] {
+            std::vector<std::pair<int, int>> batch;
+            int sequence = 0;
+            while (sequence < ITEMS_PER_PRODUCER) {
+                // 1 to 7 items, larger batches than the ring are not used by PRIF
+                size_t batch_size = std::min(1 + (sequence + p) % 7, ITEMS_PER_PRODUCER - sequence);
+                batch.clear();
+                for (size_t i = 0; i < batch_size; i++) { batch.emplace_back(p, sequence++); }
+                ring.enqueue_batch(batch.begin(), batch.size());
+            }
+        });
+    }
+
+    std::vector<int> next_sequence(NUM_PRODUCERS, 0);
+    std::vector<std::pair<int, int>> out(8);
+    int received = 0;
+    while (received < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+        ring.wait_until_not_empty();
+        size_t count = ring.dequeue_batch(out.begin(), out.size());
+        for (size_t i = 0; i < count; i++) {
+            auto [producer, sequence] = out[i];
+            ASSERT_EQ(sequence, next_sequence[producer]) << "producer " << producer;
+            next_sequence[producer]++;
+        }
+        received += count;
+    }
+    for (auto &producer : producers) { producer.join(); }
+
+    EXPECT_TRUE(ring.is_empty());
+    EXPECT_EQ(ring.produced(), (unsigned long) NUM_PRODUCERS * ITEMS_PER_PRODUCER);
+    EXPECT_EQ(ring.consumed(), ring.produced());
+    for (int p = 0; p < NUM_PRODUCERS; p++) { EXPECT_EQ(next_sequence[p], ITEMS_PER_PRODUCER); }
+}
+
+// a consumer parked on the empty ring (no spinning) is woken by every later publication
+TEST(MPSCRingTest, ParkedConsumerIsWokenByProducer) {
+    MPSCRing<int> ring(4);
+    constexpr int NUM_ITEMS = 1000;
+
+    std::thread producer([&ring] {
+        for (int i = 0; i < NUM_ITEMS; i++) {
+            if (i % 100 == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+            ring.enqueue(i);
+        }
+    });
+
+    int expected = 0;
+    int out[4];
+    while (expected < NUM_ITEMS) {
+        ring.wait_until_not_empty(0);
+        size_t count = ring.dequeue_batch(out, 4);
+        ASSERT_GT(count, 0u);
+        for (size_t i = 0; i < count; i++) { ASSERT_EQ(out[i], expected++); }
+    }
+    producer.join();
+    EXPECT_TRUE(ring.is_empty());
+}
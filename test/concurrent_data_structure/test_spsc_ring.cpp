@@ -0,0 +1,68 @@
+#include "concurrent_data_structure/SPSCRing.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(SPSCRingTest, FullAndEmptyAreReportedWithoutBlocking) {
+    SPSCRing<int> ring(5);
+    EXPECT_EQ(ring.get_capacity(), 8u);
+
+    int item = -1;
+    EXPECT_FALSE(ring.try_dequeue(item));
+    EXPECT_EQ(item, -1);
+
+    for (int i = 0; i < 8; i++) { EXPECT_TRUE(ring.try_enqueue(i)) << "item " << i; }
+    EXPECT_FALSE(ring.try_enqueue(8));
+    EXPECT_EQ(ring.size_approx(), 8u);
+
+    // one slot freed, one item fits again
+    EXPECT_TRUE(ring.try_dequeue(item));
+    EXPECT_EQ(item, 0);
+    EXPECT_TRUE(ring.try_enqueue(8));
+    EXPECT_FALSE(ring.try_enqueue(9));
+
+    for (int i = 1; i <= 8; i++) {
+        EXPECT_TRUE(ring.try_dequeue(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(ring.try_dequeue(item));
+    EXPECT_EQ(ring.size_approx(), 0u);
+}
+
+TEST(SPSCRingTest, WrapsAroundInFifoOrder) {
+    SPSCRing<int> ring(4);
+    int next_in = 0, next_out = 0, item;
+    // uneven enqueue and dequeue runs, so the indices cross the end of the slots at every offset
+    for (int lap = 0; lap < 100; lap++) {
+        for (int i = 0; i < 1 + lap % 4; i++) { ASSERT_TRUE(ring.try_enqueue(next_in++)); }
+        while (ring.try_dequeue(item)) { ASSERT_EQ(item, next_out++); }
+    }
+    EXPECT_EQ(next_out, next_in);
+    EXPECT_EQ(ring.produced(), (unsigned long) next_in);
+    EXPECT_EQ(ring.consumed(), (unsigned long) next_out);
+}
+
+// A producer and a consumer on their own threads, through a ring much smaller than the stream: every item arrives once and in order.
+TEST(SPSCRingTest, ConcurrentProducerAndConsumerKeepOrder) {
+    constexpr int NUM_ITEMS = 200000;
+    SPSCRing<int> ring(16);
+
+    std::thread producer([&ring] {
+        for (int i = 0; i < NUM_ITEMS; i++) {
+            while (!ring.try_enqueue(i)) { std::this_thread::yield(); }
+        }
+    });
+
+    // consumes the whole stream even after a mismatch, so the producer never waits on a full ring forever
+    int num_received = 0, num_out_of_order = 0, item;
+    while (num_received < NUM_ITEMS) {
+        if (!ring.try_dequeue(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item != num_received) { num_out_of_order++; }
+        num_received++;
+    }
+    producer.join();
+    EXPECT_EQ(num_out_of_order, 0);
+    EXPECT_FALSE(ring.try_dequeue(item));
+}
@@ -0,0 +1,79 @@
+#include "delegation_sketch/CpuTopology.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// A sysfs cpu directory with 2 nodes of 2 cores with 2 hardware threads each. As on most x86 machines, the siblings of a core are
+// numbered half the cpu count apart: cpus 0-3 are the first threads of the cores, cpus 4-7 their siblings. cpu 7 is offline.
+class CpuTopologyTest : public ::testing::Test {
+  protected:
+    std::string sysfs_cpu_path;
+
+    void SetUp() override {
+        sysfs_cpu_path = ::testing::TempDir() + "fake_sysfs_cpu";
+        fs::remove_all(sysfs_cpu_path);
+        fs::create_directories(sysfs_cpu_path);
+        write(sysfs_cpu_path + "/online", "0-6\n");
+        for (int cpu = 0; cpu < 8; cpu++) {
+            std::string cpu_path = sysfs_cpu_path + "/cpu" + std::to_string(cpu);
+            fs::create_directories(cpu_path + "/topology");
+            int node = (cpu % 4) / 2;
+            write(cpu_path + "/topology/core_id", std::to_string(cpu % 2) + "\n");
+            write(cpu_path + "/topology/physical_package_id", std::to_string(node) + "\n");
+            // the node is only given by the name of a nodeN entry, node ids need not be dense
+            fs::create_directories(cpu_path + "/node" + std::to_string(node * 2));
+        }
+    }
+
+    void TearDown() override { fs::remove_all(sysfs_cpu_path); }
+
+    static void write(const std::string &path, const std::string &content) { std::ofstream(path) << content; }
+};
+
+TEST_F(CpuTopologyTest, ReadsOnlineCpusCoresAndNodes) {
+    vector<CpuTopologyEntry> topology = read_cpu_topology(sysfs_cpu_path);
+    ASSERT_EQ(topology.size(), 7u);
+    for (int cpu = 0; cpu < 7; cpu++) {
+        const auto &entry = topology[cpu];
+        EXPECT_EQ(entry.cpu, cpu);
+        EXPECT_EQ(entry.core_id, cpu % 2) << "cpu " << cpu;
+        EXPECT_EQ(entry.package_id, (cpu % 4) / 2) << "cpu " << cpu;
+        EXPECT_EQ(entry.node, (cpu % 4) / 2 * 2) << "cpu " << cpu;
+        // the sibling with the higher cpu number is the second thread of the core
+        EXPECT_EQ(entry.smt_index, cpu / 4) << "cpu " << cpu;
+    }
+}
+
+TEST_F(CpuTopologyTest, ParsesCpuListsWithSinglesAndRanges) {
+    write(sysfs_cpu_path + "/online", "0,2-3,5\n");
+    vector<CpuTopologyEntry> topology = read_cpu_topology(sysfs_cpu_path);
+    ASSERT_EQ(topology.size(), 4u);
+    EXPECT_EQ(topology[0].cpu, 0);
+    EXPECT_EQ(topology[1].cpu, 2);
+    EXPECT_EQ(topology[2].cpu, 3);
+    EXPECT_EQ(topology[3].cpu, 5);
+}
+
+TEST_F(CpuTopologyTest, PlacementsFollowTheParsedLayout) {
+    vector<CpuTopologyEntry> topology = read_cpu_topology(sysfs_cpu_path);
+
+    // cpus 0 and 1 are left to main and the accuracy evaluator
+    ThreadPlacement compact = ThreadPlacement::compute("compact", 4, topology);
+    EXPECT_EQ(compact.num_nodes, 2);
+    EXPECT_EQ(compact.cpus, (vector<int>{4, 5, 2, 6}));
+    EXPECT_EQ(compact.nodes, (vector<int>{0, 0, 1, 1}));
+
+    ThreadPlacement scatter = ThreadPlacement::compute("scatter", 4, topology);
+    EXPECT_EQ(scatter.cpus, (vector<int>{4, 2, 5, 3}));
+    EXPECT_EQ(scatter.nodes, (vector<int>{0, 1, 0, 1}));
+    EXPECT_EQ(scatter.threads_per_node, (vector<vector<int>>{{0, 2}, {1, 3}}));
+
+    ThreadPlacement numa = ThreadPlacement::compute("numa", 4, topology);
+    EXPECT_EQ(numa.nodes, (vector<int>{0, 0, 1, 1}));
+    // an owner on the other node is relayed through the thread of the same rank on this node
+    EXPECT_EQ(numa.relay_of(3, 0), 1);
+    EXPECT_EQ(numa.relay_of(1, 0), 1);
+}
@@ -0,0 +1,391 @@
+#include "delegation_sketch/DelegationBuildConfig.hpp"
+#include "delegation_sketch/DelegationConfig.hpp"
+#include "delegation_sketch/DelegationHeavyHitter.hpp"
+#include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include "frequency_estimator/SequentialHeavyHitterWrapperForParallel.hpp"
+#include "frequency_estimator/SharedCuckooHeavyKeeper.hpp"
+#include "heavy_hitter_app/AppConfig.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <gtest/gtest.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+using FrequencyEstimator = SequentialHeavyHitterWrapperForParallel<CuckooHeavyKeeper, int>;
+#elif EQUAL(PARALLEL_DESIGN, SHARED)
+using FrequencyEstimator = SharedCuckooHeavyKeeper;
+#else
+using FrequencyEstimator = CuckooHeavyKeeper;
+#endif
+using TestDelegationHeavyHitter = DelegationHeavyHitter<FrequencyEstimator, int>;
+
+// The threads are driven one step at a time from the test: the thread that reads an item inserts it, then every owner drains its
+// filters, which is what the worker loops interleave. Nothing runs concurrently, so the counts can be compared exactly.
+class DelegationHeavyHitterTest : public ::testing::Test {
+  protected:
+    static constexpr int NUM_THREADS = 4;
+
+    ParallelAppConfig app_configs;
+    DelegationHeavyHitterConfig delegation_configs;
+    CuckooHeavyKeeperConfig frequency_estimator_configs;
+    std::atomic<bool> START_BENCHMARK = false;
+    std::atomic<bool> START_ACCURACY_EVALUATION = false;
+    std::unique_ptr<DelegationSketchContext> delegation_sketch_context;
+    // one vector per instance, the threads keep references to the estimators
+    std::deque<std::vector<CuckooHeavyKeeper>> sketches;
+    std::deque<std::vector<FrequencyEstimator>> frequency_estimators;
+
+    void SetUp() override {
+        ConfigParser parser;
+        ParallelAppConfig::add_params_to_config_parser(app_configs, parser);
+        DelegationHeavyHitterConfig::add_params_to_config_parser(delegation_configs, parser);
+        CuckooHeavyKeeperConfig::add_params_to_config_parser(frequency_estimator_configs, parser);
+        ASSERT_TRUE(parser.LoadDefaultValues().IsOK());
+        app_configs.NUM_THREADS = NUM_THREADS;
+        app_configs.PLACEMENT = "compact";
+        app_configs.THETA = 0.01;
+        // small filters, so that keys reach the owners' sketches between the reshards
+        delegation_configs.FILTER_SIZE = 4;
+        frequency_estimator_configs.BUCKET_NUM = 1024;
+        frequency_estimator_configs.SEED = 7;
+        delegation_sketch_context = std::make_unique<DelegationSketchContext>(app_configs, delegation_configs, nullptr, START_BENCHMARK, START_ACCURACY_EVALUATION);
+#if EQUAL(PARALLEL_DESIGN, HIERARCHICAL)
+        // threads 0-1 on node 0 and 2-3 on node 1, whatever the machine, so that keys of the other node go through a relay. Both nodes
+        // name cpu 0, the only cpu every machine has to pin the threads to.
+        vector<CpuTopologyEntry> two_nodes = {{0, 0, 0, 0, 0}, {0, 0, 1, 1, 0}};
+        delegation_sketch_context->placement = ThreadPlacement::compute("numa", NUM_THREADS, two_nodes);
+#endif
+    }
+
+    TestDelegationHeavyHitter *make_delegation_heavy_hitter() {
+        auto &instance_estimators = frequency_estimators.emplace_back();
+        instance_estimators.reserve(NUM_THREADS);
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+        // reserved up front, the wrappers keep references to the sketches
+        auto &instance_sketches = sketches.emplace_back();
+        instance_sketches.reserve(NUM_THREADS);
+        for (int i = 0; i < NUM_THREADS; i++) { instance_sketches.emplace_back(frequency_estimator_configs); }
+        for (int i = 0; i < NUM_THREADS; i++) { instance_estimators.emplace_back(instance_sketches[i], app_configs.THETA); }
+#elif EQUAL(PARALLEL_DESIGN, SHARED)
+        // one sketch updated by all threads
+        instance_estimators.emplace_back(frequency_estimator_configs.BUCKET_NUM, app_configs.THETA);
+#else
+        for (int i = 0; i < NUM_THREADS; i++) { instance_estimators.emplace_back(frequency_estimator_configs); }
+#endif
+        return new TestDelegationHeavyHitter(*delegation_sketch_context, instance_estimators);
+    }
+
+    static void drain(TestDelegationHeavyHitter *delegation_sketch) {
+        // forwarded keys may fill another filter, a second round drains those
+        for (int round = 0; round < 2; round++) {
+            for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) { thread_local_delegation_sketch->process_pending_inserts(); }
+        }
+    }
+
+    // item i is read by thread i % num_readers, as if the active threads split the stream
+    static void ingest(TestDelegationHeavyHitter *delegation_sketch, const std::vector<std::pair<int, int>> &items, int num_readers) {
+        for (size_t i = 0; i < items.size(); i++) {
+            delegation_sketch->thread_local_delegation_sketches[i % num_readers]->insert(items[i].first, items[i].second);
+            drain(delegation_sketch);
+        }
+    }
+
+    static void reshard(TestDelegationHeavyHitter *delegation_sketch, int num_active_threads) {
+        delegation_sketch->reshard(num_active_threads);
+        for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) { thread_local_delegation_sketch->check_reshard(); }
+        drain(delegation_sketch);
+    }
+
+    static void flush(TestDelegationHeavyHitter *delegation_sketch) {
+        drain(delegation_sketch);
+        for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) { thread_local_delegation_sketch->flush_pending_inserts(); }
+    }
+
+    // count of the key summed over every thread's sketch
+    static long sum_over_sketches(TestDelegationHeavyHitter *delegation_sketch, int key) {
+        long count = 0;
+        for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) { count += thread_local_delegation_sketch->frequency_estimator.estimate(key); }
+        return count;
+    }
+
+    // num_heavy keys that each take an equal share of the stream, and a few keys seen once
+    static std::vector<std::pair<int, int>> make_stream(int num_heavy, int repetitions, int first_light_key, int num_light) {
+        std::vector<std::pair<int, int>> items;
+        for (int r = 0; r < repetitions; r++) {
+            for (int key = 1; key <= num_heavy; key++) { items.emplace_back(key, 1); }
+        }
+        for (int key = first_light_key; key < first_light_key + num_light; key++) { items.emplace_back(key, 1); }
+        return items;
+    }
+};
+
+// SHARED has no owners to reshard between and no checkpoints
+#if !EQUAL(PARALLEL_DESIGN, SHARED)
+TEST_F(DelegationHeavyHitterTest, ReshardRoundTripConservesCounts) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    std::map<int, long> exact_counter;
+    auto add_exact = [&](const std::vector<std::pair<int, int>> &items) {
+        for (auto &[key, weight] : items) { exact_counter[key] += weight; }
+    };
+
+    auto phase_1 = make_stream(32, 100, 1000, 8);
+    ingest(delegation_sketch, phase_1, 4);
+    add_exact(phase_1);
+
+    // 4 -> 2 -> 4 moves the keys of threads 2 and 3 away and (some of them) back
+    reshard(delegation_sketch, 2);
+    auto phase_2 = make_stream(32, 100, 2000, 8);
+    ingest(delegation_sketch, phase_2, 2);
+    add_exact(phase_2);
+
+    reshard(delegation_sketch, 4);
+    auto phase_3 = make_stream(32, 100, 3000, 8);
+    ingest(delegation_sketch, phase_3, 4);
+    add_exact(phase_3);
+    flush(delegation_sketch);
+
+    for (auto &[key, count] : exact_counter) {
+        // every count is held by exactly one sketch, migrated keys are not counted twice
+        EXPECT_EQ(sum_over_sketches(delegation_sketch, key), count) << "key " << key;
+    }
+    // the heavy hitters moved with their counts, their owner answers for all of them
+    for (int key = 1; key <= 32; key++) { EXPECT_EQ(delegation_sketch->direct_query(key), exact_counter[key]) << "key " << key; }
+}
+
+#endif
+
+TEST_F(DelegationHeavyHitterTest, WeightedStreamSizePassesIntMax) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    // 64 keys of 40 items of weight 2^20 each, 2^31 + 2^29 in total
+    static constexpr int NUM_KEYS = 64, REPETITIONS = 40, WEIGHT = 1 << 20;
+    std::vector<std::pair<int, int>> items;
+    for (int r = 0; r < REPETITIONS; r++) {
+        for (int key = 1; key <= NUM_KEYS; key++) { items.emplace_back(key, WEIGHT); }
+    }
+    ingest(delegation_sketch, items, 4);
+    flush(delegation_sketch);
+
+    int64_t total = int64_t(NUM_KEYS) * REPETITIONS * WEIGHT;
+    ASSERT_GT(total, std::numeric_limits<int>::max());
+#if EQUAL(PARALLEL_DESIGN, QPOPSS)
+    EXPECT_EQ(delegation_sketch->QPOPSS_stream_size.load(), total);
+#else
+    EXPECT_EQ(delegation_sketch->global_heavy_hitter_tracker.stream_size.load(), total);
+#endif
+    for (int key = 1; key <= NUM_KEYS; key++) { EXPECT_EQ(delegation_sketch->direct_query(key), REPETITIONS * WEIGHT) << "key " << key; }
+
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP)
+    // every key holds 1/64 of the stream, above theta = 0.01
+    std::map<int, int> heavy_hitters;
+    delegation_sketch->query_all_heavy_hitters(heavy_hitters);
+    EXPECT_EQ(heavy_hitters.size(), size_t(NUM_KEYS));
+#endif
+}
+
+#if !EQUAL(PARALLEL_DESIGN, SHARED)
+TEST_F(DelegationHeavyHitterTest, CheckpointRestoresShardingAndTrackers) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    ingest(delegation_sketch, make_stream(32, 100, 1000, 8), 4);
+    reshard(delegation_sketch, 2);
+    ingest(delegation_sketch, make_stream(32, 100, 2000, 8), 2);
+    drain(delegation_sketch);
+
+    std::stringstream checkpoint;
+    delegation_sketch->save(checkpoint);
+    std::vector<unsigned short> mods(precomputed_mods, precomputed_mods + 512);
+    std::map<int, int> counts;
+    for (int key = 1; key <= 32; key++) { counts[key] = delegation_sketch->direct_query(key); }
+
+    // a fresh instance starts with the slot table of all 4 threads
+    TestDelegationHeavyHitter *restored = make_delegation_heavy_hitter();
+    ASSERT_EQ(restored->num_active_threads.load(), NUM_THREADS);
+    restored->load(checkpoint);
+
+    EXPECT_EQ(restored->num_active_threads.load(), 2);
+    EXPECT_EQ(restored->reshard_epoch.load(), delegation_sketch->reshard_epoch.load());
+    EXPECT_EQ(std::vector<unsigned short>(precomputed_mods, precomputed_mods + 512), mods);
+    EXPECT_EQ(restored->global_heavy_hitter_tracker.stream_size.load(), delegation_sketch->global_heavy_hitter_tracker.stream_size.load());
+    EXPECT_EQ(restored->QPOPSS_stream_size.load(), delegation_sketch->QPOPSS_stream_size.load());
+    size_t num_tracked = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        auto &saved_tracker = delegation_sketch->thread_local_delegation_sketches[i]->local_heavy_hitter_tracker;
+        auto &restored_tracker = restored->thread_local_delegation_sketches[i]->local_heavy_hitter_tracker;
+        EXPECT_EQ(restored_tracker.threshold, saved_tracker.threshold) << "thread " << i;
+        EXPECT_EQ(restored_tracker.local_heavy_hitters.size(), saved_tracker.local_heavy_hitters.size()) << "thread " << i;
+        for (const auto &el : saved_tracker.local_heavy_hitters) { EXPECT_TRUE(restored_tracker.local_heavy_hitters.contains(el.first)) << "key " << el.first; }
+        EXPECT_EQ(restored->thread_local_delegation_sketches[i]->reshard_epoch, delegation_sketch->thread_local_delegation_sketches[i]->reshard_epoch);
+        num_tracked += saved_tracker.local_heavy_hitters.size();
+    }
+#if EQUAL(PARALLEL_DESIGN, GLOBAL_HASHMAP)
+    EXPECT_EQ(num_tracked, 32u);
+#endif
+    for (int key = 1; key <= 32; key++) { EXPECT_EQ(restored->direct_query(key), counts[key]) << "key " << key; }
+
+    // ingest goes on from the checkpoint, every key still reaches the owner that holds its count
+    ingest(restored, make_stream(32, 100, 3000, 8), 2);
+    flush(restored);
+    for (int key = 1; key <= 32; key++) { EXPECT_EQ(restored->direct_query(key), counts[key] + 100) << "key " << key; }
+}
+
+TEST_F(DelegationHeavyHitterTest, LoadRefusesClaimedSketches) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    ingest(delegation_sketch, make_stream(8, 10, 1000, 8), 4);
+    std::stringstream checkpoint;
+    delegation_sketch->save(checkpoint);
+
+    // a running worker holds its sketch, the load must not replace it underneath
+    delegation_sketch->thread_local_delegation_sketches[2]->claim_sketch();
+    EXPECT_THROW(delegation_sketch->load(checkpoint), std::runtime_error);
+    delegation_sketch->thread_local_delegation_sketches[2]->release_sketch();
+
+    // the failed load released the sketches it had claimed
+    for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) {
+        EXPECT_TRUE(thread_local_delegation_sketch->try_claim_sketch());
+        thread_local_delegation_sketch->release_sketch();
+    }
+    checkpoint.seekg(0);
+    EXPECT_NO_THROW(delegation_sketch->load(checkpoint));
+}
+
+#endif
+
+#if EQUAL(PARALLEL_DESIGN, SHARED)
+// Candidates and stream size are published every filter_size inserts, the flush at the end of a run publishes what is left.
+TEST_F(DelegationHeavyHitterTest, SharedFlushPublishesTheLastItems) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    // 9 keys seen once, then 100 rounds of 8 heavy keys: 809 items, every thread is left with 2 or 3 unpublished heavy items
+    std::vector<std::pair<int, int>> items;
+    for (int key = 1000; key < 1009; key++) { items.emplace_back(key, 1); }
+    for (int r = 0; r < 100; r++) {
+        for (int key = 1; key <= 8; key++) { items.emplace_back(key, 1); }
+    }
+    ingest(delegation_sketch, items, 4);
+    EXPECT_LT(delegation_sketch->global_heavy_hitter_tracker.stream_size.load(), int64_t(items.size()));
+
+    flush(delegation_sketch);
+    EXPECT_EQ(delegation_sketch->global_heavy_hitter_tracker.stream_size.load(), int64_t(items.size()));
+    std::map<int, int> heavy_hitters;
+    delegation_sketch->query_all_heavy_hitters(heavy_hitters);
+    ASSERT_EQ(heavy_hitters.size(), 8u);
+    // the last occurrence of every heavy key was among the unpublished items
+    for (int key = 1; key <= 8; key++) { EXPECT_EQ(heavy_hitters[key], 100) << "key " << key; }
+}
+#endif
+
+#if EQUAL(PARALLEL_DESIGN, HIERARCHICAL)
+// A key of a remote owner crosses the interconnect once, from the relay of the reader's node, and is counted once by its owner.
+TEST_F(DelegationHeavyHitterTest, RelayedKeysReachTheirOwnerOnce) {
+    const auto &placement = delegation_sketch_context->placement;
+    ASSERT_EQ(placement.nodes, (vector<int>{0, 0, 1, 1}));
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    // owners 2 and 3 are reached from node 0 through threads 0 and 1, and the other way round
+    EXPECT_EQ(delegation_sketch->thread_local_delegation_sketches[0]->delegation_targets, (vector<int>{0, 1, 0, 1}));
+    EXPECT_EQ(delegation_sketch->thread_local_delegation_sketches[3]->delegation_targets, (vector<int>{2, 3, 2, 3}));
+
+    auto items = make_stream(32, 100, 1000, 8);
+    std::map<int, long> exact_counter;
+    // weight read on one node of keys owned by the other node
+    int64_t remote_weight = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        exact_counter[items[i].first] += items[i].second;
+        if (placement.nodes[i % NUM_THREADS] != placement.nodes[find_owner(items[i].first)]) { remote_weight += items[i].second; }
+    }
+    ingest(delegation_sketch, items, NUM_THREADS);
+    flush(delegation_sketch);
+
+    for (auto &[key, count] : exact_counter) {
+        EXPECT_EQ(sum_over_sketches(delegation_sketch, key), count) << "key " << key;
+        EXPECT_EQ(delegation_sketch->thread_local_delegation_sketches[find_owner(key)]->frequency_estimator.estimate(key), count) << "key " << key;
+    }
+
+    // only the relays delegate to the other node, and only once per item
+    int64_t cross_node_weight = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        auto thread_local_delegation_sketch = delegation_sketch->thread_local_delegation_sketches[i];
+        for (int owner = 0; owner < NUM_THREADS; owner++) {
+            if (placement.nodes[owner] == placement.nodes[i]) { continue; }
+            int64_t weight = thread_local_delegation_sketch->thread_pairwise_stat_collectors[owner].count_delegate_to_j_items;
+            if (placement.relay_of(owner, placement.nodes[i]) != i) { EXPECT_EQ(weight, 0) << "thread " << i << " owner " << owner; }
+            cross_node_weight += weight;
+        }
+    }
+    EXPECT_GT(remote_weight, 0);
+    EXPECT_EQ(cross_node_weight, remote_weight);
+}
+#endif
+
+// SHARED has no filters to report on
+#if !EQUAL(PARALLEL_DESIGN, SHARED)
+// Thread 0 reads 3 keys it owns and 6 owned by thread 1: one full filter of 4 waits in the queue of thread 1, the other 2 keys sit
+// in the second buffer.
+TEST_F(DelegationHeavyHitterTest, MetricsSnapshotCountsItemsAndPendingFilters) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    auto reader = delegation_sketch->thread_local_delegation_sketches[0];
+    std::vector<int> keys_left = {3, 6, 0, 0};
+    for (int key = 1; keys_left[0] + keys_left[1] > 0; key++) {
+        // handed to the owner directly, without a relay
+        int owner = find_owner(key);
+        if (reader->delegation_targets[owner] != owner || keys_left[owner] == 0) { continue; }
+        keys_left[owner]--;
+        // what the worker loop does with every item it reads
+        reader->thread_overall_stat_collector.update_received_from_stream_items();
+        reader->insert(key, 1);
+    }
+    delegation_sketch->thread_local_delegation_sketches[2]->thread_overall_stat_collector.update_received_from_stream_items(5);
+
+    MetricsSnapshot snapshot = collect_metrics_snapshot(delegation_sketch, NUM_THREADS);
+    EXPECT_EQ(snapshot.received_items, (vector<long long>{9, 0, 5, 0}));
+    EXPECT_EQ(snapshot.total_received_items, 14);
+    EXPECT_EQ(snapshot.queue_depth, (vector<int>{0, 1, 0, 0}));
+    EXPECT_EQ(snapshot.backlog_items, (vector<long long>{0, 4, 0, 0}));
+    EXPECT_EQ(snapshot.buffered_items, (vector<long long>{3, 2, 0, 0}));
+    EXPECT_EQ(snapshot.blocked_loops, (vector<long long>{0, 0, 0, 0}));
+
+    // thread 1 takes its queue, the partly filled filters stay until they are flushed
+    drain(delegation_sketch);
+    snapshot = collect_metrics_snapshot(delegation_sketch, NUM_THREADS);
+    EXPECT_EQ(snapshot.queue_depth, (vector<int>{0, 0, 0, 0}));
+    EXPECT_EQ(snapshot.backlog_items, (vector<long long>{0, 0, 0, 0}));
+    EXPECT_EQ(snapshot.buffered_items, (vector<long long>{3, 2, 0, 0}));
+    flush(delegation_sketch);
+    snapshot = collect_metrics_snapshot(delegation_sketch, NUM_THREADS);
+    EXPECT_EQ(snapshot.buffered_items, (vector<long long>{0, 0, 0, 0}));
+
+    ingest(delegation_sketch, make_stream(2, 100, 1000, 8), NUM_THREADS);
+    flush(delegation_sketch);
+    EXPECT_GT(collect_metrics_snapshot(delegation_sketch, NUM_THREADS).heavy_hitter_count, 0);
+}
+#endif
+
+TEST_F(DelegationHeavyHitterTest, PerThreadStateIsOnSeparateCacheLines) {
+    TestDelegationHeavyHitter *delegation_sketch = make_delegation_heavy_hitter();
+    // [begin, end) of every object a thread writes and another thread reads
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;
+    auto add_range = [&](const void *p, size_t bytes) { ranges.emplace_back(reinterpret_cast<uintptr_t>(p), reinterpret_cast<uintptr_t>(p) + bytes); };
+    for (auto thread_local_delegation_sketch : delegation_sketch->thread_local_delegation_sketches) {
+        add_range(thread_local_delegation_sketch, sizeof(*thread_local_delegation_sketch));
+        // filters, queries and seeds of a thread are one slab of its own arena
+        EXPECT_EQ(thread_local_delegation_sketch->arena.num_slabs(), 1u);
+        add_range(thread_local_delegation_sketch->seeds, 3 * sizeof(unsigned long));
+        for (auto &buffer : thread_local_delegation_sketch->double_buffer_delegation_filters) {
+            for (auto filter : buffer) {
+                if (filter == nullptr) { continue; }
+                add_range(filter, sizeof(*filter));
+                add_range(filter->keys.data(), filter->keys.size() * sizeof(int));
+                add_range(filter->counts.data(), filter->counts.size() * sizeof(int));
+            }
+        }
+        for (auto query : thread_local_delegation_sketch->pending_queries) { add_range(query, sizeof(*query)); }
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        EXPECT_EQ(ranges[i].first % CACHE_LINE_SIZE, 0u) << "object " << i;
+        if (i > 0) { EXPECT_LT((ranges[i - 1].second - 1) / CACHE_LINE_SIZE, ranges[i].first / CACHE_LINE_SIZE) << "objects " << i - 1 << " and " << i; }
+    }
+}
@@ -0,0 +1,140 @@
+#include "delegation_sketch/IngestPipeline.hpp"
+#include "utils/ConfigParser.hpp"
+#include <chrono>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// One reader feeding one worker, so the worker gets the relation in order, over and over.
+class IngestPipelineTest : public ::testing::Test {
+  protected:
+    static constexpr int NUM_TUPLES = 10;
+
+    DelegationHeavyHitterConfig configs;
+    std::unique_ptr<Relation> r1;
+    std::string stream_path;
+
+    void SetUp() override {
+        ConfigParser parser;
+        DelegationHeavyHitterConfig::add_params_to_config_parser(configs, parser);
+        ASSERT_TRUE(parser.LoadDefaultValues().IsOK());
+        configs.INGEST_READERS = 1;
+        configs.INGEST_BLOCK_SIZE = 4;
+        configs.INGEST_RING_SIZE = 2;
+        stream_path = ::testing::TempDir() + "ingest_pipeline_test.stream";
+        configs.INGEST_PATH = stream_path;
+        remove_stream_file();
+        precompute_mods(1);
+
+        r1 = std::make_unique<Relation>(1000, NUM_TUPLES);
+        r1->tuples = new vector<unsigned int>();
+        r1->weights = new vector<unsigned int>();
+        for (int i = 0; i < NUM_TUPLES; i++) {
+            r1->tuples->push_back(100 + i);
+            r1->weights->push_back(1 + i % 3);
+        }
+    }
+
+    void TearDown() override { remove_stream_file(); }
+
+    void remove_stream_file() {
+        fs::remove(stream_path);
+        fs::remove(stream_path + ".index");
+    }
+
+    std::unique_ptr<IngestPipeline<int>> make_pipeline(const std::string &source) {
+        configs.INGEST = source;
+        return std::make_unique<IngestPipeline<int>>(r1.get(), NUM_TUPLES, 1, configs, "compact", "test");
+    }
+
+    // the worker side: takes num_items items off the blocks of worker 0 and checks them against the relation
+    void expect_relation_in_order(IngestPipeline<int> &pipeline, int num_items) {
+        int position = 0;
+        while (position < num_items) {
+            IngestBlock<int> *block = pipeline.next_block(0);
+            if (block == nullptr) {
+                ASSERT_FALSE(pipeline.failed());
+                std::this_thread::yield();
+                continue;
+            }
+            for (int j = 0; j < block->size; j++, position++) {
+                int i = position % NUM_TUPLES;
+                EXPECT_EQ(block->keys[j], 100 + i) << "item " << position;
+                EXPECT_EQ(block->weights[j], 1 + i % 3) << "item " << position;
+                EXPECT_EQ(block->hashes[j], DelegationKeyTraits<int>::hash(100 + i)) << "item " << position;
+                EXPECT_EQ(block->owners[j], 0) << "item " << position;
+            }
+            pipeline.release_block(0, block);
+        }
+    }
+};
+
+TEST_F(IngestPipelineTest, EverySourceHandsOverTheRelationInOrder) {
+    for (std::string source : {"memory", "file", "mmap"}) {
+        SCOPED_TRACE(source);
+        auto pipeline = make_pipeline(source);
+        pipeline->start();
+        // the blocks of 4 items wrap around the 10 tuples at different offsets
+        expect_relation_in_order(*pipeline, 40);
+        pipeline->stop();
+        EXPECT_NO_THROW(pipeline->rethrow_reader_error());
+        EXPECT_GE(pipeline->items_handed_over(0), 40);
+    }
+}
+
+TEST_F(IngestPipelineTest, ReaderErrorReachesTheCaller) {
+    auto pipeline = make_pipeline("file");
+    // the stream file is cut short after it was indexed, the reader runs out of bytes in the middle of its range
+    fs::resize_file(stream_path, 5);
+    pipeline->start();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!pipeline->failed() && std::chrono::steady_clock::now() < deadline) { std::this_thread::yield(); }
+    ASSERT_TRUE(pipeline->failed());
+    pipeline->stop();
+    EXPECT_EQ(pipeline->next_block(0), nullptr);
+    EXPECT_THROW(pipeline->rethrow_reader_error(), std::runtime_error);
+}
+
+TEST_F(IngestPipelineTest, StreamFileIsReusedAcrossRuns) {
+    make_pipeline("file");
+    ASSERT_TRUE(fs::exists(stream_path));
+    uintmax_t size = fs::file_size(stream_path);
+    // backdated, so that a rewrite shows in the modification time
+    auto written_at = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    fs::last_write_time(stream_path, written_at);
+
+    // a second run of the same relation reads the file written by the first one
+    auto pipeline = make_pipeline("mmap");
+    EXPECT_EQ(fs::last_write_time(stream_path), written_at);
+    pipeline->start();
+    expect_relation_in_order(*pipeline, 20);
+    pipeline->stop();
+    pipeline.reset();
+
+    // a file cut short by a killed run is written again
+    fs::resize_file(stream_path, size - 3);
+    make_pipeline("file");
+    EXPECT_EQ(fs::file_size(stream_path), size);
+    fs::last_write_time(stream_path, written_at);
+
+    // so is the file of another relation
+    (*r1->weights)[0] = 7;
+    pipeline = make_pipeline("file");
+    EXPECT_NE(fs::last_write_time(stream_path), written_at);
+    pipeline->start();
+    IngestBlock<int> *block;
+    while ((block = pipeline->next_block(0)) == nullptr) {
+        ASSERT_FALSE(pipeline->failed());
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(block->weights[0], 7);
+    pipeline->release_block(0, block);
+    pipeline->stop();
+}
@@ -0,0 +1,141 @@
+#include "delegation_sketch/MetricsReporter.hpp"
+#include "json/json.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+MetricsSnapshot make_snapshot(long long received_per_thread) {
+    MetricsSnapshot snapshot;
+    snapshot.received_items = {received_per_thread, 2 * received_per_thread};
+    snapshot.total_received_items = 3 * received_per_thread;
+    snapshot.heavy_hitter_count = 3;
+    snapshot.blocked_loops = {0, 17};
+    snapshot.queue_depth = {1, 0};
+    snapshot.backlog_items = {4, 0};
+    snapshot.buffered_items = {2, 3};
+    return snapshot;
+}
+
+std::vector<json> read_json_lines(const std::string &path) {
+    std::ifstream is(path);
+    std::vector<json> lines;
+    for (std::string line; std::getline(is, line);) { lines.push_back(json::parse(line)); }
+    return lines;
+}
+
+// connects to the reporter socket and sends an HTTP request, the reporter answers while it waits for its next sample
+int connect_and_request(const std::string &socket_path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    socket_path.copy(addr.sun_path, socket_path.size());
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    return fd;
+}
+
+std::string read_until_closed(int fd) {
+    std::string response;
+    char buffer[1024];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) { response.append(buffer, received); }
+    close(fd);
+    return response;
+}
+
+}   // namespace
+
+TEST(MetricsReporterTest, WritesOneJsonLinePerSample) {
+    std::string path = ::testing::TempDir() + "metrics_reporter_test.jsonl";
+    fs::remove(path);
+    {
+        MetricsReporter reporter(20, path, "");
+        reporter.wait_for_next_sample();
+        reporter.report(make_snapshot(1000));
+        reporter.wait_for_next_sample();
+        reporter.report(make_snapshot(4000));
+    }
+
+    auto lines = read_json_lines(path);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0]["total_received_items"], 3000);
+    EXPECT_EQ(lines[0]["heavy_hitter_count"], 3);
+    EXPECT_EQ(lines[0]["received_items"], json({1000, 2000}));
+    EXPECT_EQ(lines[0]["blocked_loops"], json({0, 17}));
+    EXPECT_EQ(lines[0]["queue_depth"], json({1, 0}));
+    EXPECT_EQ(lines[0]["backlog_items"], json({4, 0}));
+    EXPECT_EQ(lines[0]["buffered_items"], json({2, 3}));
+    EXPECT_EQ(lines[1]["received_items"], json({4000, 8000}));
+
+    // the second sample is at least one interval later and its throughput covers the 9000 items of that interval only
+    double first_ms = lines[0]["elapsed_ms"], second_ms = lines[1]["elapsed_ms"];
+    EXPECT_GE(first_ms, 20);
+    EXPECT_GE(second_ms - first_ms, 20);
+    double throughput_mops = lines[1]["throughput_mops"];
+    EXPECT_NEAR(throughput_mops, 9000 / (second_ms - first_ms) / 1000, 1e-3);
+
+    // a later run appends to the same file
+    {
+        MetricsReporter reporter(20, path, "");
+        reporter.report(make_snapshot(1));
+    }
+    lines = read_json_lines(path);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[2]["total_received_items"], 3);
+    fs::remove(path);
+}
+
+TEST(MetricsReporterTest, ServesPrometheusTextOnTheSocket) {
+    std::string socket_path = ::testing::TempDir() + "metrics_reporter_test.sock";
+    MetricsReporter reporter(50, "", socket_path);
+    reporter.report(make_snapshot(1000));
+
+    int fd = connect_and_request(socket_path);
+    ASSERT_GE(fd, 0);
+    reporter.wait_for_next_sample();
+    std::string response = read_until_closed(fd);
+
+    size_t header_end = response.find("\r\n\r\n");
+    ASSERT_NE(header_end, std::string::npos);
+    std::string header = response.substr(0, header_end), body = response.substr(header_end + 4);
+    EXPECT_EQ(header.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+    EXPECT_NE(header.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(body.size())), std::string::npos);
+
+    for (std::string line : {"# TYPE delegation_elapsed_ms gauge", "# TYPE delegation_received_items_total counter", "delegation_heavy_hitters 3",
+                             "delegation_received_items_total{thread=\"0\"} 1000", "delegation_received_items_total{thread=\"1\"} 2000",
+                             "delegation_blocked_loops_total{thread=\"1\"} 17", "delegation_queue_depth{owner=\"0\"} 1", "delegation_backlog_items{owner=\"0\"} 4",
+                             "delegation_buffered_items{owner=\"1\"} 3"}) {
+        EXPECT_NE(body.find(line + "\n"), std::string::npos) << line;
+    }
+    // every sample is preceded by its HELP and TYPE lines
+    for (std::string name : {"delegation_throughput_mops", "delegation_queue_depth", "delegation_backlog_items", "delegation_buffered_items"}) {
+        EXPECT_NE(body.find("# HELP " + name + " "), std::string::npos) << name;
+        EXPECT_LT(body.find("# TYPE " + name + " "), body.find("\n" + name)) << name;
+    }
+}
+
+TEST(MetricsReporterTest, RemovesItsSocketOnExit) {
+    std::string socket_path = ::testing::TempDir() + "metrics_reporter_exit_test.sock";
+    // a stale socket file from an earlier run does not keep the reporter from listening
+    { std::ofstream stale(socket_path); }
+    {
+        MetricsReporter reporter(50, "", socket_path);
+        EXPECT_TRUE(fs::is_socket(socket_path));
+    }
+    EXPECT_FALSE(fs::exists(socket_path));
+}
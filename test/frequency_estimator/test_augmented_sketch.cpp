@@ -0,0 +1,155 @@
+#include "frequency_estimator/AnyFrequencyEstimator.hpp"
+#include "frequency_estimator/AugmentedSketch.hpp"
+#include "frequency_estimator/CountMinSketch.hpp"
+#include "frequency_estimator/SequentialHeavyHitterWrapperForParallel.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+// the scalar lookups the AVX2 paths replace
+int find_by_scan(const AugmentedFilter &filter, int key) {
+    for (int j = 0; j < filter.size; j++) {
+        if (filter.keys[j] == key) { return j; }
+    }
+    return -1;
+}
+
+// a drained delegation filter: (key, count) pairs of a skewed stream, some keys repeated across batches
+void make_batch(std::mt19937 &gen, std::vector<int> &keys, std::vector<int> &counts) {
+    std::geometric_distribution<int> key_distribution(0.05);
+    std::uniform_int_distribution<int> count_distribution(1, 5);
+    keys.resize(16);
+    counts.resize(16);
+    for (int i = 0; i < 16; i++) {
+        keys[i] = key_distribution(gen);
+        counts[i] = count_distribution(gen);
+    }
+}
+
+int find_min_by_scan(const AugmentedFilter &filter) {
+    int min_index = 0;
+    for (int j = 1; j < filter.size; j++) {
+        if (filter.counts[j] < filter.counts[min_index]) { min_index = j; }
+    }
+    return min_index;
+}
+
+}   // namespace
+
+// Every fill level of a filter of 20 slots (3 blocks of 8 lanes, the last one partly padding), with leftovers in the lanes past
+// size: an entry there must never be found or taken for the minimum.
+TEST(AugmentedFilterTest, FindMatchesScalarLookupAtEveryFillLevel) {
+    AugmentedFilter filter(20);
+    ASSERT_EQ(filter.keys.size(), 24u);
+    for (int size = 1; size <= 20; size++) {
+        for (int j = 0; j < 24; j++) { filter.keys[j] = 1000 + j; }
+        filter.size = size;
+        for (int key = 1000; key < 1024; key++) { EXPECT_EQ(filter.find(key), find_by_scan(filter, key)) << "size " << size << " key " << key; }
+        EXPECT_EQ(filter.find(999), -1);
+    }
+}
+
+TEST(AugmentedFilterTest, FindMinMatchesScalarScanAndTakesTheFirstTie) {
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> count_distribution(1, 6);
+    AugmentedFilter filter(20);
+    for (int round = 0; round < 200; round++) {
+        filter.size = 1 + round % 20;
+        // few distinct counts, so that the minimum is tied most of the time
+        for (int j = 0; j < 24; j++) { filter.counts[j] = j < filter.size ? count_distribution(gen) : 0; }
+        filter.min_index = -1;
+        int expected = find_min_by_scan(filter);
+        EXPECT_EQ(filter.find_min(), expected) << "round " << round;
+        EXPECT_EQ(filter.min_count, filter.counts[expected]) << "round " << round;
+    }
+}
+
+TEST(AugmentedFilterTest, CachedMinimumIsKeptUntilInvalidated) {
+    AugmentedFilter filter(12);
+    filter.size = 12;
+    for (int j = 0; j < 12; j++) { filter.counts[j] = 10 + j; }
+    filter.counts[9] = 3;
+    EXPECT_EQ(filter.find_min(), 9);
+
+    // a count changed elsewhere leaves the cached slot valid
+    filter.counts[2] = 50;
+    EXPECT_EQ(filter.find_min(), 9);
+
+    filter.counts[9] = 100;
+    filter.min_index = -1;
+    EXPECT_EQ(filter.find_min(), 0);
+    EXPECT_EQ(filter.min_count, 10);
+}
+
+// Keys that hold their filter slot from their first update are counted exactly, the others are never underestimated.
+TEST(AugmentedSketchTest, FilterKeysAreExactAndNoKeyIsUnderestimated) {
+    AugmentedSketch sketch(512u, 4u, 13);
+    std::map<int, unsigned int> exact_counts;
+    std::mt19937 gen(9);
+    std::geometric_distribution<int> key_distribution(0.05);
+    // the 13 heaviest keys come first and fill the filter, no key of the skewed tail gets close enough to take their slots
+    for (int r = 0; r < 50; r++) {
+        for (int key = 0; key < 13; key++) {
+            sketch.update(key, 100);
+            exact_counts[key] += 100;
+        }
+    }
+    for (int i = 0; i < 20000; i++) {
+        int key = 13 + key_distribution(gen);
+        sketch.update(key);
+        exact_counts[key]++;
+    }
+
+    for (int key = 0; key < 13; key++) { EXPECT_EQ(sketch.estimate(key), exact_counts[key]) << "key " << key; }
+    for (auto &[key, count] : exact_counts) { EXPECT_GE(sketch.estimate(key), count) << "key " << key; }
+}
+
+// A batch is the same as update_and_estimate pair by pair, on a copy of the sketch (same count-min seeds).
+TEST(AugmentedSketchTest, FilterBatchMatchesPerKeyUpdates) {
+    AugmentedSketch batched(256u, 4u, 13);
+    AugmentedSketch per_key = batched;
+    std::mt19937 gen(3);
+    std::vector<int> keys, counts;
+    std::vector<unsigned int> estimates(16);
+    for (int round = 0; round < 500; round++) {
+        make_batch(gen, keys, counts);
+        batched.process_filter_batch(keys.data(), counts.data(), 16, estimates.data());
+        for (int i = 0; i < 16; i++) { ASSERT_EQ(estimates[i], per_key.update_and_estimate(keys[i], counts[i])) << "round " << round << " pair " << i; }
+        // without estimates the batch only updates
+        batched.process_filter_batch(keys.data(), counts.data(), 16);
+        for (int i = 0; i < 16; i++) { per_key.update(keys[i], counts[i]); }
+    }
+    for (int key = 0; key < 200; key++) { EXPECT_EQ(batched.estimate(key), per_key.estimate(key)) << "key " << key; }
+}
+
+TEST(AugmentedSketchTest, FilterBatchTracksHeavyHittersInTheWrapper) {
+    AugmentedSketch sketch(256u, 4u, 13);
+    SequentialHeavyHitterWrapperForParallel<AugmentedSketch, int> wrapper(sketch, 0.01);
+    wrapper.update_threshold(40);
+    std::vector<int> keys = {1, 2, 3, 1}, counts = {30, 5, 50, 20};
+    wrapper.process_filter_batch(keys.data(), counts.data(), 4);
+
+    std::map<int, int> reported;
+    for (const auto &[key, count] : wrapper.get_heavy_hitters()) { reported[key] = count; }
+    EXPECT_EQ(reported, (std::map<int, int>{{1, 50}, {3, 50}}));
+}
+
+// Estimators without a batch entry point take the pairs one by one through AnyFrequencyEstimator.
+TEST(AugmentedSketchTest, AnyFrequencyEstimatorBatchesEveryEstimator) {
+    static_assert(FilterBatchProcessable<AugmentedSketch>);
+    static_assert(!FilterBatchProcessable<CountMinSketch>);
+    CountMinSketch sketch(256u, 4u);
+    CountMinSketch per_key = sketch;
+    AnyFrequencyEstimator any(std::move(sketch));
+    std::mt19937 gen(4);
+    std::vector<int> keys, counts;
+    std::vector<unsigned int> estimates(16);
+    for (int round = 0; round < 100; round++) {
+        make_batch(gen, keys, counts);
+        any.process_filter_batch(keys.data(), counts.data(), 16, estimates.data());
+        for (int i = 0; i < 16; i++) { ASSERT_EQ(estimates[i], per_key.update_and_estimate(keys[i], counts[i])) << "round " << round << " pair " << i; }
+    }
+}
@@ -0,0 +1,131 @@
+#include "frequency_estimator/BucketStreamSummary.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// (key, count, error) of every monitored key, largest count first
+template <typename Summary> std::vector<std::tuple<int, uint64_t, uint64_t>> counters_of(const Summary &summary) {
+    std::vector<std::tuple<int, uint64_t, uint64_t>> counters;
+    for (const auto &counter : summary) { counters.emplace_back(counter.key, counter.count, counter.error); }
+    return counters;
+}
+
+// three home slots for all keys, so that the index is made of long probe sequences that wrap around its end
+struct ThreeWayHash {
+    size_t operator()(int key) const { return size_t(key % 3); }
+};
+
+}   // namespace
+
+TEST(BucketStreamSummaryTest, UpdatesMoveKeysUpTheBuckets) {
+    BucketStreamSummary<int> summary(4);
+    for (int key : {1, 2, 3}) { EXPECT_EQ(summary.update(key), 1u); }
+    EXPECT_EQ(summary.lowest_count(), 1u);
+    // a counter is still unused
+    EXPECT_EQ(summary.min_count(), 0u);
+
+    // one step up into a new bucket, then past the buckets in between
+    EXPECT_EQ(summary.update(1), 2u);
+    EXPECT_EQ(summary.update(2), 2u);
+    EXPECT_EQ(summary.update(1, 5), 7u);
+    EXPECT_EQ(summary.update(4, 3), 3u);
+    using Counters = std::vector<std::tuple<int, uint64_t, uint64_t>>;
+    EXPECT_EQ(counters_of(summary), (Counters{{1, 7, 0}, {4, 3, 0}, {2, 2, 0}, {3, 1, 0}}));
+    EXPECT_EQ(summary.min_count(), 1u);
+
+    // a key alone in its bucket keeps the bucket when no other count is in the way
+    EXPECT_EQ(summary.update(1, 10), 17u);
+    // and joins the next bucket when it reaches its count
+    EXPECT_EQ(summary.update(3), 2u);
+    EXPECT_EQ(counters_of(summary), (Counters{{1, 17, 0}, {4, 3, 0}, {3, 2, 0}, {2, 2, 0}}));
+    EXPECT_EQ(summary.increment(1, 0), 17u);
+    EXPECT_EQ(summary.increment(99, 5), 0u);
+}
+
+TEST(BucketStreamSummaryTest, NewKeyTakesOverTheMinimum) {
+    BucketStreamSummary<int> summary(3);
+    summary.update(1, 5);
+    summary.update(2, 2);
+    summary.update(3, 4);
+
+    // 2 has the smallest count, 9 inherits it as error
+    EXPECT_EQ(summary.update(9, 3), 5u);
+    EXPECT_EQ(summary.estimate(2), 0u);
+    EXPECT_EQ(summary.estimate(9), 5u);
+    EXPECT_EQ(summary.error(9), 2u);
+    EXPECT_EQ(summary.size(), 3u);
+    EXPECT_EQ(summary.min_count(), 4u);
+
+    // the minimum is now 3, in a bucket of its own
+    EXPECT_EQ(summary.update(10), 5u);
+    EXPECT_EQ(summary.estimate(3), 0u);
+    EXPECT_EQ(summary.error(10), 4u);
+    // 1, 9 and 10 share the bucket of 5, the evicted one is the first node of that bucket
+    EXPECT_EQ(summary.update(11), 6u);
+    EXPECT_EQ(summary.size(), 3u);
+    EXPECT_EQ(summary.estimate(10) + summary.estimate(9) + summary.estimate(1), 10u);
+}
+
+TEST(BucketStreamSummaryTest, EraseUpToDropsTheLowestBuckets) {
+    BucketStreamSummary<int> summary(8);
+    for (int key = 1; key <= 8; key++) { summary.insert(key, key % 4 + 1); }
+    EXPECT_EQ(summary.erase_up_to(2), 4u);
+    EXPECT_EQ(summary.size(), 4u);
+    for (int key = 1; key <= 8; key++) { EXPECT_EQ(summary.estimate(key), key % 4 + 1 > 2 ? key % 4 + 1 : 0u) << "key " << key; }
+    EXPECT_EQ(summary.lowest_count(), 3u);
+    // the freed nodes and buckets are reused
+    for (int key = 11; key <= 14; key++) { summary.insert(key, 1); }
+    EXPECT_EQ(summary.size(), 8u);
+    EXPECT_THROW(summary.insert(15, 1), std::runtime_error);
+    EXPECT_EQ(summary.erase_up_to(1), 4u);
+    EXPECT_THROW(summary.insert(3, 1), std::runtime_error);
+}
+
+// Erasing from the middle of a probe sequence shifts the entries behind it back: every key stays reachable without tombstones.
+TEST(BucketStreamSummaryTest, BackwardShiftDeleteKeepsProbeSequencesWhole) {
+    BucketStreamSummary<int, ThreeWayHash> summary(16);
+    std::map<int, uint64_t> model;
+    std::mt19937 gen(17);
+    std::uniform_int_distribution<int> key_distribution(0, 40);
+    std::uniform_int_distribution<int> count_distribution(1, 6);
+    for (int round = 0; round < 3000; round++) {
+        int key = key_distribution(gen);
+        uint64_t c = count_distribution(gen);
+        if (model.count(key)) {
+            EXPECT_EQ(summary.increment(key, c), model[key] += c);
+        } else if (model.size() < 16) {
+            summary.insert(key, c);
+            model[key] = c;
+        } else {
+            // drop the lowest counts, some from the middle of the probe sequences of the keys that stay
+            uint64_t bound = summary.lowest_count() + c;
+            size_t erased = 0;
+            for (auto it = model.begin(); it != model.end();) {
+                if (it->second <= bound) {
+                    it = model.erase(it);
+                    erased++;
+                } else {
+                    ++it;
+                }
+            }
+            EXPECT_EQ(summary.erase_up_to(bound), erased);
+        }
+        ASSERT_EQ(summary.size(), model.size());
+        for (int k = 0; k <= 40; k++) { ASSERT_EQ(summary.estimate(k), model.count(k) ? model[k] : 0) << "round " << round << " key " << k; }
+    }
+}
+
+TEST(BucketStreamSummaryTest, RestoreRebuildsTheBucketOrder) {
+    BucketStreamSummary<int> summary(6);
+    for (int key = 1; key <= 6; key++) { summary.update(key, key * key % 7); }
+    auto counters = counters_of(summary);
+
+    BucketStreamSummary<int> restored(6);
+    for (auto it = counters.rbegin(); it != counters.rend(); ++it) { restored.restore(std::get<0>(*it), std::get<1>(*it), std::get<2>(*it)); }
+    EXPECT_EQ(counters_of(restored), counters);
+    EXPECT_EQ(restored.min_count(), summary.min_count());
+}
@@ -0,0 +1,68 @@
+#include "frequency_estimator/CountMinSketch.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// a skewed stream over 5000 keys with some weighted items, on a sketch narrow enough that most counters are shared
+std::vector<std::pair<int, int>> make_stream() {
+    std::mt19937 gen(13);
+    std::geometric_distribution<int> key_distribution(0.002);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < 40000; i++) { items.emplace_back(key_distribution(gen) % 5000, i % 7 == 0 ? 4 : 1); }
+    return items;
+}
+
+// a sketch with the seed of original, the seed is random and only a snapshot carries it over
+CountMinSketch copy_of(const CountMinSketch &original) {
+    std::stringstream snapshot;
+    original.save(snapshot);
+    CountMinSketch copy;
+    copy.load(snapshot);
+    return copy;
+}
+
+}   // namespace
+
+TEST(CountMinSketchTest, ConservativeUpdateNeverUnderestimates) {
+    CountMinSketch plain(256u, 4u);
+    CountMinSketch conservative = copy_of(plain);
+    conservative.conservative_update = true;
+
+    std::map<int, unsigned int> exact_counts;
+    for (auto &[key, weight] : make_stream()) {
+        exact_counts[key] += weight;
+        plain.update(key, weight);
+        // the estimate returned by the update already holds this item
+        EXPECT_GE(conservative.update_and_estimate(key, weight), exact_counts[key]) << "key " << key;
+    }
+    for (auto &[key, count] : exact_counts) {
+        unsigned int estimate = conservative.estimate(key);
+        EXPECT_GE(estimate, count) << "key " << key;
+        // same hashes, a counter never grows past the one of the plain sketch
+        EXPECT_LE(estimate, plain.estimate(key)) << "key " << key;
+    }
+    EXPECT_EQ(conservative.total, plain.total);
+}
+
+// Offsets and minimum over rows go through AVX2 (8 rows per vector) or a scalar loop; depths around the vector width, both update rules.
+TEST(CountMinSketchTest, Avx2AndScalarPathsAgree) {
+    if (!__builtin_cpu_supports("avx2")) { GTEST_SKIP() << "the cpu has no AVX2"; }
+    auto items = make_stream();
+    for (unsigned int depth : {1u, 3u, 8u, 9u, 17u}) {
+        for (bool conservative_update : {false, true}) {
+            SCOPED_TRACE(testing::Message() << "depth " << depth << (conservative_update ? ", conservative update" : ""));
+            CountMinSketch avx2(512u, depth, conservative_update);
+            CountMinSketch scalar = copy_of(avx2);
+            ASSERT_TRUE(avx2.use_avx2);
+            scalar.use_avx2 = false;
+
+            for (auto &[key, weight] : items) { ASSERT_EQ(avx2.update_and_estimate(key, weight), scalar.update_and_estimate(key, weight)) << "key " << key; }
+            for (int key = 0; key < 6000; key++) { EXPECT_EQ(avx2.estimate(key), scalar.estimate(key)) << "key " << key; }
+            EXPECT_EQ(avx2.estimate(std::string("a string key")), scalar.estimate(std::string("a string key")));
+        }
+    }
+}
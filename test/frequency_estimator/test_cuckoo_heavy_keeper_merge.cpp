@@ -0,0 +1,52 @@
+#include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+static constexpr int SEED = 11;
+
+TEST(CuckooHeavyKeeperMergeTest, HeavyKeysAddUp) {
+    CuckooHeavyKeeper a(1024, 0.01, 16, 1.08, SEED);
+    CuckooHeavyKeeper b(1024, 0.01, 16, 1.08, SEED);
+    // few keys in many buckets, every key gets a heavy slot on its first (weighted) update
+    for (int key = 0; key < 20; key++) { a.update(key, 100); }
+    for (int key = 10; key < 30; key++) { b.update(key, 50 + key); }
+
+    a.merge(b);
+    for (int key = 0; key < 30; key++) {
+        unsigned int expected = (key < 20 ? 100 : 0) + (key >= 10 ? 50 + key : 0);
+        EXPECT_EQ(a.estimate(key), expected) << "key " << key;
+    }
+    EXPECT_EQ(a.total, 20u * 100 + 20 * 50 + (10 + 29) * 20 / 2);
+}
+
+// A key that took a freed heavy slot while still in the lobby is held twice; merging must add its estimate, not both entries.
+TEST(CuckooHeavyKeeperMergeTest, KeyInHeavySlotAndLobbyIsMergedOnce) {
+    // one bucket per table: every key maps to the same two buckets, 4 heavy slots and 2 lobbies
+    CuckooHeavyKeeper a(1, 0.01, 16, 1.08, SEED);
+    CuckooHeavyKeeper b(1, 0.01, 16, 1.08, SEED);
+    for (int key = 1; key <= 4; key++) { b.update(key, 100); }
+    b.update(5, 3);   // heavy slots full, 5 waits in the lobby
+    b.remove(1);
+    b.update(5, 7);   // takes the freed heavy slot, the lobby entry stays
+    ASSERT_EQ(b.estimate(5), 7u);
+
+    a.update(5, 20);
+    a.merge(b);
+    EXPECT_EQ(a.estimate(5), 27u);
+    for (int key = 2; key <= 4; key++) { EXPECT_EQ(a.estimate(key), 100u) << "key " << key; }
+}
+
+TEST(CuckooHeavyKeeperMergeTest, WeightedKeyEnteringFullBucketKeepsItsFingerprint) {
+    CuckooHeavyKeeper b(1, 0.01, 16, 1.08, SEED);
+    for (int key = 1; key <= 4; key++) { b.update(key, 1000); }
+    // heavier than the promotion threshold, lighter than every heavy entry: promotion fails and the lobby keeps it at the threshold
+    b.update(5, 20);
+    EXPECT_EQ(b.estimate(5), 16u);
+}
+
+TEST(CuckooHeavyKeeperMergeTest, RejectsSketchesWithOtherSeeds) {
+    CuckooHeavyKeeper a(1024, 0.01, 16, 1.08, SEED);
+    CuckooHeavyKeeper b(1024, 0.01, 16, 1.08, SEED + 1);
+    EXPECT_FALSE(a.is_mergeable_with(b));
+    EXPECT_THROW(a.merge(b), std::runtime_error);
+}
@@ -0,0 +1,90 @@
+#include "frequency_estimator/elastic_sketch/ElasticSketch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+static constexpr int NUM_KEYS = 50000;
+static constexpr int TOP_K = 20;
+
+// Zipf(1.0) over NUM_KEYS keys, key 0 the most frequent; max_weight > 1 draws the weight of every item from [1, max_weight]
+std::vector<std::pair<int, int>> make_stream(int n, int max_weight, unsigned int seed) {
+    std::vector<double> frequencies(NUM_KEYS);
+    for (int key = 0; key < NUM_KEYS; key++) { frequencies[key] = 1.0 / (key + 1); }
+    std::mt19937 gen(seed);
+    std::discrete_distribution<int> key_distribution(frequencies.begin(), frequencies.end());
+    std::uniform_int_distribution<int> weight_distribution(1, max_weight);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++) { items.emplace_back(key_distribution(gen), weight_distribution(gen)); }
+    return items;
+}
+
+// The heavy keys hold a slot of the heavy part: the TOP_K largest counters listed by the sketch are about the TOP_K heaviest keys,
+// with counts exact from the moment a key took its slot plus what the light part kept of the units before.
+void expect_top_keys_recalled(int max_weight) {
+    ElasticSketch sketch(512, 512 * sizeof(Bucket) + 64 * 1024);
+    std::map<int, unsigned int> exact_counts;
+    unsigned long total = 0;
+    for (auto &[key, weight] : make_stream(200000, max_weight, 3)) {
+        sketch.update(key, weight);
+        exact_counts[key] += weight;
+        total += weight;
+    }
+    EXPECT_EQ(sketch.total, total);
+
+    std::vector<std::pair<unsigned int, int>> by_count;
+    for (auto &[key, count] : exact_counts) { by_count.emplace_back(count, key); }
+    std::partial_sort(by_count.begin(), by_count.begin() + TOP_K, by_count.end(), std::greater<>());
+    auto counters = sketch.counters<int>();
+    ASSERT_GE(counters.size(), size_t(TOP_K));
+
+    int recalled = 0;
+    for (int i = 0; i < TOP_K; i++) {
+        int key = by_count[i].second;
+        recalled += std::count_if(counters.begin(), counters.begin() + TOP_K, [&](const ElasticSketch::Counter &counter) { return counter.key == key; });
+        EXPECT_LE(sketch.estimate(key), 1.05 * exact_counts[key]) << "key " << key;
+        EXPECT_GE(sketch.estimate(key), 0.95 * exact_counts[key]) << "key " << key;
+    }
+    // the last few of the top keys have counts close to the next ones
+    EXPECT_GE(recalled, TOP_K - 2);
+}
+
+}   // namespace
+
+TEST(ElasticSketchTest, FindsTheHeavyKeysOfASkewedStream) { expect_top_keys_recalled(1); }
+
+// a weighted item votes against the smallest heavy entry with its whole weight
+TEST(ElasticSketchTest, FindsTheHeavyKeysOfAWeightedStream) { expect_top_keys_recalled(8); }
+
+// The AVX2 lookup (key match and minimum of the 7 slots in one vector each) against the scalar loop, through every outcome of
+// an insert: match, empty slot, vote against the minimum and eviction. Few buckets and few distinct weights, so counts tie.
+TEST(HeavyPartTest, Avx2AndScalarLookupsAgree) {
+    if (!__builtin_cpu_supports("avx2")) { GTEST_SKIP() << "the cpu has no AVX2"; }
+    HeavyPart avx2(16), scalar(16);
+    ASSERT_TRUE(avx2.use_avx2);
+    scalar.use_avx2 = false;
+
+    std::mt19937 gen(11);
+    std::geometric_distribution<uint32_t> key_distribution(0.01);
+    std::uniform_int_distribution<uint32_t> weight_distribution(1, 3);
+    std::map<int, int> outcomes;
+    for (int i = 0; i < 50000; i++) {
+        // key 0 is also the key of the empty slots
+        uint32_t key = key_distribution(gen), weight = weight_distribution(gen);
+        uint32_t avx2_swap_key = 0, avx2_swap_val = 0, scalar_swap_key = 0, scalar_swap_val = 0;
+        int outcome = avx2.insert(key, avx2_swap_key, avx2_swap_val, weight);
+        ASSERT_EQ(outcome, scalar.insert(key, scalar_swap_key, scalar_swap_val, weight)) << "item " << i;
+        ASSERT_EQ(avx2_swap_key, scalar_swap_key) << "item " << i;
+        ASSERT_EQ(avx2_swap_val, scalar_swap_val) << "item " << i;
+        outcomes[outcome]++;
+        if (i % 7 == 0) { ASSERT_EQ(avx2.quick_insert(key + 1, weight), scalar.quick_insert(key + 1, weight)) << "item " << i; }
+    }
+    EXPECT_EQ(outcomes.size(), 3u);
+
+    for (int i = 0; i < 16; i++) { EXPECT_EQ(std::memcmp(&avx2.get_bucket(i), &scalar.get_bucket(i), sizeof(Bucket)), 0) << "bucket " << i; }
+    for (uint32_t key = 0; key < 2000; key++) { EXPECT_EQ(avx2.query(key), scalar.query(key)) << "key " << key; }
+}
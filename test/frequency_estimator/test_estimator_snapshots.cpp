@@ -0,0 +1,105 @@
+#include "frequency_estimator/CountMinSketch.hpp"
+#include "frequency_estimator/CuckooHeavyKeeper.hpp"
+#include "frequency_estimator/HeapHashMapSpaceSaving.hpp"
+#include "frequency_estimator/MisraGries.hpp"
+#include "frequency_estimator/StreamSummarySpaceSaving.hpp"
+#include "utils/BinarySnapshot.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// a skewed stream over 2000 keys with some weighted items, so that every estimator evicts, decays or collides
+std::vector<std::pair<int, int>> make_stream() {
+    std::mt19937 gen(3);
+    std::geometric_distribution<int> key_distribution(0.01);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < 50000; i++) { items.emplace_back(key_distribution(gen) % 2000, i % 10 == 0 ? 5 : 1); }
+    return items;
+}
+
+// saves a sketch fed with the stream, restores it into restored (built with other parameters) and compares every estimate
+template <typename Estimator> void expect_round_trip(Estimator &original, Estimator &restored) {
+    for (auto &[key, weight] : make_stream()) { original.update(key, weight); }
+    original.update(std::string("a string key"), 7);
+
+    std::stringstream snapshot;
+    original.save(snapshot);
+    restored.load(snapshot);
+    for (int key = 0; key < 2000; key++) { EXPECT_EQ(restored.estimate(key), original.estimate(key)) << "key " << key; }
+    EXPECT_EQ(restored.estimate(std::string("a string key")), original.estimate(std::string("a string key")));
+
+    // the restored sketch goes on counting like the original
+    original.update(17, 3);
+    restored.update(17, 3);
+    EXPECT_EQ(restored.estimate(17), original.estimate(17));
+}
+
+}   // namespace
+
+TEST(EstimatorSnapshotTest, CuckooHeavyKeeperRoundTrip) {
+    CuckooHeavyKeeper original(256, 0.01, 16, 1.08, 5);
+    CuckooHeavyKeeper restored(16, 0.05, 16, 1.08, 9);
+    expect_round_trip(original, restored);
+}
+
+TEST(EstimatorSnapshotTest, CountMinSketchRoundTrip) {
+    CountMinSketch original(256u, 4u, true);
+    CountMinSketch restored(64u, 2u);
+    expect_round_trip(original, restored);
+    EXPECT_EQ(restored.width, original.width);
+    EXPECT_EQ(restored.depth, original.depth);
+    EXPECT_TRUE(restored.conservative_update);
+}
+
+TEST(EstimatorSnapshotTest, StreamSummarySpaceSavingRoundTrip) {
+    StreamSummarySpaceSaving original(100, 10);
+    StreamSummarySpaceSaving restored(20, 5);
+    expect_round_trip(original, restored);
+    EXPECT_EQ(restored.total, original.total);
+}
+
+TEST(EstimatorSnapshotTest, HeapHashMapSpaceSavingRoundTrip) {
+    HeapHashMapSpaceSavingV2 original(100);
+    HeapHashMapSpaceSavingV2 restored(100);
+    expect_round_trip(original, restored);
+}
+
+TEST(EstimatorSnapshotTest, MisraGriesRoundTrip) {
+    MisraGries original(100);
+    MisraGries restored(10);
+    expect_round_trip(original, restored);
+    EXPECT_EQ(restored.total, original.total);
+}
+
+TEST(EstimatorSnapshotTest, SnapshotFileRoundTrip) {
+    CuckooHeavyKeeper original(256, 0.01, 16, 1.08, 5);
+    for (auto &[key, weight] : make_stream()) { original.update(key, weight); }
+    std::string path = ::testing::TempDir() + "cuckoo_heavy_keeper.snapshot";
+    save_snapshot_file(path, original);
+
+    CuckooHeavyKeeper restored(16, 0.05, 16, 1.08, 9);
+    load_snapshot_file(path, restored);
+    for (int key = 0; key < 2000; key++) { EXPECT_EQ(restored.estimate(key), original.estimate(key)) << "key " << key; }
+    std::remove(path.c_str());
+}
+
+TEST(EstimatorSnapshotTest, RejectsOtherKindsAndTruncatedSnapshots) {
+    CountMinSketch count_min(64u, 2u);
+    std::stringstream snapshot;
+    count_min.save(snapshot);
+
+    MisraGries misra_gries(10);
+    EXPECT_THROW(misra_gries.load(snapshot), std::runtime_error);
+
+    std::string bytes = snapshot.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 8));
+    EXPECT_THROW(count_min.load(truncated), std::runtime_error);
+
+    std::stringstream not_a_snapshot("not a snapshot at all");
+    EXPECT_THROW(count_min.load(not_a_snapshot), std::runtime_error);
+}
@@ -0,0 +1,81 @@
+#include "frequency_estimator/HeavyGuardian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+static constexpr int NUM_KEYS = 50000;
+static constexpr int TOP_K = 20;
+
+// Zipf(1.0) over NUM_KEYS keys, key 0 the most frequent; max_weight > 1 draws the weight of every item from [1, max_weight]
+std::vector<std::pair<int, int>> make_stream(int n, int max_weight, unsigned int seed) {
+    std::vector<double> frequencies(NUM_KEYS);
+    for (int key = 0; key < NUM_KEYS; key++) { frequencies[key] = 1.0 / (key + 1); }
+    std::mt19937 gen(seed);
+    std::discrete_distribution<int> key_distribution(frequencies.begin(), frequencies.end());
+    std::uniform_int_distribution<int> weight_distribution(1, max_weight);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++) { items.emplace_back(key_distribution(gen), weight_distribution(gen)); }
+    return items;
+}
+
+// the TOP_K keys with the largest counts in the stream
+std::vector<int> top_keys(const std::map<int, unsigned int> &counts) {
+    std::vector<std::pair<unsigned int, int>> by_count;
+    for (auto &[key, count] : counts) { by_count.emplace_back(count, key); }
+    std::partial_sort(by_count.begin(), by_count.begin() + TOP_K, by_count.end(), std::greater<>());
+    std::vector<int> keys;
+    for (int i = 0; i < TOP_K; i++) { keys.push_back(by_count[i].second); }
+    return keys;
+}
+
+// The heavy keys hold a heavy entry of their bucket: each one is found among the TOP_K largest estimates, counted from the moment
+// it took the entry over, so a little under its true count.
+void expect_top_keys_recalled(int max_weight) {
+    HeavyGuardian sketch(1024);
+    std::map<int, unsigned int> exact_counts;
+    unsigned int total = 0;
+    for (auto &[key, weight] : make_stream(200000, max_weight, 3)) {
+        sketch.update(key, weight);
+        exact_counts[key] += weight;
+        total += weight;
+    }
+    EXPECT_EQ(sketch.total, int(total));
+
+    std::map<int, unsigned int> estimates;
+    for (auto &[key, count] : exact_counts) { estimates[key] = sketch.estimate(key); }
+    std::vector<int> expected = top_keys(exact_counts), reported = top_keys(estimates);
+    int recalled = 0;
+    for (int key : expected) {
+        recalled += std::count(reported.begin(), reported.end(), key);
+        // a light key with the same fingerprint in the same bucket adds its few units
+        EXPECT_LE(estimates[key], 1.05 * exact_counts[key]) << "key " << key;
+        EXPECT_GE(estimates[key], 0.95 * exact_counts[key]) << "key " << key;
+    }
+    // the last few of the top keys have counts close to the next ones
+    EXPECT_GE(recalled, TOP_K - 2);
+}
+
+}   // namespace
+
+TEST(HeavyGuardianTest, FindsTheHeavyKeysOfASkewedStream) { expect_top_keys_recalled(1); }
+
+// Weighted collisions draw the units until the next decay instead of one draw per unit, the heavy keys come out the same.
+TEST(HeavyGuardianTest, FindsTheHeavyKeysOfAWeightedStream) { expect_top_keys_recalled(8); }
+
+// Heavy entries of 1000 never decay, so the units of a new key all go to its light counter.
+TEST(HeavyGuardianTest, FullBucketSendsNewKeysToTheLightPart) {
+    HeavyGuardian sketch(1);
+    for (int key = 0; key < HeavyGuardian::G; key++) { sketch.update(key, 1000); }
+    EXPECT_EQ(sketch.update_and_estimate(100, 37), 37u);
+    EXPECT_EQ(sketch.update_and_estimate(100), 38u);
+    // two of them share an entry when their fingerprints are the same
+    for (int key = 0; key < HeavyGuardian::G; key++) { EXPECT_GE(sketch.estimate(key), 1000u) << "key " << key; }
+    // a key that was never seen reads its light counter, at least 1
+    EXPECT_GE(sketch.estimate(std::string("never seen")), 1u);
+    EXPECT_EQ(sketch.total, HeavyGuardian::G * 1000 + 38);
+}
@@ -0,0 +1,126 @@
+#include "frequency_estimator/MisraGries.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Summary = MisraGriesSummary<int>;
+static constexpr size_t K = 20;
+
+// a skewed stream of n items over 1000 keys, shifted by first_key so that two streams share only part of their keys
+std::vector<std::pair<int, int>> make_stream(int n, int first_key, unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::geometric_distribution<int> key_distribution(0.2);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++) { items.emplace_back(first_key + key_distribution(gen) % 1000, i % 5 == 0 ? 3 : 1); }
+    return items;
+}
+
+void feed(Summary &summary, std::map<int, Summary::count_t> &exact_counts, const std::vector<std::pair<int, int>> &items) {
+    for (auto &[key, weight] : items) {
+        summary.update(key, weight);
+        exact_counts[key] += weight;
+    }
+}
+
+// every key is undercounted by at most error_bound(), which stays within total / (k + 1)
+void expect_within_bound(const Summary &summary, const std::map<int, Summary::count_t> &exact_counts) {
+    Summary::count_t total = 0;
+    for (auto &[key, count] : exact_counts) {
+        total += count;
+        EXPECT_LE(summary.estimate(key), count) << "key " << key;
+        EXPECT_GE(summary.estimate(key) + summary.error_bound(), count) << "key " << key;
+    }
+    EXPECT_EQ(summary.get_total(), total);
+    EXPECT_LE(summary.error_bound(), total / (K + 1));
+    EXPECT_LE(summary.size(), K);
+}
+
+}   // namespace
+
+// Decrements go to the global offset: the smallest counter and every counter at its level leave the summary at once.
+TEST(MisraGriesSummaryTest, DecrementsMoveTheGlobalOffset) {
+    Summary summary(2);
+    summary.update(1, 5);
+    summary.update(2, 3);
+    // smaller than the smallest counter: every counter and the new key lose 2
+    EXPECT_EQ(summary.update(3, 2), 0u);
+    EXPECT_EQ(summary.estimate(1), 3u);
+    EXPECT_EQ(summary.estimate(2), 1u);
+    EXPECT_EQ(summary.estimate(3), 0u);
+    EXPECT_EQ(summary.error_bound(), 2u);
+
+    // larger: key 2 drops out, key 4 keeps what is left of its weight
+    EXPECT_EQ(summary.update(4, 4), 3u);
+    EXPECT_EQ(summary.estimate(1), 2u);
+    EXPECT_EQ(summary.estimate(2), 0u);
+    EXPECT_EQ(summary.estimate(4), 3u);
+    EXPECT_EQ(summary.size(), 2u);
+    EXPECT_EQ(summary.error_bound(), 3u);
+    EXPECT_EQ(summary.get_total(), 14u);
+}
+
+TEST(MisraGriesSummaryTest, StreamStaysWithinTheEpsilonBound) {
+    Summary summary(K);
+    std::map<int, Summary::count_t> exact_counts;
+    feed(summary, exact_counts, make_stream(30000, 0, 1));
+    EXPECT_GT(summary.error_bound(), 0u);
+    expect_within_bound(summary, exact_counts);
+}
+
+// Both summaries carry an offset when they are merged; the merged one (offset 0) keeps the bound of the union and goes on counting.
+TEST(MisraGriesSummaryTest, MergeKeepsTheEpsilonBoundOfTheUnion) {
+    Summary a(K), b(K);
+    std::map<int, Summary::count_t> exact_counts;
+    feed(a, exact_counts, make_stream(30000, 0, 1));
+    feed(b, exact_counts, make_stream(20000, 500, 2));
+    ASSERT_GT(a.error_bound(), 0u);
+    ASSERT_GT(b.error_bound(), 0u);
+
+    a.merge(b);
+    expect_within_bound(a, exact_counts);
+    // the heaviest key of each stream is still tracked
+    EXPECT_GT(a.estimate(0), 0u);
+    EXPECT_GT(a.estimate(500), 0u);
+
+    feed(a, exact_counts, make_stream(10000, 250, 3));
+    expect_within_bound(a, exact_counts);
+}
+
+TEST(MisraGriesSummaryTest, MergeOfSmallSummariesIsExact) {
+    Summary a(K), b(K);
+    for (int key = 0; key < 8; key++) { a.update(key, 10 + key); }
+    for (int key = 4; key < 12; key++) { b.update(key, 100); }
+    a.merge(b);
+    // 12 keys fit in 20 counters, nothing is decremented
+    EXPECT_EQ(a.error_bound(), 0u);
+    for (int key = 0; key < 12; key++) { EXPECT_EQ(a.estimate(key), (key < 8 ? 10u + key : 0u) + (key >= 4 ? 100u : 0u)) << "key " << key; }
+}
+
+TEST(MisraGriesTest, EpsilonConstructorTakesDoubles) {
+    MisraGries by_epsilon(0.05), by_float_epsilon(0.05f), by_n(20);
+    for (auto &[key, weight] : make_stream(5000, 0, 4)) {
+        by_epsilon.update(key, weight);
+        by_float_epsilon.update(key, weight);
+        by_n.update(key, weight);
+    }
+    for (int key = 0; key < 1000; key++) {
+        EXPECT_EQ(by_epsilon.estimate(key), by_n.estimate(key)) << "key " << key;
+        EXPECT_EQ(by_float_epsilon.estimate(key), by_n.estimate(key)) << "key " << key;
+    }
+}
+
+TEST(MisraGriesTest, MergeAddsIntAndStringSummaries) {
+    MisraGries a(10), b(10);
+    a.update(1, 5);
+    a.update(std::string("x"), 2);
+    b.update(1, 7);
+    b.update(std::string("x"), 3);
+    b.update(std::string("y"), 4);
+    a.merge(b);
+    EXPECT_EQ(a.estimate(1), 12u);
+    EXPECT_EQ(a.estimate(std::string("x")), 5u);
+    EXPECT_EQ(a.estimate(std::string("y")), 4u);
+}
@@ -0,0 +1,63 @@
+#include "frequency_estimator/SharedCuckooHeavyKeeper.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Several writers update the same keys at once. The keys fit the sketch without fingerprint collisions, so the only
+// loss allowed is the one documented for the SHARED design: two threads inserting the same new key may both claim a slot.
+TEST(SharedCuckooHeavyKeeperTest, ConcurrentWritersMatchExactCounts) {
+    constexpr int NUM_THREADS = 4;
+    constexpr int NUM_KEYS = 16;
+    constexpr int ROUNDS = 5000;
+    SharedCuckooHeavyKeeper sketch(1024, 0.01);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        writers.emplace_back([&sketch, t] {
+            for (int r = 0; r < ROUNDS; r++) {
+                // each thread walks the keys in its own order, with weight 1 for even keys and t + 1 for odd ones
+                for (int k = 0; k < NUM_KEYS; k++) {
+                    int key = (k * (2 * t + 1) + r) % NUM_KEYS;
+                    sketch.update(key, key % 2 == 0 ? 1 : t + 1);
+                }
+            }
+        });
+    }
+    for (auto &writer : writers) { writer.join(); }
+
+    std::map<int, long> exact_counter;
+    long exact_total = 0;
+    for (int key = 0; key < NUM_KEYS; key++) {
+        for (int t = 0; t < NUM_THREADS; t++) { exact_counter[key] += ROUNDS * long(key % 2 == 0 ? 1 : t + 1); }
+        exact_total += exact_counter[key];
+    }
+
+    EXPECT_EQ(sketch.total.load(), size_t(exact_total));
+    for (auto &[key, count] : exact_counter) {
+        unsigned int estimate = sketch.estimate(key);
+        EXPECT_LE(estimate, count) << "key " << key;
+        EXPECT_GE(estimate, count * 0.99) << "key " << key;
+    }
+}
+
+TEST(SharedCuckooHeavyKeeperTest, SingleWriterIsExactForFewKeys) {
+    SharedCuckooHeavyKeeper sketch(1024, 0.01);
+    std::map<int, long> exact_counter;
+    for (int r = 0; r < 1000; r++) {
+        for (int key = 0; key < 32; key++) {
+            int weight = key % 3 + 1;
+            exact_counter[key] += weight;
+            EXPECT_EQ(sketch.update_and_estimate(key, weight), exact_counter[key]);
+        }
+    }
+    for (auto &[key, count] : exact_counter) { EXPECT_EQ(sketch.estimate(key), count); }
+}
+
+// the bucket index is masked with bucket_num - 1, other sizes would leave buckets out or read past the tables
+TEST(SharedCuckooHeavyKeeperTest, BucketNumMustBeAPowerOfTwo) {
+    EXPECT_THROW(SharedCuckooHeavyKeeper(1000, 0.01), std::runtime_error);
+    EXPECT_THROW(SharedCuckooHeavyKeeper(0, 0.01), std::runtime_error);
+    EXPECT_NO_THROW(SharedCuckooHeavyKeeper(1024, 0.01));
+}
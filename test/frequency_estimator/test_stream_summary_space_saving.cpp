@@ -0,0 +1,124 @@
+#include "frequency_estimator/SequentialHeavyHitterWrapperForParallel.hpp"
+#include "frequency_estimator/SpaceSaving.hpp"
+#include "frequency_estimator/StreamSummarySpaceSaving.hpp"
+#include <gtest/gtest.h>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+static constexpr int K = 32;
+
+std::vector<std::pair<int, int>> make_stream(int n, int max_weight, unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::geometric_distribution<int> key_distribution(0.02);
+    std::uniform_int_distribution<int> weight_distribution(1, max_weight);
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++) { items.emplace_back(key_distribution(gen), weight_distribution(gen)); }
+    return items;
+}
+
+}   // namespace
+
+// With weights drawn from a wide range no two counters are tied at the minimum, so both evict the same key and every estimate agrees
+// with the linear SpaceSaving it replaces (the two break ties differently).
+TEST(StreamSummarySpaceSavingTest, MatchesLinearSpaceSavingWithoutTies) {
+    SpaceSaving linear(K);
+    StreamSummarySpaceSaving stream_summary(K, K);
+    for (auto &[key, weight] : make_stream(20000, 1 << 16, 5)) {
+        ASSERT_EQ(stream_summary.update_and_estimate(key, weight), linear.update_and_estimate(key, weight)) << "key " << key;
+    }
+    for (int key = 0; key < 2000; key++) { EXPECT_EQ(stream_summary.estimate(key), linear.estimate(key)) << "key " << key; }
+    EXPECT_EQ(stream_summary.estimate(std::string("17")), 0u);
+}
+
+// With unit weights ties are everywhere; both still keep the Space-Saving guarantees and find the same frequent keys.
+TEST(StreamSummarySpaceSavingTest, KeepsTheSpaceSavingBoundsWithTies) {
+    SpaceSaving linear(K);
+    StreamSummarySpaceSaving stream_summary(K, K);
+    std::map<int, unsigned int> exact_counts;
+    auto items = make_stream(50000, 1, 6);
+    for (auto &[key, weight] : items) {
+        exact_counts[key] += weight;
+        linear.update(key, weight);
+        stream_summary.update(key, weight);
+    }
+
+    uint64_t sum_of_counts = 0;
+    for (const auto &counter : stream_summary.counters<int>()) {
+        sum_of_counts += counter.count;
+        EXPECT_GE(counter.count, exact_counts[counter.key]) << "key " << counter.key;
+        EXPECT_LE(counter.count - counter.error, exact_counts[counter.key]) << "key " << counter.key;
+        // the error of a counter never exceeds the minimum, N / k
+        EXPECT_LE(counter.error, items.size() / K) << "key " << counter.key;
+    }
+    EXPECT_EQ(sum_of_counts, items.size());
+    for (auto &[key, count] : exact_counts) {
+        if (count > items.size() / K) {
+            EXPECT_GE(stream_summary.estimate(key), count) << "key " << key;
+            EXPECT_GE(linear.estimate(key), count) << "key " << key;
+        }
+    }
+}
+
+TEST(StreamSummarySpaceSavingTest, TotalPassesIntMax) {
+    StreamSummarySpaceSaving stream_summary(K, K);
+    for (int i = 0; i < 3; i++) { stream_summary.update(i, std::numeric_limits<int>::max()); }
+    EXPECT_EQ(stream_summary.total, 3 * int64_t(std::numeric_limits<int>::max()));
+
+    std::stringstream snapshot;
+    stream_summary.save(snapshot);
+    StreamSummarySpaceSaving restored(1, 1);
+    restored.load(snapshot);
+    EXPECT_EQ(restored.total, stream_summary.total);
+}
+
+TEST(StreamSummarySpaceSavingTest, CountersListIntAndStringKeysApart) {
+    StreamSummarySpaceSaving stream_summary(K, K);
+    EXPECT_EQ(stream_summary.counters<int>().size(), 0u);
+    auto items = make_stream(5000, 10, 7);
+    for (size_t i = 0; i < items.size(); i++) {
+        stream_summary.update(items[i].first, items[i].second);
+        stream_summary.update(std::to_string(i % 5), 1);
+    }
+
+    uint64_t previous = std::numeric_limits<uint64_t>::max();
+    size_t listed = 0;
+    for (const auto &counter : stream_summary.counters<int>()) {
+        EXPECT_LE(counter.count, previous);
+        EXPECT_EQ(stream_summary.estimate(counter.key), counter.count);
+        previous = counter.count;
+        listed++;
+    }
+    EXPECT_EQ(listed, size_t(K));
+    std::map<std::string, uint64_t> string_counts;
+    for (const auto &counter : stream_summary.counters<std::string>()) { string_counts[counter.key] = counter.count; }
+    EXPECT_EQ(string_counts, (std::map<std::string, uint64_t>{{"0", 1000}, {"1", 1000}, {"2", 1000}, {"3", 1000}, {"4", 1000}}));
+}
+
+// The candidates are read from the counters at query time: every key at or above the threshold, nothing below it.
+TEST(StreamSummarySpaceSavingTest, WrapperReportsTheCountersAboveTheThreshold) {
+    StreamSummarySpaceSaving stream_summary(K, K);
+    SequentialHeavyHitterWrapperForParallel<StreamSummarySpaceSaving, int> wrapper(stream_summary, 0.01);
+    for (auto &[key, weight] : make_stream(20000, 1, 8)) { wrapper.update(key, weight); }
+    // a threshold taken from a count in the middle, that key is at it exactly
+    auto counter = stream_summary.counters<int>().begin();
+    for (int i = 0; i < K / 4; i++) { ++counter; }
+    const BucketStreamSummary<int>::count_t threshold = (*counter).count;
+    wrapper.update_threshold(int(threshold));
+
+    std::map<int, int> expected;
+    for (const auto &counter : stream_summary.counters<int>()) {
+        if (counter.count >= threshold) { expected[counter.key] = counter.count; }
+    }
+    ASSERT_FALSE(expected.empty());
+    ASSERT_LT(expected.size(), size_t(K));
+
+    std::map<int, int> reported;
+    for (const auto &[key, count] : wrapper.get_heavy_hitters()) { reported[key] = count; }
+    EXPECT_EQ(reported, expected);
+}
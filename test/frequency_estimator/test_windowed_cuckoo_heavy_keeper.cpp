@@ -0,0 +1,48 @@
+#include "frequency_estimator/WindowedCuckooHeavyKeeper.hpp"
+#include <deque>
+#include <gtest/gtest.h>
+#include <map>
+
+// Windows far shorter than the bucket count, rotated on event time: the sweep of the retired sub-sketches cannot finish within one
+// window at first and carries over the rotations. Counts of a sub-sketch must never come back once it left the window.
+TEST(WindowedCuckooHeavyKeeperTest, EventTimeWindowsCountOnlyRecentItems) {
+    constexpr int NUM_WINDOWS = 3;
+    WindowedCuckooHeavyKeeper sketch(1024, 0.01, NUM_WINDOWS, 0, 5);
+    std::deque<std::map<int, long>> windows(1);
+
+    for (int w = 0; w < 200; w++) {
+        // 8 keys per window, rotating through 24 keys so that each key comes and goes
+        for (int i = 0; i < 20; i++) {
+            int key = (w * 8 + i % 8) % 24;
+            sketch.update(key, 1 + i % 3);
+            windows.back()[key] += 1 + i % 3;
+        }
+        for (int key = 0; key < 24; key++) {
+            long expected = 0;
+            for (auto &window : windows) { expected += window.count(key) ? window.at(key) : 0; }
+            ASSERT_EQ(sketch.estimate(key), expected) << "window " << w << " key " << key;
+        }
+
+        sketch.rotate();
+        windows.emplace_back();
+        if (windows.size() > NUM_WINDOWS) { windows.pop_front(); }
+    }
+}
+
+TEST(WindowedCuckooHeavyKeeperTest, CountBasedWindowsRotateOnTheirOwn) {
+    constexpr int NUM_WINDOWS = 2;
+    constexpr int WINDOW_SIZE = 100;
+    WindowedCuckooHeavyKeeper sketch(256, 0.01, NUM_WINDOWS, WINDOW_SIZE, 5);
+
+    // window w holds key w only, 100 items each
+    for (int w = 0; w < 10; w++) {
+        for (int i = 0; i < WINDOW_SIZE / 2; i++) { sketch.update(w); }
+        // halfway through window w, the query covers it and window w - 1
+        for (int key = 0; key <= w; key++) {
+            unsigned int expected = key == w ? WINDOW_SIZE / 2 : key == w - 1 ? WINDOW_SIZE : 0;
+            EXPECT_EQ(sketch.estimate(key), expected) << "window " << w << " key " << key;
+        }
+        for (int i = 0; i < WINDOW_SIZE / 2; i++) { sketch.update(w); }
+    }
+    EXPECT_EQ(sketch.total, 10u * WINDOW_SIZE);
+}
@@ -0,0 +1,139 @@
+#include "heavy_hitter_app/PcapReader.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// Writes a small trace in the layout libpcap uses, in the byte order of the host or swapped, with the given link type.
+class PcapTraceWriter {
+  public:
+    PcapTraceWriter(uint32_t link_type, bool swapped) : swapped(swapped) {
+        put32(PCAP_MAGIC_MICROSECONDS);
+        put16(2);
+        put16(4);
+        put32(0);
+        put32(0);
+        put32(65535);
+        put32(link_type);
+    }
+
+    void add_packet(const std::vector<unsigned char> &frame) {
+        put32(1);
+        put32(0);
+        put32(frame.size());
+        put32(frame.size());
+        bytes.insert(bytes.end(), frame.begin(), frame.end());
+    }
+
+    std::string write(const std::string &name) const {
+        std::string filename = ::testing::TempDir() + name;
+        FILE *file = fopen(filename.c_str(), "wb");
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+        return filename;
+    }
+
+  private:
+    bool swapped;
+    std::vector<unsigned char> bytes;
+
+    void put_bytes(const void *value, int size) {
+        for (int b = 0; b < size; b++) { bytes.push_back(static_cast<const unsigned char *>(value)[b]); }
+    }
+    void put32(uint32_t value) {
+        if (swapped) { value = __builtin_bswap32(value); }
+        put_bytes(&value, 4);
+    }
+    void put16(uint16_t value) {
+        if (swapped) { value = __builtin_bswap16(value); }
+        put_bytes(&value, 2);
+    }
+};
+
+// an IPv4 header without options, followed by the ports when the protocol carries them
+static std::vector<unsigned char> ipv4_packet(uint8_t protocol, uint32_t src_ip, uint32_t dst_ip, uint16_t src_port, uint16_t dst_port, uint16_t fragment_offset = 0) {
+    std::vector<unsigned char> packet(20, 0);
+    packet[0] = 0x45;
+    packet[6] = fragment_offset >> 8;
+    packet[7] = fragment_offset & 0xff;
+    packet[9] = protocol;
+    for (int b = 0; b < 4; b++) {
+        packet[12 + b] = src_ip >> (24 - 8 * b);
+        packet[16 + b] = dst_ip >> (24 - 8 * b);
+    }
+    for (uint16_t port : {src_port, dst_port}) {
+        packet.push_back(port >> 8);
+        packet.push_back(port & 0xff);
+    }
+    return packet;
+}
+
+static FiveTuple five_tuple(uint32_t src_ip, uint32_t dst_ip, uint16_t src_port, uint16_t dst_port, uint8_t protocol) {
+    FiveTuple flow{};
+    flow.src_ip = src_ip;
+    flow.dst_ip = dst_ip;
+    flow.src_port = src_port;
+    flow.dst_port = dst_port;
+    flow.protocol = protocol;
+    return flow;
+}
+
+TEST(PcapReaderTest, ReadsRawIpTraceInBothByteOrders) {
+    for (bool swapped : {false, true}) {
+        PcapTraceWriter writer(PCAP_LINKTYPE_RAW, swapped);
+        writer.add_packet(ipv4_packet(6, 0x0a000001, 0xc0a80102, 443, 51000));
+        writer.add_packet(ipv4_packet(17, 0x0a000002, 0x08080808, 53000, 53));
+        // IPv6 is skipped
+        writer.add_packet(std::vector<unsigned char>(40, 0x60));
+        // ICMP and non-first fragments have no ports
+        writer.add_packet(ipv4_packet(1, 0x0a000003, 0x0a000004, 0x0800, 0x1234));
+        writer.add_packet(ipv4_packet(6, 0x0a000005, 0x0a000006, 80, 8080, 0x00b9));
+        std::string filename = writer.write(swapped ? "swapped.pcap" : "native.pcap");
+
+        ASSERT_TRUE(is_pcap_file(filename));
+        std::vector<FiveTuple> flows;
+        ASSERT_EQ(read_pcap_five_tuples(filename, 100, flows), 4u);
+        EXPECT_EQ(flows[0], five_tuple(0x0a000001, 0xc0a80102, 443, 51000, 6));
+        EXPECT_EQ(flows[1], five_tuple(0x0a000002, 0x08080808, 53000, 53, 17));
+        EXPECT_EQ(flows[2], five_tuple(0x0a000003, 0x0a000004, 0, 0, 1));
+        EXPECT_EQ(flows[3], five_tuple(0x0a000005, 0x0a000006, 0, 0, 6));
+        std::remove(filename.c_str());
+    }
+}
+
+TEST(PcapReaderTest, ReadsEthernetTraceWithVlanTags) {
+    PcapTraceWriter writer(PCAP_LINKTYPE_ETHERNET, false);
+    std::vector<unsigned char> mac_addresses(12, 0xaa);
+    auto ethernet_frame = [&](std::vector<unsigned char> ethertypes, const std::vector<unsigned char> &payload) {
+        std::vector<unsigned char> frame = mac_addresses;
+        frame.insert(frame.end(), ethertypes.begin(), ethertypes.end());
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        return frame;
+    };
+    writer.add_packet(ethernet_frame({0x08, 0x00}, ipv4_packet(6, 1, 2, 3, 4)));
+    writer.add_packet(ethernet_frame({0x81, 0x00, 0x00, 0x0a, 0x08, 0x00}, ipv4_packet(17, 5, 6, 7, 8)));
+    // ARP is skipped
+    writer.add_packet(ethernet_frame({0x08, 0x06}, std::vector<unsigned char>(28, 0)));
+    std::string filename = writer.write("ethernet.pcap");
+
+    std::vector<FiveTuple> flows;
+    ASSERT_EQ(read_pcap_five_tuples(filename, 100, flows), 2u);
+    EXPECT_EQ(flows[0], five_tuple(1, 2, 3, 4, 6));
+    EXPECT_EQ(flows[1], five_tuple(5, 6, 7, 8, 17));
+
+    // max_flows stops the read early
+    flows.clear();
+    EXPECT_EQ(read_pcap_five_tuples(filename, 1, flows), 1u);
+    std::remove(filename.c_str());
+}
+
+TEST(PcapReaderTest, TextFlowFilesAreNotPcap) {
+    std::string filename = ::testing::TempDir() + "flows.csv";
+    FILE *file = fopen(filename.c_str(), "w");
+    fputs("10.0.0.1,10.0.0.2,80,8080,6\n", file);
+    fclose(file);
+    EXPECT_FALSE(is_pcap_file(filename));
+    std::vector<FiveTuple> flows;
+    EXPECT_THROW(read_pcap_five_tuples(filename, 100, flows), std::runtime_error);
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,55 @@
+#include "prif/DeltaTable.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+
+TEST(DeltaTableTest, MatchesMapThroughGrowthAndClear) {
+    // starts at the minimum capacity, so the table doubles several times
+    DeltaTable<int> table(16);
+    std::map<int, int> expected;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> key_distribution(-5000, 5000);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 20000; i++) {
+            int key = key_distribution(rng);
+            int c = i % 5 - 2;   // deltas may cancel out
+            table[key] += c;
+            expected[key] += c;
+        }
+        std::map<int, int> seen;
+        table.for_each([&](const int &key, int count) {
+            EXPECT_TRUE(seen.emplace(key, count).second) << "key " << key << " listed twice";
+        });
+        // for_each skips the keys whose delta is back to 0
+        for (auto &[key, count] : expected) {
+            if (count != 0) { EXPECT_EQ(seen[key], count) << "key " << key; }
+        }
+        for (auto &[key, count] : seen) { EXPECT_NE(count, 0); }
+        EXPECT_EQ(table.size(), expected.size());
+
+        table.clear();
+        expected.clear();
+        EXPECT_TRUE(table.empty());
+        int listed = 0;
+        table.for_each([&](const int &, int) { listed++; });
+        EXPECT_EQ(listed, 0);
+    }
+}
+
+TEST(DeltaTableTest, ClearedSlotsAreReusedAndStartAtZero) {
+    DeltaTable<std::string> table(16);
+    table["a"] += 3;
+    table["b"] += 4;
+    table.clear();
+    EXPECT_EQ(table["a"], 0);
+    table["a"] += 1;
+    int sum = 0;
+    table.for_each([&](const std::string &key, int count) {
+        EXPECT_EQ(key, "a");
+        sum += count;
+    });
+    EXPECT_EQ(sum, 1);
+    EXPECT_EQ(table.size(), 1u);
+}
@@ -0,0 +1,65 @@
+#include "prif/PRIF.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+// one worker forwarding to one merger ring, the test plays the merger
+class ThreadLocalPRIFTest : public ::testing::Test {
+  protected:
+    std::atomic<float> beta = 0;   // every update is forwarded
+    CuckooHeavyKeeperConfig frequency_estimator_configs;
+    std::unique_ptr<SharedBuffer<int>> shared_buffer = std::make_unique<SharedBuffer<int>>(4096);
+    std::unique_ptr<ThreadLocalPRIF<CuckooHeavyKeeper, int>> worker;
+
+    void SetUp() override {
+        ConfigParser parser;
+        CuckooHeavyKeeperConfig::add_params_to_config_parser(frequency_estimator_configs, parser);
+        ASSERT_TRUE(parser.LoadDefaultValues().IsOK());
+        worker = std::make_unique<ThreadLocalPRIF<CuckooHeavyKeeper, int>>(frequency_estimator_configs);
+        worker->beta = &beta;
+        worker->current_thread_id = 0;
+        worker->shared_buffers = {shared_buffer.get()};
+        worker->outgoing.resize(1);
+    }
+
+    // total delta published to the ring so far
+    long drain() {
+        std::vector<Message<int>> batch(4096);
+        long total = 0;
+        size_t count = shared_buffer->messages.dequeue_batch(batch.begin(), batch.size());
+        for (size_t i = 0; i < count; i++) { total += batch[i].delta; }
+        return total;
+    }
+};
+
+TEST_F(ThreadLocalPRIFTest, FlushPublishesEverythingAndLeavesNothingStaged) {
+    worker->batch_size = 4;
+    worker->batch_timeout = std::chrono::seconds(100);
+    for (int key = 1; key <= 3; key++) { worker->update(key, 1); }
+    EXPECT_EQ(worker->num_staged, 3);
+    EXPECT_EQ(drain(), 0);
+
+    // deltas that were never forwarded are staged by flush as well
+    beta = 1;
+    for (int key = 1; key <= 5; key++) { worker->update(key, 2); }
+    worker->flush();
+    EXPECT_EQ(worker->num_staged, 0);
+    EXPECT_EQ(drain(), 3 + 10);
+
+    // staging after a flush starts from an empty batch again
+    beta = 0;
+    for (int key = 1; key <= 4; key++) { worker->update(key, 1); }
+    EXPECT_EQ(worker->num_staged, 0);
+    EXPECT_EQ(drain(), 4);
+}
+
+TEST_F(ThreadLocalPRIFTest, TimeoutPublishesPartialBatch) {
+    // the batch never fills, the timeout check every 1024 updates publishes it
+    worker->batch_size = 1 << 20;
+    worker->batch_timeout = std::chrono::microseconds(0);
+    for (int i = 0; i < 1023; i++) { worker->update(i, 1); }
+    EXPECT_EQ(drain(), 0);
+    worker->update(1023, 1);
+    EXPECT_EQ(worker->num_staged, 0);
+    EXPECT_EQ(drain(), 1024);
+}
@@ -0,0 +1,102 @@
+#include "delegation_sketch/DelegationFilter.hpp"
+#include "delegation_sketch/PendingQuery.hpp"
+#include "heavy_hitter_app/FiveTuple.hpp"
+#include "utils/CacheLineArena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// [begin, end) byte ranges of the allocations, to check that they start on a cache line and that no line holds two of them
+using Range = std::pair<uintptr_t, uintptr_t>;
+
+Range range_of(const void *p, size_t bytes) { return {reinterpret_cast<uintptr_t>(p), reinterpret_cast<uintptr_t>(p) + bytes}; }
+
+void expect_own_cache_lines(std::vector<Range> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        EXPECT_EQ(ranges[i].first % CACHE_LINE_SIZE, 0u) << "allocation " << i;
+        // the last line of one allocation comes before the first line of the next
+        if (i > 0) { EXPECT_LT((ranges[i - 1].second - 1) / CACHE_LINE_SIZE, ranges[i].first / CACHE_LINE_SIZE) << "allocations " << i - 1 << " and " << i; }
+    }
+}
+
+template <typename KeyType> std::vector<Range> filter_ranges(DelegationFilter<KeyType> *filter) {
+    std::vector<Range> ranges = {range_of(filter, sizeof(*filter)), range_of(filter->keys.data(), filter->keys.size() * sizeof(KeyType)),
+                                 range_of(filter->counts.data(), filter->counts.size() * sizeof(int))};
+    if constexpr (!std::is_same_v<KeyType, int>) { ranges.push_back(range_of(filter->hashes.data(), filter->hashes.size() * sizeof(uint32_t))); }
+    return ranges;
+}
+
+// the per-thread state of the delegation designs: two filters and one pending query per peer, and the query seeds
+template <typename KeyType> void expect_delegation_state_layout(int num_peers, int filter_size) {
+    CacheLineArena arena(num_peers * (2 * delegation_filter_arena_bytes<KeyType>(filter_size) + sizeof(PendingQuery<KeyType>)) + CACHE_LINE_SIZE);
+    std::vector<Range> ranges;
+    auto *seeds = static_cast<unsigned long *>(arena.allocate(3 * sizeof(unsigned long)));
+    ranges.push_back(range_of(seeds, 3 * sizeof(unsigned long)));
+    for (int i = 0; i < num_peers; i++) {
+        for (int buffer = 0; buffer < 2; buffer++) {
+            auto filter_ranges_of_peer = filter_ranges(arena.create<DelegationFilter<KeyType>>(filter_size, &arena));
+            ranges.insert(ranges.end(), filter_ranges_of_peer.begin(), filter_ranges_of_peer.end());
+        }
+        auto *query = arena.create<PendingQuery<KeyType>>();
+        ranges.push_back(range_of(query, sizeof(*query)));
+    }
+    expect_own_cache_lines(ranges);
+    // the arena is sized so that a thread's state is one contiguous slab
+    EXPECT_EQ(arena.num_slabs(), 1u) << "filter size " << filter_size;
+}
+
+}   // namespace
+
+TEST(CacheLineArenaTest, AllocationsStartOnTheirOwnCacheLine) {
+    CacheLineArena arena(1024);
+    std::vector<Range> ranges;
+    for (size_t bytes : {1, 4, 63, 64, 65, 100, 128, 200}) { ranges.push_back(range_of(arena.allocate(bytes, 8), bytes)); }
+    expect_own_cache_lines(ranges);
+    // rounded up to whole lines: 1 + 1 + 1 + 1 + 2 + 2 + 2 + 4
+    EXPECT_EQ(arena.bytes_allocated(), 14 * CACHE_LINE_SIZE);
+}
+
+TEST(CacheLineArenaTest, MemoryIsZeroedAndLargeRequestsGetTheirOwnSlab) {
+    CacheLineArena arena(256);
+    auto *small = static_cast<unsigned char *>(arena.allocate(100));
+    EXPECT_TRUE(std::all_of(small, small + 100, [](unsigned char byte) { return byte == 0; }));
+    EXPECT_EQ(arena.num_slabs(), 1u);
+
+    // larger than a slab, the rest of the current slab is still used afterwards
+    auto *large = static_cast<unsigned char *>(arena.allocate(1000));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % CACHE_LINE_SIZE, 0u);
+    EXPECT_TRUE(std::all_of(large, large + 1000, [](unsigned char byte) { return byte == 0; }));
+    EXPECT_EQ(arena.num_slabs(), 2u);
+    auto *next = static_cast<unsigned char *>(arena.allocate(64));
+    EXPECT_EQ(next, small + 128);
+    EXPECT_EQ(arena.num_slabs(), 2u);
+}
+
+TEST(CacheLineArenaTest, PmrVectorsAndCreatedObjectsLiveInTheArena) {
+    static int num_destroyed = 0;
+    struct Tracked {
+        ~Tracked() { num_destroyed++; }
+    };
+    {
+        CacheLineArena arena(4096);
+        std::pmr::vector<int> values(10, &arena);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(values.data()) % CACHE_LINE_SIZE, 0u);
+        arena.create<Tracked>();
+        arena.create<Tracked>();
+        EXPECT_EQ(arena.num_slabs(), 1u);
+    }
+    EXPECT_EQ(num_destroyed, 2);
+}
+
+TEST(CacheLineArenaTest, DelegationStateHasNoSharedCacheLines) {
+    for (int filter_size : {1, 3, 4, 15, 16, 17, 64, 100}) {
+        expect_delegation_state_layout<int>(4, filter_size);
+        expect_delegation_state_layout<FiveTuple>(4, filter_size);
+    }
+}